@@ -0,0 +1,214 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+/* wrk-style load generator for HTTP/1.1 servers: it keeps `connections` keep-alive connections busy
+ * for `duration` seconds, each of them has `depth` pipelined requests in flight,
+ * and reports requests/s, throughput and latency percentiles;
+ * without port, an in-process cat_http_server is benchmarked
+ * usage: main [port] [connections] [duration] [depth] [path] */
+
+#include "cat_api.h"
+#include "cat_http_server.h"
+
+#define BENCH_MAX_SAMPLES (1024 * 1024)
+
+typedef struct bench_s {
+    int port;
+    size_t connections;
+    size_t depth;
+    cat_msec_t duration;
+    char request[256];
+    size_t request_length;
+    cat_bool_t stopped;
+    size_t requests;
+    size_t errors;
+    size_t bytes;
+    size_t sample_count;
+    cat_nsec_t *samples;
+    cat_sync_wait_group_t wg;
+} bench_t;
+
+static cat_bool_t handle_request(cat_http_server_connection_t *connection, void *data)
+{
+    (void) data;
+    return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, CAT_STRL("text/plain"), CAT_STRL("Hello, World!"));
+}
+
+static cat_data_t *serve(cat_data_t *data)
+{
+    (void) cat_http_server_run((cat_http_server_t *) data);
+    return NULL;
+}
+
+static cat_data_t *run_connection(cat_data_t *data)
+{
+    bench_t *bench = (bench_t *) data;
+    cat_socket_t client;
+    cat_http_parser_t parser;
+    char *batch = NULL, buffer[64 * 1024];
+    size_t i;
+
+    if (cat_socket_create(&client, CAT_SOCKET_TYPE_TCP) == NULL ||
+        !cat_socket_connect_to(&client, CAT_STRL("127.0.0.1"), bench->port)) {
+        bench->errors++;
+        goto _out;
+    }
+    batch = (char *) malloc(bench->request_length * bench->depth);
+    if (batch == NULL) {
+        abort();
+    }
+    for (i = 0; i < bench->depth; i++) {
+        memcpy(batch + i * bench->request_length, bench->request, bench->request_length);
+    }
+    (void) cat_http_parser_create(&parser);
+    (void) cat_http_parser_set_type(&parser, CAT_HTTP_PARSER_TYPE_RESPONSE);
+    cat_http_parser_set_events(&parser, CAT_HTTP_PARSER_EVENT_BODY | CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE);
+    while (!bench->stopped) {
+        cat_nsec_t start = cat_time_nsec(), latency;
+        size_t completed = 0;
+        if (!cat_socket_send(&client, batch, bench->request_length * bench->depth)) {
+            bench->errors++;
+            break;
+        }
+        while (completed < bench->depth) {
+            const char *p = buffer, *pe;
+            ssize_t n = cat_socket_recv(&client, buffer, sizeof(buffer));
+            if (n <= 0) {
+                bench->errors++;
+                goto _out;
+            }
+            bench->bytes += n;
+            pe = buffer + n;
+            /* message may complete after body without any more data */
+            while (p < pe || parser.event == CAT_HTTP_PARSER_EVENT_BODY) {
+                if (!cat_http_parser_execute(&parser, p, pe - p)) {
+                    bench->errors++;
+                    goto _out;
+                }
+                p += parser.parsed_length;
+                if (parser.event == CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE) {
+                    if (cat_http_parser_get_status_code(&parser) != CAT_HTTP_STATUS_OK) {
+                        bench->errors++;
+                    }
+                    completed++;
+                }
+            }
+        }
+        latency = cat_time_nsec() - start;
+        bench->requests += completed;
+        if (bench->sample_count < BENCH_MAX_SAMPLES) {
+            bench->samples[bench->sample_count++] = latency;
+        }
+    }
+
+    _out:
+    free(batch);
+    cat_socket_close(&client);
+    (void) cat_sync_wait_group_done(&bench->wg);
+    return NULL;
+}
+
+static int compare_samples(const void *a, const void *b)
+{
+    cat_nsec_t x = *(const cat_nsec_t *) a, y = *(const cat_nsec_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static double get_percentile(const bench_t *bench, double percentile)
+{
+    size_t index;
+    if (bench->sample_count == 0) {
+        return 0;
+    }
+    index = (size_t) (percentile / 100 * (bench->sample_count - 1));
+    return (double) bench->samples[index] / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    static const double percentiles[] = { 50, 75, 90, 99, 99.9 };
+    cat_http_server_t server;
+    cat_bool_t embedded;
+    bench_t bench;
+    const char *path;
+    cat_nsec_t start;
+    double elapsed;
+    size_t i;
+
+    memset(&bench, 0, sizeof(bench));
+    bench.port = argc > 1 ? atoi(argv[1]) : 0;
+    bench.connections = argc > 2 ? (size_t) atoll(argv[2]) : 64;
+    bench.duration = (argc > 3 ? (cat_msec_t) atoll(argv[3]) : 5) * 1000;
+    bench.depth = argc > 4 ? (size_t) atoll(argv[4]) : 1;
+    path = argc > 5 ? argv[5] : "/plaintext";
+    bench.request_length = snprintf(bench.request, sizeof(bench.request),
+        "GET %s HTTP/1.1\r\nHost: localhost\r\n\r\n", path);
+    if (bench.request_length >= sizeof(bench.request) || bench.connections == 0 || bench.depth == 0) {
+        fprintf(stderr, "usage: %s [port] [connections] [duration] [depth] [path]\n", argv[0]);
+        return 1;
+    }
+    bench.samples = (cat_nsec_t *) malloc(sizeof(*bench.samples) * BENCH_MAX_SAMPLES);
+    if (bench.samples == NULL) {
+        abort();
+    }
+
+    cat_init_all();
+    cat_run(CAT_RUN_EASY);
+
+    embedded = bench.port == 0;
+    if (embedded) {
+        if (cat_http_server_create(&server, NULL, handle_request, NULL) == NULL ||
+            !cat_http_server_listen(&server, CAT_STRL("127.0.0.1"), 0)) {
+            fprintf(stderr, "%s\n", cat_get_last_error_message());
+            return 1;
+        }
+        bench.port = cat_http_server_get_port(&server);
+        cat_coroutine_run(NULL, serve, &server);
+    }
+
+    printf("Running %.0fs test @ http://127.0.0.1:%d%s\n  %zu connections, pipeline depth %zu\n",
+        (double) bench.duration / 1000, bench.port, path, bench.connections, bench.depth);
+    (void) cat_sync_wait_group_create(&bench.wg);
+    (void) cat_sync_wait_group_add(&bench.wg, bench.connections);
+    start = cat_time_nsec();
+    for (i = 0; i < bench.connections; i++) {
+        cat_coroutine_run(NULL, run_connection, &bench);
+    }
+    (void) cat_time_msleep(bench.duration);
+    bench.stopped = cat_true;
+    (void) cat_sync_wait_group_wait(&bench.wg, CAT_TIMEOUT_FOREVER);
+    elapsed = (double) (cat_time_nsec() - start) / 1e9;
+
+    qsort(bench.samples, bench.sample_count, sizeof(*bench.samples), compare_samples);
+    printf("  Latency (per batch)\n");
+    for (i = 0; i < CAT_ARRAY_SIZE(percentiles); i++) {
+        printf("  %7.1f%%%12.3fms\n", percentiles[i], get_percentile(&bench, percentiles[i]));
+    }
+    printf("  %zu requests in %.2fs, %.2fMB read, %zu errors\n",
+        bench.requests, elapsed, (double) bench.bytes / (1024 * 1024), bench.errors);
+    printf("Requests/sec: %12.2f\n", (double) bench.requests / elapsed);
+    printf("Transfer/sec: %10.2fMB\n", (double) bench.bytes / (1024 * 1024) / elapsed);
+
+    if (embedded) {
+        (void) cat_http_server_shutdown(&server, CAT_TIMEOUT_FOREVER);
+        cat_http_server_close(&server);
+    }
+    free(bench.samples);
+
+    return bench.errors != 0;
+}
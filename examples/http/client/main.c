@@ -0,0 +1,169 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+/* benchmark of the native HTTP client against the cat_curl path,
+ * both of them keep connections alive and send requests to an in-process cat_http_server
+ * from `concurrency` coroutines
+ * usage: main [requests] [concurrency] */
+
+#include "cat_api.h"
+#include "cat_http_client.h"
+#include "cat_http_server.h"
+#include "cat_curl.h"
+
+typedef struct bench_s {
+    const char *name;
+    int port;
+    size_t requests;
+    size_t concurrency;
+    size_t errors;
+    cat_http_client_t client;
+    cat_sync_wait_group_t wg;
+} bench_t;
+
+static cat_bool_t handle_request(cat_http_server_connection_t *connection, void *data)
+{
+    (void) data;
+    return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, CAT_STRL("text/plain"), CAT_STRL("Hello, World!"));
+}
+
+static cat_data_t *serve(cat_data_t *data)
+{
+    (void) cat_http_server_run((cat_http_server_t *) data);
+    return NULL;
+}
+
+static cat_data_t *run_native(cat_data_t *data)
+{
+    bench_t *bench = (bench_t *) data;
+    cat_http_client_request_t request;
+    cat_http_client_response_t response;
+    size_t n;
+
+    cat_http_client_request_init(&request);
+    request.path = "/plaintext";
+    request.path_length = CAT_STRLEN("/plaintext");
+    cat_http_client_response_init(&response);
+    for (n = 0; n < bench->requests / bench->concurrency; n++) {
+        if (!cat_http_client_execute(&bench->client, CAT_STRL("127.0.0.1"), bench->port, cat_false, &request, &response) ||
+            response.status != CAT_HTTP_STATUS_OK) {
+            bench->errors++;
+        }
+    }
+    cat_http_client_response_close(&response);
+    (void) cat_sync_wait_group_done(&bench->wg);
+
+    return NULL;
+}
+
+#ifdef CAT_CURL
+static size_t curl_write_function(char *data, size_t size, size_t nmemb, void *userdata)
+{
+    (void) data;
+    (void) userdata;
+    return size * nmemb;
+}
+
+static cat_data_t *run_curl(cat_data_t *data)
+{
+    bench_t *bench = (bench_t *) data;
+    char url[64];
+    CURL *ch;
+    size_t n;
+
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/plaintext", bench->port);
+    ch = curl_easy_init();
+    curl_easy_setopt(ch, CURLOPT_URL, url);
+    curl_easy_setopt(ch, CURLOPT_WRITEFUNCTION, curl_write_function);
+    for (n = 0; n < bench->requests / bench->concurrency; n++) {
+        long status = 0;
+        if (cat_curl_easy_perform(ch) != CURLE_OK ||
+            curl_easy_getinfo(ch, CURLINFO_RESPONSE_CODE, &status) != CURLE_OK || status != 200) {
+            bench->errors++;
+        }
+    }
+    curl_easy_cleanup(ch);
+    (void) cat_sync_wait_group_done(&bench->wg);
+
+    return NULL;
+}
+#endif
+
+static void run_case(bench_t *bench, const char *name, cat_coroutine_function_t function)
+{
+    cat_nsec_t start;
+    size_t i;
+
+    bench->name = name;
+    bench->errors = 0;
+    (void) cat_sync_wait_group_create(&bench->wg);
+    (void) cat_sync_wait_group_add(&bench->wg, bench->concurrency);
+    start = cat_time_nsec();
+    for (i = 0; i < bench->concurrency; i++) {
+        cat_coroutine_run(NULL, function, bench);
+    }
+    (void) cat_sync_wait_group_wait(&bench->wg, CAT_TIMEOUT_FOREVER);
+    printf("%-8s%14.0f%10zu\n", name,
+        (double) (bench->requests / bench->concurrency * bench->concurrency) / ((double) (cat_time_nsec() - start) / 1e9),
+        bench->errors);
+}
+
+int main(int argc, char *argv[])
+{
+    cat_http_server_t server;
+    bench_t bench;
+
+    bench.requests = argc > 1 ? (size_t) atoll(argv[1]) : 20000;
+    bench.concurrency = argc > 2 ? (size_t) atoll(argv[2]) : 16;
+    if (bench.concurrency == 0) {
+        return 1;
+    }
+
+    cat_init_all();
+#ifdef CAT_CURL
+    cat_curl_module_init();
+    cat_curl_runtime_init();
+#endif
+    cat_run(CAT_RUN_EASY);
+
+    if (cat_http_server_create(&server, NULL, handle_request, NULL) == NULL ||
+        !cat_http_server_listen(&server, CAT_STRL("127.0.0.1"), 0)) {
+        fprintf(stderr, "%s\n", cat_get_last_error_message());
+        return 1;
+    }
+    bench.port = cat_http_server_get_port(&server);
+    cat_coroutine_run(NULL, serve, &server);
+
+    printf("%zu requests, concurrency %zu\n", bench.requests, bench.concurrency);
+    printf("%-8s%14s%10s\n", "client", "requests/s", "errors");
+    (void) cat_http_client_create(&bench.client, NULL);
+    run_case(&bench, "native", run_native);
+    cat_http_client_close(&bench.client);
+#ifdef CAT_CURL
+    run_case(&bench, "curl", run_curl);
+#endif
+
+    (void) cat_http_server_shutdown(&server, CAT_TIMEOUT_FOREVER);
+    cat_http_server_close(&server);
+#ifdef CAT_CURL
+    cat_curl_runtime_close();
+    cat_curl_module_shutdown();
+#endif
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+/* benchmark of HTTP/1.1 pipelining, a client keeps `depth` requests in flight on one connection,
+ * the server handles them with cat_http_pipeline, responses of each batch are sent by one writev,
+ * depth 1 is the classic request-response loop
+ * usage: main [requests] */
+
+#include "cat_api.h"
+#include "cat_http.h"
+#include "cat_time.h"
+
+#define HTTP_REQUEST   "GET /plaintext HTTP/1.1\r\nHost: localhost\r\n\r\n"
+#define HTTP_RESPONSE  "HTTP/1.1 200 OK\r\nContent-Length: 13\r\nContent-Type: text/plain\r\n\r\nHello, World!"
+
+static cat_bool_t handle_request(cat_http_pipeline_t *pipeline, void *data)
+{
+    (void) data;
+    return cat_http_pipeline_respond_static(pipeline, CAT_STRL(HTTP_RESPONSE));
+}
+
+static cat_data_t *serve(cat_data_t *data)
+{
+    cat_socket_t *connection = (cat_socket_t *) data;
+    cat_http_pipeline_t pipeline;
+
+    (void) cat_http_pipeline_create(&pipeline);
+    (void) cat_http_pipeline_run(&pipeline, connection, handle_request, NULL);
+    printf("%12zu\n", pipeline.writes);
+    cat_http_pipeline_close(&pipeline);
+    cat_socket_close(connection);
+
+    return NULL;
+}
+
+static void run_case(cat_socket_t *server, int port, size_t requests, size_t depth)
+{
+    cat_socket_t client, *connection;
+    char *batch, *responses;
+    size_t response_length = sizeof(HTTP_RESPONSE) - 1, i, n;
+    cat_nsec_t start;
+
+    batch = (char *) malloc((sizeof(HTTP_REQUEST) - 1) * depth);
+    responses = (char *) malloc(response_length * depth);
+    if (batch == NULL || responses == NULL) {
+        abort();
+    }
+    for (i = 0; i < depth; i++) {
+        memcpy(batch + i * (sizeof(HTTP_REQUEST) - 1), HTTP_REQUEST, sizeof(HTTP_REQUEST) - 1);
+    }
+    connection = cat_socket_create(NULL, CAT_SOCKET_TYPE_TCP);
+    if (cat_socket_create(&client, CAT_SOCKET_TYPE_TCP) == NULL || connection == NULL ||
+        !cat_socket_connect_to(&client, CAT_STRL("127.0.0.1"), port) ||
+        !cat_socket_accept(server, connection)) {
+        abort();
+    }
+    cat_coroutine_run(NULL, serve, connection);
+
+    start = cat_time_nsec();
+    for (n = 0; n < requests; n += depth) {
+        if (!cat_socket_send(&client, batch, (sizeof(HTTP_REQUEST) - 1) * depth) ||
+            cat_socket_read(&client, responses, response_length * depth) != (ssize_t) (response_length * depth)) {
+            abort();
+        }
+    }
+    printf("%8zu%14.0f", depth, (double) n / ((double) (cat_time_nsec() - start) / 1e9));
+
+    cat_socket_close(&client);
+    /* wait for server to print its stats */
+    (void) cat_time_msleep(10);
+    free(batch);
+    free(responses);
+}
+
+int main(int argc, char *argv[])
+{
+    static const size_t depths[] = { 1, 4, 16, 64 };
+    size_t requests = argc > 1 ? (size_t) atoll(argv[1]) : 200000;
+    cat_socket_t server;
+    size_t i;
+    int port;
+
+    cat_init_all();
+    cat_run(CAT_RUN_EASY);
+
+    if (cat_socket_create(&server, CAT_SOCKET_TYPE_TCP) == NULL ||
+        !cat_socket_bind_to(&server, CAT_STRL("127.0.0.1"), 0) ||
+        !cat_socket_listen(&server, 128)) {
+        return 1;
+    }
+    port = cat_socket_get_sock_port(&server);
+    printf("%8s%14s%12s\n", "depth", "requests/s", "writes");
+    for (i = 0; i < CAT_ARRAY_SIZE(depths); i++) {
+        run_case(&server, port, requests, depths[i]);
+    }
+    cat_socket_close(&server);
+
+    return 0;
+}
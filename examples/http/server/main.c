@@ -0,0 +1,78 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+/* HTTP/1.1 server with keep-alive, pipelining and graceful shutdown (on SIGINT)
+ * usage: main [port] */
+
+#include "cat_api.h"
+#include "cat_http_server.h"
+
+static cat_bool_t handle_request(cat_http_server_connection_t *connection, void *data)
+{
+    cat_http_pipeline_t *pipeline = &connection->pipeline;
+    (void) data;
+
+    if (pipeline->url_length == CAT_STRLEN("/echo") && memcmp(pipeline->url, CAT_STRL("/echo")) == 0) {
+        return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, CAT_STRL("application/octet-stream"), pipeline->body, pipeline->body_length);
+    }
+
+    return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, CAT_STRL("text/plain"), CAT_STRL("Hello, World!"));
+}
+
+static cat_data_t *wait_for_shutdown(cat_data_t *data)
+{
+    cat_http_server_t *server = (cat_http_server_t *) data;
+
+    if (cat_signal_wait(SIGINT, CAT_TIMEOUT_FOREVER)) {
+        fprintf(stdout, "Shutting down...\n");
+        if (!cat_http_server_shutdown(server, 5000)) {
+            fprintf(stderr, "%s\n", cat_get_last_error_message());
+        }
+    }
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int port = argc > 1 ? atoi(argv[1]) : 8080;
+    cat_http_server_t server;
+
+    cat_init_all();
+    cat_run(CAT_RUN_EASY);
+
+    if (cat_http_server_create(&server, NULL, handle_request, NULL) == NULL ||
+        !cat_http_server_listen(&server, CAT_STRL("0.0.0.0"), port)) {
+        fprintf(stderr, "%s\n", cat_get_last_error_message());
+        return 1;
+    }
+    fprintf(stdout, "Server is running on 0.0.0.0:%d\n", cat_http_server_get_port(&server));
+    cat_coroutine_run(NULL, wait_for_shutdown, &server);
+    if (!cat_http_server_run(&server)) {
+        fprintf(stderr, "%s\n", cat_get_last_error_message());
+        return 1;
+    }
+    /* wait for shutdown to complete */
+    while (server.connections != 0) {
+        (void) cat_time_msleep(10);
+    }
+    fprintf(stdout, "%zu connections, %zu requests\n", server.accepted, server.requests);
+    cat_http_server_close(&server);
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+/* disabled log benchmark:
+ * 1. micro: cost of a disabled debug log (runtime level check) vs the same one eliminated at compile time,
+ *    and cost of a notice log disabled by cat_log_set_module_types()
+ * 2. end-to-end: in-process TCP echo round trips (socket read/write path has debug logs),
+ *    build libcat with -DLIBCAT_DEBUG_LOG_LEVEL_MAX_MODULES="socket=0" (or -DLIBCAT_DEBUG_LOG_LEVEL_MAX=0)
+ *    to get the baseline of it
+ * usage: main [rounds] [connections] */
+
+#include "cat_api.h"
+#include "cat_socket.h"
+#include "cat_sync.h"
+#include "cat_time.h"
+
+static volatile size_t bench_sink;
+
+static cat_nsec_t bench_runtime_disabled(size_t rounds)
+{
+    cat_nsec_t start = cat_time_nsec();
+    size_t n;
+
+    for (n = 0; n < rounds; n++) {
+        CAT_LOG_DEBUG_VA_WITH_LEVEL(BENCH, 3, {
+            char *tmp;
+            CAT_LOG_D(DEBUG, BENCH, 0, "round %zu, data: %s", n, cat_log_str_quote(CAT_STRL("ping"), &tmp));
+            cat_free(tmp);
+        });
+        bench_sink = n;
+    }
+
+    return cat_time_nsec() - start;
+}
+
+static cat_nsec_t bench_module_disabled(size_t rounds)
+{
+    cat_nsec_t start = cat_time_nsec();
+    size_t n;
+
+    for (n = 0; n < rounds; n++) {
+        CAT_NOTICE(BENCH, "round %zu", n);
+        bench_sink = n;
+    }
+
+    return cat_time_nsec() - start;
+}
+
+#undef CAT_LOG_DEBUG_LEVEL_MAX
+#define CAT_LOG_DEBUG_LEVEL_MAX 0
+
+static cat_nsec_t bench_compile_time_disabled(size_t rounds)
+{
+    cat_nsec_t start = cat_time_nsec();
+    size_t n;
+
+    for (n = 0; n < rounds; n++) {
+        CAT_LOG_DEBUG_VA_WITH_LEVEL(BENCH, 3, {
+            char *tmp;
+            CAT_LOG_D(DEBUG, BENCH, 0, "round %zu, data: %s", n, cat_log_str_quote(CAT_STRL("ping"), &tmp));
+            cat_free(tmp);
+        });
+        bench_sink = n;
+    }
+
+    return cat_time_nsec() - start;
+}
+
+static void bench_micro(size_t rounds)
+{
+    cat_nsec_t runtime_ns, module_ns, compile_time_ns;
+
+    compile_time_ns = bench_compile_time_disabled(rounds);
+    runtime_ns = bench_runtime_disabled(rounds);
+    (void) cat_log_set_module_types("BENCH", CAT_LOG_TYPES_ALL ^ CAT_LOG_TYPE_NOTICE);
+    module_ns = bench_module_disabled(rounds);
+    (void) cat_log_set_module_types("BENCH", CAT_LOG_TYPES_ALL);
+
+    printf("compiled out:     %6.3f ns/op\n", (double) compile_time_ns / rounds);
+    printf("level disabled:   %6.3f ns/op\n", (double) runtime_ns / rounds);
+    printf("module disabled:  %6.3f ns/op\n", (double) module_ns / rounds);
+}
+
+typedef struct bench_echo_s {
+    cat_socket_t server;
+    int port;
+    size_t rounds;
+    cat_sync_wait_group_t wg;
+} bench_echo_t;
+
+static cat_data_t *bench_echo_session(cat_data_t *data)
+{
+    cat_socket_t *client = (cat_socket_t *) data;
+    char buffer[64];
+    ssize_t n;
+
+    while ((n = cat_socket_recv(client, buffer, sizeof(buffer))) > 0) {
+        if (!cat_socket_send(client, buffer, n)) {
+            break;
+        }
+    }
+    cat_socket_close(client);
+    cat_free(client);
+
+    return NULL;
+}
+
+static cat_data_t *bench_echo_server(cat_data_t *data)
+{
+    bench_echo_t *bench = (bench_echo_t *) data;
+
+    while (1) {
+        cat_socket_t *client = (cat_socket_t *) cat_malloc(sizeof(*client));
+        if (cat_socket_create(client, CAT_SOCKET_TYPE_TCP) == NULL) {
+            cat_free(client);
+            break;
+        }
+        if (!cat_socket_accept_ex(&bench->server, client, CAT_TIMEOUT_FOREVER)) {
+            cat_socket_close(client);
+            cat_free(client);
+            break;
+        }
+        cat_coroutine_run(NULL, bench_echo_session, client);
+    }
+
+    return NULL;
+}
+
+static cat_data_t *bench_echo_client(cat_data_t *data)
+{
+    bench_echo_t *bench = (bench_echo_t *) data;
+    cat_socket_t socket;
+    char buffer[64];
+    size_t n;
+
+    if (cat_socket_create(&socket, CAT_SOCKET_TYPE_TCP) != NULL) {
+        if (cat_socket_connect_to(&socket, CAT_STRL("127.0.0.1"), bench->port)) {
+            for (n = 0; n < bench->rounds; n++) {
+                if (!cat_socket_send(&socket, CAT_STRL("ping")) ||
+                    cat_socket_read(&socket, buffer, 4) != 4) {
+                    break;
+                }
+            }
+        }
+        cat_socket_close(&socket);
+    }
+    cat_sync_wait_group_done(&bench->wg);
+
+    return NULL;
+}
+
+static void bench_end_to_end(size_t rounds, size_t connections)
+{
+    bench_echo_t bench;
+    cat_nsec_t start, elapsed;
+    size_t i;
+
+    cat_socket_create(&bench.server, CAT_SOCKET_TYPE_TCP);
+    if (!cat_socket_bind_to(&bench.server, CAT_STRL("127.0.0.1"), 0) || !cat_socket_listen(&bench.server, 512)) {
+        fprintf(stderr, "Listen failed: %s\n", cat_get_last_error_message());
+        return;
+    }
+    bench.port = cat_socket_get_sock_port(&bench.server);
+    bench.rounds = rounds;
+    cat_sync_wait_group_create(&bench.wg);
+    cat_coroutine_run(NULL, bench_echo_server, &bench);
+
+    start = cat_time_nsec();
+    cat_sync_wait_group_add(&bench.wg, connections);
+    for (i = 0; i < connections; i++) {
+        cat_coroutine_run(NULL, bench_echo_client, &bench);
+    }
+    cat_sync_wait_group_wait(&bench.wg, CAT_TIMEOUT_FOREVER);
+    elapsed = cat_time_nsec() - start;
+    cat_socket_close(&bench.server);
+
+    /* each round trip is 2 writes and 2 reads */
+    printf("echo: %zu connections x %zu round trips in %.3f s, %.1f ns per read/write\n",
+        connections, rounds, (double) elapsed / 1e9,
+        (double) elapsed / (connections * rounds * 4));
+}
+
+int main(int argc, char *argv[])
+{
+    size_t rounds = argc > 1 ? (size_t) atoll(argv[1]) : 10000000;
+    size_t connections = argc > 2 ? (size_t) atoll(argv[2]) : 64;
+
+    cat_init_all();
+    cat_run(CAT_RUN_EASY);
+
+    bench_micro(rounds);
+    bench_end_to_end(rounds / 1000, connections);
+
+    cat_stop();
+    cat_shutdown_all();
+
+    return 0;
+}
@@ -0,0 +1,196 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+/* slab allocator benchmark:
+ * 1. micro: alloc/free loops of cat_malloc() vs cat_slab_alloc() for typical internal object sizes
+ * 2. end-to-end: in-process TCP echo round trips (timers, write requests and defer tasks go through slab),
+ *    build libcat with -DCAT_SLAB_USE_SYS_MALLOC to get the baseline of it
+ * usage: main [rounds] [connections] */
+
+#include "cat_api.h"
+#include "cat_socket.h"
+#include "cat_sync.h"
+#include "cat_time.h"
+
+#define BENCH_BATCH 64
+
+static const size_t bench_sizes[] = { 48, 160, 200, 352 };
+
+static void bench_micro(size_t rounds)
+{
+    void *ptrs[BENCH_BATCH];
+    size_t i, n, k;
+
+    for (i = 0; i < CAT_ARRAY_SIZE(bench_sizes); i++) {
+        size_t size = bench_sizes[i];
+        cat_nsec_t start, malloc_ns, slab_ns;
+        start = cat_time_nsec();
+        for (n = 0; n < rounds; n++) {
+            for (k = 0; k < BENCH_BATCH; k++) {
+                ptrs[k] = cat_malloc(size);
+                *((volatile char *) ptrs[k]) = 0;
+            }
+            for (k = 0; k < BENCH_BATCH; k++) {
+                cat_free(ptrs[k]);
+            }
+        }
+        malloc_ns = cat_time_nsec() - start;
+        start = cat_time_nsec();
+        for (n = 0; n < rounds; n++) {
+            for (k = 0; k < BENCH_BATCH; k++) {
+                ptrs[k] = cat_slab_alloc(size);
+                *((volatile char *) ptrs[k]) = 0;
+            }
+            for (k = 0; k < BENCH_BATCH; k++) {
+                cat_slab_free(ptrs[k], size);
+            }
+        }
+        slab_ns = cat_time_nsec() - start;
+        printf("size %4zu: malloc %6.2f ns/op, slab %6.2f ns/op\n", size,
+            (double) malloc_ns / (rounds * BENCH_BATCH),
+            (double) slab_ns / (rounds * BENCH_BATCH));
+    }
+}
+
+typedef struct bench_echo_s {
+    cat_socket_t server;
+    int port;
+    size_t rounds;
+    cat_sync_wait_group_t wg;
+} bench_echo_t;
+
+static cat_data_t *bench_echo_session(cat_data_t *data)
+{
+    cat_socket_t *client = (cat_socket_t *) data;
+    char buffer[64];
+    ssize_t n;
+
+    while ((n = cat_socket_recv(client, buffer, sizeof(buffer))) > 0) {
+        if (!cat_socket_send(client, buffer, n)) {
+            break;
+        }
+    }
+    cat_socket_close(client);
+    cat_free(client);
+
+    return NULL;
+}
+
+static cat_data_t *bench_echo_server(cat_data_t *data)
+{
+    bench_echo_t *bench = (bench_echo_t *) data;
+
+    while (1) {
+        cat_socket_t *client = (cat_socket_t *) cat_malloc(sizeof(*client));
+        if (cat_socket_create(client, CAT_SOCKET_TYPE_TCP) == NULL) {
+            cat_free(client);
+            break;
+        }
+        if (!cat_socket_accept_ex(&bench->server, client, CAT_TIMEOUT_FOREVER)) {
+            cat_socket_close(client);
+            cat_free(client);
+            break;
+        }
+        cat_coroutine_run(NULL, bench_echo_session, client);
+    }
+
+    return NULL;
+}
+
+static cat_data_t *bench_echo_client(cat_data_t *data)
+{
+    bench_echo_t *bench = (bench_echo_t *) data;
+    cat_socket_t socket;
+    char buffer[64];
+    size_t n;
+
+    if (cat_socket_create(&socket, CAT_SOCKET_TYPE_TCP) != NULL) {
+        if (cat_socket_connect_to(&socket, CAT_STRL("127.0.0.1"), bench->port)) {
+            for (n = 0; n < bench->rounds; n++) {
+                if (!cat_socket_send(&socket, CAT_STRL("ping")) ||
+                    cat_socket_read(&socket, buffer, 4) != 4) {
+                    break;
+                }
+            }
+        }
+        cat_socket_close(&socket);
+    }
+    cat_sync_wait_group_done(&bench->wg);
+
+    return NULL;
+}
+
+static void bench_end_to_end(size_t rounds, size_t connections)
+{
+    bench_echo_t bench;
+    cat_nsec_t start, elapsed;
+    size_t i;
+
+    cat_socket_create(&bench.server, CAT_SOCKET_TYPE_TCP);
+    if (!cat_socket_bind_to(&bench.server, CAT_STRL("127.0.0.1"), 0) || !cat_socket_listen(&bench.server, 512)) {
+        fprintf(stderr, "Listen failed: %s\n", cat_get_last_error_message());
+        return;
+    }
+    bench.port = cat_socket_get_sock_port(&bench.server);
+    bench.rounds = rounds;
+    cat_sync_wait_group_create(&bench.wg);
+    cat_coroutine_run(NULL, bench_echo_server, &bench);
+
+    start = cat_time_nsec();
+    cat_sync_wait_group_add(&bench.wg, connections);
+    for (i = 0; i < connections; i++) {
+        cat_coroutine_run(NULL, bench_echo_client, &bench);
+    }
+    cat_sync_wait_group_wait(&bench.wg, CAT_TIMEOUT_FOREVER);
+    elapsed = cat_time_nsec() - start;
+    cat_socket_close(&bench.server);
+
+    printf("echo (%s): %zu connections x %zu round trips in %.3f s, %.0f round trips/s\n",
+#ifdef CAT_SLAB_USE_SYS_MALLOC
+        "system allocator",
+#else
+        "slab",
+#endif
+        connections, rounds, (double) elapsed / 1e9,
+        (double) (connections * rounds) / ((double) elapsed / 1e9));
+    for (i = 0; i < CAT_SLAB_CLASS_COUNT; i++) {
+        const cat_slab_stats_t *stats = cat_slab_get_stats(i);
+        if (stats->allocs == 0) {
+            continue;
+        }
+        printf("  class %3zu: allocs %" PRIu64 ", in use %zu, peak %zu, cached %zu, pages %zu\n",
+            stats->size, stats->allocs, stats->in_use, stats->peak, stats->cached, stats->pages);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t rounds = argc > 1 ? (size_t) atoll(argv[1]) : 100000;
+    size_t connections = argc > 2 ? (size_t) atoll(argv[2]) : 64;
+
+    cat_init_all();
+    cat_run(CAT_RUN_EASY);
+
+    bench_micro(rounds);
+    bench_end_to_end(rounds / 10, connections);
+
+    cat_stop();
+    cat_shutdown_all();
+
+    return 0;
+}
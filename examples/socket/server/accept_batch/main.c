@@ -0,0 +1,125 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+/* connections-per-second benchmark of cat_socket_accept() vs cat_socket_accept_batch()
+ * usage: main [batch|single] [duration_ms] [concurrency] */
+
+#include "cat_api.h"
+#include "cat_time.h"
+
+#define ACCEPT_BATCH_SIZE 64
+
+static cat_bool_t use_batch = cat_true;
+static cat_bool_t running = cat_true;
+static int server_port;
+static size_t accepted_count;
+static size_t connected_count;
+
+static cat_data_t *server_run(cat_data_t *data)
+{
+    cat_socket_t *server = (cat_socket_t *) data;
+    cat_socket_t connections[ACCEPT_BATCH_SIZE];
+    size_t slots = use_batch ? ACCEPT_BATCH_SIZE : 1;
+
+    while (running) {
+        ssize_t n;
+        size_t i;
+        for (i = 0; i < slots; i++) {
+            if (cat_socket_create(&connections[i], CAT_SOCKET_TYPE_TCP) == NULL) {
+                exit(1);
+            }
+        }
+        if (use_batch) {
+            n = cat_socket_accept_batch(server, connections, slots);
+        } else {
+            n = cat_socket_accept(server, &connections[0]) ? 1 : -1;
+        }
+        /* close accepted connections and unused lazy sockets */
+        for (i = 0; i < slots; i++) {
+            cat_socket_close(&connections[i]);
+        }
+        if (n < 0) {
+            break;
+        }
+        accepted_count += (size_t) n;
+    }
+
+    return NULL;
+}
+
+static cat_data_t *client_run(cat_data_t *data)
+{
+    (void) data;
+
+    while (running) {
+        cat_socket_t client;
+        if (cat_socket_create(&client, CAT_SOCKET_TYPE_TCP) == NULL) {
+            exit(1);
+        }
+        if (cat_socket_connect_to(&client, CAT_STRL("127.0.0.1"), server_port)) {
+            connected_count++;
+        }
+        cat_socket_close(&client);
+    }
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    cat_socket_t server;
+    cat_msec_t duration = 3000, start, elapsed;
+    int concurrency = 128, i;
+
+    if (argc > 1) {
+        use_batch = strcmp(argv[1], "single") != 0;
+    }
+    if (argc > 2) {
+        duration = (cat_msec_t) atoi(argv[2]);
+    }
+    if (argc > 3) {
+        concurrency = atoi(argv[3]);
+    }
+
+    cat_init_all();
+    cat_run(CAT_RUN_EASY);
+
+    if (cat_socket_create(&server, CAT_SOCKET_TYPE_TCP) == NULL ||
+        !cat_socket_bind_to(&server, CAT_STRL("127.0.0.1"), 0) ||
+        !cat_socket_listen(&server, 8192)) {
+        fprintf(stderr, "Server failed: %s\n", cat_get_last_error_message());
+        exit(1);
+    }
+    server_port = cat_socket_get_sock_port(&server);
+
+    cat_coroutine_run(NULL, server_run, &server);
+    for (i = 0; i < concurrency; i++) {
+        cat_coroutine_run(NULL, client_run, NULL);
+    }
+    start = cat_time_msec();
+    cat_time_msleep(duration);
+    running = cat_false;
+    elapsed = cat_time_msec() - start;
+    cat_socket_close(&server);
+
+    printf("mode: %s, concurrency: %d, connected: %zu, accepted: %zu, %.0f conn/s\n",
+        use_batch ? "batch" : "single", concurrency, connected_count, accepted_count,
+        (double) accepted_count * 1000 / (double) (elapsed > 0 ? elapsed : 1));
+
+    return 0;
+}
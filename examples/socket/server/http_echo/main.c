@@ -20,7 +20,6 @@
 #include "cat_http.h"
 
 #define HTTP_REQUEST_MAX_LENGTH              (2 * 1024 * 1024)
-#define HTTP_EMPTY_RESPONSE                  "HTTP/1.1 200 OK\r\nConnection: keep-alive\r\nContent-Length: 0\r\n\r\n"
 #define HTTP_SERVICE_UNAVAILABLE_RESPONSE    "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n"
 
 static cat_data_t *echo_server_handle_connection(cat_data_t *data)
@@ -65,23 +64,13 @@ static cat_data_t *echo_server_handle_connection(cat_data_t *data)
                 }
             }
             if (cat_http_parser_is_completed(&parser)) {
-                if (body_length == 0) {
-                    (void) cat_socket_send(connection, CAT_STRL(HTTP_EMPTY_RESPONSE));
-                } else {
-                    char *response = cat_sprintf(
-                        "HTTP/1.1 200 OK\r\n"
-                        "Connection: keep-alive\r\n"
-                        "Content-Length: %zu\r\n\r\n"
-                        "%.*s",
-                        body_length,
-                        (int) body_length,
-                        body_begin ? body_begin : ""
-                    );
-                    if (unlikely(response == NULL)) {
-                        goto _error;
-                    }
-                    (void) cat_socket_send(connection, response, strlen(response));
-                }
+                cat_http_response_writer_t writer;
+                cat_http_response_writer_init(&writer, CAT_HTTP_STATUS_OK);
+                (void) cat_http_response_writer_add_header_line(&writer, CAT_STRL("Connection: keep-alive\r\n"));
+                (void) cat_http_response_writer_add_date(&writer);
+                (void) cat_http_response_writer_add_content_length(&writer, body_length);
+                (void) cat_http_response_writer_end(&writer, body_begin, body_length);
+                (void) cat_http_response_writer_write(&writer, connection);
                 break;
             }
         }
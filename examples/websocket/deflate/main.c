@@ -0,0 +1,161 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+/* throughput and memory benchmark of permessage-deflate,
+ * compares context takeover, no context takeover and no context takeover with a shared pool,
+ * memory is the zlib state retained by each idle connection after one message
+ * usage: main [total_bytes_per_case] [connections] */
+
+#include "cat_api.h"
+#include "cat_websocket_deflate.h"
+#include "cat_time.h"
+
+#ifdef CAT_WEBSOCKET_DEFLATE
+
+typedef struct {
+    const char *name;
+    cat_bool_t no_context_takeover;
+    cat_bool_t use_pool;
+} deflate_case_t;
+
+static const deflate_case_t cases[] = {
+    { "takeover", cat_false, cat_false },
+    { "no-takeover", cat_true, cat_false },
+    { "no-takeover+pool", cat_true, cat_true },
+};
+
+static const size_t sizes[] = { 128, 4 * 1024, 64 * 1024 };
+
+static char *make_message(size_t size)
+{
+    char *message = (char *) malloc(size + 64);
+    size_t length = 0;
+    unsigned int i = 0;
+
+    if (message == NULL) {
+        abort();
+    }
+    while (length < size) {
+        length += snprintf(message + length, 64, "{\"id\":%u,\"name\":\"libcat\",\"ok\":true},", i++);
+    }
+
+    return message;
+}
+
+static void run_case(const deflate_case_t *c, size_t size, size_t total, size_t connections)
+{
+    cat_websocket_deflate_parameters_t parameters;
+    cat_websocket_deflate_options_t options;
+    cat_websocket_deflate_pool_t pool;
+    cat_websocket_deflate_t server, client, *idle;
+    cat_buffer_t compressed, decompressed;
+    size_t rounds = total / size, n, memory = 0;
+    cat_nsec_t start, compress_time = 0, decompress_time = 0;
+    char *message = make_message(size);
+
+    cat_websocket_deflate_parameters_init(&parameters);
+    parameters.server_no_context_takeover = c->no_context_takeover;
+    parameters.client_no_context_takeover = c->no_context_takeover;
+    cat_websocket_deflate_options_init(&options);
+    if (c->use_pool) {
+        (void) cat_websocket_deflate_pool_create(&pool, 64);
+        options.pool = &pool;
+    }
+    (void) cat_websocket_deflate_create(&server, &parameters, cat_true, &options);
+    (void) cat_websocket_deflate_create(&client, &parameters, cat_false, &options);
+    (void) cat_buffer_create(&compressed, size);
+    (void) cat_buffer_create(&decompressed, size);
+
+    for (n = 0; n < rounds; n++) {
+        compressed.length = 0;
+        decompressed.length = 0;
+        start = cat_time_nsec();
+        if (!cat_websocket_deflate_compress(&server, message, size, cat_true, &compressed)) {
+            abort();
+        }
+        compress_time += cat_time_nsec() - start;
+        start = cat_time_nsec();
+        if (!cat_websocket_deflate_decompress(&client, compressed.value, compressed.length, cat_true, &decompressed)) {
+            abort();
+        }
+        decompress_time += cat_time_nsec() - start;
+    }
+
+    /* idle connections after one message in each direction */
+    idle = (cat_websocket_deflate_t *) malloc(sizeof(*idle) * connections);
+    if (idle == NULL) {
+        abort();
+    }
+    for (n = 0; n < connections; n++) {
+        (void) cat_websocket_deflate_create(&idle[n], &parameters, cat_true, &options);
+        compressed.length = 0;
+        (void) cat_websocket_deflate_compress(&idle[n], message, size, cat_true, &compressed);
+        decompressed.length = 0;
+        (void) cat_websocket_deflate_decompress(&idle[n], compressed.value, compressed.length, cat_true, &decompressed);
+        memory += cat_websocket_deflate_get_memory_usage(&idle[n]);
+    }
+
+    printf("%-18s %8zu %8.3f %12.1f %12.1f %12zu\n", c->name, size,
+        (double) compressed.length / size,
+        (double) (rounds * size) / 1e6 / ((double) compress_time / 1e9),
+        (double) (rounds * size) / 1e6 / ((double) decompress_time / 1e9),
+        memory / connections);
+
+    for (n = 0; n < connections; n++) {
+        cat_websocket_deflate_close(&idle[n]);
+    }
+    free(idle);
+    cat_buffer_close(&compressed);
+    cat_buffer_close(&decompressed);
+    cat_websocket_deflate_close(&server);
+    cat_websocket_deflate_close(&client);
+    if (c->use_pool) {
+        cat_websocket_deflate_pool_close(&pool);
+    }
+    free(message);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t total = argc > 1 ? (size_t) atoll(argv[1]) : (size_t) 64 * 1024 * 1024;
+    size_t connections = argc > 2 ? (size_t) atoll(argv[2]) : 1000;
+    size_t i, j;
+
+    cat_init_all();
+
+    printf("%-18s %8s %8s %12s %12s %12s\n", "case", "size", "ratio", "deflate MB/s", "inflate MB/s", "idle bytes");
+    for (i = 0; i < CAT_ARRAY_SIZE(cases); i++) {
+        for (j = 0; j < CAT_ARRAY_SIZE(sizes); j++) {
+            run_case(&cases[i], sizes[j], total, connections);
+        }
+    }
+
+    cat_shutdown_all();
+
+    return 0;
+}
+
+#else
+
+int main(void)
+{
+    fprintf(stderr, "zlib is not enabled\n");
+    return 1;
+}
+
+#endif
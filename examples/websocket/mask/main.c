@@ -0,0 +1,77 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+/* throughput benchmark of cat_websocket_unmask() over frame sizes from 16B to 1MiB,
+ * the byte-by-byte loop is shown for reference
+ * usage: main [total_bytes_per_size] */
+
+#include "cat_api.h"
+#include "cat_websocket.h"
+#include "cat_time.h"
+
+#define MASK_MIN_SIZE 16
+#define MASK_MAX_SIZE (1024 * 1024)
+
+static void mask_bytewise(char *data, uint64_t length, const char *masking_key)
+{
+    uint64_t i;
+
+    for (i = 0; i < length; i++) {
+        data[i] ^= masking_key[i & (CAT_WEBSOCKET_MASKING_KEY_LENGTH - 1)];
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *masking_key = "\x12\x34\x56\x78";
+    size_t total = argc > 1 ? (size_t) atoll(argv[1]) : (size_t) 1024 * 1024 * 1024;
+    size_t size;
+    char *buffer;
+
+    buffer = (char *) malloc(MASK_MAX_SIZE + 1);
+    if (buffer == NULL) {
+        return 1;
+    }
+    memset(buffer, 'x', MASK_MAX_SIZE + 1);
+
+    printf("kernel: %s\n", cat_websocket_mask_get_kernel_name());
+    printf("%10s %14s %14s\n", "size", "unmask MB/s", "bytewise MB/s");
+    for (size = MASK_MIN_SIZE; size <= MASK_MAX_SIZE; size *= 2) {
+        size_t rounds = total / size, n;
+        cat_nsec_t start, unmask_time, bytewise_time;
+        /* +1 to make data unaligned as it is in a frame */
+        char *data = buffer + 1;
+
+        start = cat_time_nsec();
+        for (n = 0; n < rounds; n++) {
+            cat_websocket_unmask(data, size, masking_key);
+        }
+        unmask_time = cat_time_nsec() - start;
+        start = cat_time_nsec();
+        for (n = 0; n < rounds; n++) {
+            mask_bytewise(data, size, masking_key);
+        }
+        bytewise_time = cat_time_nsec() - start;
+        printf("%10zu %14.1f %14.1f\n", size,
+            (double) (rounds * size) / 1e6 / ((double) unmask_time / 1e9),
+            (double) (rounds * size) / 1e6 / ((double) bytewise_time / 1e9));
+    }
+    free(buffer);
+
+    return 0;
+}
@@ -82,6 +82,7 @@ CAT_GLOBALS_STRUCT_BEGIN(cat) {
     cat_error_t last_error;
     cat_const_string_t exepath;
     cat_log_globals_t log_globals;
+    cat_slab_globals_t slab_globals;
 } CAT_GLOBALS_STRUCT_END(cat);
 
 extern CAT_API CAT_GLOBALS_DECLARE(cat);
@@ -90,6 +91,8 @@ extern CAT_API CAT_GLOBALS_DECLARE(cat);
 
 #define CAT_LOG_G(x) CAT_G(log_globals).x
 
+#define CAT_SLAB_G(x) CAT_G(slab_globals).x
+
 /* special constants */
 
 #define CAT_MAGIC_NUMBER 9764
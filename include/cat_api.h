@@ -33,6 +33,8 @@ extern "C" {
 #include "cat_dns.h"
 #include "cat_work.h"
 #include "cat_buffer.h"
+#include "cat_buf_chain.h"
+#include "cat_trace.h"
 #include "cat_fs.h"
 #include "cat_signal.h"
 #include "cat_os_wait.h"
@@ -40,6 +42,7 @@ extern "C" {
 #include "cat_watchdog.h"
 #include "cat_process.h"
 #include "cat_ssl.h"
+#include "cat_http.h"
 
 typedef enum cat_run_mode_e{
     CAT_RUN_EASY = 0,
@@ -0,0 +1,121 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#ifndef CAT_BUF_CHAIN_H
+#define CAT_BUF_CHAIN_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cat.h"
+#include "cat_queue.h"
+#include "cat_ref.h"
+#include "cat_socket.h"
+
+/* buf chain (rope): a list of slices over refcounted fixed-size blocks,
+ * appending never moves existing data, and slices can be shared by many chains without copy
+ * (e.g. broadcast one response to many sockets, or forward the received data as-is);
+ * data of a block below its used mark is immutable, only the chain whose last slice
+ * ends at the mark can append in place, the others start a new block;
+ * prepare() reserves the rest of the block (used mark is moved to the end) until commit(),
+ * so that the other chains can not append to it while the caller is waiting for data */
+
+#ifndef CAT_BUF_BLOCK_SIZE
+#define CAT_BUF_BLOCK_SIZE (16 * 1024) /* including the header */
+#endif
+
+/* max number of free blocks cached by the pool */
+#ifndef CAT_BUF_BLOCK_POOL_SIZE
+#define CAT_BUF_BLOCK_POOL_SIZE 256
+#endif
+
+typedef struct cat_buf_block_s cat_buf_block_t;
+
+struct cat_buf_block_s {
+    CAT_REF_FIELD;
+    uint32_t size; /* capacity of data */
+    uint32_t used;
+    cat_buf_block_t *next; /* in pool */
+    char data[1];
+};
+
+#define CAT_BUF_BLOCK_CAPACITY ((uint32_t) (CAT_BUF_BLOCK_SIZE - offsetof(cat_buf_block_t, data)))
+
+typedef struct cat_buf_slice_s {
+    cat_queue_node_t node;
+    cat_buf_block_t *block;
+    uint32_t offset;
+    uint32_t length;
+} cat_buf_slice_t;
+
+typedef struct cat_buf_chain_s {
+    /* public readonly */
+    size_t length;
+    uint32_t count; /* number of slices */
+    /* private */
+    cat_queue_t slices;
+    /* slice which owns the space reserved by prepare() */
+    cat_buf_slice_t *pending;
+    uint32_t pending_length;
+} cat_buf_chain_t;
+
+CAT_GLOBALS_STRUCT_BEGIN(cat_buf_chain) {
+    cat_buf_block_t *pool;
+    uint32_t pool_count;
+    uint32_t pool_size;
+} CAT_GLOBALS_STRUCT_END(cat_buf_chain);
+
+extern CAT_API CAT_GLOBALS_DECLARE(cat_buf_chain);
+
+#define CAT_BUF_CHAIN_G(x) CAT_GLOBALS_GET(cat_buf_chain, x)
+
+CAT_API cat_bool_t cat_buf_chain_module_init(void);
+CAT_API cat_bool_t cat_buf_chain_module_shutdown(void);
+CAT_API cat_bool_t cat_buf_chain_runtime_init(void);
+CAT_API cat_bool_t cat_buf_chain_runtime_shutdown(void);
+
+CAT_API void cat_buf_chain_init(cat_buf_chain_t *chain);
+/* release all slices, chain can be reused after that */
+CAT_API void cat_buf_chain_clear(cat_buf_chain_t *chain);
+#define cat_buf_chain_close cat_buf_chain_clear
+
+/* copy data to the tail (filling up the last block first) */
+CAT_API cat_bool_t cat_buf_chain_append(cat_buf_chain_t *chain, const char *data, size_t length);
+/* append a view of [offset, offset + length) of src without copy (blocks are shared),
+ * length can be SIZE_MAX which means till the end */
+CAT_API cat_bool_t cat_buf_chain_append_ref(cat_buf_chain_t *chain, const cat_buf_chain_t *src, size_t offset, size_t length);
+/* zero-copy receiving: get writable space at the tail (at least 1 byte, it may start a new block),
+ * then commit how many bytes have been written to it (the rest of the space is given back);
+ * prepare() again before commit() returns the same space */
+CAT_API char *cat_buf_chain_prepare(cat_buf_chain_t *chain, size_t *available);
+CAT_API cat_bool_t cat_buf_chain_commit(cat_buf_chain_t *chain, size_t length);
+/* drop data from the head (e.g. it has been sent) */
+CAT_API void cat_buf_chain_consume(cat_buf_chain_t *chain, size_t length);
+
+/* fill vectors from the head, returns number of vectors (at most max_count) */
+CAT_API unsigned int cat_buf_chain_get_vectors(const cat_buf_chain_t *chain, cat_socket_write_vector_t *vectors, unsigned int max_count);
+/* writev all data of chain to socket (chain is not consumed) */
+CAT_API cat_bool_t cat_buf_chain_write(const cat_buf_chain_t *chain, cat_socket_t *socket);
+CAT_API cat_bool_t cat_buf_chain_write_ex(const cat_buf_chain_t *chain, cat_socket_t *socket, cat_timeout_t timeout);
+/* copy [offset, offset + length) to buffer, returns bytes copied */
+CAT_API size_t cat_buf_chain_copy(const cat_buf_chain_t *chain, size_t offset, char *buffer, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAT_BUF_CHAIN_H */
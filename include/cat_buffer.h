@@ -47,7 +47,77 @@ typedef struct cat_buffer_allocator_s {
 
 extern CAT_API cat_buffer_allocator_t cat_buffer_allocator;
 
+/* pool: the default allocator, values are rounded up to power-of-two size classes
+ * and recycled by per-runtime free lists, each class caches at most
+ * CAT_BUFFER_POOL_CLASS_MAX_BYTES (and CAT_BUFFER_POOL_CLASS_MAX_COUNT) of them,
+ * cached values which have not been reused for a whole CAT_BUFFER_POOL_TRIM_INTERVAL are released,
+ * values larger than CAT_BUFFER_POOL_MAX_SIZE fall back to cat_malloc(),
+ * CAT_BUFFER_USE_SYS_MALLOC registers the plain malloc allocator instead (e.g. for ASan) */
+
+#define CAT_BUFFER_POOL_MIN_SHIFT   4  /* 16 */
+#define CAT_BUFFER_POOL_MAX_SHIFT   16 /* 64K */
+#define CAT_BUFFER_POOL_MIN_SIZE    (1 << CAT_BUFFER_POOL_MIN_SHIFT)
+#define CAT_BUFFER_POOL_MAX_SIZE    (1 << CAT_BUFFER_POOL_MAX_SHIFT)
+#define CAT_BUFFER_POOL_CLASS_COUNT (CAT_BUFFER_POOL_MAX_SHIFT - CAT_BUFFER_POOL_MIN_SHIFT + 1)
+
+#ifndef CAT_BUFFER_POOL_CLASS_MAX_BYTES
+#define CAT_BUFFER_POOL_CLASS_MAX_BYTES (512 * 1024)
+#endif
+
+#ifndef CAT_BUFFER_POOL_CLASS_MAX_COUNT
+#define CAT_BUFFER_POOL_CLASS_MAX_COUNT 64
+#endif
+
+#ifndef CAT_BUFFER_POOL_TRIM_INTERVAL
+#define CAT_BUFFER_POOL_TRIM_INTERVAL (10 * 1000) /* ms */
+#endif
+
+#if !defined(CAT_BUFFER_USE_SYS_MALLOC) && defined(CAT_HAVE_ASAN)
+#define CAT_BUFFER_USE_SYS_MALLOC 1
+#endif
+
+typedef struct cat_buffer_pool_stats_s {
+    size_t size; /* capacity of the class */
+    uint64_t allocs;
+    uint64_t frees;
+    size_t in_use;
+    size_t peak;
+    size_t cached;
+    size_t max_cached;
+    uint64_t trimmed;
+} cat_buffer_pool_stats_t;
+
+typedef struct cat_buffer_pool_object_s cat_buffer_pool_object_t;
+
+typedef struct cat_buffer_pool_class_s {
+    cat_buffer_pool_object_t *free_list;
+    size_t low_cached; /* min cached since last trim */
+    cat_buffer_pool_stats_t stats;
+} cat_buffer_pool_class_t;
+
+CAT_GLOBALS_STRUCT_BEGIN(cat_buffer) {
+    cat_bool_t pool_enabled;
+    cat_buffer_pool_class_t pool_classes[CAT_BUFFER_POOL_CLASS_COUNT];
+    uv_timer_t pool_trim_timer;
+} CAT_GLOBALS_STRUCT_END(cat_buffer);
+
+extern CAT_API CAT_GLOBALS_DECLARE(cat_buffer);
+
+#define CAT_BUFFER_G(x) CAT_GLOBALS_GET(cat_buffer, x)
+
 CAT_API cat_bool_t cat_buffer_module_init(void);
+CAT_API cat_bool_t cat_buffer_module_shutdown(void);
+CAT_API cat_bool_t cat_buffer_runtime_init(void);
+CAT_API cat_bool_t cat_buffer_runtime_shutdown(void);
+
+/* allocator functions of the pool */
+CAT_API char *cat_buffer_pool_alloc(size_t size);
+CAT_API char *cat_buffer_pool_realloc(char *old_value, size_t new_size);
+CAT_API void cat_buffer_pool_free(char *value);
+/* release all cached values */
+CAT_API void cat_buffer_pool_trim(void);
+/* index is in [0, CAT_BUFFER_POOL_CLASS_COUNT) */
+CAT_API const cat_buffer_pool_stats_t *cat_buffer_pool_get_stats(size_t index);
 
 CAT_API cat_bool_t cat_buffer_register_allocator(const cat_buffer_allocator_t *allocator);
 
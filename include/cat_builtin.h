@@ -197,6 +197,17 @@
 # define CAT_DESTRUCTOR
 #endif
 
+/* it should be placed before the declaration */
+#if defined(__GNUC__)
+# define CAT_ALIGNED(n) __attribute__((aligned(n)))
+#elif defined(_MSC_VER)
+# define CAT_ALIGNED(n) __declspec(align(n))
+#else
+# define CAT_ALIGNED(n)
+#endif
+
+#define CAT_CACHE_LINE_SIZE 64
+
 /* function special suffix */
 
 #define CAT_INTERNAL   /* The API is designed for internal use, it is not recommended unless there are special circumstances */
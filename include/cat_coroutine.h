@@ -24,6 +24,7 @@ extern "C" {
 
 #include "cat.h"
 #include "cat_queue.h"
+#include "cat_atomic.h"
 
 #define CAT_COROUTINE_MIN_STACK_SIZE            (128UL * 1024UL)
 #define CAT_COROUTINE_RECOMMENDED_STACK_SIZE    (256UL * 1024UL)
@@ -108,6 +109,32 @@ typedef uint32_t cat_coroutine_stack_size_t;
 
 typedef cat_data_t *(*cat_coroutine_function_t)(cat_data_t *data);
 
+/* arena: short-lived allocations of coroutine are carved from pooled chunks,
+ * and they are released in bulk when coroutine finished (or arena is reset) */
+
+#ifndef CAT_COROUTINE_ARENA_CHUNK_SIZE
+#define CAT_COROUTINE_ARENA_CHUNK_SIZE (16 * 1024)
+#endif
+/* allocations larger than it get their own chunks if they do not fit in the current one */
+#define CAT_COROUTINE_ARENA_LARGE_SIZE (CAT_COROUTINE_ARENA_CHUNK_SIZE / 4)
+/* max number of free chunks cached by the pool */
+#ifndef CAT_COROUTINE_ARENA_POOL_SIZE
+#define CAT_COROUTINE_ARENA_POOL_SIZE 64
+#endif
+
+typedef struct cat_coroutine_arena_chunk_s cat_coroutine_arena_chunk_t;
+
+struct cat_coroutine_arena_chunk_s {
+    cat_coroutine_arena_chunk_t *next;
+    size_t size;
+};
+
+typedef struct cat_coroutine_arena_s {
+    cat_coroutine_arena_chunk_t *chunk;
+    char *pos;
+    char *end;
+} cat_coroutine_arena_t;
+
 typedef struct cat_coroutine_s cat_coroutine_t;
 
 struct cat_coroutine_s
@@ -132,6 +159,7 @@ struct cat_coroutine_s
     cat_coroutine_function_t function;
     cat_coroutine_stack_size_t stack_size;
     /* internal properties (inaccessible) */
+    cat_coroutine_arena_t arena;
 #ifdef CAT_COROUTINE_USE_USER_STACK
     uint32_t virtual_memory_size;
     void *virtual_memory;
@@ -164,6 +192,20 @@ typedef void (*cat_coroutine_deadlock_callback_t)(void);
 
 typedef cat_msec_t (*cat_coroutine_msec_time_function_t)(void);
 
+/* preemption requests, they are set by watchdog (see cat_watchdog_set_preempt_actions())
+ * and handled by cat_coroutine_check_preempt() */
+typedef enum cat_coroutine_preempt_flag_e {
+    CAT_COROUTINE_PREEMPT_NONE   = 0,
+    /* yield and let the others run */
+    CAT_COROUTINE_PREEMPT_YIELD  = 1 << 0,
+    /* log a warning about the runaway coroutine */
+    CAT_COROUTINE_PREEMPT_LOG    = 1 << 1,
+    /* checkpoint fails with CAT_ECANCELED */
+    CAT_COROUTINE_PREEMPT_CANCEL = 1 << 2,
+} cat_coroutine_preempt_flag_t;
+
+typedef uint8_t cat_coroutine_preempt_flags_t;
+
 CAT_GLOBALS_STRUCT_BEGIN(cat_coroutine) {
     /* options */
     cat_coroutine_stack_size_t default_stack_size;
@@ -187,6 +229,13 @@ CAT_GLOBALS_STRUCT_BEGIN(cat_coroutine) {
     cat_coroutine_count_t peak_count;
     /* global switches (for watchdog) */
     cat_coroutine_switches_t switches;
+    /* preemption (written by watchdog thread) */
+    cat_atomic_uint8_t preempt;
+    cat_atomic_uint64_t preempt_switches;
+    cat_atomic_int64_t preempt_blocking_time;
+    /* free arena chunks */
+    cat_coroutine_arena_chunk_t *arena_pool;
+    uint32_t arena_pool_count;
 } CAT_GLOBALS_STRUCT_END(cat_coroutine);
 
 extern CAT_API CAT_GLOBALS_DECLARE(cat_coroutine);
@@ -305,6 +354,28 @@ CAT_API const char *cat_coroutine_get_role_name_in_uppercase(const cat_coroutine
 /* helper */
 CAT_API cat_coroutine_t *cat_coroutine_run(cat_coroutine_t *coroutine, cat_coroutine_function_t function, cat_data_t *data);
 
+/* arena of the current coroutine, memory is pointer-size aligned and must not be freed by cat_free() */
+CAT_API void *cat_coroutine_arena_alloc(size_t size);
+CAT_API char *cat_coroutine_arena_strndup(const char *string, size_t length);
+CAT_API char *cat_coroutine_arena_vsprintf(const char *format, va_list args);
+CAT_API char *cat_coroutine_arena_sprintf(const char *format, ...) CAT_ATTRIBUTE_FORMAT(printf, 1, 2);
+/* explicit reset point: release all memory allocated from the arena of the current coroutine */
+CAT_API void cat_coroutine_arena_reset(void);
+/* arena of the given coroutine, coroutine should not be running (it is also called when coroutine finished) */
+CAT_API void cat_coroutine_arena_release(cat_coroutine_t *coroutine);
+
+/* handle preemption requests at once, see cat_coroutine_check_preempt() */
+CAT_API cat_bool_t cat_coroutine_preempt(void);
+/* preemption checkpoint, it is cheap enough to be called in long loops,
+ * returns false (and the loop should be broken) if coroutine has been canceled */
+static cat_always_inline cat_bool_t cat_coroutine_check_preempt(void)
+{
+    if (likely(cat_atomic_uint8_load(&CAT_COROUTINE_G(preempt)) == CAT_COROUTINE_PREEMPT_NONE)) {
+        return cat_true;
+    }
+    return cat_coroutine_preempt();
+}
+
 /* debug */
 CAT_API cat_bool_t cat_coroutine_is_deadlocked(void);
 CAT_API void cat_coroutine_unlock_deadlock(void);
@@ -38,12 +38,68 @@ typedef void (*cat_event_loop_defer_callback_t)(cat_event_loop_defer_task_t *tas
 typedef struct cat_event_io_defer_task_s cat_event_io_defer_task_t;
 typedef void (*cat_event_io_defer_callback_t)(cat_event_io_defer_task_t *task, cat_data_t *data);
 
+typedef struct cat_event_busy_poll_stats_s {
+    /* non-blocking polls while spinning */
+    uint64_t spins;
+    /* spins which got something to do */
+    uint64_t hits;
+    /* times we ran out of budget and went to sleep */
+    uint64_t sleeps;
+} cat_event_busy_poll_stats_t;
+
+#define CAT_EVENT_METRICS_LAG_BUCKET_COUNT 20
+
+/* all of time values are in nanoseconds,
+ * cumulative ones are monotonic, readers should diff two snapshots */
+typedef struct cat_event_metrics_s {
+    /* cumulative (since metrics were enabled) */
+    cat_nsec_t elapsed_time;
+    /* blocked in poll */
+    cat_nsec_t poll_time;
+    /* running callbacks and coroutines */
+    cat_nsec_t run_time;
+    /* loop lag is the running time of each round,
+     * lag_histogram[i] counts rounds which took less than 2^i microseconds (the last one counts the rest) */
+    cat_nsec_t max_lag;
+    uint64_t lag_histogram[CAT_EVENT_METRICS_LAG_BUCKET_COUNT];
+    /* cumulative (since runtime init) */
+    cat_event_round_t rounds;
+    cat_coroutine_switches_t switches;
+    /* current status */
+    cat_coroutine_count_t coroutines;
+    size_t io_defer_tasks;
+    size_t active_requests;
+    size_t active_handles;
+    /* active timers are active_handles_by_type[UV_TIMER] */
+    size_t active_handles_by_type[UV_HANDLE_TYPE_MAX];
+} cat_event_metrics_t;
+
 CAT_GLOBALS_STRUCT_BEGIN(cat_event) {
     uv_loop_t loop;
     uv_timer_t deadlock;
     cat_queue_t runtime_shutdown_tasks;
     cat_queue_t io_defer_tasks;
     uv_check_t io_defer_check;
+    struct {
+        cat_nsec_t budget;
+        cat_nsec_t deadline;
+        cat_coroutine_switches_t switches;
+        cat_event_busy_poll_stats_t stats;
+        uv_prepare_t prepare;
+        uv_check_t check;
+        uv_idle_t idle;
+    } busy_poll;
+    struct {
+        cat_bool_t enabled;
+        cat_nsec_t start_time;
+        cat_nsec_t start_idle_time;
+        cat_nsec_t last_time;
+        cat_nsec_t last_idle_time;
+        cat_nsec_t run_time;
+        cat_nsec_t max_lag;
+        uint64_t lag_histogram[CAT_EVENT_METRICS_LAG_BUCKET_COUNT];
+        uv_prepare_t prepare;
+    } metrics;
 } CAT_GLOBALS_STRUCT_END(cat_event);
 
 extern CAT_API CAT_GLOBALS_DECLARE(cat_event);
@@ -88,6 +144,19 @@ CAT_API cat_event_io_defer_task_t *cat_event_io_defer_task_create(
  * if task callback has been called, it will return true, otherwise false. */
 CAT_API cat_bool_t cat_event_io_defer_task_close(cat_event_io_defer_task_t *task);
 
+/* busy-poll: after being woken up, keep polling in non-blocking mode
+ * until nothing happened for budget nanoseconds, then go to sleep again,
+ * it trades CPU for latency, 0 means disabled (default) */
+CAT_API cat_nsec_t cat_event_get_busy_poll(void);
+CAT_API void cat_event_set_busy_poll(cat_nsec_t budget);
+CAT_API void cat_event_get_busy_poll_stats(cat_event_busy_poll_stats_t *stats);
+
+/* metrics are disabled by default, enabling resets the cumulative time values */
+CAT_API cat_bool_t cat_event_get_metrics_enabled(void);
+CAT_API void cat_event_set_metrics_enabled(cat_bool_t enable);
+/* take a snapshot, it walks all handles, so it is cheap enough to be called once a second */
+CAT_API void cat_event_get_metrics(cat_event_metrics_t *metrics);
+
 CAT_API void cat_event_fork(void);
 
 CAT_API void cat_event_print_all_handles(cat_os_fd_t output);
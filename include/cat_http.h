@@ -24,12 +24,17 @@ extern "C" {
 #endif
 
 #include "cat.h"
+#include "cat_buffer.h"
+#include "cat_socket.h"
 
 #include "llhttp.h"
 
 #include "multipart_parser.h"
 
 CAT_API cat_bool_t cat_http_module_init(void);
+CAT_API cat_bool_t cat_http_module_shutdown(void);
+CAT_API cat_bool_t cat_http_runtime_init(void);
+CAT_API cat_bool_t cat_http_runtime_shutdown(void);
 
 #define CAT_HTTP_METHOD_MAP HTTP_METHOD_MAP
 
@@ -118,6 +123,15 @@ enum cat_http_status_e
 typedef uint16_t cat_http_status_code_t;
 
 CAT_API const char *cat_http_status_get_reason(cat_http_status_code_t status);
+/* pre-rendered "HTTP/1.1 NNN Reason\r\n", returns NULL if status is unknown */
+CAT_API const char *cat_http_status_get_line(cat_http_status_code_t status, size_t *length);
+
+/* "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n" */
+#define CAT_HTTP_DATE_HEADER_LENGTH (sizeof("Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n") - 1)
+
+/* it is re-rendered at most once per second (based on cat_time_msec_cached()),
+ * returned memory is owned by the current thread and its content will be updated in place */
+CAT_API const char *cat_http_get_date_header(void);
 
 /* parser */
 
@@ -130,6 +144,7 @@ CAT_API const char *cat_http_status_get_reason(cat_http_status_code_t status);
     HTTP_ERRNO_MAP(XX) \
     XX(HPE_MAX + 1, NOMEM, NOMEM) \
     XX(HPE_MAX + 2, MULTIPART, MULTIPART) \
+    XX(HPE_MAX + 3, HEADER_INDEX, HEADER_INDEX) \
 
 typedef enum cat_http_parser_standard_errno_e {
 #define CAT_HTTP_PARSER_ERRNO_GEN(code, name, string) CAT_EHP_ ## name = CAT_HTTP_PARSER_STANDARD_ERRNO_START - (code),
@@ -137,6 +152,9 @@ typedef enum cat_http_parser_standard_errno_e {
 #undef CAT_HTTP_PARSER_ERRNO_GEN
 } cat_http_parser_errno_t;
 
+/* whether error is one of CAT_EHP_* */
+CAT_API cat_bool_t cat_http_parser_is_errno(cat_errno_t error);
+
 typedef enum cat_http_parser_type_e {
     CAT_HTTP_PARSER_TYPE_BOTH     = HTTP_BOTH,
     CAT_HTTP_PARSER_TYPE_REQUEST  = HTTP_REQUEST,
@@ -202,6 +220,99 @@ typedef enum cat_http_parser_internal_flag_e {
 
 typedef uint8_t cat_http_parser_internal_flags_t;
 
+/* header index: an opt-in mode in which parser records all headers as (offset, length) slices
+ * of the read buffer in a fixed-capacity inline array, without any allocation,
+ * well-known headers are classified by a perfect hash so that they can be found in O(1) */
+
+#define CAT_HTTP_KNOWN_HEADER_MAP(XX) \
+    XX(HOST, "Host") \
+    XX(CONTENT_LENGTH, "Content-Length") \
+    XX(CONTENT_TYPE, "Content-Type") \
+    XX(CONNECTION, "Connection") \
+    XX(TRANSFER_ENCODING, "Transfer-Encoding") \
+    XX(UPGRADE, "Upgrade") \
+    XX(ACCEPT, "Accept") \
+    XX(ACCEPT_ENCODING, "Accept-Encoding") \
+    XX(ACCEPT_LANGUAGE, "Accept-Language") \
+    XX(USER_AGENT, "User-Agent") \
+    XX(COOKIE, "Cookie") \
+    XX(AUTHORIZATION, "Authorization") \
+    XX(EXPECT, "Expect") \
+    XX(KEEP_ALIVE, "Keep-Alive") \
+    XX(ORIGIN, "Origin") \
+    XX(REFERER, "Referer") \
+    XX(CACHE_CONTROL, "Cache-Control") \
+    XX(IF_MODIFIED_SINCE, "If-Modified-Since") \
+    XX(IF_NONE_MATCH, "If-None-Match") \
+    XX(X_FORWARDED_FOR, "X-Forwarded-For") \
+    XX(SEC_WEBSOCKET_KEY, "Sec-WebSocket-Key") \
+    XX(SEC_WEBSOCKET_VERSION, "Sec-WebSocket-Version") \
+    XX(SEC_WEBSOCKET_EXTENSIONS, "Sec-WebSocket-Extensions") \
+    XX(SEC_WEBSOCKET_PROTOCOL, "Sec-WebSocket-Protocol") \
+    XX(DATE, "Date") \
+    XX(SERVER, "Server") \
+    XX(SET_COOKIE, "Set-Cookie") \
+    XX(LOCATION, "Location") \
+    XX(CONTENT_ENCODING, "Content-Encoding") \
+    XX(RANGE, "Range") \
+
+typedef enum cat_http_header_id_e {
+    CAT_HTTP_HEADER_UNKNOWN = 0,
+#define CAT_HTTP_HEADER_ID_GEN(name, unused) CAT_HTTP_HEADER_##name,
+    CAT_HTTP_KNOWN_HEADER_MAP(CAT_HTTP_HEADER_ID_GEN)
+#undef CAT_HTTP_HEADER_ID_GEN
+    CAT_HTTP_HEADER_ID_MAX
+} cat_http_header_id_t;
+
+/* case-insensitive, returns CAT_HTTP_HEADER_UNKNOWN if it is not a well-known header */
+CAT_API cat_http_header_id_t cat_http_header_lookup(const char *name, size_t length);
+CAT_API const char *cat_http_header_get_name(cat_http_header_id_t id);
+
+/* it can be overridden, but no more than 255 */
+#ifndef CAT_HTTP_HEADER_INDEX_MAX_HEADERS
+#define CAT_HTTP_HEADER_INDEX_MAX_HEADERS 64
+#endif
+
+typedef struct cat_http_header_slice_s {
+    uint32_t name_offset;
+    uint32_t name_length;
+    uint32_t value_offset;
+    uint32_t value_length;
+    cat_http_header_id_t id;
+} cat_http_header_slice_t;
+
+typedef struct cat_http_header_index_s {
+    /* public readonly: offsets are relative to it */
+    const char *base;
+    /* public readonly: number of recorded headers */
+    uint16_t count;
+    /* private: whether the last header data is field or value */
+    uint8_t last;
+    /* private: position + 1 of the first occurrence of each well-known header */
+    uint8_t known[CAT_HTTP_HEADER_ID_MAX];
+    /* public readonly */
+    cat_http_header_slice_t headers[CAT_HTTP_HEADER_INDEX_MAX_HEADERS];
+} cat_http_header_index_t;
+
+CAT_API void cat_http_header_index_init(cat_http_header_index_t *index, const char *base);
+/* all the headers of current message must stay in the buffer until headers complete,
+ * call it if buffer has been reallocated or compacted (the first `consumed` bytes are dropped) */
+CAT_API void cat_http_header_index_rebase(cat_http_header_index_t *index, const char *base, size_t consumed);
+/* O(1), returns the first occurrence */
+CAT_API const cat_http_header_slice_t *cat_http_header_index_find(const cat_http_header_index_t *index, cat_http_header_id_t id);
+/* O(1) for well-known headers, otherwise it is a linear case-insensitive search */
+CAT_API const cat_http_header_slice_t *cat_http_header_index_get(const cat_http_header_index_t *index, const char *name, size_t length);
+
+static cat_always_inline const char *cat_http_header_index_get_name(const cat_http_header_index_t *index, const cat_http_header_slice_t *slice)
+{
+    return index->base + slice->name_offset;
+}
+
+static cat_always_inline const char *cat_http_header_index_get_value(const cat_http_header_index_t *index, const cat_http_header_slice_t *slice)
+{
+    return index->base + slice->value_offset;
+}
+
 typedef struct cat_http_parser_s {
     /* public readonly: which events will return from execute */
     cat_http_parser_events_t events;
@@ -237,6 +348,8 @@ typedef struct cat_http_parser_s {
     multipart_parser multipart;
     /* private: multipart parser pointer */
     const char *multipart_ptr;
+    /* private: header index (opt-in) */
+    cat_http_header_index_t *header_index;
 } cat_http_parser_t;
 
 /*
@@ -384,6 +497,153 @@ CAT_API cat_bool_t cat_http_parser_is_upgrade(const cat_http_parser_t *parser);
 * Notice: it should be called after headers complete event triggered
 */
 CAT_API cat_bool_t cat_http_parser_is_multipart(const cat_http_parser_t *parser);
+/*
+* record headers into the index on parsing (NULL to disable), it is reset on each message begin,
+* data passed to execute must be located after index->base
+*/
+CAT_API void cat_http_parser_set_header_index(cat_http_parser_t *parser, cat_http_header_index_t *index);
+CAT_API cat_http_header_index_t *cat_http_parser_get_header_index(const cat_http_parser_t *parser);
+
+/* pipeline: a server loop which parses all buffered requests of a connection (HTTP/1.1 pipelining),
+ * and gathers their responses into a single writev() */
+
+#ifndef CAT_HTTP_PIPELINE_MAX_VECTORS
+#define CAT_HTTP_PIPELINE_MAX_VECTORS 64
+#endif
+
+#define CAT_HTTP_PIPELINE_DEFAULT_MAX_REQUEST_LENGTH (8 * 1024 * 1024)
+
+typedef struct cat_http_pipeline_s cat_http_pipeline_t;
+
+/* it is called on each complete request, responses should be added by cat_http_pipeline_respond*(),
+ * it is also used as event handler (see cat_http_pipeline_set_event_handler()),
+ * return false to stop the loop */
+typedef cat_bool_t (*cat_http_pipeline_handler_t)(cat_http_pipeline_t *pipeline, void *data);
+
+struct cat_http_pipeline_s {
+    /* public readonly: parser of the current request (method, version, keep-alive and so on) */
+    cat_http_parser_t parser;
+    /* public readonly: the current request */
+    const char *url;
+    size_t url_length;
+    const char *body;
+    size_t body_length;
+    /* public readonly: headers of the current request */
+    cat_http_header_index_t headers;
+    /* public readonly: statistics */
+    size_t requests;
+    size_t writes;
+    /* public readonly: it is waiting for a new request */
+    cat_bool_t idle;
+    /* public: options */
+    size_t max_request_length; /* request line and headers */
+    size_t max_body_length;
+    cat_timeout_t read_timeout; /* CAT_TIMEOUT_INVALID means socket read timeout */
+    cat_timeout_t idle_timeout; /* same as above */
+    /* private */
+    cat_bool_t stopping;
+    cat_http_parser_events_t events;
+    cat_http_pipeline_handler_t event_handler;
+    cat_socket_t *socket;
+    cat_buffer_t buffer;
+    cat_buffer_t body_buffer;
+    cat_buffer_t response_buffer;
+    size_t url_offset;
+    unsigned int vector_count;
+    cat_socket_write_vector_t vectors[CAT_HTTP_PIPELINE_MAX_VECTORS];
+};
+
+CAT_API cat_http_pipeline_t *cat_http_pipeline_create(cat_http_pipeline_t *pipeline);
+CAT_API void cat_http_pipeline_close(cat_http_pipeline_t *pipeline);
+/* response data will be copied */
+CAT_API cat_bool_t cat_http_pipeline_respond(cat_http_pipeline_t *pipeline, const char *data, size_t length);
+/* response data will be referenced, it must be kept alive until the current handler returns and the loop continues */
+CAT_API cat_bool_t cat_http_pipeline_respond_static(cat_http_pipeline_t *pipeline, const char *data, size_t length);
+/* write all gathered responses out, it is called by the loop automatically */
+CAT_API cat_bool_t cat_http_pipeline_flush(cat_http_pipeline_t *pipeline);
+/* subscribe extra parser events (e.g. HEADERS_COMPLETE or MULTIPART_*), handler is called on each of them
+ * with parser event and data, data is only available during the call;
+ * if BODY is subscribed, body is streamed to handler instead of being buffered */
+CAT_API void cat_http_pipeline_set_event_handler(cat_http_pipeline_t *pipeline, cat_http_parser_events_t events, cat_http_pipeline_handler_t handler);
+/* loop will stop after the current request, or at once if it is idle
+ * (idle socket read should be cancelled by the caller, e.g. cat_socket_abort()) */
+CAT_API void cat_http_pipeline_stop(cat_http_pipeline_t *pipeline);
+/* serve requests on the socket until EOF, non-keep-alive/upgrade request, handler returns false or stopped,
+ * returns false on parse (CAT_EHP_*), size limit (CAT_EMSGSIZE) or I/O error, socket will not be closed */
+CAT_API cat_bool_t cat_http_pipeline_run(cat_http_pipeline_t *pipeline, cat_socket_t *socket, cat_http_pipeline_handler_t handler, void *data);
+
+/* response writer: it builds a response as an iovec array for cat_socket_write(),
+ * status line and Date header are pre-rendered, headers and body are referenced without copy,
+ * so that there is no format parsing or allocation per response */
+
+#ifndef CAT_HTTP_RESPONSE_WRITER_MAX_VECTORS
+#define CAT_HTTP_RESPONSE_WRITER_MAX_VECTORS 32
+#endif
+
+/* enough for an unknown status line and a Content-Length header */
+#define CAT_HTTP_RESPONSE_WRITER_SCRATCH_SIZE 64
+
+typedef struct cat_http_response_writer_s {
+    /* private */
+    unsigned int vector_count;
+    unsigned int scratch_length;
+    cat_bool_t ended;
+    char scratch[CAT_HTTP_RESPONSE_WRITER_SCRATCH_SIZE];
+    cat_socket_write_vector_t vectors[CAT_HTTP_RESPONSE_WRITER_MAX_VECTORS];
+} cat_http_response_writer_t;
+
+/* all data will be referenced, it must be kept alive until the response is written,
+ * and the writer itself must not be moved since it may be referenced too */
+CAT_API void cat_http_response_writer_init(cat_http_response_writer_t *writer, cat_http_status_code_t status);
+CAT_API cat_bool_t cat_http_response_writer_add_header(cat_http_response_writer_t *writer, const char *name, size_t name_length, const char *value, size_t value_length);
+/* a pre-rendered "Name: value\r\n" line */
+CAT_API cat_bool_t cat_http_response_writer_add_header_line(cat_http_response_writer_t *writer, const char *line, size_t length);
+CAT_API cat_bool_t cat_http_response_writer_add_date(cat_http_response_writer_t *writer);
+CAT_API cat_bool_t cat_http_response_writer_add_content_length(cat_http_response_writer_t *writer, uint64_t length);
+/* "Transfer-Encoding: chunked", body should be written by cat_http_chunked_writer after the response is written */
+CAT_API cat_bool_t cat_http_response_writer_add_chunked(cat_http_response_writer_t *writer);
+/* end of headers, body is optional */
+CAT_API cat_bool_t cat_http_response_writer_end(cat_http_response_writer_t *writer, const char *body, size_t body_length);
+CAT_API const cat_socket_write_vector_t *cat_http_response_writer_get_vectors(const cat_http_response_writer_t *writer, unsigned int *count);
+CAT_API size_t cat_http_response_writer_get_length(const cat_http_response_writer_t *writer);
+CAT_API cat_bool_t cat_http_response_writer_write(const cat_http_response_writer_t *writer, cat_socket_t *socket);
+/* response will be copied into pipeline */
+CAT_API cat_bool_t cat_http_pipeline_respond_writer(cat_http_pipeline_t *pipeline, const cat_http_response_writer_t *writer);
+
+/* chunked writer: it streams a body in chunked transfer-encoding,
+ * small writes are copied and coalesced into one chunk per flush,
+ * large writes are sent as a chunk together with the pending data without copy */
+
+/* 64-bit length in hex + CRLF */
+#define CAT_HTTP_CHUNK_HEADER_MAX_LENGTH (16 + 2)
+
+#ifndef CAT_HTTP_CHUNKED_WRITER_DEFAULT_COALESCE_SIZE
+#define CAT_HTTP_CHUNKED_WRITER_DEFAULT_COALESCE_SIZE (8 * 1024)
+#endif
+
+/* render "<hex-length>\r\n" into buffer (at least CAT_HTTP_CHUNK_HEADER_MAX_LENGTH bytes), returns its length */
+CAT_API size_t cat_http_chunk_header_render(char *buffer, uint64_t length);
+
+typedef struct cat_http_chunked_writer_s {
+    /* public readonly: statistics */
+    size_t chunks;
+    uint64_t bytes;
+    /* public: writes smaller than it are coalesced, buffered data is flushed once it is reached */
+    size_t coalesce_size;
+    /* private */
+    cat_socket_t *socket;
+    cat_buffer_t buffer;
+    cat_bool_t ended;
+} cat_http_chunked_writer_t;
+
+CAT_API cat_http_chunked_writer_t *cat_http_chunked_writer_create(cat_http_chunked_writer_t *writer, cat_socket_t *socket);
+CAT_API void cat_http_chunked_writer_close(cat_http_chunked_writer_t *writer);
+/* empty write is ignored, because an empty chunk means the end of body */
+CAT_API cat_bool_t cat_http_chunked_writer_write(cat_http_chunked_writer_t *writer, const char *data, size_t length);
+/* send buffered data as a chunk */
+CAT_API cat_bool_t cat_http_chunked_writer_flush(cat_http_chunked_writer_t *writer);
+/* flush and send the last chunk, trailers are optional pre-rendered "Name: value\r\n" lines */
+CAT_API cat_bool_t cat_http_chunked_writer_end(cat_http_chunked_writer_t *writer, const char *trailers, size_t trailers_length);
 
 #ifdef __cplusplus
 }
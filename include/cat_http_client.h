@@ -0,0 +1,117 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#ifndef CAT_HTTP_CLIENT_H
+#define CAT_HTTP_CLIENT_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cat.h"
+#include "cat_queue.h"
+#include "cat_buffer.h"
+#include "cat_socket.h"
+#include "cat_http.h"
+
+/* HTTP/1.1 client on top of cat_socket and cat_http_parser,
+ * connections are kept alive in a per-host pool and reused by the following requests,
+ * requests wait in queue if all connections of the host are busy (see max_connections_per_host) */
+
+#define CAT_HTTP_CLIENT_DEFAULT_MAX_CONNECTIONS_PER_HOST      64
+#define CAT_HTTP_CLIENT_DEFAULT_MAX_IDLE_CONNECTIONS_PER_HOST 16
+#define CAT_HTTP_CLIENT_DEFAULT_MAX_RESPONSE_LENGTH           (64 * 1024 * 1024)
+
+typedef struct cat_http_client_options_s {
+    /* timeouts per phase, CAT_TIMEOUT_INVALID means socket defaults */
+    cat_timeout_t connect_timeout; /* also used for waiting for a free connection */
+    cat_timeout_t handshake_timeout;
+    cat_timeout_t write_timeout;
+    cat_timeout_t read_timeout;
+    size_t max_connections_per_host; /* 0 means unlimited */
+    size_t max_idle_connections_per_host;
+    size_t max_response_length; /* headers and body */
+#ifdef CAT_SSL
+    /* NULL means verify peer with default CA and host name */
+    const cat_socket_crypto_options_t *crypto_options;
+#endif
+} cat_http_client_options_t;
+
+typedef struct cat_http_client_request_s {
+    const char *method;
+    size_t method_length;
+    const char *path;
+    size_t path_length;
+    /* pre-rendered "Name: value\r\n" lines (Host, Content-Length and Connection are added automatically,
+     * Connection is close if max_idle_connections_per_host is 0, otherwise keep-alive) */
+    const char *headers;
+    size_t headers_length;
+    /* it is sent with Content-Length (omitted for GET/HEAD without body) */
+    const char *body;
+    size_t body_length;
+} cat_http_client_request_t;
+
+typedef struct cat_http_client_response_s {
+    /* public readonly */
+    cat_http_status_code_t status;
+    cat_bool_t keep_alive;
+    /* status line and headers */
+    cat_buffer_t header_buffer;
+    /* it is based on header_buffer */
+    cat_http_header_index_t headers;
+    /* decoded body (both Content-Length and chunked) */
+    cat_buffer_t body;
+} cat_http_client_response_t;
+
+typedef struct cat_http_client_s {
+    /* public readonly */
+    cat_http_client_options_t options;
+    /* public readonly: statistics */
+    size_t connects;
+    size_t reuses;
+    size_t requests;
+    /* private */
+    cat_queue_t hosts;
+} cat_http_client_t;
+
+CAT_API void cat_http_client_options_init(cat_http_client_options_t *options);
+
+/* options can be NULL */
+CAT_API cat_http_client_t *cat_http_client_create(cat_http_client_t *client, const cat_http_client_options_t *options);
+/* idle connections are closed at once, busy ones will be closed when their requests are done
+ * (they do not access client any more, so it can be freed after close),
+ * coroutines which are waiting for a free connection fail with CAT_ECANCELED */
+CAT_API void cat_http_client_close(cat_http_client_t *client);
+
+/* GET / without headers and body */
+CAT_API void cat_http_client_request_init(cat_http_client_request_t *request);
+
+CAT_API void cat_http_client_response_init(cat_http_client_response_t *response);
+CAT_API void cat_http_client_response_close(cat_http_client_response_t *response);
+CAT_API const char *cat_http_client_response_get_header(const cat_http_client_response_t *response, const char *name, size_t name_length, size_t *value_length);
+
+/* send the request on a pooled connection (or a new one) and read its response,
+ * response must have been initialized, its previous content will be cleared;
+ * ssl requires CAT_SSL */
+CAT_API cat_bool_t cat_http_client_execute(cat_http_client_t *client, const char *host, size_t host_length, int port, cat_bool_t ssl, const cat_http_client_request_t *request, cat_http_client_response_t *response);
+/* send all requests by one write on one connection (HTTP/1.1 pipelining) and read their responses in order */
+CAT_API cat_bool_t cat_http_client_pipeline(cat_http_client_t *client, const char *host, size_t host_length, int port, cat_bool_t ssl, const cat_http_client_request_t *requests, cat_http_client_response_t *responses, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAT_HTTP_CLIENT_H */
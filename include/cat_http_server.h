@@ -0,0 +1,110 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#ifndef CAT_HTTP_SERVER_H
+#define CAT_HTTP_SERVER_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cat.h"
+#include "cat_queue.h"
+#include "cat_socket.h"
+#include "cat_sync.h"
+#include "cat_http.h"
+
+/* HTTP/1.1 server: one coroutine per connection, each of them runs a cat_http_pipeline,
+ * so that keep-alive, pipelining, size limits and timeouts are handled by the pipeline */
+
+#define CAT_HTTP_SERVER_DEFAULT_BACKLOG 512
+
+typedef struct cat_http_server_s cat_http_server_t;
+typedef struct cat_http_server_connection_s cat_http_server_connection_t;
+
+/* it is called on each complete request (routing callback),
+ * request is available via connection->pipeline (url, headers, body and parser),
+ * response should be added by cat_http_server_respond() or cat_http_pipeline_respond*(),
+ * return false to close the connection */
+typedef cat_bool_t (*cat_http_server_handler_t)(cat_http_server_connection_t *connection, void *data);
+
+typedef struct cat_http_server_options_s {
+    size_t max_request_length; /* request line and headers */
+    size_t max_body_length;
+    cat_timeout_t read_timeout; /* CAT_TIMEOUT_INVALID means socket read timeout */
+    cat_timeout_t idle_timeout; /* keep-alive timeout, same as above */
+    int backlog;
+} cat_http_server_options_t;
+
+struct cat_http_server_connection_s {
+    /* public readonly */
+    cat_http_pipeline_t pipeline;
+    cat_socket_t socket;
+    cat_http_server_t *server;
+    /* private */
+    cat_queue_node_t node;
+    cat_coroutine_t *coroutine;
+};
+
+struct cat_http_server_s {
+    /* public readonly */
+    cat_socket_t socket;
+    cat_http_server_options_t options;
+    /* public readonly: statistics */
+    size_t connections;
+    size_t accepted;
+    size_t requests;
+    /* private */
+    cat_http_server_handler_t handler;
+    void *data;
+    cat_http_parser_events_t events;
+    cat_http_server_handler_t event_handler;
+    cat_queue_t connection_queue;
+    cat_sync_wait_group_t wg;
+    cat_bool_t shutting_down;
+};
+
+CAT_API void cat_http_server_options_init(cat_http_server_options_t *options);
+
+/* options can be NULL */
+CAT_API cat_http_server_t *cat_http_server_create(cat_http_server_t *server, const cat_http_server_options_t *options, cat_http_server_handler_t handler, void *data);
+/* server should have been shut down (or never run) */
+CAT_API void cat_http_server_close(cat_http_server_t *server);
+/* see cat_http_pipeline_set_event_handler(), e.g. subscribe BODY and MULTIPART_* to stream request bodies */
+CAT_API void cat_http_server_set_event_handler(cat_http_server_t *server, cat_http_parser_events_t events, cat_http_server_handler_t handler);
+
+CAT_API cat_bool_t cat_http_server_listen(cat_http_server_t *server, const char *name, size_t name_length, int port);
+CAT_API int cat_http_server_get_port(cat_http_server_t *server);
+/* accept and serve connections until it is shut down (returns true) or accept failed (returns false),
+ * connections may still be alive when it returns, see cat_http_server_shutdown() */
+CAT_API cat_bool_t cat_http_server_run(cat_http_server_t *server);
+/* graceful shutdown: stop accepting, let connections finish their in-flight requests
+ * (with "Connection: close"), close idle ones, and wait for all of them;
+ * connections which are still alive after timeout will be aborted and it returns false;
+ * it can also be called from a handler, the calling connection is not waited for
+ * and it will be closed after the current response */
+CAT_API cat_bool_t cat_http_server_shutdown(cat_http_server_t *server, cat_timeout_t timeout);
+CAT_API cat_bool_t cat_http_server_is_shutting_down(const cat_http_server_t *server);
+
+/* respond a complete response with Date and Content-Length (body will be copied),
+ * "Connection: close" is added if the connection is going to be closed */
+CAT_API cat_bool_t cat_http_server_respond(cat_http_server_connection_t *connection, cat_http_status_code_t status, const char *content_type, size_t content_type_length, const char *body, size_t body_length);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAT_HTTP_SERVER_H */
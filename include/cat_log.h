@@ -70,13 +70,38 @@ typedef struct cat_log_globals_s {
 #define CAT_LOG_STRINGL_OR_NULL_PARAM(string, length) \
         CAT_LOG_STRINGL_OR_X_PARAM(string, length, "NULL")
 
+/* per-module log types (process-wide, they are checked after CAT_LOG_G(types)),
+ * module id is resolved on the first call and cached in a static variable of the call site,
+ * so that the check is only an array access */
+
+#define CAT_LOG_MODULE_MAX 64 /* 0 is unresolved, the last one is shared by overflowed modules */
+
+typedef uint8_t cat_log_module_id_t;
+
+/* it is one cache line and zero means all types are enabled */
+extern CAT_API uint8_t cat_log_module_disabled_types[CAT_LOG_MODULE_MAX];
+
+CAT_API cat_log_module_id_t cat_log_module_register(const char *module_name);
+CAT_API cat_bool_t cat_log_set_module_types(const char *module_name, cat_log_types_t types);
+CAT_API cat_log_types_t cat_log_get_module_types(const char *module_name);
+
+static cat_always_inline cat_bool_t cat_log_module_is_enabled(cat_log_module_id_t *id, const char *module_name, int type)
+{
+    if (unlikely(*id == 0)) {
+        *id = cat_log_module_register(module_name);
+    }
+    return (cat_log_module_disabled_types[*id] & type) == 0;
+}
+
 /* Notes for log macros:
  * [XXX_WITH_TYPE] macros designed for dynamic types,
  * [XXX_D] macros means log directly without checking user config */
 
 #define CAT_LOG_SCOPE_WITH_TYPE_START(type, module_name) do { \
+    static cat_log_module_id_t _cat_log_module_id; \
     if (( \
             ((type) & CAT_LOG_G(types)) == (type) && \
+            cat_log_module_is_enabled(&_cat_log_module_id, #module_name, (int) (type)) && \
             ( \
                 likely(CAT_LOG_G(module_name_filter) == NULL) || \
                 cat_str_list_contains_ci(CAT_LOG_G(module_name_filter), #module_name, strlen(#module_name)) \
@@ -140,8 +165,14 @@ typedef struct cat_log_globals_s {
 # define CAT_LOG_DEBUG_WITH_LEVEL(module_name, level, format, ...)
 # define CAT_LOG_DEBUG_D(module_name, format, ...)
 #else
+/* debug logs above it are eliminated at compile time (it can be defined per file),
+ * and debug log arguments (including temporary strings) are never evaluated unless it is enabled */
+# ifndef CAT_LOG_DEBUG_LEVEL_MAX
+#  define CAT_LOG_DEBUG_LEVEL_MAX 3
+# endif
+
 # define CAT_LOG_DEBUG_LEVEL_SCOPE_START(level) do { \
-    if (unlikely(CAT_LOG_G(debug_level) >= level)) { \
+    if ((level) <= CAT_LOG_DEBUG_LEVEL_MAX && unlikely(CAT_LOG_G(debug_level) >= level)) { \
         CAT_LOG_G(last_debug_log_level) = level; \
 
 # define CAT_LOG_DEBUG_LEVEL_SCOPE_END() \
@@ -238,6 +269,55 @@ CAT_API cat_bool_t cat_log_fwrite(FILE *file, const char *str, size_t length);
 CAT_API void cat_log_va_list_standard(CAT_LOG_VA_LIST_PARAMETERS);
 CAT_API void cat_log_standard(CAT_LOG_PARAMETERS);
 
+/* async log: messages are formatted by the caller and pushed into a bounded lock-free ring,
+ * a dedicated writer thread drains it and writes them with batched writev(),
+ * so that a slow disk or a blocked pipe never stalls the event loop;
+ * error messages flush the ring and are written synchronously before abort,
+ * and pending messages are also written on cat_abort() or fatal signals (SIGSEGV, SIGBUS, SIGABRT...) */
+
+typedef enum cat_log_async_overflow_policy_e {
+    CAT_LOG_ASYNC_OVERFLOW_DROP, /* drop the message and count it */
+    CAT_LOG_ASYNC_OVERFLOW_BLOCK, /* wait for the writer (blocks the caller thread) */
+} cat_log_async_overflow_policy_t;
+
+#define CAT_LOG_ASYNC_DEFAULT_CAPACITY       4096
+#define CAT_LOG_ASYNC_DEFAULT_FLUSH_INTERVAL 100 /* ms */
+#define CAT_LOG_ASYNC_DEFAULT_FLUSH_TIMEOUT  1000 /* ms */
+
+typedef struct cat_log_async_options_s {
+    size_t capacity; /* max number of pending messages, it will be rounded up to power of 2 */
+    cat_log_async_overflow_policy_t overflow_policy;
+    cat_msec_t flush_interval; /* max latency of writer if wakeup is missed */
+    cat_timeout_t flush_timeout; /* max time to wait for pending messages before abort */
+} cat_log_async_options_t;
+
+typedef struct cat_log_async_stats_s {
+    uint64_t written;
+    uint64_t dropped;
+    uint64_t blocked; /* times callers waited for the writer */
+    uint64_t write_errors;
+    size_t pending;
+} cat_log_async_stats_t;
+
+CAT_API void cat_log_async_options_init(cat_log_async_options_t *options);
+/* start writer thread and install cat_log_async() as cat_log_function (options can be NULL),
+ * it also takes over SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT, handlers installed before
+ * are chained after pending messages have been written, and handlers installed after it
+ * are kept by stop() */
+CAT_API cat_bool_t cat_log_async_start(const cat_log_async_options_t *options);
+/* write all pending messages, stop writer and restore the previous log function */
+CAT_API cat_bool_t cat_log_async_stop(void);
+CAT_API cat_bool_t cat_log_async_is_running(void);
+/* wait for all messages which have been pushed to be written */
+CAT_API cat_bool_t cat_log_async_flush(cat_timeout_t timeout);
+CAT_API void cat_log_async_get_stats(cat_log_async_stats_t *stats);
+
+/* write pending messages at once without the writer (async-signal-safe), it is called on crash */
+CAT_API void cat_log_async_crash_flush(void);
+
+CAT_API void cat_log_va_list_async(CAT_LOG_VA_LIST_PARAMETERS);
+CAT_API void cat_log_async(CAT_LOG_PARAMETERS);
+
 /* Notice: n will be limited to CAT_LOG_G(str_size) if it exceed CAT_LOG_G(str_size) */
 CAT_API const char *cat_log_str_quote(const char *str, size_t n, char **tmp_str); CAT_FREE
 /* Notice: n will not be limited anyway */
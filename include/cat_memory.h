@@ -215,6 +215,66 @@ CAT_API char *cat_sys_strndup(const char *str, size_t length);
 CAT_API char *cat_strdup(const char *str);
 CAT_API char *cat_strndup(const char *str, size_t length);
 
+/* slab: per-runtime free lists by size classes for small fixed-size internal objects
+ * (timers, requests, contexts...), the same size must be passed to cat_slab_free(),
+ * objects larger than CAT_SLAB_MAX_SIZE fall back to cat_malloc(),
+ * CAT_SLAB_USE_SYS_MALLOC routes all of them to cat_malloc() (e.g. for ASan),
+ * and pages are released when runtime is closed */
+
+#define CAT_SLAB_CLASS_ALIGNMENT 32
+#define CAT_SLAB_MAX_SIZE        512
+#define CAT_SLAB_CLASS_COUNT     (CAT_SLAB_MAX_SIZE / CAT_SLAB_CLASS_ALIGNMENT)
+
+#ifndef CAT_SLAB_PAGE_SIZE
+#define CAT_SLAB_PAGE_SIZE (16 * 1024)
+#endif
+
+#if !defined(CAT_SLAB_USE_SYS_MALLOC) && defined(CAT_HAVE_ASAN)
+#define CAT_SLAB_USE_SYS_MALLOC 1
+#endif
+
+typedef struct cat_slab_stats_s {
+    size_t size; /* object size of the class */
+    uint64_t allocs;
+    uint64_t frees;
+    size_t in_use;
+    size_t peak;
+    size_t cached; /* number of free objects */
+    size_t pages;
+} cat_slab_stats_t;
+
+typedef struct cat_slab_object_s cat_slab_object_t;
+typedef struct cat_slab_page_s cat_slab_page_t;
+
+typedef struct cat_slab_class_s {
+    cat_slab_object_t *free_list;
+    cat_slab_stats_t stats;
+} cat_slab_class_t;
+
+typedef struct cat_slab_globals_s {
+    cat_slab_class_t classes[CAT_SLAB_CLASS_COUNT];
+    cat_slab_page_t *pages;
+} cat_slab_globals_t;
+
+CAT_API void cat_slab_runtime_init(void); CAT_INTERNAL
+CAT_API void cat_slab_runtime_close(void); CAT_INTERNAL
+
+CAT_API void *cat_slab_alloc(size_t size);
+CAT_API void cat_slab_free(void *ptr, size_t size);
+
+static cat_always_inline void *cat_slab_alloc_unrecoverable(size_t size)
+{
+    void *ptr = cat_slab_alloc(size);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(ptr == NULL)) {
+        cat_out_of_memory();
+    }
+#endif
+    return ptr;
+}
+/* index is in [0, CAT_SLAB_CLASS_COUNT) */
+CAT_API const cat_slab_stats_t *cat_slab_get_stats(size_t index);
+
 CAT_API void *cat_malloc_function(size_t size);
 CAT_API void *cat_calloc_function(size_t count, size_t size);
 CAT_API void *cat_realloc_function(void *ptr, size_t size);
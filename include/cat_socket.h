@@ -268,6 +268,8 @@ typedef enum cat_socket_type_e {
     XX(TCP_DELAY,     1 << 0)  /* (disable tcp_nodelay) */ \
     XX(TCP_KEEPALIVE, 1 << 1)  /* (enable keep-alive) */ \
     XX(UDP_BROADCAST, 1 << 2)  /* (enable broadcast) TODO: support it or remove */ \
+    XX(TCP_FAST_OPEN, 1 << 3)  /* (enable TCP Fast Open) */ \
+    XX(TCP_DEFERRED_ACCEPT, 1 << 4)  /* (enable TCP_DEFER_ACCEPT) */ \
 
 typedef enum cat_socket_option_flag_e {
 #define CAT_SOCKET_OPTION_FLAG_GEN(name, value) CAT_ENUM_GEN(CAT_SOCKET_OPTION_FLAG_, name, value)
@@ -330,7 +332,8 @@ typedef uint32_t cat_socket_internal_flags_t;
     XX(RDWR,      CAT_SOCKET_IO_FLAG_READ | CAT_SOCKET_IO_FLAG_WRITE) \
     XX(BIND,      1 << 2 | CAT_SOCKET_IO_FLAG_RDWR) \
     XX(ACCEPT,    1 << 3 | CAT_SOCKET_IO_FLAG_RDWR) \
-    XX(CONNECT,   1 << 4 | CAT_SOCKET_IO_FLAG_RDWR)
+    XX(CONNECT,   1 << 4 | CAT_SOCKET_IO_FLAG_RDWR) \
+    XX(PROXY,     1 << 5 | CAT_SOCKET_IO_FLAG_RDWR) /* splice, even writes are not allowed */
 
 typedef enum cat_socket_io_flag_e {
 #define CAT_SOCKET_IO_FLAG_GEN(name, value) CAT_ENUM_GEN(CAT_SOCKET_IO_FLAG_, name, value)
@@ -411,6 +414,8 @@ typedef struct cat_socket_internal_s cat_socket_internal_t;
 typedef struct cat_socket_options_s {
     cat_socket_timeout_options_t timeout;
     unsigned int tcp_keepalive_delay;
+    unsigned int tcp_fastopen_queue_length;
+    unsigned int tcp_defer_accept_timeout;
 } cat_socket_options_t;
 
 typedef struct cat_socket_inheritance_info_s {
@@ -418,6 +423,38 @@ typedef struct cat_socket_inheritance_info_s {
     cat_socket_options_t options;
 } cat_socket_inheritance_info_t;
 
+/* I/O statistics, they are optional (see cat_socket_set_global_stats()),
+ * global ones are the sum of all sockets which have stats */
+
+typedef struct cat_socket_stats_s {
+    uint64_t read_ops;
+    uint64_t read_bytes;
+    uint64_t write_ops;
+    uint64_t write_bytes;
+    /* inline reads which got data at once, or fell back to the async path due to EAGAIN (Unix only) */
+    uint64_t read_inline;
+    uint64_t read_eagain;
+    /* writes which could not be done at once and were queued */
+    uint64_t write_eagain;
+    /* time spent on waiting in the async path */
+    cat_nsec_t read_wait_time;
+    cat_nsec_t write_wait_time;
+    uint64_t connects;
+    cat_nsec_t connect_time;
+    uint64_t handshakes;
+    cat_nsec_t handshake_time;
+} cat_socket_stats_t;
+
+/* snapshot of TCP_INFO (Linux only) */
+typedef struct cat_socket_tcp_info_s {
+    uint32_t rtt; /* smoothed RTT in microseconds */
+    uint32_t rtt_var;
+    uint32_t retransmits; /* total retransmitted segments */
+    uint32_t lost;
+    uint32_t cwnd; /* congestion window in segments */
+    uint32_t mss;
+} cat_socket_tcp_info_t;
+
 struct cat_socket_internal_s
 {
     /* === public === */
@@ -455,6 +492,7 @@ struct cat_socket_internal_s
     cat_ssl_t *ssl;
     char *ssl_peer_name;
 #endif
+    cat_socket_stats_t *stats;
     /* tree */
     RB_ENTRY(cat_socket_internal_s) tree_entry;
     /* bound socket objects */
@@ -512,11 +550,21 @@ CAT_GLOBALS_STRUCT_BEGIN(cat_socket) {
     struct {
         cat_socket_timeout_options_t timeout;
         unsigned int tcp_keepalive_delay;
+        unsigned int tcp_fastopen_queue_length;
+        unsigned int tcp_defer_accept_timeout;
     } options;
     /* In theory, all internal socket objects should be maintained in the tree,
      * but currently only the internal sockets that need to be used are stored
      * e.g., server sockets for poll module. */
     struct cat_socket_internal_tree_s internal_tree;
+    /* stats */
+    cat_bool_t stats_enabled;
+    cat_socket_stats_t stats;
+    /* proxy */
+    struct {
+        union cat_socket_proxy_buffer_u *head;
+        size_t count;
+    } proxy_buffer_pool;
     /* dns */
     // TODO: dns_cache (we should implement lru_cache)
 } CAT_GLOBALS_STRUCT_END(cat_socket);
@@ -530,6 +578,7 @@ extern CAT_API CAT_GLOBALS_DECLARE(cat_socket);
 CAT_API cat_bool_t cat_socket_module_init(void);
 CAT_API cat_bool_t cat_socket_module_shutdown(void);
 CAT_API cat_bool_t cat_socket_runtime_init(void);
+CAT_API cat_bool_t cat_socket_runtime_shutdown(void);
 
 /* common methods */
 /* tip: functions of fast version will never change the last error */
@@ -591,6 +640,12 @@ CAT_API cat_bool_t cat_socket_bind_to_ex(cat_socket_t *socket, const char *name,
 CAT_API cat_bool_t cat_socket_listen(cat_socket_t *socket, int backlog);
 CAT_API cat_bool_t cat_socket_accept(cat_socket_t *server, cat_socket_t *client);
 CAT_API cat_bool_t cat_socket_accept_ex(cat_socket_t *server, cat_socket_t *client, cat_timeout_t timeout);
+typedef cat_bool_t (*cat_socket_accept_filter_t)(cat_socket_fd_t fd, cat_data_t *data);
+/* accept up to count pending connections at once (it waits only if there is none),
+ * connections must be an array of lazy sockets, filter can reject a connection before it is returned.
+ * it returns the number of accepted connections or -1 on failure */
+CAT_API ssize_t cat_socket_accept_batch(cat_socket_t *server, cat_socket_t *connections, size_t count);
+CAT_API ssize_t cat_socket_accept_batch_ex(cat_socket_t *server, cat_socket_t *connections, size_t count, cat_socket_accept_filter_t filter, cat_data_t *data, cat_timeout_t timeout);
 
 CAT_API cat_bool_t cat_socket_connect(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length);
 CAT_API cat_bool_t cat_socket_connect_ex(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout);
@@ -673,6 +728,17 @@ CAT_API ssize_t cat_socket_try_write(cat_socket_t *socket, const cat_socket_writ
 CAT_API ssize_t cat_socket_try_writeto(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length);
 CAT_API ssize_t cat_socket_try_write_to(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port);
 
+/* write_async: queue data on the write queue of a stream socket and return immediately,
+ * callback will be called with status (0 or E* errno) after data has been written or canceled,
+ * so vector data must be kept alive until then,
+ * it is counted in socket stats once it has been written.
+ * @note it does not support SSL sockets */
+typedef void (*cat_socket_write_async_callback_t)(void *data, cat_errno_t status);
+
+CAT_API cat_bool_t cat_socket_write_async(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, cat_socket_write_async_callback_t callback, void *data);
+/* bytes which have been queued but not yet written */
+CAT_API size_t cat_socket_get_write_queue_size(const cat_socket_t *socket);
+
 CAT_API ssize_t cat_socket_peek(const cat_socket_t *socket, char *buffer, size_t size);
 CAT_API ssize_t cat_socket_peek_ex(const cat_socket_t *socket, char *buffer, size_t size, cat_timeout_t timeout);
 CAT_API ssize_t cat_socket_peekfrom(const cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length);
@@ -686,8 +752,26 @@ CAT_API cat_bool_t cat_socket_send_handle_ex(cat_socket_t *socket, cat_socket_t
 CAT_API ssize_t cat_socket_send_file(cat_socket_t *socket, const char *filename, int64_t offset, size_t length);
 CAT_API ssize_t cat_socket_send_file_ex(cat_socket_t *socket, const char *filename, int64_t offset, size_t length, cat_timeout_t timeout);
 
+typedef struct cat_socket_proxy_options_s {
+    /* proxy fails with ETIMEDOUT if no data moves in either direction within it */
+    cat_timeout_t idle_timeout;
+    /* they are updated in real-time, so other coroutines can observe the traffic */
+    uint64_t a_to_b_bytes;
+    uint64_t b_to_a_bytes;
+} cat_socket_proxy_options_t;
+
+CAT_API void cat_socket_proxy_options_init(cat_socket_proxy_options_t *options);
+/* forward data in both directions until both sides reach EOF,
+ * it uses splice() on Linux (if neither socket is encrypted),
+ * and falls back to the pooled-buffer copying otherwise.
+ * @note options can be NULL */
+CAT_API cat_bool_t cat_socket_proxy(cat_socket_t *a, cat_socket_t *b, cat_socket_proxy_options_t *options);
+
 /* @note last_error will not be updated when close failed,  */
 CAT_API cat_bool_t cat_socket_close(cat_socket_t *socket);
+/* close the connection at once as if an unrecoverable I/O error occurred,
+ * all I/O operations on it will be canceled, but socket still needs to be closed by its owner */
+CAT_API void cat_socket_abort(cat_socket_t *socket);
 
 /* getter */
 
@@ -728,6 +812,9 @@ CAT_API int cat_socket_get_recv_buffer_size(const cat_socket_t *socket);
 CAT_API int cat_socket_get_send_buffer_size(const cat_socket_t *socket);
 CAT_API int cat_socket_set_recv_buffer_size(cat_socket_t *socket, int size);
 CAT_API int cat_socket_set_send_buffer_size(cat_socket_t *socket, int size);
+/* SO_BUSY_POLL (Linux only): the kernel busy-polls the device queue for up to usec on empty reads,
+ * it may require CAP_NET_ADMIN to exceed net.core.busy_read */
+CAT_API cat_bool_t cat_socket_set_busy_poll(cat_socket_t *socket, unsigned int usec);
 
 CAT_API cat_bool_t cat_socket_get_tcp_nodelay(const cat_socket_t *socket);
 CAT_API cat_bool_t cat_socket_set_tcp_nodelay(cat_socket_t *socket, cat_bool_t enable);
@@ -736,6 +823,17 @@ CAT_API cat_bool_t cat_socket_get_tcp_keepalive(const cat_socket_t *socket);
 CAT_API unsigned int cat_socket_get_tcp_keepalive_delay(const cat_socket_t *socket);
 CAT_API cat_bool_t cat_socket_set_tcp_keepalive(cat_socket_t *socket, cat_bool_t enable, unsigned int delay);
 
+/* server: TCP_FASTOPEN with the queue length (0 means default),
+ * client: data of the first send after connect() will be carried in the SYN (Linux only) */
+CAT_API cat_bool_t cat_socket_get_tcp_fastopen(const cat_socket_t *socket);
+CAT_API unsigned int cat_socket_get_tcp_fastopen_queue_length(const cat_socket_t *socket);
+CAT_API cat_bool_t cat_socket_set_tcp_fastopen(cat_socket_t *socket, cat_bool_t enable, unsigned int queue_length);
+
+/* server only: accept() only returns when data has arrived or timeout (seconds, 0 means default) expired */
+CAT_API cat_bool_t cat_socket_get_tcp_defer_accept(const cat_socket_t *socket);
+CAT_API unsigned int cat_socket_get_tcp_defer_accept_timeout(const cat_socket_t *socket);
+CAT_API cat_bool_t cat_socket_set_tcp_defer_accept(cat_socket_t *socket, cat_bool_t enable, unsigned int timeout);
+
 CAT_API cat_bool_t cat_socket_get_udp_broadcast(const cat_socket_t *socket);
 CAT_API cat_bool_t cat_socket_set_udp_broadcast(cat_socket_t *socket, cat_bool_t enable);
 
@@ -743,6 +841,17 @@ CAT_API cat_bool_t cat_socket_set_udp_broadcast(cat_socket_t *socket, cat_bool_t
 
 CAT_API int cat_socket_get_local_free_port(void);
 
+/* sockets which are created after it is enabled will have stats, returns the previous value */
+CAT_API cat_bool_t cat_socket_set_global_stats(cat_bool_t enable);
+CAT_API const cat_socket_stats_t *cat_socket_get_global_stats(void);
+CAT_API void cat_socket_reset_global_stats(void);
+/* enable stats of the socket (and the other sockets which share the same internal one) */
+CAT_API cat_bool_t cat_socket_enable_stats(cat_socket_t *socket);
+/* returns NULL if stats is not enabled */
+CAT_API const cat_socket_stats_t *cat_socket_get_stats(const cat_socket_t *socket);
+CAT_API cat_bool_t cat_socket_get_tcp_info(const cat_socket_t *socket, cat_socket_tcp_info_t *info);
+
+/* stats and TCP info are also printed if they are available */
 CAT_API void cat_socket_dump_all(void);
 CAT_API void cat_socket_close_all(void);
 
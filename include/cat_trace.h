@@ -0,0 +1,149 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#ifndef CAT_TRACE_H
+#define CAT_TRACE_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cat.h"
+
+/* probes are only emitted by the instrumented sources of libcat (they define CAT_TRACE_USE_PROBES),
+ * so that our <sys/sdt.h> settings never leak into consumers */
+#if defined(CAT_HAVE_SDT) && defined(CAT_TRACE_USE_PROBES)
+/* probes are guarded by semaphores, which are set by tracers when they are attached */
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+#endif
+
+/* binary tracing of coroutine and I/O events:
+ * events are recorded as fixed-size records into a ring of the current runtime
+ * (the oldest ones are overwritten), and it can be exported as Chrome trace event JSON
+ * (chrome://tracing or Perfetto), each coroutine is shown as a thread;
+ * it costs a predicted branch when it is not started,
+ * and events are also emitted as USDT probes (provider "libcat") if <sys/sdt.h> is available,
+ * so that they can be consumed by perf/bpftrace without starting it
+ * (another predicted branch on the probe semaphore, arguments are only evaluated when someone is tracing) */
+
+#ifndef CAT_TRACE_DEFAULT_CAPACITY
+#define CAT_TRACE_DEFAULT_CAPACITY (64 * 1024)
+#endif
+
+/* XX(name, phase, title, object, value):
+ * phase and title are used by Chrome trace event (begin and end of a span have the same title),
+ * object and value are names of the arguments (NULL means unused) */
+#define CAT_TRACE_EVENT_MAP(XX) \
+    XX(COROUTINE_CREATE,   "i", "create", "coroutine", "stack_size") \
+    XX(COROUTINE_RESUME,   "i", "resume", "to",        NULL) \
+    XX(COROUTINE_YIELD,    "i", "yield",  "to",        NULL) \
+    XX(COROUTINE_FINISH,   "i", "finish", NULL,        NULL) \
+    XX(SOCKET_READ_START,  "B", "read",   "socket",    "size") \
+    XX(SOCKET_READ_END,    "E", "read",   "socket",    "bytes") \
+    XX(SOCKET_WRITE_START, "B", "write",  "socket",    "size") \
+    XX(SOCKET_WRITE_END,   "E", "write",  "socket",    "bytes") \
+    XX(TIMER_ARM,          "b", "timer",  "timer",     "msec") \
+    XX(TIMER_FIRE,         "e", "timer",  "timer",     NULL) \
+    XX(TIMER_CANCEL,       "e", "timer",  "timer",     NULL) \
+    XX(WORK_SUBMIT,        "b", "work",   "work",      NULL) \
+    XX(WORK_COMPLETE,      "e", "work",   "work",      "status") \
+    XX(DNS_START,          "b", "dns",    "request",   NULL) \
+    XX(DNS_END,            "e", "dns",    "request",   "status") \
+
+typedef enum cat_trace_event_e {
+#define CAT_TRACE_EVENT_GEN(name, phase, title, object, value) CAT_TRACE_EVENT_##name,
+    CAT_TRACE_EVENT_MAP(CAT_TRACE_EVENT_GEN)
+#undef CAT_TRACE_EVENT_GEN
+    CAT_TRACE_EVENT_COUNT
+} cat_trace_event_t;
+
+typedef struct cat_trace_record_s {
+    uint64_t timestamp; /* nanoseconds */
+    uint64_t coroutine_id;
+    uint64_t object; /* id or address, see CAT_TRACE_EVENT_MAP */
+    int64_t value;
+    uint32_t event;
+    uint32_t reserved;
+} cat_trace_record_t;
+
+CAT_GLOBALS_STRUCT_BEGIN(cat_trace) {
+    cat_bool_t enabled;
+    cat_trace_record_t *records;
+    size_t mask; /* capacity - 1 */
+    uint64_t count; /* total number of recorded events */
+} CAT_GLOBALS_STRUCT_END(cat_trace);
+
+extern CAT_API CAT_GLOBALS_DECLARE(cat_trace);
+
+#define CAT_TRACE_G(x) CAT_GLOBALS_GET(cat_trace, x)
+
+#ifdef CAT_HAVE_SDT
+# define CAT_TRACE_PROBE_SEMAPHORE(name) libcat_##name##_semaphore
+# define CAT_TRACE_PROBE_SEMAPHORE_GEN(name, phase, title, object, value) \
+        extern CAT_API volatile unsigned short CAT_TRACE_PROBE_SEMAPHORE(name);
+CAT_TRACE_EVENT_MAP(CAT_TRACE_PROBE_SEMAPHORE_GEN)
+# undef CAT_TRACE_PROBE_SEMAPHORE_GEN
+#endif
+
+#if defined(CAT_HAVE_SDT) && defined(CAT_TRACE_USE_PROBES)
+# define CAT_TRACE_PROBE(name, object, value) do { \
+    if (unlikely(CAT_TRACE_PROBE_SEMAPHORE(name) != 0)) { \
+        DTRACE_PROBE2(libcat, name, (uint64_t) (object), (int64_t) (value)); \
+    } \
+} while (0)
+#else
+# define CAT_TRACE_PROBE(name, object, value)
+#endif
+
+#ifndef CAT_DISABLE_TRACE
+# define CAT_TRACE(name, object, value) do { \
+    CAT_TRACE_PROBE(name, object, value); \
+    if (unlikely(CAT_TRACE_G(enabled))) { \
+        cat_trace_record(CAT_TRACE_EVENT_##name, (uint64_t) (object), (int64_t) (value)); \
+    } \
+} while (0)
+#else
+# define CAT_TRACE(name, object, value)
+#endif
+
+CAT_API cat_bool_t cat_trace_module_init(void);
+CAT_API cat_bool_t cat_trace_module_shutdown(void);
+CAT_API cat_bool_t cat_trace_runtime_init(void);
+CAT_API cat_bool_t cat_trace_runtime_shutdown(void);
+
+/* capacity will be rounded up to power of 2 (0 means default), records of the previous run are dropped */
+CAT_API cat_bool_t cat_trace_start(size_t capacity);
+/* stop recording, records are kept until the next start or runtime shutdown */
+CAT_API void cat_trace_stop(void);
+CAT_API cat_bool_t cat_trace_is_enabled(void);
+
+CAT_API const char *cat_trace_event_name(cat_trace_event_t event);
+CAT_API void cat_trace_record(cat_trace_event_t event, uint64_t object, int64_t value);
+/* number of records in the ring, records are ordered from the oldest one */
+CAT_API size_t cat_trace_get_record_count(void);
+CAT_API const cat_trace_record_t *cat_trace_get_record(size_t index);
+/* total number of events which are overwritten */
+CAT_API uint64_t cat_trace_get_lost_count(void);
+
+/* write records as Chrome trace event JSON (blocking stdio, for debugging) */
+CAT_API cat_bool_t cat_trace_export_chrome(FILE *file);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAT_TRACE_H */
@@ -26,6 +26,7 @@ extern "C" {
 
 #include "cat_coroutine.h"
 #include "cat_atomic.h"
+#include "cat_buffer.h"
 
 #define CAT_WATCH_DOG_DEFAULT_QUANTUM    (5 * 1000 * 1000)
 #define CAT_WATCH_DOG_DEFAULT_THRESHOLD  (10 * 1000 * 1000)
@@ -41,6 +42,47 @@ extern "C" {
 #define CAT_ALERT_COUNT_FMT_SPEC PRIu64
 typedef uint64_t cat_alert_count_t;
 
+/* sampling profiler: watchdog thread signals the runtime thread on each alert (and periodically if interval is set),
+ * and signal handler captures a backtrace of the current coroutine into a ring */
+
+#if defined(CAT_OS_UNIX_LIKE) && (defined(__GLIBC__) || defined(CAT_OS_DARWIN))
+#define CAT_WATCH_DOG_HAVE_SAMPLING 1
+#endif
+
+#ifndef CAT_WATCH_DOG_SAMPLE_SIGNAL
+#define CAT_WATCH_DOG_SAMPLE_SIGNAL SIGPROF
+#endif
+
+#ifndef CAT_WATCH_DOG_SAMPLE_MAX_DEPTH
+#define CAT_WATCH_DOG_SAMPLE_MAX_DEPTH 32
+#endif
+
+#define CAT_WATCH_DOG_DEFAULT_SAMPLE_CAPACITY 4096
+
+typedef enum cat_watchdog_sample_reason_e {
+    CAT_WATCH_DOG_SAMPLE_REASON_ALERT,
+    CAT_WATCH_DOG_SAMPLE_REASON_PERIODIC,
+} cat_watchdog_sample_reason_t;
+
+typedef struct cat_watchdog_sample_s {
+    cat_coroutine_id_t coroutine_id;
+    uint8_t reason;
+    uint8_t depth;
+    void *frames[CAT_WATCH_DOG_SAMPLE_MAX_DEPTH];
+} cat_watchdog_sample_t;
+
+typedef struct cat_watchdog_sampler_s {
+    /* sampling interval (nano seconds), 0 means sampling on alert only */
+    cat_timeout_t interval;
+    /* capacity of the ring (power of 2), oldest samples are overwritten */
+    size_t capacity;
+    /* it is written by signal handler only */
+    cat_atomic_uint64_t head;
+    /* reason of the pending signal */
+    cat_atomic_uint8_t reason;
+    cat_watchdog_sample_t *samples;
+} cat_watchdog_sampler_t;
+
 typedef struct cat_watchdog_s cat_watchdog_t;
 
 typedef void (*cat_watchdog_alerter_t)(cat_watchdog_t *watchdog);
@@ -72,6 +114,9 @@ struct cat_watchdog_s
     uv_sem_t *sem;
     uv_cond_t cond;
     uv_mutex_t mutex;
+    uv_thread_t runtime_thread;
+    cat_watchdog_sampler_t *sampler;
+    cat_atomic_uint8_t preempt_actions;
 };
 
 CAT_API cat_bool_t cat_watchdog_module_init(void);
@@ -84,6 +129,27 @@ CAT_API cat_bool_t cat_watchdog_stop(void);
 
 CAT_API void cat_watchdog_alert_standard(cat_watchdog_t *watchdog);
 
+/* watchdog must be running, interval is in nano seconds (0 means sampling on alert only),
+ * capacity will be aligned to power of 2 (0 means default);
+ * frames are symbolized on export, so the executable should be linked with -rdynamic */
+CAT_API cat_bool_t cat_watchdog_start_sampling(cat_timeout_t interval, size_t capacity);
+CAT_API cat_bool_t cat_watchdog_stop_sampling(void);
+CAT_API cat_bool_t cat_watchdog_is_sampling(void);
+/* number of samples in the ring */
+CAT_API size_t cat_watchdog_get_sample_count(void);
+/* number of samples in the ring which were taken on alert or periodically */
+CAT_API size_t cat_watchdog_get_sample_count_by_reason(cat_watchdog_sample_reason_t reason);
+CAT_API void cat_watchdog_clear_samples(void);
+/* export samples in collapsed-stack format ("root;...;leaf count\n", as flamegraph.pl input),
+ * stacks are prefixed with "coroutine#<id>" if by_coroutine is true */
+CAT_API cat_bool_t cat_watchdog_export_samples(cat_buffer_t *buffer, cat_bool_t by_coroutine);
+
+/* preemption (opt-in): on each alert, watchdog requests the blocking coroutine to yield (YIELD),
+ * and once blocking time reaches threshold, it escalates to LOG and/or CANCEL,
+ * requests are handled when the coroutine reaches cat_coroutine_check_preempt() */
+CAT_API cat_bool_t cat_watchdog_set_preempt_actions(cat_coroutine_preempt_flags_t actions);
+CAT_API cat_coroutine_preempt_flags_t cat_watchdog_get_preempt_actions(void);
+
 CAT_API cat_bool_t cat_watchdog_is_running(void);
 CAT_API cat_timeout_t cat_watchdog_get_quantum(void);
 CAT_API cat_timeout_t cat_watchdog_get_threshold(void);
@@ -23,6 +23,8 @@ extern "C" {
 #endif
 
 #include "cat.h"
+#include "cat_ref.h"
+#include "cat_socket.h"
 
 #define CAT_WEBSOCKET_VERSION                   13
 #define CAT_WEBSOCKET_SECRET_KEY_LENGTH         16
@@ -157,6 +159,144 @@ CAT_API void cat_websocket_mask_ex(const char *from, char *to, uint64_t length,
 CAT_API void cat_websocket_unmask(char *data, uint64_t length, const char *masking_key);
 CAT_API void cat_websocket_unmask_ex(char *data, uint64_t length, const char *masking_key, uint64_t index);
 
+/* name of the vectorized masking kernel selected at runtime ("sse2", "avx2", "neon" or "none") */
+CAT_API const char *cat_websocket_mask_get_kernel_name(void);
+
+/* parser (incremental frame decoder) */
+
+#define CAT_WEBSOCKET_PARSER_EVENT_MAP(XX) \
+    XX(NONE,             0) \
+    XX(FRAME_HEADER,     1 << 0) \
+    XX(PAYLOAD,          1 << 1) \
+    XX(FRAME_COMPLETE,   1 << 2) /* a non-final frame of a fragmented message */ \
+    XX(MESSAGE_COMPLETE, 1 << 3) /* the final frame of a message (or a control frame) */ \
+
+typedef enum cat_websocket_parser_event_e {
+#define CAT_WEBSOCKET_PARSER_EVENT_GEN(name, value) CAT_WEBSOCKET_PARSER_EVENT_##name = value,
+    CAT_WEBSOCKET_PARSER_EVENT_MAP(CAT_WEBSOCKET_PARSER_EVENT_GEN)
+#undef CAT_WEBSOCKET_PARSER_EVENT_GEN
+} cat_websocket_parser_event_t;
+
+typedef enum cat_websocket_parser_flag_e {
+    CAT_WEBSOCKET_PARSER_FLAG_NONE = 0,
+    /* server side: frames from clients must be masked */
+    CAT_WEBSOCKET_PARSER_FLAG_REQUIRE_MASK = 1 << 0,
+    /* an extension (e.g. permessage-deflate) has been negotiated to use RSV1 */
+    CAT_WEBSOCKET_PARSER_FLAG_ALLOW_RSV1 = 1 << 1,
+} cat_websocket_parser_flag_t;
+
+typedef uint8_t cat_websocket_parser_flags_t;
+
+typedef struct cat_websocket_parser_s {
+    /* public writable */
+    cat_websocket_parser_flags_t flags;
+    /* public writable: limit of the message payload length, 0 means unlimited */
+    uint64_t max_message_length;
+    /* public readonly: current event */
+    cat_websocket_parser_event_t event;
+    /* public readonly: header of the current frame (available since FRAME_HEADER event) */
+    cat_websocket_header_t header;
+    /* public readonly: payload length of the current frame */
+    uint64_t payload_length;
+    /* public readonly: how much payload of the current frame has been parsed */
+    uint64_t payload_offset;
+    /* public readonly: opcode of the current data message (TEXT or BINARY, also for continuation frames) */
+    cat_websocket_opcode_t message_opcode;
+    /* public readonly: payload length of the current data message so far */
+    uint64_t message_length;
+    /* public readonly: unmasked payload data of the PAYLOAD event (it points into the input data) */
+    char *data;
+    size_t data_length;
+    /* public readonly: parsed length of the last execution */
+    size_t parsed_length;
+    /* public readonly: suggested close status code on error */
+    cat_websocket_status_code_t error_status;
+    /* private */
+    uint8_t state;
+    uint8_t header_length;
+    cat_bool_t in_message;
+} cat_websocket_parser_t;
+
+CAT_API void cat_websocket_parser_init(cat_websocket_parser_t *parser);
+/* reset parsing state but keep flags and limits */
+CAT_API void cat_websocket_parser_reset(cat_websocket_parser_t *parser);
+/**
+ * execute parser with data, it returns at each event and parser->parsed_length tells how much data was consumed,
+ * payload is unmasked in place, so the data must be writable,
+ * it should be called repeatedly with the rest of data until parser->event is NONE (which means it needs more data),
+ * returns false on protocol error, parser->error_status can be used to close the connection
+ */
+CAT_API cat_bool_t cat_websocket_parser_execute(cat_websocket_parser_t *parser, char *data, size_t length);
+CAT_API const char *cat_websocket_parser_event_get_name(cat_websocket_parser_event_t event);
+CAT_API const char *cat_websocket_parser_get_event_name(const cat_websocket_parser_t *parser);
+/* opcode of the current frame, or the opcode of the message for continuation frames */
+CAT_API cat_websocket_opcode_t cat_websocket_parser_get_opcode(const cat_websocket_parser_t *parser);
+CAT_API cat_bool_t cat_websocket_opcode_is_control(cat_websocket_opcode_t opcode);
+
+/* serializer */
+
+/**
+ * build a frame into header buffer and vector (header + payload), which can be passed to writev()/cat_socket_write()
+ * (cat_io_vector_t has the same layout as cat_socket_write_vector_t),
+ * payload is masked in place if masking_key is not NULL,
+ * returns the number of vectors (1 or 2)
+ */
+CAT_API unsigned int cat_websocket_frame_serialize(
+    cat_websocket_header_t *header, cat_io_vector_t vector[2],
+    cat_websocket_opcode_t opcode, cat_bool_t fin,
+    char *payload, uint64_t payload_length, const char *masking_key
+);
+
+/* broadcast: server frames are unmasked, so a frame can be built once and shared by all recipients */
+
+typedef struct cat_websocket_broadcast_frame_s {
+    CAT_REF_FIELD;
+    unsigned int vector_count;
+    cat_socket_write_vector_t vector[2];
+    cat_websocket_header_t header;
+    char payload[1];
+} cat_websocket_broadcast_frame_t;
+
+typedef enum cat_websocket_broadcast_policy_e {
+    /* skip the frame for the slow consumer */
+    CAT_WEBSOCKET_BROADCAST_POLICY_DROP,
+    /* abort the connection of the slow consumer */
+    CAT_WEBSOCKET_BROADCAST_POLICY_DISCONNECT,
+    /* wait until the slow consumer has written the frame (within timeout),
+     * the connection will be aborted on timeout */
+    CAT_WEBSOCKET_BROADCAST_POLICY_WAIT,
+} cat_websocket_broadcast_policy_t;
+
+typedef struct cat_websocket_broadcast_options_s {
+    cat_websocket_broadcast_policy_t policy;
+    /* a consumer is slow if its queued bytes would exceed it, 0 means unlimited */
+    size_t max_queue_size;
+    /* for WAIT policy, CAT_TIMEOUT_INVALID means using the write timeout of socket */
+    cat_timeout_t timeout;
+} cat_websocket_broadcast_options_t;
+
+typedef struct cat_websocket_broadcast_result_s {
+    size_t queued;
+    size_t written;
+    size_t dropped;
+    size_t disconnected;
+    size_t failed;
+} cat_websocket_broadcast_result_t;
+
+/* payload is copied once, frame is released after all writes are done */
+CAT_API cat_websocket_broadcast_frame_t *cat_websocket_broadcast_frame_create(cat_websocket_opcode_t opcode, const char *payload, size_t payload_length);
+CAT_API void cat_websocket_broadcast_frame_release(cat_websocket_broadcast_frame_t *frame);
+
+CAT_API void cat_websocket_broadcast_options_init(cat_websocket_broadcast_options_t *options);
+/* queue the frame to all sockets without copying it, returns the number of sockets which frame has been queued/written to,
+ * options and result can be NULL */
+CAT_API size_t cat_websocket_broadcast(
+    cat_websocket_broadcast_frame_t *frame,
+    cat_socket_t * const *sockets, size_t count,
+    const cat_websocket_broadcast_options_t *options,
+    cat_websocket_broadcast_result_t *result
+);
+
 #ifdef __cplusplus
 }
 #endif
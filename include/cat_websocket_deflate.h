@@ -0,0 +1,139 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#ifndef CAT_WEBSOCKET_DEFLATE_H
+#define CAT_WEBSOCKET_DEFLATE_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cat.h"
+#include "cat_queue.h"
+#include "cat_buffer.h"
+#include "cat_websocket.h"
+
+#ifdef CAT_HAVE_ZLIB
+#define CAT_WEBSOCKET_DEFLATE 1
+
+#include <zlib.h>
+
+/* permessage-deflate (RFC 7692) */
+
+#define CAT_WEBSOCKET_DEFLATE_EXTENSION_NAME     "permessage-deflate"
+/* zlib does not support window bits of 8 for raw deflate, so we never agree to it for our own deflater
+ * (server_max_window_bits in negotiate(), client_max_window_bits in accept()), inflating with 9 is fine */
+#define CAT_WEBSOCKET_DEFLATE_MIN_WINDOW_BITS    9
+#define CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS    15
+/* client_max_window_bits was offered without value */
+#define CAT_WEBSOCKET_DEFLATE_WINDOW_BITS_ANY    0xff
+
+/* handshake */
+
+typedef struct cat_websocket_deflate_parameters_s {
+    /* 0 means absent */
+    uint8_t server_max_window_bits;
+    /* 0 means absent, or WINDOW_BITS_ANY */
+    uint8_t client_max_window_bits;
+    cat_bool_t server_no_context_takeover;
+    cat_bool_t client_no_context_takeover;
+} cat_websocket_deflate_parameters_t;
+
+CAT_API void cat_websocket_deflate_parameters_init(cat_websocket_deflate_parameters_t *parameters);
+/* parse the first permessage-deflate offer (or response) from the value of Sec-WebSocket-Extensions,
+ * returns false if there is no valid one */
+CAT_API cat_bool_t cat_websocket_deflate_parameters_parse(cat_websocket_deflate_parameters_t *parameters, const char *value, size_t length);
+/* format parameters as an extension value, returns the length (excluding NUL) or 0 if the buffer is too small */
+CAT_API size_t cat_websocket_deflate_parameters_format(const cat_websocket_deflate_parameters_t *parameters, char *buffer, size_t size);
+/* server side: accept the client offer within our limits (max window bits and no-context-takeover requirements),
+ * returns false if it can not be accepted */
+CAT_API cat_bool_t cat_websocket_deflate_parameters_negotiate(
+    const cat_websocket_deflate_parameters_t *offer,
+    const cat_websocket_deflate_parameters_t *limits,
+    cat_websocket_deflate_parameters_t *response
+);
+/* client side: check the server response against our offer,
+ * returns false if the connection must be failed */
+CAT_API cat_bool_t cat_websocket_deflate_parameters_accept(
+    const cat_websocket_deflate_parameters_t *offer,
+    const cat_websocket_deflate_parameters_t *response
+);
+
+/* pool: idle zlib streams can be shared between connections,
+ * it only works for the directions without context takeover (state is dropped after each message anyway) */
+
+typedef struct cat_websocket_deflate_pool_s {
+    cat_queue_t streams;
+    size_t count;
+    size_t max_count;
+} cat_websocket_deflate_pool_t;
+
+CAT_API cat_websocket_deflate_pool_t *cat_websocket_deflate_pool_create(cat_websocket_deflate_pool_t *pool, size_t max_count);
+CAT_API void cat_websocket_deflate_pool_close(cat_websocket_deflate_pool_t *pool);
+
+/* context (one per connection) */
+
+typedef struct cat_websocket_deflate_stream_s cat_websocket_deflate_stream_t;
+
+typedef struct cat_websocket_deflate_options_s {
+    /* zlib compression level, default is Z_DEFAULT_COMPRESSION */
+    int level;
+    /* zlib memory level (1 ~ 9), default is 8,
+     * deflate memory usage is about (1 << (window_bits + 2)) + (1 << (mem_level + 9)) */
+    int mem_level;
+    /* limit of the decompressed message length, 0 means unlimited */
+    size_t max_message_length;
+    /* optional */
+    cat_websocket_deflate_pool_t *pool;
+} cat_websocket_deflate_options_t;
+
+typedef struct cat_websocket_deflate_s {
+    cat_websocket_deflate_options_t options;
+    uint8_t deflate_window_bits;
+    uint8_t inflate_window_bits;
+    cat_bool_t deflate_no_context_takeover;
+    cat_bool_t inflate_no_context_takeover;
+    cat_websocket_deflate_stream_t *deflater;
+    cat_websocket_deflate_stream_t *inflater;
+    size_t inflated_length;
+} cat_websocket_deflate_t;
+
+CAT_API void cat_websocket_deflate_options_init(cat_websocket_deflate_options_t *options);
+
+/* options can be NULL */
+CAT_API cat_websocket_deflate_t *cat_websocket_deflate_create(
+    cat_websocket_deflate_t *deflate,
+    const cat_websocket_deflate_parameters_t *parameters, cat_bool_t is_server,
+    const cat_websocket_deflate_options_t *options
+);
+CAT_API void cat_websocket_deflate_close(cat_websocket_deflate_t *deflate);
+
+/* compress (a part of) a message and append the output to the buffer,
+ * it can be called for each fragment, fin must be set at the last one,
+ * the first frame of the message must have RSV1 set */
+CAT_API cat_bool_t cat_websocket_deflate_compress(cat_websocket_deflate_t *deflate, const char *data, size_t length, cat_bool_t fin, cat_buffer_t *buffer);
+/* decompress (a part of) a message with RSV1 set and append the output to the buffer */
+CAT_API cat_bool_t cat_websocket_deflate_decompress(cat_websocket_deflate_t *deflate, const char *data, size_t length, cat_bool_t fin, cat_buffer_t *buffer);
+/* memory currently held by zlib streams of this connection */
+CAT_API size_t cat_websocket_deflate_get_memory_usage(const cat_websocket_deflate_t *deflate);
+
+#endif /* CAT_HAVE_ZLIB */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAT_WEBSOCKET_DEFLATE_H */
@@ -76,6 +76,10 @@ CAT_API cat_bool_t cat_module_init(void)
 
 CAT_API cat_bool_t cat_module_shutdown(void)
 {
+    if (cat_log_async_is_running()) {
+        (void) cat_log_async_stop();
+    }
+
     cat_error_module_shutdown();
 
     CAT_GLOBALS_UNREGISTER(cat);
@@ -102,6 +106,7 @@ CAT_API cat_bool_t cat_runtime_init(void)
 #endif
     CAT_G(show_last_error) = cat_false;
     memset(&CAT_G(last_error), 0, sizeof(CAT_G(last_error)));
+    cat_slab_runtime_init();
 
     /* error log */
     if (!cat_env_is_empty("CAT_LOG_ERROR_OUTPUT")) {
@@ -196,6 +201,9 @@ CAT_API cat_bool_t cat_runtime_shutdown(void)
 
 CAT_API cat_bool_t cat_runtime_close(void)
 {
+    /* objects may be released until event loop is closed */
+    cat_slab_runtime_close();
+
     CAT_GLOBALS_RUNTIME_CLOSE();
 
     return cat_true;
@@ -38,13 +38,16 @@ CAT_API cat_bool_t cat_shutdown_all(void)
 CAT_API cat_bool_t cat_module_init_all(void)
 {
     return cat_module_init() &&
+           cat_trace_module_init() &&
            cat_coroutine_module_init() &&
            cat_event_module_init() &&
            cat_buffer_module_init() &&
+           cat_buf_chain_module_init() &&
 #ifdef CAT_SSL
            cat_ssl_module_init() &&
 #endif
            cat_socket_module_init() &&
+           cat_http_module_init() &&
 #ifdef CAT_OS_WAIT
            cat_os_wait_module_init() &&
 #endif
@@ -60,9 +63,13 @@ CAT_API cat_bool_t cat_module_shutdown_all(void)
 #ifdef CAT_OS_WAIT
     ret = cat_os_wait_module_shutdown() && ret;
 #endif
+    ret = cat_http_module_shutdown() && ret;
     ret = cat_socket_module_shutdown() && ret;
+    ret = cat_buf_chain_module_shutdown() && ret;
+    ret = cat_buffer_module_shutdown() && ret;
     ret = cat_event_module_shutdown() && ret;
     ret = cat_coroutine_module_shutdown() && ret;
+    ret = cat_trace_module_shutdown() && ret;
     ret = cat_module_shutdown() && ret;
 
     return ret;
@@ -71,9 +78,13 @@ CAT_API cat_bool_t cat_module_shutdown_all(void)
 CAT_API cat_bool_t cat_runtime_init_all(void)
 {
     return cat_runtime_init() &&
+           cat_trace_runtime_init() &&
            cat_coroutine_runtime_init() &&
            cat_event_runtime_init() &&
+           cat_buffer_runtime_init() &&
+           cat_buf_chain_runtime_init() &&
            cat_socket_runtime_init() &&
+           cat_http_runtime_init() &&
 #ifdef CAT_OS_WAIT
            cat_os_wait_runtime_init() &&
 #endif
@@ -89,8 +100,13 @@ CAT_API cat_bool_t cat_runtime_shutdown_all(void)
 #ifdef CAT_OS_WAIT
     ret = cat_os_wait_runtime_shutdown() && ret;
 #endif
+    ret = cat_http_runtime_shutdown() && ret;
+    ret = cat_socket_runtime_shutdown() && ret;
+    ret = cat_buf_chain_runtime_shutdown() && ret;
+    ret = cat_buffer_runtime_shutdown() && ret;
     ret = cat_event_runtime_shutdown() && ret;
     ret = cat_coroutine_runtime_shutdown() && ret;
+    ret = cat_trace_runtime_shutdown() && ret;
     ret = cat_runtime_shutdown() && ret;
 
     return ret;
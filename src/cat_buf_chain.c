@@ -0,0 +1,400 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "cat_buf_chain.h"
+
+#define CAT_BUF_CHAIN_WRITE_VECTOR_COUNT 64
+
+CAT_API CAT_GLOBALS_DECLARE(cat_buf_chain);
+
+CAT_API cat_bool_t cat_buf_chain_module_init(void)
+{
+    CAT_GLOBALS_REGISTER(cat_buf_chain);
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_buf_chain_module_shutdown(void)
+{
+    CAT_GLOBALS_UNREGISTER(cat_buf_chain);
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_buf_chain_runtime_init(void)
+{
+    /* do not touch the cached blocks, runtime may be re-initialized */
+    CAT_BUF_CHAIN_G(pool_size) = CAT_BUF_BLOCK_POOL_SIZE;
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_buf_chain_runtime_shutdown(void)
+{
+    cat_buf_block_t *block = CAT_BUF_CHAIN_G(pool);
+
+    while (block != NULL) {
+        cat_buf_block_t *next = block->next;
+        cat_free(block);
+        block = next;
+    }
+    CAT_BUF_CHAIN_G(pool) = NULL;
+    CAT_BUF_CHAIN_G(pool_count) = 0;
+    /* blocks which are released later will be freed directly */
+    CAT_BUF_CHAIN_G(pool_size) = 0;
+
+    return cat_true;
+}
+
+static cat_buf_block_t *cat_buf_block_alloc(void)
+{
+    cat_buf_block_t *block = CAT_BUF_CHAIN_G(pool);
+
+    if (block != NULL) {
+        CAT_BUF_CHAIN_G(pool) = block->next;
+        CAT_BUF_CHAIN_G(pool_count)--;
+    } else {
+        block = (cat_buf_block_t *) cat_malloc(CAT_BUF_BLOCK_SIZE);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(block == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for buffer block failed");
+            return NULL;
+        }
+#endif
+    }
+    CAT_REF_INIT(block);
+    block->size = CAT_BUF_BLOCK_CAPACITY;
+    block->used = 0;
+    block->next = NULL;
+
+    return block;
+}
+
+static void cat_buf_block_release(cat_buf_block_t *block)
+{
+    if (CAT_REF_DEL(block) != 0) {
+        return;
+    }
+    if (CAT_BUF_CHAIN_G(pool_count) < CAT_BUF_CHAIN_G(pool_size)) {
+        block->next = CAT_BUF_CHAIN_G(pool);
+        CAT_BUF_CHAIN_G(pool) = block;
+        CAT_BUF_CHAIN_G(pool_count)++;
+    } else {
+        cat_free(block);
+    }
+}
+
+/* slice takes the ownership of one reference of block */
+static cat_buf_slice_t *cat_buf_chain_push_slice(cat_buf_chain_t *chain, cat_buf_block_t *block, uint32_t offset, uint32_t length)
+{
+    cat_buf_slice_t *slice;
+
+    slice = (cat_buf_slice_t *) cat_slab_alloc(sizeof(*slice));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(slice == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for buffer slice failed");
+        return NULL;
+    }
+#endif
+    slice->block = block;
+    slice->offset = offset;
+    slice->length = length;
+    cat_queue_push_back(&chain->slices, &slice->node);
+    chain->length += length;
+    chain->count++;
+
+    return slice;
+}
+
+static void cat_buf_chain_remove_slice(cat_buf_chain_t *chain, cat_buf_slice_t *slice)
+{
+    if (unlikely(slice == chain->pending)) {
+        /* give back the reserved space (nobody else can append to the block since it is full) */
+        slice->block->used -= chain->pending_length;
+        chain->pending = NULL;
+        chain->pending_length = 0;
+    }
+    cat_queue_remove(&slice->node);
+    chain->length -= slice->length;
+    chain->count--;
+    cat_buf_block_release(slice->block);
+    cat_slab_free(slice, sizeof(*slice));
+}
+
+/* returns the tail slice if data can be appended to it in place */
+static cat_always_inline cat_buf_slice_t *cat_buf_chain_get_writable_tail(const cat_buf_chain_t *chain)
+{
+    cat_buf_slice_t *slice = cat_queue_back_data(&chain->slices, cat_buf_slice_t, node);
+
+    if (slice != NULL &&
+        slice->offset + slice->length == slice->block->used &&
+        slice->block->used < slice->block->size) {
+        return slice;
+    }
+
+    return NULL;
+}
+
+CAT_API void cat_buf_chain_init(cat_buf_chain_t *chain)
+{
+    chain->length = 0;
+    chain->count = 0;
+    cat_queue_init(&chain->slices);
+    chain->pending = NULL;
+    chain->pending_length = 0;
+}
+
+CAT_API void cat_buf_chain_clear(cat_buf_chain_t *chain)
+{
+    cat_buf_slice_t *slice;
+
+    while ((slice = cat_queue_front_data(&chain->slices, cat_buf_slice_t, node))) {
+        cat_buf_chain_remove_slice(chain, slice);
+    }
+}
+
+CAT_API cat_bool_t cat_buf_chain_append(cat_buf_chain_t *chain, const char *data, size_t length)
+{
+    cat_buf_slice_t *slice = cat_buf_chain_get_writable_tail(chain);
+
+    while (length > 0) {
+        cat_buf_block_t *block;
+        uint32_t n;
+
+        if (slice == NULL) {
+            block = cat_buf_block_alloc();
+#if CAT_ALLOC_HANDLE_ERRORS
+            if (unlikely(block == NULL)) {
+                cat_update_last_error_with_previous("Buffer chain append failed");
+                return cat_false;
+            }
+#endif
+            slice = cat_buf_chain_push_slice(chain, block, 0, 0);
+#if CAT_ALLOC_HANDLE_ERRORS
+            if (unlikely(slice == NULL)) {
+                cat_buf_block_release(block);
+                cat_update_last_error_with_previous("Buffer chain append failed");
+                return cat_false;
+            }
+#endif
+        } else {
+            block = slice->block;
+        }
+        n = (uint32_t) CAT_MIN(length, (size_t) (block->size - block->used));
+        memcpy(block->data + block->used, data, n);
+        block->used += n;
+        slice->length += n;
+        chain->length += n;
+        data += n;
+        length -= n;
+        slice = NULL;
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_buf_chain_append_ref(cat_buf_chain_t *chain, const cat_buf_chain_t *src, size_t offset, size_t length)
+{
+    cat_queue_t *node;
+
+    if (unlikely(offset > src->length)) {
+        cat_update_last_error(CAT_EINVAL, "Buffer chain offset %zu is out of range (length %zu)", offset, src->length);
+        return cat_false;
+    }
+    length = CAT_MIN(length, src->length - offset);
+    /* length was fixed, so that chain can be the same as src */
+    for (node = cat_queue_next(&src->slices); length > 0; node = cat_queue_next(node)) {
+        cat_buf_slice_t *slice = cat_queue_data(node, cat_buf_slice_t, node);
+        uint32_t n;
+
+        if (offset >= slice->length) {
+            offset -= slice->length;
+            continue;
+        }
+        n = (uint32_t) CAT_MIN(length, slice->length - offset);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(cat_buf_chain_push_slice(chain, slice->block, slice->offset + (uint32_t) offset, n) == NULL)) {
+            cat_update_last_error_with_previous("Buffer chain append reference failed");
+            return cat_false;
+        }
+#else
+        (void) cat_buf_chain_push_slice(chain, slice->block, slice->offset + (uint32_t) offset, n);
+#endif
+        CAT_REF_ADD(slice->block);
+        offset = 0;
+        length -= n;
+    }
+
+    return cat_true;
+}
+
+CAT_API char *cat_buf_chain_prepare(cat_buf_chain_t *chain, size_t *available)
+{
+    cat_buf_slice_t *slice = chain->pending;
+    cat_buf_block_t *block;
+
+    if (slice != NULL) {
+        *available = chain->pending_length;
+        return slice->block->data + slice->offset + slice->length;
+    }
+    slice = cat_buf_chain_get_writable_tail(chain);
+    if (slice == NULL) {
+        block = cat_buf_block_alloc();
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(block == NULL)) {
+            cat_update_last_error_with_previous("Buffer chain prepare failed");
+            return NULL;
+        }
+#endif
+        slice = cat_buf_chain_push_slice(chain, block, 0, 0);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(slice == NULL)) {
+            cat_buf_block_release(block);
+            cat_update_last_error_with_previous("Buffer chain prepare failed");
+            return NULL;
+        }
+#endif
+    } else {
+        block = slice->block;
+    }
+    /* reserve all the rest space of block, the caller may yield before commit() */
+    chain->pending = slice;
+    chain->pending_length = block->size - block->used;
+    block->used = block->size;
+    *available = chain->pending_length;
+
+    return block->data + slice->offset + slice->length;
+}
+
+CAT_API cat_bool_t cat_buf_chain_commit(cat_buf_chain_t *chain, size_t length)
+{
+    cat_buf_slice_t *slice = chain->pending;
+    cat_buf_block_t *block;
+
+    if (unlikely(slice == NULL)) {
+        cat_update_last_error(CAT_EMISUSE, "Buffer chain commit without prepare");
+        return cat_false;
+    }
+    if (unlikely(length > chain->pending_length)) {
+        cat_update_last_error(CAT_EINVAL, "Buffer chain commit length %zu is greater than prepared %u", length, chain->pending_length);
+        return cat_false;
+    }
+    block = slice->block;
+    CAT_ASSERT(slice->offset + slice->length + chain->pending_length == block->used);
+    /* give back the unused space */
+    block->used -= chain->pending_length - (uint32_t) length;
+    chain->pending = NULL;
+    chain->pending_length = 0;
+    if (length == 0) {
+        if (slice->length == 0) {
+            cat_buf_chain_remove_slice(chain, slice);
+        }
+        return cat_true;
+    }
+    slice->length += (uint32_t) length;
+    chain->length += length;
+
+    return cat_true;
+}
+
+CAT_API void cat_buf_chain_consume(cat_buf_chain_t *chain, size_t length)
+{
+    cat_queue_t *node = cat_queue_next(&chain->slices);
+
+    while (length > 0 && node != &chain->slices) {
+        cat_buf_slice_t *slice = cat_queue_data(node, cat_buf_slice_t, node);
+        node = cat_queue_next(node);
+        if (slice->length <= length && slice != chain->pending) {
+            length -= slice->length;
+            cat_buf_chain_remove_slice(chain, slice);
+        } else {
+            /* the slice which owns the reserved space is kept even if it becomes empty */
+            uint32_t n = (uint32_t) CAT_MIN(length, (size_t) slice->length);
+            slice->offset += n;
+            slice->length -= n;
+            chain->length -= n;
+            length -= n;
+        }
+    }
+}
+
+static unsigned int cat_buf_chain_fill_vectors(const cat_buf_chain_t *chain, cat_queue_t **from, cat_socket_write_vector_t *vectors, unsigned int max_count)
+{
+    cat_queue_t *queue = (cat_queue_t *) &chain->slices;
+    cat_queue_t *node = *from;
+    unsigned int count = 0;
+
+    for (; node != queue && count < max_count; node = cat_queue_next(node)) {
+        cat_buf_slice_t *slice = cat_queue_data(node, cat_buf_slice_t, node);
+        if (slice->length == 0) {
+            continue;
+        }
+        vectors[count++] = cat_socket_write_vector_init(slice->block->data + slice->offset, slice->length);
+    }
+    *from = node;
+
+    return count;
+}
+
+CAT_API unsigned int cat_buf_chain_get_vectors(const cat_buf_chain_t *chain, cat_socket_write_vector_t *vectors, unsigned int max_count)
+{
+    cat_queue_t *from = cat_queue_next(&chain->slices);
+
+    return cat_buf_chain_fill_vectors(chain, &from, vectors, max_count);
+}
+
+CAT_API cat_bool_t cat_buf_chain_write(const cat_buf_chain_t *chain, cat_socket_t *socket)
+{
+    return cat_buf_chain_write_ex(chain, socket, cat_socket_get_write_timeout(socket));
+}
+
+CAT_API cat_bool_t cat_buf_chain_write_ex(const cat_buf_chain_t *chain, cat_socket_t *socket, cat_timeout_t timeout)
+{
+    cat_socket_write_vector_t vectors[CAT_BUF_CHAIN_WRITE_VECTOR_COUNT];
+    cat_queue_t *from = cat_queue_next(&chain->slices);
+    unsigned int count;
+
+    while ((count = cat_buf_chain_fill_vectors(chain, &from, vectors, CAT_ARRAY_SIZE(vectors))) > 0) {
+        if (unlikely(!cat_socket_write_ex(socket, vectors, count, timeout))) {
+            cat_update_last_error_with_previous("Buffer chain write failed");
+            return cat_false;
+        }
+    }
+
+    return cat_true;
+}
+
+CAT_API size_t cat_buf_chain_copy(const cat_buf_chain_t *chain, size_t offset, char *buffer, size_t length)
+{
+    size_t copied = 0;
+
+    CAT_QUEUE_FOREACH_DATA_START((cat_queue_t *) &chain->slices, cat_buf_slice_t, node, slice) {
+        size_t n;
+        if (copied == length) {
+            break;
+        }
+        if (offset >= slice->length) {
+            offset -= slice->length;
+            continue;
+        }
+        n = CAT_MIN(length - copied, slice->length - offset);
+        memcpy(buffer + copied, slice->block->data + slice->offset + offset, n);
+        copied += n;
+        offset = 0;
+    } CAT_QUEUE_FOREACH_DATA_END();
+
+    return copied;
+}
@@ -17,9 +17,11 @@
  */
 
 #include "cat_buffer.h"
+#include "cat_event.h"
 
 CAT_API cat_buffer_allocator_t cat_buffer_allocator;
 
+#ifdef CAT_BUFFER_USE_SYS_MALLOC
 static char *cat_buffer_alloc_standard(size_t size)
 {
     char *value = (char *) cat_malloc(size);
@@ -52,21 +54,275 @@ static void cat_buffer_free_standard(char *value)
 {
     cat_free(value);
 }
+#endif
+
+/* pool */
+
+CAT_API CAT_GLOBALS_DECLARE(cat_buffer);
+
+struct cat_buffer_pool_object_s {
+    cat_buffer_pool_object_t *next; /* in free list */
+    size_t index; /* CAT_BUFFER_POOL_CLASS_COUNT means it is not pooled */
+};
+
+#define CAT_BUFFER_POOL_HEADER_SIZE CAT_MEMORY_ALIGNED_SIZE_EX(sizeof(cat_buffer_pool_object_t), 16)
+
+#define cat_buffer_pool_object_of(value) \
+    ((cat_buffer_pool_object_t *) (((char *) (value)) - CAT_BUFFER_POOL_HEADER_SIZE))
+
+#define cat_buffer_pool_object_value(object) \
+    (((char *) (object)) + CAT_BUFFER_POOL_HEADER_SIZE)
+
+static cat_always_inline size_t cat_buffer_pool_get_index(size_t size)
+{
+    size_t index = 0, class_size = CAT_BUFFER_POOL_MIN_SIZE;
+
+    if (unlikely(size > CAT_BUFFER_POOL_MAX_SIZE)) {
+        return CAT_BUFFER_POOL_CLASS_COUNT;
+    }
+    while (class_size < size) {
+        class_size <<= 1;
+        index++;
+    }
+
+    return index;
+}
+
+static cat_buffer_pool_object_t *cat_buffer_pool_object_alloc(size_t size, size_t index)
+{
+    cat_buffer_pool_object_t *object;
+
+    if (index < CAT_BUFFER_POOL_CLASS_COUNT) {
+        cat_buffer_pool_class_t *klass = &CAT_BUFFER_G(pool_classes)[index];
+        object = klass->free_list;
+        if (object != NULL) {
+            klass->free_list = object->next;
+            klass->stats.cached--;
+            if (klass->stats.cached < klass->low_cached) {
+                klass->low_cached = klass->stats.cached;
+            }
+        } else {
+            object = (cat_buffer_pool_object_t *) cat_malloc(CAT_BUFFER_POOL_HEADER_SIZE + klass->stats.size);
+#if CAT_ALLOC_HANDLE_ERRORS
+            if (unlikely(object == NULL)) {
+                cat_update_last_error_of_syscall("Malloc for buffer value failed with size %zu", size);
+                return NULL;
+            }
+#endif
+        }
+        klass->stats.allocs++;
+        if (++klass->stats.in_use > klass->stats.peak) {
+            klass->stats.peak = klass->stats.in_use;
+        }
+    } else {
+        object = (cat_buffer_pool_object_t *) cat_malloc(CAT_BUFFER_POOL_HEADER_SIZE + size);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(object == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for buffer value failed with size %zu", size);
+            return NULL;
+        }
+#endif
+    }
+    object->index = index;
+
+    return object;
+}
+
+static void cat_buffer_pool_trim_callback(uv_timer_t *timer);
+
+static void cat_buffer_pool_object_free(cat_buffer_pool_object_t *object)
+{
+    cat_buffer_pool_class_t *klass;
+
+    if (unlikely(object->index == CAT_BUFFER_POOL_CLASS_COUNT)) {
+        cat_free(object);
+        return;
+    }
+    klass = &CAT_BUFFER_G(pool_classes)[object->index];
+    klass->stats.frees++;
+    klass->stats.in_use--;
+    if (unlikely(!CAT_BUFFER_G(pool_enabled) || klass->stats.cached >= klass->stats.max_cached)) {
+        cat_free(object);
+        return;
+    }
+    object->next = klass->free_list;
+    klass->free_list = object;
+    klass->stats.cached++;
+    if (!uv_is_active((uv_handle_t *) &CAT_BUFFER_G(pool_trim_timer))) {
+        (void) uv_timer_start(&CAT_BUFFER_G(pool_trim_timer), cat_buffer_pool_trim_callback, CAT_BUFFER_POOL_TRIM_INTERVAL, CAT_BUFFER_POOL_TRIM_INTERVAL);
+    }
+}
+
+static void cat_buffer_pool_class_release(cat_buffer_pool_class_t *klass, size_t count)
+{
+    while (count-- > 0) {
+        cat_buffer_pool_object_t *object = klass->free_list;
+        klass->free_list = object->next;
+        klass->stats.cached--;
+        klass->stats.trimmed++;
+        cat_free(object);
+    }
+    klass->low_cached = klass->stats.cached;
+}
+
+/* release values which have not been reused since the last round */
+static void cat_buffer_pool_trim_callback(uv_timer_t *timer)
+{
+    size_t index, cached = 0;
+
+    for (index = 0; index < CAT_BUFFER_POOL_CLASS_COUNT; index++) {
+        cat_buffer_pool_class_t *klass = &CAT_BUFFER_G(pool_classes)[index];
+        cat_buffer_pool_class_release(klass, klass->low_cached);
+        cached += klass->stats.cached;
+    }
+    if (cached == 0) {
+        (void) uv_timer_stop(timer);
+    }
+}
+
+CAT_API char *cat_buffer_pool_alloc(size_t size)
+{
+    cat_buffer_pool_object_t *object;
+
+    object = cat_buffer_pool_object_alloc(size, cat_buffer_pool_get_index(size));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(object == NULL)) {
+        return NULL;
+    }
+#endif
+
+    return cat_buffer_pool_object_value(object);
+}
+
+CAT_API char *cat_buffer_pool_realloc(char *old_value, size_t new_size)
+{
+    cat_buffer_pool_object_t *old_object, *new_object;
+    size_t old_index, new_index, copy_size;
+
+    if (old_value == NULL) {
+        return cat_buffer_pool_alloc(new_size);
+    }
+    old_object = cat_buffer_pool_object_of(old_value);
+    old_index = old_object->index;
+    new_index = cat_buffer_pool_get_index(new_size);
+    if (old_index == new_index) {
+        if (old_index < CAT_BUFFER_POOL_CLASS_COUNT) {
+            /* it still fits */
+            return old_value;
+        }
+        new_object = (cat_buffer_pool_object_t *) cat_realloc(old_object, CAT_BUFFER_POOL_HEADER_SIZE + new_size);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(new_object == NULL)) {
+            cat_update_last_error_of_syscall("Realloc for buffer value failed with new size %zu", new_size);
+            return NULL;
+        }
+#endif
+        return cat_buffer_pool_object_value(new_object);
+    }
+    new_object = cat_buffer_pool_object_alloc(new_size, new_index);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(new_object == NULL)) {
+        cat_update_last_error_with_previous("Realloc for buffer value failed with new size %zu", new_size);
+        return NULL;
+    }
+#endif
+    /* we do not know the size of a large one, but it must be larger than the max class */
+    copy_size = old_index < CAT_BUFFER_POOL_CLASS_COUNT ?
+        ((size_t) CAT_BUFFER_POOL_MIN_SIZE << old_index) : CAT_BUFFER_POOL_MAX_SIZE;
+    copy_size = CAT_MIN(copy_size, new_size);
+    memcpy(cat_buffer_pool_object_value(new_object), old_value, copy_size);
+    cat_buffer_pool_object_free(old_object);
+
+    return cat_buffer_pool_object_value(new_object);
+}
+
+CAT_API void cat_buffer_pool_free(char *value)
+{
+    if (value == NULL) {
+        return;
+    }
+    cat_buffer_pool_object_free(cat_buffer_pool_object_of(value));
+}
+
+CAT_API void cat_buffer_pool_trim(void)
+{
+    size_t index;
+
+    for (index = 0; index < CAT_BUFFER_POOL_CLASS_COUNT; index++) {
+        cat_buffer_pool_class_t *klass = &CAT_BUFFER_G(pool_classes)[index];
+        cat_buffer_pool_class_release(klass, klass->stats.cached);
+    }
+}
+
+CAT_API const cat_buffer_pool_stats_t *cat_buffer_pool_get_stats(size_t index)
+{
+    if (unlikely(index >= CAT_BUFFER_POOL_CLASS_COUNT)) {
+        return NULL;
+    }
+    return &CAT_BUFFER_G(pool_classes)[index].stats;
+}
 
 CAT_API cat_bool_t cat_buffer_module_init(void)
 {
+#ifndef CAT_BUFFER_USE_SYS_MALLOC
+    static const cat_buffer_allocator_t allocator = {
+        cat_buffer_pool_alloc,
+        cat_buffer_pool_realloc,
+        NULL,
+        cat_buffer_pool_free
+    };
+#else
     static const cat_buffer_allocator_t allocator = {
         cat_buffer_alloc_standard,
         cat_buffer_realloc_standard,
         NULL,
         cat_buffer_free_standard
     };
+#endif
+    size_t index;
+
+    CAT_GLOBALS_REGISTER(cat_buffer);
+
+    /* values may be allocated before runtime init, they will not be cached */
+    for (index = 0; index < CAT_BUFFER_POOL_CLASS_COUNT; index++) {
+        cat_buffer_pool_stats_t *stats = &CAT_BUFFER_G(pool_classes)[index].stats;
+        stats->size = (size_t) CAT_BUFFER_POOL_MIN_SIZE << index;
+        stats->max_cached = CAT_MAX(1, CAT_MIN(CAT_BUFFER_POOL_CLASS_MAX_COUNT, CAT_BUFFER_POOL_CLASS_MAX_BYTES / stats->size));
+    }
 
     cat_buffer_allocator = allocator;
 
     return cat_true;
 }
 
+CAT_API cat_bool_t cat_buffer_module_shutdown(void)
+{
+    CAT_GLOBALS_UNREGISTER(cat_buffer);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_buffer_runtime_init(void)
+{
+    uv_timer_t *timer = &CAT_BUFFER_G(pool_trim_timer);
+
+    (void) uv_timer_init(&CAT_EVENT_G(loop), timer);
+    uv_unref((uv_handle_t *) timer);
+    CAT_BUFFER_G(pool_enabled) = cat_true;
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_buffer_runtime_shutdown(void)
+{
+    /* values which are freed later will not be cached */
+    CAT_BUFFER_G(pool_enabled) = cat_false;
+    cat_buffer_pool_trim();
+    uv_close((uv_handle_t *) &CAT_BUFFER_G(pool_trim_timer), NULL);
+
+    return cat_true;
+}
+
 CAT_API cat_bool_t cat_buffer_register_allocator(const cat_buffer_allocator_t *allocator)
 {
     if (
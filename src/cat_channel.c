@@ -256,11 +256,13 @@ static cat_bool_t cat_channel_unbuffered_pop(cat_channel_t *channel, cat_data_t
     return cat_true;
 }
 
+#define CAT_CHANNEL_BUCKET_SIZE(data_size) (offsetof(cat_channel_bucket_t, data) + (data_size))
+
 static cat_always_inline cat_channel_bucket_t *cat_channel_buffered_bucket_create(const cat_data_t *data, size_t data_size)
 {
     cat_channel_bucket_t *bucket;
 
-    bucket = (cat_channel_bucket_t *) cat_malloc(offsetof(cat_channel_bucket_t, data) + data_size);
+    bucket = (cat_channel_bucket_t *) cat_slab_alloc(CAT_CHANNEL_BUCKET_SIZE(data_size));
 
 #if CAT_ALLOC_HANDLE_ERRORS
     if (unlikely(bucket == NULL)) {
@@ -303,7 +305,7 @@ static cat_always_inline void cat_channel_buffered_pop_data(cat_channel_t *chann
     } else if (channel->dtor != NULL) {
         channel->dtor(bucket->data);
     }
-    cat_free(bucket);
+    cat_slab_free(bucket, CAT_CHANNEL_BUCKET_SIZE(channel->data_size));
     channel->length--;
 }
 
@@ -469,7 +471,7 @@ CAT_API void cat_channel_cleanup(cat_channel_t *channel)
             if (dtor != NULL) {
                 dtor(bucket->data);
             }
-            cat_free(bucket);
+            cat_slab_free(bucket, CAT_CHANNEL_BUCKET_SIZE(channel->data_size));
             channel->length--;
         }
     }
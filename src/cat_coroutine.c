@@ -18,6 +18,8 @@
 
 #include "cat_coroutine.h"
 #include "cat_time.h"
+#define CAT_TRACE_USE_PROBES
+#include "cat_trace.h"
 
 /* Note: ASan can not work well with mmap()/VirtualAlloc(),
  * Using sys_malloc() so we can get better memory log.
@@ -183,6 +185,11 @@ CAT_API cat_bool_t cat_coroutine_runtime_init(void)
     CAT_COROUTINE_G(count) = 0;
     CAT_COROUTINE_G(peak_count) = 0;
     CAT_COROUTINE_G(switches) = 0;
+    cat_atomic_uint8_init(&CAT_COROUTINE_G(preempt), CAT_COROUTINE_PREEMPT_NONE);
+    cat_atomic_uint64_init(&CAT_COROUTINE_G(preempt_switches), 0);
+    cat_atomic_int64_init(&CAT_COROUTINE_G(preempt_blocking_time), 0);
+    CAT_COROUTINE_G(arena_pool) = NULL;
+    CAT_COROUTINE_G(arena_pool_count) = 0;
 
     /* init main coroutine properties */
     do {
@@ -198,6 +205,7 @@ CAT_API cat_bool_t cat_coroutine_runtime_init(void)
         main_coroutine->next = NULL;
         main_coroutine->stack_size = 0;
         main_coroutine->function = NULL;
+        memset(&main_coroutine->arena, 0, sizeof(main_coroutine->arena));
 #ifdef CAT_COROUTINE_USE_USER_STACK
         main_coroutine->virtual_memory = NULL;
         main_coroutine->virtual_memory_size = 0;
@@ -245,6 +253,14 @@ CAT_API cat_bool_t cat_coroutine_runtime_shutdown(void)
     CAT_ASSERT(cat_coroutine_get_scheduler() == NULL && "Coroutine scheduler should have been stopped");
     CAT_ASSERT(CAT_COROUTINE_G(count) == 1 && "Coroutine count should be 1");
 
+    cat_coroutine_arena_release(CAT_COROUTINE_G(main));
+    while (CAT_COROUTINE_G(arena_pool) != NULL) {
+        cat_coroutine_arena_chunk_t *chunk = CAT_COROUTINE_G(arena_pool);
+        CAT_COROUTINE_G(arena_pool) = chunk->next;
+        cat_free(chunk);
+    }
+    CAT_COROUTINE_G(arena_pool_count) = 0;
+
     return cat_true;
 }
 
@@ -421,10 +437,13 @@ static void cat_coroutine_context_function(cat_coroutine_transfer_t transfer)
     data = coroutine->function(data);
     /* end time */
     coroutine->end_time = cat_coroutine_msec_time();
+    /* release temporaries */
+    cat_coroutine_arena_release(coroutine);
     /* finished */
     CAT_COROUTINE_G(count)--;
     CAT_LOG_DEBUG(COROUTINE, "coroutine_finish(" CAT_COROUTINE_ID_FMT ") (count: " CAT_COROUTINE_COUNT_FMT ")",
         coroutine->id, CAT_COROUTINE_G(count));
+    CAT_TRACE(COROUTINE_FINISH, 0, 0);
     /* mark as dead */
     coroutine->state = CAT_COROUTINE_STATE_DEAD;
     /* yield to previous */
@@ -568,6 +587,7 @@ CAT_API cat_coroutine_t *cat_coroutine_create_ex(cat_coroutine_t *coroutine, cat
     coroutine->end_time = 0;
     coroutine->stack_size = (cat_coroutine_stack_size_t) stack_size;
     coroutine->function = function;
+    memset(&coroutine->arena, 0, sizeof(coroutine->arena));
 #ifdef CAT_COROUTINE_USE_USER_STACK
     coroutine->virtual_memory = virtual_memory;
     coroutine->virtual_memory_size = (uint32_t) virtual_memory_size;
@@ -595,6 +615,7 @@ CAT_API cat_coroutine_t *cat_coroutine_create_ex(cat_coroutine_t *coroutine, cat
         function, stack_size,
         coroutine->id, (int64_t) coroutine->context);
 #endif
+    CAT_TRACE(COROUTINE_CREATE, coroutine->id, stack_size);
 
     return coroutine;
 }
@@ -778,6 +799,7 @@ CAT_API cat_bool_t cat_coroutine_resume(cat_coroutine_t *coroutine, cat_data_t *
     }
 
     CAT_COROUTINE_SWITCH_LOG(resume, coroutine);
+    CAT_TRACE(COROUTINE_RESUME, coroutine->id, 0);
 
     /* 1. common resume flow:
     * +------+  +------+       +------+
@@ -847,6 +869,7 @@ CAT_API cat_bool_t cat_coroutine_yield(cat_data_t *data, cat_data_t **retval)
     }
 
     CAT_COROUTINE_SWITCH_LOG(yield, coroutine);
+    CAT_TRACE(COROUTINE_YIELD, coroutine->id, 0);
 
     /* yield flow:
     * +------+  +------+       +------+
@@ -1199,6 +1222,181 @@ CAT_API cat_coroutine_t *cat_coroutine_run(cat_coroutine_t *coroutine, cat_corou
     return coroutine;
 }
 
+/* arena */
+
+static void *cat_coroutine_arena_alloc_slow(cat_coroutine_arena_t *arena, size_t size)
+{
+    cat_coroutine_arena_chunk_t *chunk;
+    char *payload;
+
+    if (unlikely(size > CAT_COROUTINE_ARENA_LARGE_SIZE)) {
+        chunk = (cat_coroutine_arena_chunk_t *) cat_malloc(sizeof(*chunk) + size);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(chunk == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for coroutine arena chunk failed");
+            return NULL;
+        }
+#endif
+        chunk->size = sizeof(*chunk) + size;
+        /* keep the current chunk in front, so that its remaining space can still be used */
+        if (arena->chunk != NULL) {
+            chunk->next = arena->chunk->next;
+            arena->chunk->next = chunk;
+        } else {
+            chunk->next = NULL;
+            arena->chunk = chunk;
+        }
+        return chunk + 1;
+    }
+    chunk = CAT_COROUTINE_G(arena_pool);
+    if (chunk != NULL) {
+        CAT_COROUTINE_G(arena_pool) = chunk->next;
+        CAT_COROUTINE_G(arena_pool_count)--;
+    } else {
+        chunk = (cat_coroutine_arena_chunk_t *) cat_malloc(CAT_COROUTINE_ARENA_CHUNK_SIZE);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(chunk == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for coroutine arena chunk failed");
+            return NULL;
+        }
+#endif
+        chunk->size = CAT_COROUTINE_ARENA_CHUNK_SIZE;
+    }
+    chunk->next = arena->chunk;
+    arena->chunk = chunk;
+    payload = (char *) (chunk + 1);
+    arena->pos = payload + size;
+    arena->end = ((char *) chunk) + CAT_COROUTINE_ARENA_CHUNK_SIZE;
+
+    return payload;
+}
+
+CAT_API void *cat_coroutine_arena_alloc(size_t size)
+{
+    cat_coroutine_arena_t *arena = &CAT_COROUTINE_G(current)->arena;
+    char *ptr;
+
+    size = CAT_MEMORY_ALIGNED_SIZE(size);
+    if (likely((size_t) (arena->end - arena->pos) >= size)) {
+        ptr = arena->pos;
+        arena->pos += size;
+        return ptr;
+    }
+
+    return cat_coroutine_arena_alloc_slow(arena, size);
+}
+
+CAT_API char *cat_coroutine_arena_strndup(const char *string, size_t length)
+{
+    char *ptr = (char *) cat_coroutine_arena_alloc(length + 1);
+
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(ptr == NULL)) {
+        return NULL;
+    }
+#endif
+    memcpy(ptr, string, length);
+    ptr[length] = '\0';
+
+    return ptr;
+}
+
+CAT_API char *cat_coroutine_arena_vsprintf(const char *format, va_list args)
+{
+    va_list args_copy;
+    char *ptr;
+    int length;
+
+    va_copy(args_copy, args);
+    length = vsnprintf(NULL, 0, format, args_copy);
+    va_end(args_copy);
+    if (unlikely(length < 0)) {
+        cat_update_last_error_of_syscall("Format string failed");
+        return NULL;
+    }
+    ptr = (char *) cat_coroutine_arena_alloc(((size_t) length) + 1);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(ptr == NULL)) {
+        return NULL;
+    }
+#endif
+    (void) vsnprintf(ptr, ((size_t) length) + 1, format, args);
+
+    return ptr;
+}
+
+CAT_API char *cat_coroutine_arena_sprintf(const char *format, ...)
+{
+    va_list args;
+    char *ptr;
+
+    va_start(args, format);
+    ptr = cat_coroutine_arena_vsprintf(format, args);
+    va_end(args);
+
+    return ptr;
+}
+
+CAT_API void cat_coroutine_arena_reset(void)
+{
+    cat_coroutine_arena_release(CAT_COROUTINE_G(current));
+}
+
+CAT_API void cat_coroutine_arena_release(cat_coroutine_t *coroutine)
+{
+    cat_coroutine_arena_t *arena = &coroutine->arena;
+    cat_coroutine_arena_chunk_t *chunk = arena->chunk;
+
+    while (chunk != NULL) {
+        cat_coroutine_arena_chunk_t *next = chunk->next;
+        if (chunk->size == CAT_COROUTINE_ARENA_CHUNK_SIZE &&
+            CAT_COROUTINE_G(arena_pool_count) < CAT_COROUTINE_ARENA_POOL_SIZE) {
+            chunk->next = CAT_COROUTINE_G(arena_pool);
+            CAT_COROUTINE_G(arena_pool) = chunk;
+            CAT_COROUTINE_G(arena_pool_count)++;
+        } else {
+            cat_free(chunk);
+        }
+        chunk = next;
+    }
+    arena->chunk = NULL;
+    arena->pos = NULL;
+    arena->end = NULL;
+}
+
+/* preemption */
+
+CAT_API cat_bool_t cat_coroutine_preempt(void)
+{
+    /* take the request, watchdog publishes switches and blocking time before the flags */
+    cat_coroutine_preempt_flags_t flags = cat_atomic_uint8_exchange(&CAT_COROUTINE_G(preempt), CAT_COROUTINE_PREEMPT_NONE);
+    cat_coroutine_t *coroutine = CAT_COROUTINE_G(current);
+
+    /* the coroutine which was blocking has switched out, the request is out of date */
+    if (unlikely(flags == CAT_COROUTINE_PREEMPT_NONE ||
+                 cat_atomic_uint64_load(&CAT_COROUTINE_G(preempt_switches)) != CAT_COROUTINE_G(switches))) {
+        return cat_true;
+    }
+    if (flags & CAT_COROUTINE_PREEMPT_LOG) {
+        CAT_WARN(COROUTINE, "Coroutine#" CAT_COROUTINE_ID_FMT " has been running for more than " CAT_TIMEOUT_FMT " ns without yielding",
+            coroutine->id, (cat_timeout_t) cat_atomic_int64_load(&CAT_COROUTINE_G(preempt_blocking_time)));
+    }
+    if (unlikely(coroutine == CAT_COROUTINE_G(scheduler) || CAT_COROUTINE_G(switch_denied))) {
+        return cat_true;
+    }
+    if (flags & CAT_COROUTINE_PREEMPT_CANCEL) {
+        cat_update_last_error(CAT_ECANCELED, "Coroutine has been preempted and canceled for running too long");
+        return cat_false;
+    }
+    if (flags & CAT_COROUTINE_PREEMPT_YIELD) {
+        if (unlikely(cat_time_delay(0) == CAT_RET_ERROR)) {
+            return cat_false;
+        }
+    }
+
+    return cat_true;
+}
+
 /* debug */
 
 CAT_API cat_bool_t cat_coroutine_is_deadlocked(void)
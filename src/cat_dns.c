@@ -20,6 +20,8 @@
 #include "cat_coroutine.h"
 #include "cat_event.h"
 #include "cat_time.h"
+#define CAT_TRACE_USE_PROBES
+#include "cat_trace.h"
 
 typedef struct cat_getaddrinfo_context_s {
     union {
@@ -35,6 +37,7 @@ static void cat_dns_getaddrinfo_callback(uv_getaddrinfo_t* request, int status,
 {
     cat_getaddrinfo_context_t *context = cat_container_of(request, cat_getaddrinfo_context_t, request.getaddrinfo);
 
+    CAT_TRACE(DNS_END, (uintptr_t) context, status);
     if (likely(context->request.coroutine != NULL)) {
         context->status = status;
         context->response = response;
@@ -43,7 +46,7 @@ static void cat_dns_getaddrinfo_callback(uv_getaddrinfo_t* request, int status,
         uv_freeaddrinfo(response);
     }
 
-    cat_free(context);
+    cat_slab_free(context, sizeof(*context));
 }
 
 CAT_API struct addrinfo *cat_dns_getaddrinfo(const char *hostname, const char *service, const struct addrinfo *hints)
@@ -53,7 +56,7 @@ CAT_API struct addrinfo *cat_dns_getaddrinfo(const char *hostname, const char *s
 
 CAT_API struct addrinfo *cat_dns_getaddrinfo_ex(const char *hostname, const char *service, const struct addrinfo *hints, cat_timeout_t timeout)
 {
-    cat_getaddrinfo_context_t *context = (cat_getaddrinfo_context_t *) cat_malloc(sizeof(*context));
+    cat_getaddrinfo_context_t *context = (cat_getaddrinfo_context_t *) cat_slab_alloc(sizeof(*context));
     cat_bool_t ret;
     int error;
 
@@ -66,9 +69,10 @@ CAT_API struct addrinfo *cat_dns_getaddrinfo_ex(const char *hostname, const char
     error = uv_getaddrinfo(&CAT_EVENT_G(loop), &context->request.getaddrinfo, cat_dns_getaddrinfo_callback, hostname, service, hints);
     if (error != 0) {
         cat_update_last_error_with_reason(error, "DNS getaddrinfo init failed");
-        cat_free(context);
+        cat_slab_free(context, sizeof(*context));
         return NULL;
     }
+    CAT_TRACE(DNS_START, (uintptr_t) context, 0);
     context->status = CAT_ECANCELED;
     context->request.coroutine = CAT_COROUTINE_G(current);
     ret = cat_time_wait(timeout);
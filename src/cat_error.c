@@ -119,6 +119,7 @@ CAT_API void cat_show_last_error(void)
 #ifndef CAT_IDE_HELPER
 CAT_API CAT_COLD CAT_NORETURN void cat_abort(void)
 {
+    cat_log_async_crash_flush();
     abort();
 }
 #endif
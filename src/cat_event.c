@@ -48,6 +48,8 @@ struct cat_event_io_defer_task_s {
 CAT_API CAT_GLOBALS_DECLARE(cat_event);
 
 static void cat_event_do_io_defer_tasks(uv_check_t *check);
+static void cat_event_busy_poll_close(void);
+static void cat_event_metrics_close(void);
 
 CAT_API cat_bool_t cat_event_module_init(void)
 {
@@ -83,6 +85,26 @@ CAT_API cat_bool_t cat_event_runtime_init(void)
         uv_unref((uv_handle_t *) check);
         check->flags |= UV_HANDLE_INTERNAL;
     } while (0);
+    memset(&CAT_EVENT_G(busy_poll), 0, sizeof(CAT_EVENT_G(busy_poll)));
+    do {
+        uv_loop_t *loop = &CAT_EVENT_G(loop);
+        (void) uv_prepare_init(loop, &CAT_EVENT_G(busy_poll.prepare));
+        (void) uv_check_init(loop, &CAT_EVENT_G(busy_poll.check));
+        (void) uv_idle_init(loop, &CAT_EVENT_G(busy_poll.idle));
+        uv_unref((uv_handle_t *) &CAT_EVENT_G(busy_poll.prepare));
+        uv_unref((uv_handle_t *) &CAT_EVENT_G(busy_poll.check));
+        uv_unref((uv_handle_t *) &CAT_EVENT_G(busy_poll.idle));
+        CAT_EVENT_G(busy_poll.prepare).flags |= UV_HANDLE_INTERNAL;
+        CAT_EVENT_G(busy_poll.check).flags |= UV_HANDLE_INTERNAL;
+        CAT_EVENT_G(busy_poll.idle).flags |= UV_HANDLE_INTERNAL;
+    } while (0);
+    memset(&CAT_EVENT_G(metrics), 0, sizeof(CAT_EVENT_G(metrics)));
+    do {
+        uv_prepare_t *prepare = &CAT_EVENT_G(metrics.prepare);
+        (void) uv_prepare_init(&CAT_EVENT_G(loop), prepare);
+        uv_unref((uv_handle_t *) prepare);
+        prepare->flags |= UV_HANDLE_INTERNAL;
+    } while (0);
 
     return cat_true;
 }
@@ -104,6 +126,8 @@ CAT_API cat_bool_t cat_event_runtime_shutdown(void)
     cat_event_schedule();
 
     uv_close((uv_handle_t *) &CAT_EVENT_G(io_defer_check), NULL);
+    cat_event_busy_poll_close();
+    cat_event_metrics_close();
 
     CAT_ASSERT(cat_queue_empty(&CAT_EVENT_G(runtime_shutdown_tasks)));
     CAT_ASSERT(cat_queue_empty(&CAT_EVENT_G(io_defer_tasks)));
@@ -187,7 +211,7 @@ static void cat_event_loop_defer_task_callback(uv_timer_t *timer)
 static void cat_event_loop_defer_task_free_callback(uv_handle_t *handle)
 {
     cat_event_loop_defer_task_t *task = cat_container_of(handle, cat_event_loop_defer_task_t, u.handle);
-    cat_free(task);
+    cat_slab_free(task, sizeof(*task));
 }
 
 CAT_API cat_event_loop_defer_task_t *cat_event_loop_defer_task_create(
@@ -195,7 +219,7 @@ CAT_API cat_event_loop_defer_task_t *cat_event_loop_defer_task_create(
     cat_data_t *data
 ) {
     cat_event_loop_defer_task_t *task;
-    task = (cat_event_loop_defer_task_t *) cat_malloc_unrecoverable(sizeof(*task));
+    task = (cat_event_loop_defer_task_t *) cat_slab_alloc_unrecoverable(sizeof(*task));
     task->callback = callback;
     task->u.data = data;
     (void) uv_timer_init(&CAT_EVENT_G(loop), &task->u.timer);
@@ -229,7 +253,7 @@ CAT_API cat_event_io_defer_task_t *cat_event_io_defer_task_create(
     cat_event_io_defer_callback_t callback,
     cat_data_t *data
 ) {
-    cat_event_io_defer_task_t *task = (cat_event_io_defer_task_t *) cat_malloc_unrecoverable(sizeof(*task));
+    cat_event_io_defer_task_t *task = (cat_event_io_defer_task_t *) cat_slab_alloc_unrecoverable(sizeof(*task));
     task->callback = callback;
     task->data = data;
     cat_queue_push_back(&CAT_EVENT_G(io_defer_tasks), &task->node);
@@ -243,10 +267,172 @@ CAT_API cat_bool_t cat_event_io_defer_task_close(cat_event_io_defer_task_t *task
     if (!called) {
         cat_queue_remove(&task->node);
     }
-    cat_free(task);
+    cat_slab_free(task, sizeof(*task));
     return called;
 }
 
+/* busy-poll:
+ * an active idle handle makes the loop poll with zero timeout,
+ * the prepare and check handles wrap each poll to see whether it woke up anybody */
+
+static void cat_event_busy_poll_idle_callback(uv_idle_t *idle)
+{
+    (void) idle;
+}
+
+static void cat_event_busy_poll_prepare_callback(uv_prepare_t *prepare)
+{
+    (void) prepare;
+    CAT_EVENT_G(busy_poll.switches) = CAT_COROUTINE_G(switches);
+}
+
+static void cat_event_busy_poll_check_callback(uv_check_t *check)
+{
+    uv_idle_t *idle = &CAT_EVENT_G(busy_poll.idle);
+    cat_nsec_t now = uv_hrtime();
+
+    (void) check;
+    if (!uv_is_active((uv_handle_t *) idle)) {
+        /* we have just been woken up, start spinning */
+        (void) uv_idle_start(idle, cat_event_busy_poll_idle_callback);
+        CAT_EVENT_G(busy_poll.deadline) = now + CAT_EVENT_G(busy_poll.budget);
+        return;
+    }
+    CAT_EVENT_G(busy_poll.stats.spins)++;
+    if (CAT_COROUTINE_G(switches) != CAT_EVENT_G(busy_poll.switches)) {
+        CAT_EVENT_G(busy_poll.stats.hits)++;
+        CAT_EVENT_G(busy_poll.deadline) = now + CAT_EVENT_G(busy_poll.budget);
+    } else if (now >= CAT_EVENT_G(busy_poll.deadline)) {
+        CAT_EVENT_G(busy_poll.stats.sleeps)++;
+        (void) uv_idle_stop(idle);
+    }
+}
+
+CAT_API cat_nsec_t cat_event_get_busy_poll(void)
+{
+    return CAT_EVENT_G(busy_poll.budget);
+}
+
+CAT_API void cat_event_set_busy_poll(cat_nsec_t budget)
+{
+    CAT_EVENT_G(busy_poll.budget) = budget;
+    if (budget > 0) {
+        (void) uv_prepare_start(&CAT_EVENT_G(busy_poll.prepare), cat_event_busy_poll_prepare_callback);
+        (void) uv_check_start(&CAT_EVENT_G(busy_poll.check), cat_event_busy_poll_check_callback);
+        (void) uv_idle_start(&CAT_EVENT_G(busy_poll.idle), cat_event_busy_poll_idle_callback);
+        CAT_EVENT_G(busy_poll.deadline) = uv_hrtime() + budget;
+    } else {
+        (void) uv_prepare_stop(&CAT_EVENT_G(busy_poll.prepare));
+        (void) uv_check_stop(&CAT_EVENT_G(busy_poll.check));
+        (void) uv_idle_stop(&CAT_EVENT_G(busy_poll.idle));
+    }
+}
+
+CAT_API void cat_event_get_busy_poll_stats(cat_event_busy_poll_stats_t *stats)
+{
+    *stats = CAT_EVENT_G(busy_poll.stats);
+}
+
+static void cat_event_busy_poll_close(void)
+{
+    cat_event_set_busy_poll(0);
+    uv_close((uv_handle_t *) &CAT_EVENT_G(busy_poll.prepare), NULL);
+    uv_close((uv_handle_t *) &CAT_EVENT_G(busy_poll.check), NULL);
+    uv_close((uv_handle_t *) &CAT_EVENT_G(busy_poll.idle), NULL);
+}
+
+/* metrics:
+ * the prepare handle runs right before each poll,
+ * so the time between two of them minus the time blocked in poll is the running time of a round */
+
+static void cat_event_metrics_prepare_callback(uv_prepare_t *prepare)
+{
+    cat_nsec_t now = uv_hrtime();
+    cat_nsec_t idle_time = uv_metrics_idle_time(&CAT_EVENT_G(loop));
+    cat_nsec_t lag = (now - CAT_EVENT_G(metrics.last_time)) - (idle_time - CAT_EVENT_G(metrics.last_idle_time));
+    uint64_t lag_us = lag / 1000;
+    size_t bucket = 0;
+
+    (void) prepare;
+    while (lag_us > 0 && bucket < CAT_EVENT_METRICS_LAG_BUCKET_COUNT - 1) {
+        lag_us >>= 1;
+        bucket++;
+    }
+    CAT_EVENT_G(metrics.lag_histogram)[bucket]++;
+    if (lag > CAT_EVENT_G(metrics.max_lag)) {
+        CAT_EVENT_G(metrics.max_lag) = lag;
+    }
+    CAT_EVENT_G(metrics.run_time) += lag;
+    CAT_EVENT_G(metrics.last_time) = now;
+    CAT_EVENT_G(metrics.last_idle_time) = idle_time;
+}
+
+CAT_API cat_bool_t cat_event_get_metrics_enabled(void)
+{
+    return CAT_EVENT_G(metrics.enabled);
+}
+
+CAT_API void cat_event_set_metrics_enabled(cat_bool_t enable)
+{
+    uv_loop_t *loop = &CAT_EVENT_G(loop);
+
+    if (enable == CAT_EVENT_G(metrics.enabled)) {
+        return;
+    }
+    CAT_EVENT_G(metrics.enabled) = enable;
+    if (enable) {
+        /* note: it can not be turned off once it was on, but it is cheap */
+        (void) uv_loop_configure(loop, UV_METRICS_IDLE_TIME);
+        CAT_EVENT_G(metrics.start_time) = CAT_EVENT_G(metrics.last_time) = uv_hrtime();
+        CAT_EVENT_G(metrics.start_idle_time) = CAT_EVENT_G(metrics.last_idle_time) = uv_metrics_idle_time(loop);
+        CAT_EVENT_G(metrics.run_time) = 0;
+        CAT_EVENT_G(metrics.max_lag) = 0;
+        memset(CAT_EVENT_G(metrics.lag_histogram), 0, sizeof(CAT_EVENT_G(metrics.lag_histogram)));
+        (void) uv_prepare_start(&CAT_EVENT_G(metrics.prepare), cat_event_metrics_prepare_callback);
+    } else {
+        (void) uv_prepare_stop(&CAT_EVENT_G(metrics.prepare));
+    }
+}
+
+static void cat_event_metrics_walk_callback(uv_handle_t *handle, void *arg)
+{
+    cat_event_metrics_t *metrics = (cat_event_metrics_t *) arg;
+
+    if (uv_is_active(handle)) {
+        metrics->active_handles++;
+        metrics->active_handles_by_type[handle->type]++;
+    }
+}
+
+CAT_API void cat_event_get_metrics(cat_event_metrics_t *metrics)
+{
+    uv_loop_t *loop = &CAT_EVENT_G(loop);
+
+    memset(metrics, 0, sizeof(*metrics));
+    if (CAT_EVENT_G(metrics.enabled)) {
+        metrics->elapsed_time = uv_hrtime() - CAT_EVENT_G(metrics.start_time);
+        metrics->poll_time = uv_metrics_idle_time(loop) - CAT_EVENT_G(metrics.start_idle_time);
+        metrics->run_time = CAT_EVENT_G(metrics.run_time);
+        metrics->max_lag = CAT_EVENT_G(metrics.max_lag);
+        memcpy(metrics->lag_histogram, CAT_EVENT_G(metrics.lag_histogram), sizeof(metrics->lag_histogram));
+    }
+    metrics->rounds = loop->round;
+    metrics->switches = cat_coroutine_get_global_switches();
+    metrics->coroutines = cat_coroutine_get_count();
+    CAT_QUEUE_FOREACH_START(&CAT_EVENT_G(io_defer_tasks), node) {
+        (void) node;
+        metrics->io_defer_tasks++;
+    } CAT_QUEUE_FOREACH_END();
+    metrics->active_requests = loop->active_reqs.count;
+    uv_walk(loop, cat_event_metrics_walk_callback, metrics);
+}
+
+static void cat_event_metrics_close(void)
+{
+    cat_event_set_metrics_enabled(cat_false);
+    uv_close((uv_handle_t *) &CAT_EVENT_G(metrics.prepare), NULL);
+}
+
 CAT_API void cat_event_fork(void)
 {
 #ifndef CAT_COROUTINE_USE_THREAD_CONTEXT
@@ -442,7 +442,7 @@ CAT_API cat_file_t cat_fs_open(const char *path, cat_fs_open_flags_t flags, ...)
     CAT_LOG_DEBUG_VA(FS, {
         CAT_LOG_DEBUG_D(FS, "open(\"%s\", %s, %04o) = " CAT_FS_FILE_FMT,
             path, flags_str, mode, fd);
-        cat_free(flags_str);
+        cat_buffer_str_free(flags_str);
     });
 
     return fd;
@@ -1058,7 +1058,7 @@ CAT_API int cat_fs_symlink(const char *path, const char *new_path, cat_fs_symlin
     error = cat_fs_symlink_impl(path, new_path, flags);
     CAT_LOG_DEBUG_VA(FS, {
         CAT_LOG_DEBUG_D(FS, "symlink(\"%s\", \"%s\", %s) = " CAT_LOG_INT_RET_FMT, path, new_path, flags_str, CAT_LOG_INT_RET_C(error));
-        cat_free(flags_str);
+        cat_buffer_str_free(flags_str);
     });
     return error;
 }
@@ -1237,7 +1237,7 @@ CAT_API int cat_fs_copyfile(const char *path, const char *new_path, cat_fs_copyf
 
     CAT_LOG_DEBUG_VA(FS, {
         CAT_LOG_DEBUG_D(FS, "copyfile(\"%s\", \"%s\", %s) = " CAT_LOG_INT_RET_FMT, path, new_path, flags_str, CAT_LOG_INT_RET_C(error));
-        cat_free(flags_str);
+        cat_buffer_str_free(flags_str);
     });
 
     return error;
@@ -2773,7 +2773,7 @@ CAT_API int cat_fs_flock(cat_file_t fd, cat_fs_flock_flags_t operation)
 
     CAT_LOG_DEBUG_VA(FS, {
         CAT_LOG_DEBUG_D(FS, "flock(" CAT_FS_FILE_FMT ", %s) = " CAT_LOG_INT_RET_FMT, fd, operation_str, CAT_LOG_INT_RET_C(ret));
-        cat_free(operation_str);
+        cat_buffer_str_free(operation_str);
     });
 
     return ret;
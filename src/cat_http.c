@@ -18,6 +18,19 @@
  */
 
 #include "cat_http.h"
+#include "cat_time.h"
+
+/* globals */
+
+CAT_GLOBALS_STRUCT_BEGIN(cat_http) {
+    cat_msec_t date_second;
+    /* larger than needed to make compiler happy */
+    char date_header[64];
+} CAT_GLOBALS_STRUCT_END(cat_http);
+
+CAT_GLOBALS_DECLARE(cat_http);
+
+#define CAT_HTTP_G(x) CAT_GLOBALS_GET(cat_http, x)
 
 CAT_API const char *cat_http_method_get_name(cat_http_method_t method)
 {
@@ -39,6 +52,59 @@ CAT_API const char *cat_http_status_get_reason(cat_http_status_code_t status)
     return "UNKNOWN";
 }
 
+CAT_API const char *cat_http_status_get_line(cat_http_status_code_t status, size_t *length)
+{
+    switch (status) {
+#define CAT_HTTP_STATUS_LINE_GEN(_, code, reason) case code: \
+        *length = CAT_STRLEN("HTTP/1.1 " #code " " reason "\r\n"); \
+        return "HTTP/1.1 " #code " " reason "\r\n";
+        CAT_HTTP_STATUS_MAP(CAT_HTTP_STATUS_LINE_GEN)
+#undef CAT_HTTP_STATUS_LINE_GEN
+    }
+    *length = 0;
+    return NULL;
+}
+
+/* date */
+
+static void cat_http_render_date_header(char *buffer, size_t size, time_t now)
+{
+    static const char weekdays[7][4] = { "Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed" };
+    static const char months[12][4] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    int64_t days = (int64_t) now / 86400;
+    int64_t seconds = (int64_t) now % 86400;
+    int64_t era, day_of_era, year_of_era, day_of_year, mp, year;
+    unsigned int day, month;
+
+    /* days to civil date, gmtime() is not thread-safe and gmtime_r() is not portable */
+    era = (days + 719468) / 146097;
+    day_of_era = (days + 719468) - era * 146097;
+    year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    mp = (5 * day_of_year + 2) / 153;
+    day = (unsigned int) (day_of_year - (153 * mp + 2) / 5 + 1);
+    month = (unsigned int) (mp < 10 ? mp + 3 : mp - 9);
+    year = year_of_era + era * 400 + (month <= 2);
+
+    (void) snprintf(buffer, size, "Date: %s, %02u %s %04d %02d:%02d:%02d GMT\r\n",
+        weekdays[days % 7], day, months[month - 1], (int) year,
+        (int) (seconds / 3600), (int) (seconds % 3600 / 60), (int) (seconds % 60));
+}
+
+CAT_API const char *cat_http_get_date_header(void)
+{
+    cat_msec_t second = cat_time_msec_cached() / 1000;
+
+    if (unlikely(second != CAT_HTTP_G(date_second) || CAT_HTTP_G(date_header)[0] == '\0')) {
+        struct timespec ts;
+        (void) cat_clock_gettime_realtime(&ts);
+        cat_http_render_date_header(CAT_HTTP_G(date_header), sizeof(CAT_HTTP_G(date_header)), ts.tv_sec);
+        CAT_HTTP_G(date_second) = second;
+    }
+
+    return CAT_HTTP_G(date_header);
+}
+
 #define mt_dbg() do { \
     CAT_LOG_DEBUG_V3(HTTP, "content_type parser %s:%d state %d char %c", __FILE__, __LINE__, state, *p); \
 } while (0)
@@ -140,6 +206,151 @@ static const multipart_parser_settings cat_http_multipart_parser_settings = {
     CAT_HTTP_MULTIPART_CB_FNAME(body_end),
 };
 
+/* http header things */
+
+static const struct {
+    const char *name;
+    size_t length;
+} cat_http_header_names[] = {
+    { "UNKNOWN", 0 },
+#define CAT_HTTP_HEADER_NAME_GEN(_, name) { name, sizeof(name) - 1 },
+    CAT_HTTP_KNOWN_HEADER_MAP(CAT_HTTP_HEADER_NAME_GEN)
+#undef CAT_HTTP_HEADER_NAME_GEN
+};
+
+/* perfect hash of well-known headers, it is collision-free on the length,
+ * the first and the last characters (case-insensitive),
+ * table must be regenerated when CAT_HTTP_KNOWN_HEADER_MAP changes (test will tell) */
+
+#define CAT_HTTP_HEADER_HASH(name, length) \
+    ((((length) * 2) + (((name)[0] | 0x20) * 19) + (((name)[(length) - 1] | 0x20) * 49)) & 63)
+
+static const uint8_t cat_http_header_hash_table[64] = {
+    CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_SEC_WEBSOCKET_VERSION, CAT_HTTP_HEADER_IF_MODIFIED_SINCE, CAT_HTTP_HEADER_UNKNOWN,
+    CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_CONTENT_TYPE, CAT_HTTP_HEADER_UNKNOWN,
+    CAT_HTTP_HEADER_ACCEPT_ENCODING, CAT_HTTP_HEADER_DATE, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN,
+    CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_IF_NONE_MATCH, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN,
+    CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UPGRADE, CAT_HTTP_HEADER_UNKNOWN,
+    CAT_HTTP_HEADER_SEC_WEBSOCKET_KEY, CAT_HTTP_HEADER_RANGE, CAT_HTTP_HEADER_REFERER, CAT_HTTP_HEADER_ORIGIN,
+    CAT_HTTP_HEADER_X_FORWARDED_FOR, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_KEEP_ALIVE, CAT_HTTP_HEADER_AUTHORIZATION,
+    CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_CONTENT_LENGTH, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_CACHE_CONTROL,
+    CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_SEC_WEBSOCKET_PROTOCOL, CAT_HTTP_HEADER_LOCATION, CAT_HTTP_HEADER_UNKNOWN,
+    CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_ACCEPT_LANGUAGE, CAT_HTTP_HEADER_SERVER,
+    CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN,
+    CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN,
+    CAT_HTTP_HEADER_CONTENT_ENCODING, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_SET_COOKIE, CAT_HTTP_HEADER_ACCEPT,
+    CAT_HTTP_HEADER_HOST, CAT_HTTP_HEADER_TRANSFER_ENCODING, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_USER_AGENT,
+    CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_COOKIE, CAT_HTTP_HEADER_CONNECTION,
+    CAT_HTTP_HEADER_SEC_WEBSOCKET_EXTENSIONS, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_UNKNOWN, CAT_HTTP_HEADER_EXPECT,
+};
+
+CAT_API cat_http_header_id_t cat_http_header_lookup(const char *name, size_t length)
+{
+    cat_http_header_id_t id;
+
+    if (unlikely(length == 0)) {
+        return CAT_HTTP_HEADER_UNKNOWN;
+    }
+    id = (cat_http_header_id_t) cat_http_header_hash_table[CAT_HTTP_HEADER_HASH(name, length)];
+    if (id != CAT_HTTP_HEADER_UNKNOWN &&
+        cat_http_header_names[id].length == length &&
+        cat_strncasecmp(cat_http_header_names[id].name, name, length) == 0) {
+        return id;
+    }
+
+    return CAT_HTTP_HEADER_UNKNOWN;
+}
+
+CAT_API const char *cat_http_header_get_name(cat_http_header_id_t id)
+{
+    if (unlikely((size_t) id >= CAT_ARRAY_SIZE(cat_http_header_names))) {
+        return "UNKNOWN";
+    }
+    return cat_http_header_names[id].name;
+}
+
+/* known[] stores position + 1 as uint8_t */
+CAT_STATIC_ASSERT(CAT_HTTP_HEADER_INDEX_MAX_HEADERS <= UINT8_MAX);
+
+typedef enum cat_http_header_index_last_e {
+    CAT_HTTP_HEADER_INDEX_LAST_NONE = 0,
+    CAT_HTTP_HEADER_INDEX_LAST_FIELD,
+    CAT_HTTP_HEADER_INDEX_LAST_VALUE,
+} cat_http_header_index_last_t;
+
+static cat_always_inline void cat_http_header_index_reset(cat_http_header_index_t *index)
+{
+    index->count = 0;
+    index->last = CAT_HTTP_HEADER_INDEX_LAST_NONE;
+    memset(index->known, 0, sizeof(index->known));
+}
+
+CAT_API void cat_http_header_index_init(cat_http_header_index_t *index, const char *base)
+{
+    index->base = base;
+    cat_http_header_index_reset(index);
+}
+
+CAT_API void cat_http_header_index_rebase(cat_http_header_index_t *index, const char *base, size_t consumed)
+{
+    uint16_t i;
+
+    index->base = base;
+    if (consumed == 0) {
+        return;
+    }
+    for (i = 0; i < index->count; i++) {
+        cat_http_header_slice_t *slice = &index->headers[i];
+        CAT_ASSERT(slice->name_offset >= consumed);
+        slice->name_offset -= (uint32_t) consumed;
+        slice->value_offset -= (uint32_t) consumed;
+    }
+}
+
+CAT_API const cat_http_header_slice_t *cat_http_header_index_find(const cat_http_header_index_t *index, cat_http_header_id_t id)
+{
+    uint8_t position;
+
+    if (unlikely(id <= CAT_HTTP_HEADER_UNKNOWN || id >= CAT_HTTP_HEADER_ID_MAX)) {
+        return NULL;
+    }
+    position = index->known[id];
+    if (position == 0) {
+        return NULL;
+    }
+
+    return &index->headers[position - 1];
+}
+
+CAT_API const cat_http_header_slice_t *cat_http_header_index_get(const cat_http_header_index_t *index, const char *name, size_t length)
+{
+    cat_http_header_id_t id = cat_http_header_lookup(name, length);
+    uint16_t i;
+
+    if (id != CAT_HTTP_HEADER_UNKNOWN) {
+        return cat_http_header_index_find(index, id);
+    }
+    for (i = 0; i < index->count; i++) {
+        const cat_http_header_slice_t *slice = &index->headers[i];
+        if (slice->name_length == length &&
+            cat_strncasecmp(index->base + slice->name_offset, name, length) == 0) {
+            return slice;
+        }
+    }
+
+    return NULL;
+}
+
+static void cat_http_header_index_complete_name(cat_http_header_index_t *index)
+{
+    cat_http_header_slice_t *slice = &index->headers[index->count - 1];
+
+    slice->id = cat_http_header_lookup(index->base + slice->name_offset, slice->name_length);
+    if (slice->id != CAT_HTTP_HEADER_UNKNOWN && index->known[slice->id] == 0) {
+        index->known[slice->id] = (uint8_t) index->count;
+    }
+}
+
 /* http parser things */
 
 static cat_always_inline cat_http_parser_t *cat_http_parser_get_from_handle(const llhttp_t *llhttp)
@@ -193,11 +404,76 @@ static int cat_http_parser_on_##name(llhttp_t *llhttp, const char *at, size_t le
 CAT_HTTP_PARSER_ON_DATA_BEGIN(name, NAME) \
 CAT_HTTP_PARSER_ON_DATA_END()
 
-CAT_HTTP_PARSER_ON_EVENT(message_begin, MESSAGE_BEGIN)
+static int cat_http_parser_index_header(cat_http_parser_t *parser, const char *at, size_t length, cat_bool_t is_value)
+{
+    cat_http_header_index_t *index = parser->header_index;
+    cat_http_header_slice_t *slice;
+    uint32_t offset;
+
+    CAT_ASSERT(at >= index->base);
+    offset = (uint32_t) (at - index->base);
+    if (!is_value) {
+        if (index->last == CAT_HTTP_HEADER_INDEX_LAST_FIELD) {
+            slice = &index->headers[index->count - 1];
+            if (slice->name_offset + slice->name_length == offset) {
+                /* split across reads */
+                slice->name_length += (uint32_t) length;
+                slice->value_offset = slice->name_offset + slice->name_length;
+                return CAT_HTTP_PARSER_E_OK;
+            }
+            /* previous header has an empty value */
+            cat_http_header_index_complete_name(index);
+        }
+        if (unlikely(index->count == CAT_HTTP_HEADER_INDEX_MAX_HEADERS)) {
+            cat_http_parser_throw_error(return -1, CAT_HTTP_PARSER_E_HEADER_INDEX,
+                "Too many headers (max %u)", (unsigned int) CAT_HTTP_HEADER_INDEX_MAX_HEADERS);
+        }
+        slice = &index->headers[index->count++];
+        slice->name_offset = offset;
+        slice->name_length = (uint32_t) length;
+        /* keep it valid for rebase even if value is empty */
+        slice->value_offset = offset + (uint32_t) length;
+        slice->value_length = 0;
+        slice->id = CAT_HTTP_HEADER_UNKNOWN;
+        index->last = CAT_HTTP_HEADER_INDEX_LAST_FIELD;
+    } else {
+        if (unlikely(index->count == 0)) {
+            return CAT_HTTP_PARSER_E_OK;
+        }
+        slice = &index->headers[index->count - 1];
+        if (index->last == CAT_HTTP_HEADER_INDEX_LAST_FIELD) {
+            cat_http_header_index_complete_name(index);
+            slice->value_offset = offset;
+            slice->value_length = (uint32_t) length;
+            index->last = CAT_HTTP_HEADER_INDEX_LAST_VALUE;
+        } else {
+            /* split across reads (or obsolete line folding, raw data is kept) */
+            slice->value_length = offset + (uint32_t) length - slice->value_offset;
+        }
+    }
+
+    return CAT_HTTP_PARSER_E_OK;
+}
+
+CAT_HTTP_PARSER_ON_EVENT_BEGIN(message_begin, MESSAGE_BEGIN) {
+    /* pipelining: do not inherit the states of the previous message */
+    parser->content_length = 0;
+    parser->current_chunk_length = 0;
+    parser->multipart_state = CAT_MULTIPART_HEADER_FIELD_STATE_START;
+    parser->multipart.boundary_length = 0;
+    if (parser->header_index != NULL) {
+        cat_http_header_index_reset(parser->header_index);
+    }
+} CAT_HTTP_PARSER_ON_EVENT_END()
 CAT_HTTP_PARSER_ON_DATA (url,           URL          )
 CAT_HTTP_PARSER_ON_DATA (status,        STATUS       )
 
 CAT_HTTP_PARSER_ON_DATA_BEGIN(header_field, HEADER_FIELD) {
+    if (parser->header_index != NULL && length != 0) {
+        if (unlikely(cat_http_parser_index_header(parser, at, length, cat_false) != CAT_HTTP_PARSER_E_OK)) {
+            return -1;
+        }
+    }
     if (! (parser->events & CAT_HTTP_PARSER_EVENT_FLAG_MULTIPART)) {
         _CAT_HTTP_PARSER_ON_EVENT_END();
     }
@@ -217,6 +493,11 @@ CAT_HTTP_PARSER_ON_DATA_BEGIN(header_field, HEADER_FIELD) {
 } CAT_HTTP_PARSER_ON_EVENT_END()
 
 CAT_HTTP_PARSER_ON_DATA_BEGIN(header_value, HEADER_VALUE) {
+    if (parser->header_index != NULL && length != 0) {
+        if (unlikely(cat_http_parser_index_header(parser, at, length, cat_true) != CAT_HTTP_PARSER_E_OK)) {
+            return -1;
+        }
+    }
     if (! (parser->events & CAT_HTTP_PARSER_EVENT_FLAG_MULTIPART)) {
         _CAT_HTTP_PARSER_ON_EVENT_END();
     }
@@ -262,6 +543,11 @@ CAT_HTTP_PARSER_ON_DATA_BEGIN(header_value, HEADER_VALUE) {
 } CAT_HTTP_PARSER_ON_DATA_END()
 
 CAT_HTTP_PARSER_ON_EVENT_BEGIN(headers_complete, HEADERS_COMPLETE) {
+    if (parser->header_index != NULL && parser->header_index->last == CAT_HTTP_HEADER_INDEX_LAST_FIELD) {
+        /* the last header has an empty value */
+        cat_http_header_index_complete_name(parser->header_index);
+        parser->header_index->last = CAT_HTTP_HEADER_INDEX_LAST_VALUE;
+    }
     parser->keep_alive = !!llhttp_should_keep_alive(&parser->llhttp);
     parser->content_length = parser->llhttp.content_length;
     if (! (parser->events & CAT_HTTP_PARSER_EVENT_FLAG_MULTIPART)) {
@@ -370,6 +656,7 @@ CAT_API void cat_http_parser_init(cat_http_parser_t *parser)
     llhttp_init(&parser->llhttp, HTTP_BOTH, &cat_http_parser_settings);
     cat_http_parser__init(parser);
     parser->events = CAT_HTTP_PARSER_EVENTS_NONE;
+    parser->header_index = NULL;
 }
 
 CAT_API void cat_http_parser_reset(cat_http_parser_t *parser)
@@ -741,6 +1028,604 @@ CAT_API cat_bool_t cat_http_parser_is_multipart(const cat_http_parser_t *parser)
     return parser->multipart.boundary_length >= 2;
 }
 
+CAT_API void cat_http_parser_set_header_index(cat_http_parser_t *parser, cat_http_header_index_t *index)
+{
+    parser->header_index = index;
+}
+
+CAT_API cat_http_header_index_t *cat_http_parser_get_header_index(const cat_http_parser_t *parser)
+{
+    return parser->header_index;
+}
+
+/* pipeline */
+
+#define CAT_HTTP_PIPELINE_EVENTS ( \
+    CAT_HTTP_PARSER_EVENT_URL | \
+    CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE | \
+    CAT_HTTP_PARSER_EVENT_BODY | \
+    CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE \
+)
+
+CAT_API cat_http_pipeline_t *cat_http_pipeline_create(cat_http_pipeline_t *pipeline)
+{
+    if (pipeline == NULL) {
+        pipeline = (cat_http_pipeline_t *) cat_malloc(sizeof(*pipeline));
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(pipeline == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for HTTP pipeline failed");
+            return NULL;
+        }
+#endif
+    }
+    cat_http_parser_init(&pipeline->parser);
+    (void) cat_http_parser_set_type(&pipeline->parser, CAT_HTTP_PARSER_TYPE_REQUEST);
+    cat_http_parser_set_events(&pipeline->parser, CAT_HTTP_PIPELINE_EVENTS);
+    cat_http_header_index_init(&pipeline->headers, NULL);
+    cat_http_parser_set_header_index(&pipeline->parser, &pipeline->headers);
+    pipeline->url = NULL;
+    pipeline->url_length = 0;
+    pipeline->body = NULL;
+    pipeline->body_length = 0;
+    pipeline->requests = 0;
+    pipeline->writes = 0;
+    pipeline->idle = cat_false;
+    pipeline->max_request_length = CAT_HTTP_PIPELINE_DEFAULT_MAX_REQUEST_LENGTH;
+    pipeline->max_body_length = SIZE_MAX;
+    pipeline->read_timeout = CAT_TIMEOUT_INVALID;
+    pipeline->idle_timeout = CAT_TIMEOUT_INVALID;
+    pipeline->stopping = cat_false;
+    pipeline->events = CAT_HTTP_PARSER_EVENTS_NONE;
+    pipeline->event_handler = NULL;
+    pipeline->socket = NULL;
+    cat_buffer_init(&pipeline->buffer);
+    cat_buffer_init(&pipeline->body_buffer);
+    cat_buffer_init(&pipeline->response_buffer);
+    pipeline->url_offset = 0;
+    pipeline->vector_count = 0;
+
+    return pipeline;
+}
+
+CAT_API void cat_http_pipeline_close(cat_http_pipeline_t *pipeline)
+{
+    cat_buffer_close(&pipeline->buffer);
+    cat_buffer_close(&pipeline->body_buffer);
+    cat_buffer_close(&pipeline->response_buffer);
+}
+
+static cat_always_inline cat_bool_t cat_http_pipeline_last_vector_is_copied(const cat_http_pipeline_t *pipeline)
+{
+    /* base of copied data is NULL until flush, because response buffer may be reallocated */
+    return pipeline->vector_count > 0 && pipeline->vectors[pipeline->vector_count - 1].base == NULL;
+}
+
+CAT_API cat_bool_t cat_http_pipeline_respond(cat_http_pipeline_t *pipeline, const char *data, size_t length)
+{
+    cat_bool_t merge = cat_http_pipeline_last_vector_is_copied(pipeline);
+
+    if (length == 0) {
+        return cat_true;
+    }
+    if (!merge && pipeline->vector_count == CAT_HTTP_PIPELINE_MAX_VECTORS) {
+        if (unlikely(!cat_http_pipeline_flush(pipeline))) {
+            return cat_false;
+        }
+    }
+    if (unlikely(!cat_buffer_append(&pipeline->response_buffer, data, length))) {
+        return cat_false;
+    }
+    if (merge) {
+        pipeline->vectors[pipeline->vector_count - 1].length += (cat_socket_vector_length_t) length;
+    } else {
+        pipeline->vectors[pipeline->vector_count++] = cat_socket_write_vector_init(NULL, (cat_socket_vector_length_t) length);
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_http_pipeline_respond_static(cat_http_pipeline_t *pipeline, const char *data, size_t length)
+{
+    if (length == 0) {
+        return cat_true;
+    }
+    if (pipeline->vector_count == CAT_HTTP_PIPELINE_MAX_VECTORS) {
+        if (unlikely(!cat_http_pipeline_flush(pipeline))) {
+            return cat_false;
+        }
+    }
+    pipeline->vectors[pipeline->vector_count++] = cat_socket_write_vector_init(data, (cat_socket_vector_length_t) length);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_http_pipeline_flush(cat_http_pipeline_t *pipeline)
+{
+    size_t offset = 0;
+    unsigned int i;
+    cat_bool_t ret;
+
+    if (pipeline->vector_count == 0) {
+        return cat_true;
+    }
+    if (unlikely(pipeline->socket == NULL)) {
+        cat_update_last_error(CAT_EMISUSE, "HTTP pipeline is not running");
+        return cat_false;
+    }
+    for (i = 0; i < pipeline->vector_count; i++) {
+        cat_socket_write_vector_t *vector = &pipeline->vectors[i];
+        if (vector->base == NULL) {
+            vector->base = pipeline->response_buffer.value + offset;
+            offset += vector->length;
+        }
+    }
+    ret = cat_socket_write(pipeline->socket, pipeline->vectors, pipeline->vector_count);
+    pipeline->vector_count = 0;
+    pipeline->writes++;
+    cat_buffer_clear(&pipeline->response_buffer);
+
+    return ret;
+}
+
+static cat_always_inline void cat_http_pipeline_reset_request(cat_http_pipeline_t *pipeline)
+{
+    pipeline->url = NULL;
+    pipeline->url_length = 0;
+    pipeline->body = NULL;
+    pipeline->body_length = 0;
+    cat_buffer_clear(&pipeline->body_buffer);
+}
+
+CAT_API void cat_http_pipeline_set_event_handler(cat_http_pipeline_t *pipeline, cat_http_parser_events_t events, cat_http_pipeline_handler_t handler)
+{
+    pipeline->events = handler != NULL ? events : CAT_HTTP_PARSER_EVENTS_NONE;
+    pipeline->event_handler = handler;
+    cat_http_parser_set_events(&pipeline->parser, CAT_HTTP_PIPELINE_EVENTS | pipeline->events);
+}
+
+CAT_API void cat_http_pipeline_stop(cat_http_pipeline_t *pipeline)
+{
+    pipeline->stopping = cat_true;
+}
+
+CAT_API cat_bool_t cat_http_pipeline_run(cat_http_pipeline_t *pipeline, cat_socket_t *socket, cat_http_pipeline_handler_t handler, void *data)
+{
+    cat_http_parser_t *parser = &pipeline->parser;
+    cat_buffer_t *buffer = &pipeline->buffer;
+    /* offset of the first unfinished request */
+    size_t message_offset = 0;
+    size_t parsed_offset = 0;
+    /* end of headers of the request which is receiving body, body data after it can be dropped */
+    size_t headers_end = 0;
+    size_t body_length = 0;
+    cat_bool_t ret = cat_false;
+
+    pipeline->socket = socket;
+    pipeline->stopping = cat_false;
+    cat_http_parser_reset(parser);
+    cat_http_pipeline_reset_request(pipeline);
+    cat_buffer_clear(buffer);
+    cat_http_header_index_init(&pipeline->headers, NULL);
+
+    while (1) {
+        cat_timeout_t timeout;
+        ssize_t n;
+        if (buffer->length == buffer->size) {
+            if (unlikely(buffer->length >= pipeline->max_request_length)) {
+                cat_update_last_error(CAT_EMSGSIZE, "HTTP request is too large");
+                break;
+            }
+            if (unlikely(!cat_buffer_extend(buffer, CAT_MAX(buffer->length + 1, CAT_BUFFER_COMMON_SIZE)))) {
+                cat_update_last_error_of_syscall("HTTP pipeline buffer extend failed");
+                break;
+            }
+        }
+        /* nothing of the next request has been received */
+        pipeline->idle = buffer->length == 0;
+        if (pipeline->idle && pipeline->stopping) {
+            ret = cat_true;
+            break;
+        }
+        timeout = pipeline->idle ? pipeline->idle_timeout : pipeline->read_timeout;
+        if (timeout == CAT_TIMEOUT_INVALID) {
+            timeout = cat_socket_get_read_timeout(socket);
+        }
+        n = cat_socket_recv_ex(socket, buffer->value + buffer->length, buffer->size - buffer->length, timeout);
+        if (n <= 0) {
+            /* EOF is not an error */
+            ret = n == 0;
+            break;
+        }
+        pipeline->idle = cat_false;
+        buffer->length += n;
+        /* buffer may have been reallocated */
+        cat_http_header_index_rebase(&pipeline->headers, buffer->value, 0);
+        /* message may complete right after headers or body without any more data */
+        while (parsed_offset < buffer->length ||
+               parser->event == CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE ||
+               parser->event == CAT_HTTP_PARSER_EVENT_BODY) {
+            cat_http_parser_event_t event;
+            if (unlikely(!cat_http_parser_execute(parser, buffer->value + parsed_offset, buffer->length - parsed_offset))) {
+                /* send responses of previous requests anyway */
+                (void) cat_http_pipeline_flush(pipeline);
+                goto _out;
+            }
+            parsed_offset += parser->parsed_length;
+            event = parser->event;
+            if (event == CAT_HTTP_PARSER_EVENT_URL) {
+                if (pipeline->url_length == 0) {
+                    pipeline->url_offset = parser->data - buffer->value;
+                }
+                pipeline->url_length += parser->data_length;
+                continue;
+            }
+            if (event == CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE) {
+                pipeline->url = buffer->value + pipeline->url_offset;
+                headers_end = parsed_offset;
+            } else if (event == CAT_HTTP_PARSER_EVENT_BODY) {
+                body_length += parser->data_length;
+                if (unlikely(body_length > pipeline->max_body_length)) {
+                    cat_update_last_error(CAT_EMSGSIZE, "HTTP request body is too large");
+                    (void) cat_http_pipeline_flush(pipeline);
+                    goto _out;
+                }
+                if (!(pipeline->events & CAT_HTTP_PARSER_EVENT_BODY)) {
+                    if (unlikely(!cat_buffer_append(&pipeline->body_buffer, parser->data, parser->data_length))) {
+                        goto _out;
+                    }
+                }
+            } else if (event == CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE) {
+                cat_bool_t stop;
+                pipeline->url = buffer->value + pipeline->url_offset;
+                if (!(pipeline->events & CAT_HTTP_PARSER_EVENT_BODY)) {
+                    pipeline->body = pipeline->body_buffer.value;
+                }
+                pipeline->body_length = body_length;
+                pipeline->requests++;
+                stop = !handler(pipeline, data) ||
+                    pipeline->stopping ||
+                    !cat_http_parser_should_keep_alive(parser) ||
+                    cat_http_parser_is_upgrade(parser);
+                cat_http_pipeline_reset_request(pipeline);
+                cat_http_header_index_init(&pipeline->headers, buffer->value);
+                message_offset = parsed_offset;
+                headers_end = 0;
+                body_length = 0;
+                if (stop) {
+                    ret = cat_http_pipeline_flush(pipeline);
+                    goto _out;
+                }
+                /* a long pipelined batch should not starve the other connections */
+                if (unlikely(!cat_coroutine_check_preempt())) {
+                    (void) cat_http_pipeline_flush(pipeline);
+                    goto _out;
+                }
+                continue;
+            }
+            if ((pipeline->events & event) == event && event != CAT_HTTP_PARSER_EVENT_NONE) {
+                if (!pipeline->event_handler(pipeline, data)) {
+                    ret = cat_http_pipeline_flush(pipeline);
+                    goto _out;
+                }
+            }
+        }
+        /* all buffered requests have been handled, respond them at once */
+        if (unlikely(!cat_http_pipeline_flush(pipeline))) {
+            break;
+        }
+        /* body data has been consumed, only keep the headers */
+        if (headers_end != 0 && parsed_offset > headers_end) {
+            memmove(buffer->value + headers_end, buffer->value + parsed_offset, buffer->length - parsed_offset);
+            buffer->length -= parsed_offset - headers_end;
+            parsed_offset = headers_end;
+        }
+        /* only keep the unfinished request */
+        if (message_offset != 0) {
+            cat_buffer_truncate_from(buffer, message_offset, buffer->length - message_offset);
+            cat_http_header_index_rebase(&pipeline->headers, buffer->value, message_offset);
+            pipeline->url_offset -= CAT_MIN(pipeline->url_offset, message_offset);
+            parsed_offset -= message_offset;
+            if (headers_end != 0) {
+                headers_end -= message_offset;
+            }
+            message_offset = 0;
+        }
+    }
+
+    _out:
+    pipeline->socket = NULL;
+    return ret;
+}
+
+/* response writer */
+
+static const char cat_http_crlf[] = "\r\n";
+static const char cat_http_header_separator[] = ": ";
+
+static cat_always_inline cat_bool_t cat_http_response_writer_reserve(cat_http_response_writer_t *writer, unsigned int count)
+{
+    if (unlikely(writer->ended)) {
+        cat_update_last_error(CAT_EMISUSE, "HTTP response writer has been ended");
+        return cat_false;
+    }
+    if (unlikely(writer->vector_count + count > CAT_HTTP_RESPONSE_WRITER_MAX_VECTORS)) {
+        cat_update_last_error(CAT_ENOBUFS, "HTTP response writer vectors are exhausted (max %u)", (unsigned int) CAT_HTTP_RESPONSE_WRITER_MAX_VECTORS);
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+static cat_always_inline void cat_http_response_writer_push(cat_http_response_writer_t *writer, const char *data, size_t length)
+{
+    writer->vectors[writer->vector_count++] = cat_socket_write_vector_init(data, (cat_socket_vector_length_t) length);
+}
+
+CAT_API void cat_http_response_writer_init(cat_http_response_writer_t *writer, cat_http_status_code_t status)
+{
+    const char *line;
+    size_t length;
+
+    writer->vector_count = 0;
+    writer->scratch_length = 0;
+    writer->ended = cat_false;
+    line = cat_http_status_get_line(status, &length);
+    if (unlikely(line == NULL)) {
+        /* unknown status, reason phrase can be empty */
+        length = (size_t) snprintf(writer->scratch, sizeof(writer->scratch), "HTTP/1.1 %03u \r\n", (unsigned int) status);
+        line = writer->scratch;
+        writer->scratch_length = (unsigned int) length;
+    }
+    cat_http_response_writer_push(writer, line, length);
+}
+
+CAT_API cat_bool_t cat_http_response_writer_add_header(cat_http_response_writer_t *writer, const char *name, size_t name_length, const char *value, size_t value_length)
+{
+    if (unlikely(!cat_http_response_writer_reserve(writer, 4))) {
+        return cat_false;
+    }
+    cat_http_response_writer_push(writer, name, name_length);
+    cat_http_response_writer_push(writer, cat_http_header_separator, CAT_STRLEN(cat_http_header_separator));
+    cat_http_response_writer_push(writer, value, value_length);
+    cat_http_response_writer_push(writer, cat_http_crlf, CAT_STRLEN(cat_http_crlf));
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_http_response_writer_add_header_line(cat_http_response_writer_t *writer, const char *line, size_t length)
+{
+    if (unlikely(!cat_http_response_writer_reserve(writer, 1))) {
+        return cat_false;
+    }
+    cat_http_response_writer_push(writer, line, length);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_http_response_writer_add_date(cat_http_response_writer_t *writer)
+{
+    return cat_http_response_writer_add_header_line(writer, cat_http_get_date_header(), CAT_HTTP_DATE_HEADER_LENGTH);
+}
+
+CAT_API cat_bool_t cat_http_response_writer_add_content_length(cat_http_response_writer_t *writer, uint64_t length)
+{
+    char *line = writer->scratch + writer->scratch_length;
+    size_t size = sizeof(writer->scratch) - writer->scratch_length;
+    char digits[20];
+    size_t n = 0, line_length;
+
+    if (unlikely(!cat_http_response_writer_reserve(writer, 1))) {
+        return cat_false;
+    }
+    if (unlikely(size < sizeof("Content-Length: 18446744073709551615\r\n") - 1)) {
+        cat_update_last_error(CAT_ENOBUFS, "HTTP response writer scratch buffer is exhausted");
+        return cat_false;
+    }
+    do {
+        digits[n++] = (char) ('0' + (length % 10));
+        length /= 10;
+    } while (length != 0);
+    memcpy(line, "Content-Length: ", CAT_STRLEN("Content-Length: "));
+    line_length = CAT_STRLEN("Content-Length: ");
+    while (n > 0) {
+        line[line_length++] = digits[--n];
+    }
+    line[line_length++] = '\r';
+    line[line_length++] = '\n';
+    writer->scratch_length += (unsigned int) line_length;
+    cat_http_response_writer_push(writer, line, line_length);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_http_response_writer_add_chunked(cat_http_response_writer_t *writer)
+{
+    return cat_http_response_writer_add_header_line(writer, CAT_STRL("Transfer-Encoding: chunked\r\n"));
+}
+
+CAT_API cat_bool_t cat_http_response_writer_end(cat_http_response_writer_t *writer, const char *body, size_t body_length)
+{
+    if (unlikely(!cat_http_response_writer_reserve(writer, body_length > 0 ? 2 : 1))) {
+        return cat_false;
+    }
+    cat_http_response_writer_push(writer, cat_http_crlf, CAT_STRLEN(cat_http_crlf));
+    if (body_length > 0) {
+        cat_http_response_writer_push(writer, body, body_length);
+    }
+    writer->ended = cat_true;
+
+    return cat_true;
+}
+
+CAT_API const cat_socket_write_vector_t *cat_http_response_writer_get_vectors(const cat_http_response_writer_t *writer, unsigned int *count)
+{
+    *count = writer->vector_count;
+    return writer->vectors;
+}
+
+CAT_API size_t cat_http_response_writer_get_length(const cat_http_response_writer_t *writer)
+{
+    size_t length = 0;
+    unsigned int i;
+
+    for (i = 0; i < writer->vector_count; i++) {
+        length += writer->vectors[i].length;
+    }
+
+    return length;
+}
+
+CAT_API cat_bool_t cat_http_pipeline_respond_writer(cat_http_pipeline_t *pipeline, const cat_http_response_writer_t *writer)
+{
+    unsigned int i;
+
+    if (unlikely(!writer->ended)) {
+        cat_update_last_error(CAT_EMISUSE, "HTTP response writer has not been ended");
+        return cat_false;
+    }
+    for (i = 0; i < writer->vector_count; i++) {
+        if (unlikely(!cat_http_pipeline_respond(pipeline, writer->vectors[i].base, writer->vectors[i].length))) {
+            return cat_false;
+        }
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_http_response_writer_write(const cat_http_response_writer_t *writer, cat_socket_t *socket)
+{
+    if (unlikely(!writer->ended)) {
+        cat_update_last_error(CAT_EMISUSE, "HTTP response writer has not been ended");
+        return cat_false;
+    }
+
+    return cat_socket_write(socket, writer->vectors, writer->vector_count);
+}
+
+/* chunked writer */
+
+CAT_API size_t cat_http_chunk_header_render(char *buffer, uint64_t length)
+{
+    static const char hex[] = "0123456789abcdef";
+    char digits[16];
+    size_t n = 0, i = 0;
+
+    do {
+        digits[n++] = hex[length & 0xf];
+        length >>= 4;
+    } while (length != 0);
+    while (n > 0) {
+        buffer[i++] = digits[--n];
+    }
+    buffer[i++] = '\r';
+    buffer[i++] = '\n';
+
+    return i;
+}
+
+CAT_API cat_http_chunked_writer_t *cat_http_chunked_writer_create(cat_http_chunked_writer_t *writer, cat_socket_t *socket)
+{
+    if (writer == NULL) {
+        writer = (cat_http_chunked_writer_t *) cat_malloc(sizeof(*writer));
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(writer == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for HTTP chunked writer failed");
+            return NULL;
+        }
+#endif
+    }
+    writer->chunks = 0;
+    writer->bytes = 0;
+    writer->coalesce_size = CAT_HTTP_CHUNKED_WRITER_DEFAULT_COALESCE_SIZE;
+    writer->socket = socket;
+    cat_buffer_init(&writer->buffer);
+    writer->ended = cat_false;
+
+    return writer;
+}
+
+CAT_API void cat_http_chunked_writer_close(cat_http_chunked_writer_t *writer)
+{
+    cat_buffer_close(&writer->buffer);
+}
+
+/* buffered data and data are sent as one chunk, then the last chunk (if it is the end) */
+static cat_bool_t cat_http_chunked_writer_send(cat_http_chunked_writer_t *writer, const char *data, size_t length, cat_bool_t end, const char *trailers, size_t trailers_length)
+{
+    cat_socket_write_vector_t vectors[7];
+    char header[CAT_HTTP_CHUNK_HEADER_MAX_LENGTH];
+    size_t chunk_length = writer->buffer.length + length;
+    unsigned int count = 0;
+    cat_bool_t ret;
+
+    if (unlikely(writer->ended)) {
+        cat_update_last_error(CAT_EMISUSE, "HTTP chunked writer has been ended");
+        return cat_false;
+    }
+    if (chunk_length > 0) {
+        vectors[count++] = cat_socket_write_vector_init(header, (cat_socket_vector_length_t) cat_http_chunk_header_render(header, chunk_length));
+        if (writer->buffer.length > 0) {
+            vectors[count++] = cat_socket_write_vector_init(writer->buffer.value, (cat_socket_vector_length_t) writer->buffer.length);
+        }
+        if (length > 0) {
+            vectors[count++] = cat_socket_write_vector_init(data, (cat_socket_vector_length_t) length);
+        }
+        vectors[count++] = cat_socket_write_vector_init(CAT_STRL("\r\n"));
+    }
+    if (end) {
+        vectors[count++] = cat_socket_write_vector_init(CAT_STRL("0\r\n"));
+        if (trailers_length > 0) {
+            vectors[count++] = cat_socket_write_vector_init(trailers, (cat_socket_vector_length_t) trailers_length);
+        }
+        vectors[count++] = cat_socket_write_vector_init(CAT_STRL("\r\n"));
+        writer->ended = cat_true;
+    }
+    if (count == 0) {
+        return cat_true;
+    }
+    ret = cat_socket_write(writer->socket, vectors, count);
+    if (chunk_length > 0) {
+        writer->chunks++;
+        writer->bytes += chunk_length;
+    }
+    cat_buffer_clear(&writer->buffer);
+
+    return ret;
+}
+
+CAT_API cat_bool_t cat_http_chunked_writer_write(cat_http_chunked_writer_t *writer, const char *data, size_t length)
+{
+    if (unlikely(writer->ended)) {
+        cat_update_last_error(CAT_EMISUSE, "HTTP chunked writer has been ended");
+        return cat_false;
+    }
+    if (length == 0) {
+        return cat_true;
+    }
+    if (length >= writer->coalesce_size) {
+        /* large write goes out at once with the pending data, without copy */
+        return cat_http_chunked_writer_send(writer, data, length, cat_false, NULL, 0);
+    }
+    if (unlikely(!cat_buffer_append(&writer->buffer, data, length))) {
+        return cat_false;
+    }
+    if (writer->buffer.length >= writer->coalesce_size) {
+        return cat_http_chunked_writer_send(writer, NULL, 0, cat_false, NULL, 0);
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_http_chunked_writer_flush(cat_http_chunked_writer_t *writer)
+{
+    return cat_http_chunked_writer_send(writer, NULL, 0, cat_false, NULL, 0);
+}
+
+CAT_API cat_bool_t cat_http_chunked_writer_end(cat_http_chunked_writer_t *writer, const char *trailers, size_t trailers_length)
+{
+    return cat_http_chunked_writer_send(writer, NULL, 0, cat_true, trailers, trailers_length);
+}
+
 /* module */
 
 static void cat_http_parser_update_last_error(cat_http_parser_internal_errno_t error, const char *format, ...)
@@ -761,9 +1646,36 @@ static const char *cat_http_parser_strerrno_function(cat_errno_t error)
     return NULL;
 }
 
+CAT_API cat_bool_t cat_http_parser_is_errno(cat_errno_t error)
+{
+    return cat_http_parser_strerrno_function(error) != NULL;
+}
+
 CAT_API cat_bool_t cat_http_module_init(void)
 {
+    CAT_GLOBALS_REGISTER(cat_http);
+
     cat_strerrno_handler_register(cat_http_parser_strerrno_function);
 
     return cat_true;
 }
+
+CAT_API cat_bool_t cat_http_module_shutdown(void)
+{
+    CAT_GLOBALS_UNREGISTER(cat_http);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_http_runtime_init(void)
+{
+    CAT_HTTP_G(date_second) = 0;
+    CAT_HTTP_G(date_header)[0] = '\0';
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_http_runtime_shutdown(void)
+{
+    return cat_true;
+}
@@ -0,0 +1,643 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "cat_http_client.h"
+#include "cat_coroutine.h"
+#include "cat_time.h"
+
+typedef struct cat_http_client_host_s {
+    cat_queue_node_t node;
+    cat_queue_t idle_connections;
+    /* coroutines which are waiting for a free connection */
+    cat_queue_t waiters;
+    size_t connections;
+    /* it is NULL after client closed, busy connections use the copy of options */
+    cat_http_client_t *client;
+    cat_http_client_options_t options;
+    int port;
+    cat_bool_t ssl;
+    size_t name_length;
+    char name[1];
+} cat_http_client_host_t;
+
+typedef struct cat_http_client_connection_s {
+    cat_queue_node_t node;
+    cat_http_client_host_t *host;
+    cat_socket_t socket;
+    cat_http_parser_t parser;
+    /* received but not parsed data (of pipelined responses) */
+    cat_buffer_t buffer;
+    /* request lines and headers */
+    cat_buffer_t write_buffer;
+    cat_bool_t reused;
+} cat_http_client_connection_t;
+
+#define CAT_HTTP_CLIENT_PARSER_EVENTS ( \
+    CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE | \
+    CAT_HTTP_PARSER_EVENT_BODY | \
+    CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE \
+)
+
+CAT_API void cat_http_client_options_init(cat_http_client_options_t *options)
+{
+    options->connect_timeout = CAT_TIMEOUT_INVALID;
+    options->handshake_timeout = CAT_TIMEOUT_INVALID;
+    options->write_timeout = CAT_TIMEOUT_INVALID;
+    options->read_timeout = CAT_TIMEOUT_INVALID;
+    options->max_connections_per_host = CAT_HTTP_CLIENT_DEFAULT_MAX_CONNECTIONS_PER_HOST;
+    options->max_idle_connections_per_host = CAT_HTTP_CLIENT_DEFAULT_MAX_IDLE_CONNECTIONS_PER_HOST;
+    options->max_response_length = CAT_HTTP_CLIENT_DEFAULT_MAX_RESPONSE_LENGTH;
+#ifdef CAT_SSL
+    options->crypto_options = NULL;
+#endif
+}
+
+CAT_API cat_http_client_t *cat_http_client_create(cat_http_client_t *client, const cat_http_client_options_t *options)
+{
+    if (client == NULL) {
+        client = (cat_http_client_t *) cat_malloc(sizeof(*client));
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(client == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for HTTP client failed");
+            return NULL;
+        }
+#endif
+    }
+    if (options != NULL) {
+        client->options = *options;
+    } else {
+        cat_http_client_options_init(&client->options);
+    }
+    client->connects = 0;
+    client->reuses = 0;
+    client->requests = 0;
+    cat_queue_init(&client->hosts);
+
+    return client;
+}
+
+static void cat_http_client_connection_free(cat_http_client_connection_t *connection)
+{
+    cat_http_client_host_t *host = connection->host;
+
+    host->connections--;
+    (void) cat_socket_close(&connection->socket);
+    cat_buffer_close(&connection->buffer);
+    cat_buffer_close(&connection->write_buffer);
+    cat_free(connection);
+}
+
+static void cat_http_client_host_free(cat_http_client_host_t *host)
+{
+    cat_http_client_connection_t *connection;
+    cat_coroutine_t *waiter;
+
+    while ((connection = cat_queue_front_data(&host->idle_connections, cat_http_client_connection_t, node))) {
+        cat_queue_remove(&connection->node);
+        cat_http_client_connection_free(connection);
+    }
+    if (host->connections == 0) {
+        cat_queue_remove(&host->node);
+        cat_free(host);
+        return;
+    }
+    /* it will be freed by the last connection */
+    host->client = NULL;
+    /* waiters will find that client has been closed (they remove themselves from the queue) */
+    while ((waiter = cat_queue_front_data(&host->waiters, cat_coroutine_t, waiter.node))) {
+        cat_coroutine_schedule(waiter, HTTP, "HTTP client connection waiter");
+    }
+}
+
+CAT_API void cat_http_client_close(cat_http_client_t *client)
+{
+    cat_http_client_host_t *host;
+
+    while ((host = cat_queue_front_data(&client->hosts, cat_http_client_host_t, node))) {
+        cat_queue_remove(&host->node);
+        cat_queue_init(&host->node);
+        cat_http_client_host_free(host);
+    }
+}
+
+CAT_API void cat_http_client_request_init(cat_http_client_request_t *request)
+{
+    request->method = "GET";
+    request->method_length = CAT_STRLEN("GET");
+    request->path = "/";
+    request->path_length = CAT_STRLEN("/");
+    request->headers = NULL;
+    request->headers_length = 0;
+    request->body = NULL;
+    request->body_length = 0;
+}
+
+CAT_API void cat_http_client_response_init(cat_http_client_response_t *response)
+{
+    response->status = 0;
+    response->keep_alive = cat_false;
+    cat_buffer_init(&response->header_buffer);
+    cat_http_header_index_init(&response->headers, NULL);
+    cat_buffer_init(&response->body);
+}
+
+CAT_API void cat_http_client_response_close(cat_http_client_response_t *response)
+{
+    cat_buffer_close(&response->header_buffer);
+    cat_buffer_close(&response->body);
+}
+
+CAT_API const char *cat_http_client_response_get_header(const cat_http_client_response_t *response, const char *name, size_t name_length, size_t *value_length)
+{
+    const cat_http_header_slice_t *slice = cat_http_header_index_get(&response->headers, name, name_length);
+
+    if (slice == NULL) {
+        return NULL;
+    }
+    *value_length = slice->value_length;
+
+    return cat_http_header_index_get_value(&response->headers, slice);
+}
+
+static void cat_http_client_response_reset(cat_http_client_response_t *response)
+{
+    response->status = 0;
+    response->keep_alive = cat_false;
+    cat_buffer_clear(&response->header_buffer);
+    cat_http_header_index_init(&response->headers, NULL);
+    cat_buffer_clear(&response->body);
+}
+
+/* pool */
+
+static cat_http_client_host_t *cat_http_client_get_host(cat_http_client_t *client, const char *name, size_t name_length, int port, cat_bool_t ssl)
+{
+    cat_http_client_host_t *host;
+
+    CAT_QUEUE_FOREACH_DATA_START(&client->hosts, cat_http_client_host_t, node, host) {
+        if (host->port == port && host->ssl == ssl &&
+            host->name_length == name_length && cat_strncasecmp(host->name, name, name_length) == 0) {
+            return host;
+        }
+    } CAT_QUEUE_FOREACH_DATA_END();
+
+    host = (cat_http_client_host_t *) cat_malloc(offsetof(cat_http_client_host_t, name) + name_length + 1);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(host == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for HTTP client host failed");
+        return NULL;
+    }
+#endif
+    cat_queue_init(&host->idle_connections);
+    cat_queue_init(&host->waiters);
+    host->connections = 0;
+    host->client = client;
+    host->options = client->options;
+    host->port = port;
+    host->ssl = ssl;
+    host->name_length = name_length;
+    memcpy(host->name, name, name_length);
+    host->name[name_length] = '\0';
+    cat_queue_push_back(&client->hosts, &host->node);
+
+    return host;
+}
+
+static cat_http_client_connection_t *cat_http_client_connect(cat_http_client_host_t *host)
+{
+    const cat_http_client_options_t *options = &host->options;
+    cat_http_client_connection_t *connection;
+
+    connection = (cat_http_client_connection_t *) cat_malloc(sizeof(*connection));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(connection == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for HTTP client connection failed");
+        return NULL;
+    }
+#endif
+    if (unlikely(cat_socket_create(&connection->socket, CAT_SOCKET_TYPE_TCP) == NULL)) {
+        cat_free(connection);
+        return NULL;
+    }
+    connection->host = host;
+    host->connections++;
+    cat_http_parser_init(&connection->parser);
+    (void) cat_http_parser_set_type(&connection->parser, CAT_HTTP_PARSER_TYPE_RESPONSE);
+    cat_http_parser_set_events(&connection->parser, CAT_HTTP_CLIENT_PARSER_EVENTS);
+    cat_buffer_init(&connection->buffer);
+    cat_buffer_init(&connection->write_buffer);
+    connection->reused = cat_false;
+    if (options->read_timeout != CAT_TIMEOUT_INVALID) {
+        (void) cat_socket_set_read_timeout(&connection->socket, options->read_timeout);
+    }
+    if (options->write_timeout != CAT_TIMEOUT_INVALID) {
+        (void) cat_socket_set_write_timeout(&connection->socket, options->write_timeout);
+    }
+    if (unlikely(!cat_socket_connect_to_ex(&connection->socket, host->name, host->name_length, host->port,
+            options->connect_timeout != CAT_TIMEOUT_INVALID ? options->connect_timeout : cat_socket_get_connect_timeout(&connection->socket)))) {
+        cat_update_last_error_with_previous("HTTP client connect to %s:%d failed", host->name, host->port);
+        goto _error;
+    }
+    if (host->ssl) {
+#ifdef CAT_SSL
+        if (unlikely(!cat_socket_enable_crypto_ex(&connection->socket, options->crypto_options,
+                options->handshake_timeout != CAT_TIMEOUT_INVALID ? options->handshake_timeout : cat_socket_get_handshake_timeout(&connection->socket)))) {
+            cat_update_last_error_with_previous("HTTP client TLS handshake with %s:%d failed", host->name, host->port);
+            goto _error;
+        }
+#else
+        cat_update_last_error(CAT_ENOTSUP, "HTTP client TLS is not supported without SSL");
+        goto _error;
+#endif
+    }
+    if (host->client != NULL) {
+        host->client->connects++;
+    }
+
+    return connection;
+
+    _error:
+    cat_http_client_connection_free(connection);
+    return NULL;
+}
+
+static cat_http_client_connection_t *cat_http_client_acquire(cat_http_client_host_t *host)
+{
+    const cat_http_client_options_t *options = &host->options;
+
+    while (1) {
+        cat_http_client_connection_t *connection;
+        cat_queue_node_t *waiter;
+        cat_bool_t ret;
+
+        if (unlikely(host->client == NULL)) {
+            cat_update_last_error(CAT_ECANCELED, "HTTP client has been closed");
+            return NULL;
+        }
+        /* LIFO, the most recently used connection is the least likely to be closed by peer */
+        while ((connection = cat_queue_back_data(&host->idle_connections, cat_http_client_connection_t, node))) {
+            cat_queue_remove(&connection->node);
+            if (likely(cat_socket_check_liveness(&connection->socket))) {
+                connection->reused = cat_true;
+                host->client->reuses++;
+                return connection;
+            }
+            cat_http_client_connection_free(connection);
+        }
+        if (options->max_connections_per_host == 0 || host->connections < options->max_connections_per_host) {
+            return cat_http_client_connect(host);
+        }
+        /* wait for a connection to be released */
+        waiter = &CAT_COROUTINE_G(current)->waiter.node;
+        cat_queue_push_back(&host->waiters, waiter);
+        ret = cat_time_wait(options->connect_timeout != CAT_TIMEOUT_INVALID ? options->connect_timeout : cat_socket_get_global_connect_timeout());
+        cat_queue_remove(waiter);
+        if (unlikely(!ret)) {
+            cat_update_last_error_with_previous("HTTP client waiting for a free connection to %s:%d failed", host->name, host->port);
+            return NULL;
+        }
+    }
+}
+
+static void cat_http_client_release(cat_http_client_connection_t *connection, cat_bool_t reusable)
+{
+    cat_http_client_host_t *host = connection->host;
+    cat_coroutine_t *waiter;
+    size_t idle_count = 0;
+
+    if (reusable && host->client != NULL && connection->buffer.length == 0) {
+        CAT_QUEUE_FOREACH_START(&host->idle_connections, node) {
+            (void) node;
+            idle_count++;
+        } CAT_QUEUE_FOREACH_END();
+        reusable = idle_count < host->options.max_idle_connections_per_host;
+    } else {
+        reusable = cat_false;
+    }
+    if (reusable) {
+        cat_queue_push_back(&host->idle_connections, &connection->node);
+    } else {
+        cat_http_client_connection_free(connection);
+    }
+    if (host->client == NULL) {
+        /* client has been closed */
+        if (host->connections == 0) {
+            cat_free(host);
+        }
+        return;
+    }
+    waiter = cat_queue_front_data(&host->waiters, cat_coroutine_t, waiter.node);
+    if (waiter != NULL) {
+        cat_coroutine_schedule(waiter, HTTP, "HTTP client connection waiter");
+    }
+}
+
+/* request */
+
+static cat_bool_t cat_http_client_method_is(const cat_http_client_request_t *request, const char *method, size_t length)
+{
+    return request->method_length == length && memcmp(request->method, method, length) == 0;
+}
+
+/* requests which can be retried automatically, see RFC 9110 section 9.2.2 */
+static cat_bool_t cat_http_client_requests_are_idempotent(const cat_http_client_request_t *requests, size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        const cat_http_client_request_t *request = &requests[i];
+        if (!(cat_http_client_method_is(request, CAT_STRL("GET")) ||
+              cat_http_client_method_is(request, CAT_STRL("HEAD")) ||
+              cat_http_client_method_is(request, CAT_STRL("OPTIONS")) ||
+              cat_http_client_method_is(request, CAT_STRL("PUT")) ||
+              cat_http_client_method_is(request, CAT_STRL("DELETE")))) {
+            return cat_false;
+        }
+    }
+
+    return cat_true;
+}
+
+static cat_bool_t cat_http_client_write_requests(cat_http_client_connection_t *connection, const cat_http_client_request_t *requests, size_t count)
+{
+    cat_http_client_host_t *host = connection->host;
+    cat_buffer_t *buffer = &connection->write_buffer;
+    cat_socket_write_vector_t _vectors[4 * 4], *vectors = _vectors;
+    size_t *offsets, _offsets[4 * 2];
+    unsigned int vector_count = 0;
+    /* IPv6 literal must be enclosed in brackets (RFC 3986 section 3.2.2) */
+    cat_bool_t ipv6 = memchr(host->name, ':', host->name_length) != NULL;
+    /* connection will never be pooled, let server close it after the last response */
+    cat_bool_t keep_alive = host->options.max_idle_connections_per_host != 0;
+    cat_bool_t ret = cat_false;
+    size_t i;
+
+    if (count > 4) {
+        vectors = (cat_socket_write_vector_t *) cat_malloc(sizeof(*vectors) * count * 4 + sizeof(*offsets) * count * 2);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(vectors == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for HTTP client vectors failed");
+            return cat_false;
+        }
+#endif
+        offsets = (size_t *) (vectors + count * 4);
+    } else {
+        offsets = _offsets;
+    }
+    /* render request lines and generated headers, user headers and body are referenced */
+    cat_buffer_clear(buffer);
+    for (i = 0; i < count; i++) {
+        const cat_http_client_request_t *request = &requests[i];
+        offsets[i * 2] = buffer->length;
+        if (unlikely(!cat_buffer_append_printf(buffer, "%.*s %.*s HTTP/1.1\r\nHost: %s%s%s",
+                (int) request->method_length, request->method,
+                (int) request->path_length, request->path,
+                ipv6 ? "[" : "", host->name, ipv6 ? "]" : ""))) {
+            goto _out;
+        }
+        if ((host->ssl && host->port != 443) || (!host->ssl && host->port != 80)) {
+            if (unlikely(!cat_buffer_append_printf(buffer, ":%d", host->port))) {
+                goto _out;
+            }
+        }
+        if (unlikely(!cat_buffer_append(buffer, CAT_STRL("\r\n")))) {
+            goto _out;
+        }
+        offsets[i * 2 + 1] = buffer->length;
+        if (request->body_length != 0 ||
+            !(cat_http_client_method_is(request, CAT_STRL("GET")) || cat_http_client_method_is(request, CAT_STRL("HEAD")))) {
+            if (unlikely(!cat_buffer_append_printf(buffer, "Content-Length: %zu\r\n", request->body_length))) {
+                goto _out;
+            }
+        }
+        if (unlikely(!cat_buffer_append_printf(buffer, "Connection: %s\r\n\r\n",
+                keep_alive || i + 1 < count ? "keep-alive" : "close"))) {
+            goto _out;
+        }
+    }
+    for (i = 0; i < count; i++) {
+        const cat_http_client_request_t *request = &requests[i];
+        size_t end = i + 1 < count ? offsets[(i + 1) * 2] : buffer->length;
+        vectors[vector_count++] = cat_socket_write_vector_init(buffer->value + offsets[i * 2], (cat_socket_vector_length_t) (offsets[i * 2 + 1] - offsets[i * 2]));
+        if (request->headers_length != 0) {
+            vectors[vector_count++] = cat_socket_write_vector_init(request->headers, (cat_socket_vector_length_t) request->headers_length);
+        }
+        vectors[vector_count++] = cat_socket_write_vector_init(buffer->value + offsets[i * 2 + 1], (cat_socket_vector_length_t) (end - offsets[i * 2 + 1]));
+        if (request->body_length != 0) {
+            vectors[vector_count++] = cat_socket_write_vector_init(request->body, (cat_socket_vector_length_t) request->body_length);
+        }
+    }
+    ret = cat_socket_write(&connection->socket, vectors, vector_count);
+    if (unlikely(!ret)) {
+        cat_update_last_error_with_previous("HTTP client send request failed");
+    }
+
+    _out:
+    if (vectors != _vectors) {
+        cat_free(vectors);
+    }
+    return ret;
+}
+
+/* response */
+
+static cat_bool_t cat_http_client_read_response(cat_http_client_connection_t *connection, cat_bool_t is_head, cat_http_client_response_t *response, cat_bool_t *received)
+{
+    const cat_http_client_options_t *options = &connection->host->options;
+    cat_http_parser_t *parser = &connection->parser;
+    cat_buffer_t *buffer = &connection->buffer;
+    /* buffer always starts with unparsed data here */
+    size_t message_offset = 0, parsed_offset = 0;
+    cat_bool_t headers_completed = cat_false, interim = cat_false;
+
+    cat_http_client_response_reset(response);
+    cat_http_header_index_init(&response->headers, buffer->value);
+    cat_http_parser_set_header_index(parser, &response->headers);
+    *received = buffer->length != 0;
+
+    while (1) {
+        ssize_t n;
+        /* message may complete right after headers or body without any more data */
+        while (parsed_offset < buffer->length ||
+               parser->event == CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE ||
+               parser->event == CAT_HTTP_PARSER_EVENT_BODY) {
+            if (unlikely(!cat_http_parser_execute(parser, buffer->value + parsed_offset, buffer->length - parsed_offset))) {
+                return cat_false;
+            }
+            parsed_offset += parser->parsed_length;
+            if (parser->event == CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE) {
+                response->status = cat_http_parser_get_status_code(parser);
+                /* skip 1xx responses (e.g. 100-continue), they are completed without body */
+                if (response->status >= 100 && response->status < 200 && response->status != 101) {
+                    interim = cat_true;
+                    continue;
+                }
+                if (unlikely(!cat_buffer_append(&response->header_buffer, buffer->value + message_offset, parsed_offset - message_offset))) {
+                    return cat_false;
+                }
+                cat_http_header_index_rebase(&response->headers, response->header_buffer.value, message_offset);
+                /* trailers are not indexed */
+                cat_http_parser_set_header_index(parser, NULL);
+                headers_completed = cat_true;
+                if (is_head) {
+                    /* there is no body even if Content-Length is present */
+                    response->keep_alive = cat_http_parser_should_keep_alive(parser);
+                    cat_http_parser_reset(parser);
+                    goto _completed;
+                }
+            } else if (parser->event == CAT_HTTP_PARSER_EVENT_BODY) {
+                if (unlikely(response->header_buffer.length + response->body.length + parser->data_length > options->max_response_length)) {
+                    cat_update_last_error(CAT_EMSGSIZE, "HTTP response is too large");
+                    return cat_false;
+                }
+                if (unlikely(!cat_buffer_append(&response->body, parser->data, parser->data_length))) {
+                    return cat_false;
+                }
+            } else if (parser->event == CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE) {
+                if (interim) {
+                    interim = cat_false;
+                    message_offset = parsed_offset;
+                    cat_http_header_index_init(&response->headers, buffer->value);
+                    continue;
+                }
+                response->keep_alive = cat_http_parser_should_keep_alive(parser);
+                goto _completed;
+            }
+        }
+        /* drop parsed data, only headers of the current response should be kept */
+        if (headers_completed) {
+            cat_buffer_clear(buffer);
+            parsed_offset = 0;
+        } else if (message_offset != 0) {
+            cat_buffer_truncate_from(buffer, message_offset, buffer->length - message_offset);
+            cat_http_header_index_rebase(&response->headers, buffer->value, message_offset);
+            parsed_offset -= message_offset;
+            message_offset = 0;
+        }
+        if (buffer->length == buffer->size) {
+            if (unlikely(buffer->length >= options->max_response_length)) {
+                cat_update_last_error(CAT_EMSGSIZE, "HTTP response header is too large");
+                return cat_false;
+            }
+            if (unlikely(!cat_buffer_extend(buffer, CAT_MAX(buffer->length + 1, CAT_BUFFER_COMMON_SIZE)))) {
+                cat_update_last_error_of_syscall("HTTP client buffer extend failed");
+                return cat_false;
+            }
+        }
+        n = cat_socket_recv(&connection->socket, buffer->value + buffer->length, buffer->size - buffer->length);
+        if (unlikely(n <= 0)) {
+            if (n == 0) {
+                /* body may be delimited by EOF */
+                if (headers_completed && cat_http_parser_finish(parser) && cat_http_parser_is_completed(parser)) {
+                    response->keep_alive = cat_false;
+                    goto _completed;
+                }
+                cat_update_last_error(CAT_ECONNRESET, "HTTP client connection closed before response completed");
+            } else {
+                cat_update_last_error_with_previous("HTTP client receive response failed");
+            }
+            return cat_false;
+        }
+        *received = cat_true;
+        buffer->length += n;
+        if (!headers_completed) {
+            /* buffer may have been reallocated */
+            cat_http_header_index_rebase(&response->headers, buffer->value, 0);
+        }
+    }
+
+    _completed:
+    /* keep data of the following responses */
+    cat_buffer_truncate_from(buffer, parsed_offset, buffer->length - parsed_offset);
+    cat_http_parser_set_header_index(parser, NULL);
+    return cat_true;
+}
+
+static cat_bool_t cat_http_client_do(cat_http_client_t *client, const char *name, size_t name_length, int port, cat_bool_t ssl, const cat_http_client_request_t *requests, cat_http_client_response_t *responses, size_t count)
+{
+    cat_http_client_host_t *host;
+    int retries = 1;
+
+#ifndef CAT_SSL
+    if (unlikely(ssl)) {
+        cat_update_last_error(CAT_ENOTSUP, "HTTP client TLS is not supported without SSL");
+        return cat_false;
+    }
+#endif
+    host = cat_http_client_get_host(client, name, name_length, port, ssl);
+    if (unlikely(host == NULL)) {
+        return cat_false;
+    }
+    while (1) {
+        cat_http_client_connection_t *connection;
+        cat_bool_t written, received = cat_false, keep_alive = cat_true;
+        size_t i = 0;
+
+        connection = cat_http_client_acquire(host);
+        if (unlikely(connection == NULL)) {
+            return cat_false;
+        }
+        written = cat_http_client_write_requests(connection, requests, count);
+        if (likely(written)) {
+            for (; i < count; i++) {
+                cat_bool_t is_head = cat_http_client_method_is(&requests[i], CAT_STRL("HEAD"));
+                if (unlikely(!cat_http_client_read_response(connection, is_head, &responses[i], &received))) {
+                    break;
+                }
+                if (host->client != NULL) {
+                    host->client->requests++;
+                }
+                keep_alive = responses[i].keep_alive;
+                if (!keep_alive && i + 1 < count) {
+                    cat_update_last_error(CAT_ECONNRESET, "HTTP client connection was closed by peer after %zu of %zu pipelined responses", i + 1, count);
+                    i++;
+                    break;
+                }
+            }
+        }
+        if (likely(i == count)) {
+            cat_http_client_release(connection, keep_alive);
+            return cat_true;
+        }
+        /* stale pooled connection (closed by peer before it received anything), try again with another one,
+         * but requests which have been written may have been processed by server,
+         * so only idempotent ones can be replayed */
+        if (connection->reused && i == 0 && !received && host->client != NULL &&
+            (!written || cat_http_client_requests_are_idempotent(requests, count)) &&
+            retries-- > 0) {
+            cat_http_client_release(connection, cat_false);
+            continue;
+        }
+        cat_http_client_release(connection, cat_false);
+        return cat_false;
+    }
+}
+
+CAT_API cat_bool_t cat_http_client_execute(cat_http_client_t *client, const char *host, size_t host_length, int port, cat_bool_t ssl, const cat_http_client_request_t *request, cat_http_client_response_t *response)
+{
+    return cat_http_client_do(client, host, host_length, port, ssl, request, response, 1);
+}
+
+CAT_API cat_bool_t cat_http_client_pipeline(cat_http_client_t *client, const char *host, size_t host_length, int port, cat_bool_t ssl, const cat_http_client_request_t *requests, cat_http_client_response_t *responses, size_t count)
+{
+    if (unlikely(count == 0)) {
+        return cat_true;
+    }
+
+    return cat_http_client_do(client, host, host_length, port, ssl, requests, responses, count);
+}
@@ -0,0 +1,304 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "cat_http_server.h"
+#include "cat_coroutine.h"
+
+CAT_API void cat_http_server_options_init(cat_http_server_options_t *options)
+{
+    options->max_request_length = CAT_HTTP_PIPELINE_DEFAULT_MAX_REQUEST_LENGTH;
+    options->max_body_length = SIZE_MAX;
+    options->read_timeout = CAT_TIMEOUT_INVALID;
+    options->idle_timeout = CAT_TIMEOUT_INVALID;
+    options->backlog = CAT_HTTP_SERVER_DEFAULT_BACKLOG;
+}
+
+CAT_API cat_http_server_t *cat_http_server_create(cat_http_server_t *server, const cat_http_server_options_t *options, cat_http_server_handler_t handler, void *data)
+{
+    cat_bool_t allocated = cat_false;
+
+    if (server == NULL) {
+        server = (cat_http_server_t *) cat_malloc(sizeof(*server));
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(server == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for HTTP server failed");
+            return NULL;
+        }
+#endif
+        allocated = cat_true;
+    }
+    if (unlikely(cat_socket_create(&server->socket, CAT_SOCKET_TYPE_TCP) == NULL)) {
+        cat_update_last_error_with_previous("HTTP server create socket failed");
+        if (allocated) {
+            cat_free(server);
+        }
+        return NULL;
+    }
+    if (options != NULL) {
+        server->options = *options;
+    } else {
+        cat_http_server_options_init(&server->options);
+    }
+    server->connections = 0;
+    server->accepted = 0;
+    server->requests = 0;
+    server->handler = handler;
+    server->data = data;
+    server->events = CAT_HTTP_PARSER_EVENTS_NONE;
+    server->event_handler = NULL;
+    cat_queue_init(&server->connection_queue);
+    (void) cat_sync_wait_group_create(&server->wg);
+    server->shutting_down = cat_false;
+
+    return server;
+}
+
+CAT_API void cat_http_server_close(cat_http_server_t *server)
+{
+    CAT_ASSERT(server->connections == 0 && "HTTP server connections are still alive");
+    (void) cat_socket_close(&server->socket);
+}
+
+CAT_API void cat_http_server_set_event_handler(cat_http_server_t *server, cat_http_parser_events_t events, cat_http_server_handler_t handler)
+{
+    server->events = events;
+    server->event_handler = handler;
+}
+
+CAT_API cat_bool_t cat_http_server_listen(cat_http_server_t *server, const char *name, size_t name_length, int port)
+{
+    if (unlikely(!cat_socket_bind_to(&server->socket, name, name_length, port))) {
+        cat_update_last_error_with_previous("HTTP server bind failed");
+        return cat_false;
+    }
+    if (unlikely(!cat_socket_listen(&server->socket, server->options.backlog))) {
+        cat_update_last_error_with_previous("HTTP server listen failed");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+CAT_API int cat_http_server_get_port(cat_http_server_t *server)
+{
+    return cat_socket_get_sock_port(&server->socket);
+}
+
+static cat_bool_t cat_http_server_connection_on_request(cat_http_pipeline_t *pipeline, void *data)
+{
+    cat_http_server_connection_t *connection = (cat_http_server_connection_t *) data;
+    cat_http_server_t *server = connection->server;
+
+    server->requests++;
+
+    return server->handler(connection, server->data);
+}
+
+static cat_bool_t cat_http_server_connection_on_event(cat_http_pipeline_t *pipeline, void *data)
+{
+    cat_http_server_connection_t *connection = (cat_http_server_connection_t *) data;
+    cat_http_server_t *server = connection->server;
+
+    return server->event_handler(connection, server->data);
+}
+
+/* try to tell the client why the connection is going to be closed */
+static void cat_http_server_connection_respond_error(cat_http_server_connection_t *connection)
+{
+    cat_http_pipeline_t *pipeline = &connection->pipeline;
+    cat_errno_t error = cat_get_last_error_code();
+    cat_http_status_code_t status;
+    cat_http_response_writer_t writer;
+
+    if (error == CAT_EMSGSIZE) {
+        status = CAT_HTTP_STATUS_REQUEST_ENTITY_TOO_LARGE;
+    } else if (cat_http_parser_is_errno(error)) {
+        status = CAT_HTTP_STATUS_BAD_REQUEST;
+    } else if (error == CAT_ETIMEDOUT && !pipeline->idle) {
+        status = CAT_HTTP_STATUS_REQUEST_TIME_OUT;
+    } else {
+        return;
+    }
+    cat_http_response_writer_init(&writer, status);
+    (void) cat_http_response_writer_add_date(&writer);
+    (void) cat_http_response_writer_add_header_line(&writer, CAT_STRL("Connection: close\r\n"));
+    (void) cat_http_response_writer_add_content_length(&writer, 0);
+    (void) cat_http_response_writer_end(&writer, NULL, 0);
+    (void) cat_http_response_writer_write(&writer, &connection->socket);
+}
+
+static cat_data_t *cat_http_server_connection_main(cat_data_t *data)
+{
+    cat_http_server_connection_t *connection = (cat_http_server_connection_t *) data;
+    cat_http_server_t *server = connection->server;
+    cat_http_pipeline_t *pipeline = &connection->pipeline;
+
+    connection->coroutine = CAT_COROUTINE_G(current);
+    if (!cat_http_pipeline_run(pipeline, &connection->socket, cat_http_server_connection_on_request, connection)) {
+        if (!server->shutting_down) {
+            cat_http_server_connection_respond_error(connection);
+        }
+    }
+
+    cat_queue_remove(&connection->node);
+    server->connections--;
+    cat_http_pipeline_close(pipeline);
+    (void) cat_socket_close(&connection->socket);
+    cat_free(connection);
+    (void) cat_sync_wait_group_done(&server->wg);
+
+    return NULL;
+}
+
+CAT_API cat_bool_t cat_http_server_run(cat_http_server_t *server)
+{
+    while (1) {
+        cat_http_server_connection_t *connection;
+        cat_http_pipeline_t *pipeline;
+
+        connection = (cat_http_server_connection_t *) cat_malloc(sizeof(*connection));
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(connection == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for HTTP server connection failed");
+            return cat_false;
+        }
+#endif
+        if (unlikely(cat_socket_create(&connection->socket, cat_socket_get_simple_type(&server->socket)) == NULL)) {
+            cat_free(connection);
+            return cat_false;
+        }
+        if (unlikely(!cat_socket_accept_ex(&server->socket, &connection->socket, CAT_TIMEOUT_FOREVER))) {
+            (void) cat_socket_close(&connection->socket);
+            cat_free(connection);
+            if (server->shutting_down) {
+                return cat_true;
+            }
+            cat_update_last_error_with_previous("HTTP server accept failed");
+            return cat_false;
+        }
+        pipeline = cat_http_pipeline_create(&connection->pipeline);
+        pipeline->max_request_length = server->options.max_request_length;
+        pipeline->max_body_length = server->options.max_body_length;
+        pipeline->read_timeout = server->options.read_timeout;
+        pipeline->idle_timeout = server->options.idle_timeout;
+        if (server->event_handler != NULL) {
+            cat_http_pipeline_set_event_handler(pipeline, server->events, cat_http_server_connection_on_event);
+        }
+        connection->server = server;
+        connection->coroutine = NULL;
+        cat_queue_push_back(&server->connection_queue, &connection->node);
+        server->connections++;
+        server->accepted++;
+        (void) cat_sync_wait_group_add(&server->wg, 1);
+        if (unlikely(cat_coroutine_run(NULL, cat_http_server_connection_main, connection) == NULL)) {
+            cat_queue_remove(&connection->node);
+            server->connections--;
+            (void) cat_sync_wait_group_done(&server->wg);
+            cat_http_pipeline_close(pipeline);
+            (void) cat_socket_close(&connection->socket);
+            cat_free(connection);
+            /* out of memory or too many coroutines, keep serving the others */
+            continue;
+        }
+    }
+}
+
+static void cat_http_server_abort_connections(cat_http_server_t *server, cat_bool_t idle_only)
+{
+    cat_queue_t *queue = &server->connection_queue;
+    cat_queue_t *node = cat_queue_next(queue);
+
+    /* aborted connection may be resumed and freed at once, so get the next one first */
+    while (node != queue) {
+        cat_http_server_connection_t *connection = cat_queue_data(node, cat_http_server_connection_t, node);
+        node = cat_queue_next(node);
+        if (!idle_only || connection->pipeline.idle) {
+            cat_socket_abort(&connection->socket);
+        }
+    }
+}
+
+static cat_bool_t cat_http_server_is_in_handler(cat_http_server_t *server)
+{
+    CAT_QUEUE_FOREACH_DATA_START(&server->connection_queue, cat_http_server_connection_t, node, connection) {
+        if (connection->coroutine == CAT_COROUTINE_G(current)) {
+            return cat_true;
+        }
+    } CAT_QUEUE_FOREACH_DATA_END();
+
+    return cat_false;
+}
+
+CAT_API cat_bool_t cat_http_server_shutdown(cat_http_server_t *server, cat_timeout_t timeout)
+{
+    cat_bool_t in_handler;
+    cat_bool_t ret;
+
+    if (unlikely(server->shutting_down)) {
+        cat_update_last_error(CAT_EALREADY, "HTTP server is already shutting down");
+        return cat_false;
+    }
+    server->shutting_down = cat_true;
+    /* stop accepting (run() will return) */
+    cat_socket_abort(&server->socket);
+    /* in-flight requests will be finished, idle connections are closed at once */
+    CAT_QUEUE_FOREACH_DATA_START(&server->connection_queue, cat_http_server_connection_t, node, connection) {
+        cat_http_pipeline_stop(&connection->pipeline);
+    } CAT_QUEUE_FOREACH_DATA_END();
+    cat_http_server_abort_connections(server, cat_true);
+    /* called from a handler, we would wait for ourselves forever */
+    in_handler = cat_http_server_is_in_handler(server);
+    if (in_handler) {
+        (void) cat_sync_wait_group_done(&server->wg);
+    }
+    ret = cat_sync_wait_group_wait(&server->wg, timeout);
+    if (unlikely(!ret)) {
+        cat_update_last_error_with_previous("HTTP server graceful shutdown failed");
+        cat_http_server_abort_connections(server, cat_false);
+        (void) cat_sync_wait_group_wait(&server->wg, CAT_TIMEOUT_FOREVER);
+    }
+    if (in_handler) {
+        (void) cat_sync_wait_group_add(&server->wg, 1);
+    }
+
+    return ret;
+}
+
+CAT_API cat_bool_t cat_http_server_is_shutting_down(const cat_http_server_t *server)
+{
+    return server->shutting_down;
+}
+
+CAT_API cat_bool_t cat_http_server_respond(cat_http_server_connection_t *connection, cat_http_status_code_t status, const char *content_type, size_t content_type_length, const char *body, size_t body_length)
+{
+    cat_http_pipeline_t *pipeline = &connection->pipeline;
+    cat_http_response_writer_t writer;
+
+    cat_http_response_writer_init(&writer, status);
+    (void) cat_http_response_writer_add_date(&writer);
+    if (content_type != NULL) {
+        (void) cat_http_response_writer_add_header(&writer, CAT_STRL("Content-Type"), content_type, content_type_length);
+    }
+    (void) cat_http_response_writer_add_content_length(&writer, body_length);
+    if (connection->server->shutting_down || !cat_http_parser_should_keep_alive(&pipeline->parser)) {
+        (void) cat_http_response_writer_add_header_line(&writer, CAT_STRL("Connection: close\r\n"));
+    }
+    (void) cat_http_response_writer_end(&writer, body, body_length);
+
+    return cat_http_pipeline_respond_writer(pipeline, &writer);
+}
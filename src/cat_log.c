@@ -24,6 +24,11 @@
 
 #include "cat_buffer.h"
 #include "cat_coroutine.h" /* for coroutine id (TODO: need to decouple it?) */
+#include "cat_atomic.h"
+
+#ifndef CAT_OS_WIN
+#include <sys/uio.h> /* writev */
+#endif
 
 CAT_API cat_log_t cat_log_function;
 
@@ -239,12 +244,12 @@ CAT_API cat_bool_t cat_log_fwrite(FILE *file, const char *str, size_t length)
     }
 }
 
-CAT_API void cat_log_va_list_standard(CAT_LOG_VA_LIST_PARAMETERS)
+/* format the whole log message (with header and tail) into buffer,
+ * output will be NULL if there is nothing to output */
+static cat_bool_t cat_log_format(cat_buffer_t *buffer, FILE **output, CAT_LOG_VA_LIST_PARAMETERS)
 {
-    cat_buffer_t buffer;
     cat_bool_t ret;
     const char *type_name;
-    FILE *output;
 
     if (unlikely(type & CAT_LOG_TYPES_ABNORMAL)) {
         va_list _args;
@@ -253,15 +258,18 @@ CAT_API void cat_log_va_list_standard(CAT_LOG_VA_LIST_PARAMETERS)
         va_end(_args);
     }
 
-    type_name = cat_log_type_dispatch(type, &output);
+    cat_buffer_init(buffer);
+    type_name = cat_log_type_dispatch(type, output);
     if (unlikely(type_name == NULL)) {
-        return;
+        *output = NULL;
+        return cat_true;
     }
 
-    ret = cat_buffer_create(&buffer, 0);
+    ret = cat_buffer_create(buffer, 0);
     if (unlikely(!ret)) {
         fprintf(CAT_LOG_G(error_output), "libcat error: create log buffer failed (%s)\n", cat_get_last_error_message());
-        return;
+        *output = NULL;
+        return cat_true;
     }
 
     do {
@@ -269,14 +277,14 @@ CAT_API void cat_log_va_list_standard(CAT_LOG_VA_LIST_PARAMETERS)
         if (timestamps_level == 0) {
             break;
         }
-        (void) cat_buffer_append_char(&buffer, '[');
+        (void) cat_buffer_append_char(buffer, '[');
         (void) cat_log_buffer_append_timestamps(
-            &buffer,
+            buffer,
             timestamps_level,
             CAT_LOG_G(timestamps_format),
             CAT_LOG_G(show_timestamps_as_relative)
         );
-        (void) cat_buffer_append_str(&buffer, "] ");
+        (void) cat_buffer_append_str(buffer, "] ");
     } while (0);
 
     // role_name + log_type + module_name
@@ -298,41 +306,56 @@ CAT_API void cat_log_va_list_standard(CAT_LOG_VA_LIST_PARAMETERS)
         } else {
             name_length = strlen(name);
         }
-        (void) cat_buffer_append_char(&buffer, '[');
-        (void) cat_buffer_append_str_with_padding(&buffer, name, ' ', name_width);
-        (void) cat_buffer_append_str(&buffer, "] ");
-        (void) cat_buffer_append_str(&buffer, type_name);
+        (void) cat_buffer_append_char(buffer, '[');
+        (void) cat_buffer_append_str_with_padding(buffer, name, ' ', name_width);
+        (void) cat_buffer_append_str(buffer, "] ");
+        (void) cat_buffer_append_str(buffer, type_name);
 #ifdef CAT_ENABLE_DEBUG_LOG
         if (type == CAT_LOG_TYPE_DEBUG && CAT_LOG_G(debug_level) > 1) {
-            (void) cat_buffer_append_str(&buffer, "(v");
-            (void) cat_buffer_append_signed(&buffer, CAT_LOG_G(last_debug_log_level));
-            (void) cat_buffer_append_char(&buffer, ')');
+            (void) cat_buffer_append_str(buffer, "(v");
+            (void) cat_buffer_append_signed(buffer, CAT_LOG_G(last_debug_log_level));
+            (void) cat_buffer_append_char(buffer, ')');
         }
 #endif
-        (void) cat_buffer_append_str(&buffer, ": <");
-        (void) cat_buffer_append_str(&buffer, module_name);
-        (void) cat_buffer_append_str(&buffer, "> ");
+        (void) cat_buffer_append_str(buffer, ": <");
+        (void) cat_buffer_append_str(buffer, module_name);
+        (void) cat_buffer_append_str(buffer, "> ");
     } while (0);
 
-    ret = cat_buffer_append_vprintf(&buffer, format, args);
+    ret = cat_buffer_append_vprintf(buffer, format, args);
     if (unlikely(!ret)) {
         fprintf(CAT_LOG_G(error_output), "libcat error: vprintf() log message failed (%s)\n", cat_get_last_error_message());
-        goto _error;
+        return cat_false;
     }
 
-    cat_buffer_append_str(&buffer, "\n");
+    cat_buffer_append_str(buffer, "\n");
 
 #ifdef CAT_SOURCE_POSITION
     if (CAT_LOG_G(show_source_postion)) {
         (void) cat_buffer_append_printf(
-            &buffer,
+            buffer,
             "  ^ " "%s:%d | %s()\n",
             file, line, function
         );
     }
 #endif
 
-    cat_buffer_zero_terminate(&buffer);
+    cat_buffer_zero_terminate(buffer);
+
+    return cat_true;
+}
+
+CAT_API void cat_log_va_list_standard(CAT_LOG_VA_LIST_PARAMETERS)
+{
+    cat_buffer_t buffer;
+    FILE *output;
+
+    if (unlikely(!cat_log_format(&buffer, &output, type, module_name CAT_SOURCE_POSITION_RELAY_CC, code, format, args))) {
+        goto _error;
+    }
+    if (unlikely(output == NULL)) {
+        return;
+    }
 
     if (!cat_log_fwrite(output, buffer.value, buffer.length)) {
         goto _error;
@@ -363,6 +386,616 @@ CAT_API void cat_log_standard(CAT_LOG_PARAMETERS)
     va_end(args);
 }
 
+/* async log */
+
+#define CAT_LOG_ASYNC_BATCH_SIZE 64
+
+typedef struct cat_log_async_entry_s {
+    cat_atomic_uint64_t sequence;
+    FILE *output;
+    char *data; /* allocated by cat_sys_malloc() since it is freed on writer thread */
+    size_t length;
+} cat_log_async_entry_t;
+
+typedef struct cat_log_async_s {
+    cat_log_async_options_t options;
+    cat_log_t previous_function;
+    cat_log_async_entry_t *entries;
+    uint64_t mask;
+    cat_atomic_uint64_t tail; /* next position to push */
+    cat_atomic_uint64_t head; /* next position to pop (written by writer only) */
+    uv_thread_t thread;
+    uv_mutex_t mutex;
+    uv_cond_t cond;
+    cat_atomic_bool_t waiting;
+    cat_atomic_bool_t stop;
+    cat_atomic_bool_t crashed;
+    cat_atomic_uint64_t written;
+    cat_atomic_uint64_t dropped;
+    cat_atomic_uint64_t blocked;
+    cat_atomic_uint64_t write_errors;
+} cat_log_async_t;
+
+static cat_atomic_ptr_t cat_log_async_instance;
+/* number of threads which are using the instance, stop() waits for them before free */
+static cat_atomic_uint32_t cat_log_async_users;
+
+#ifdef CAT_OS_UNIX_LIKE
+static const int cat_log_async_crash_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+static struct sigaction cat_log_async_crash_old_actions[CAT_ARRAY_SIZE(cat_log_async_crash_signals)];
+#endif
+
+CAT_API void cat_log_async_options_init(cat_log_async_options_t *options)
+{
+    options->capacity = CAT_LOG_ASYNC_DEFAULT_CAPACITY;
+    options->overflow_policy = CAT_LOG_ASYNC_OVERFLOW_DROP;
+    options->flush_interval = CAT_LOG_ASYNC_DEFAULT_FLUSH_INTERVAL;
+    options->flush_timeout = CAT_LOG_ASYNC_DEFAULT_FLUSH_TIMEOUT;
+}
+
+static cat_log_async_t *cat_log_async_acquire(void)
+{
+    cat_log_async_t *async;
+
+    (void) cat_atomic_uint32_fetch_add(&cat_log_async_users, 1);
+    async = (cat_log_async_t *) cat_atomic_ptr_load(&cat_log_async_instance);
+    if (async == NULL) {
+        (void) cat_atomic_uint32_fetch_sub(&cat_log_async_users, 1);
+    }
+
+    return async;
+}
+
+static void cat_log_async_release(void)
+{
+    (void) cat_atomic_uint32_fetch_sub(&cat_log_async_users, 1);
+}
+
+static void cat_log_async_wakeup(cat_log_async_t *async)
+{
+    if (cat_atomic_bool_load(&async->waiting)) {
+        uv_mutex_lock(&async->mutex);
+        uv_cond_signal(&async->cond);
+        uv_mutex_unlock(&async->mutex);
+    }
+}
+
+/* multi-producer bounded ring (slots are tagged by sequence) */
+static cat_bool_t cat_log_async_push(cat_log_async_t *async, FILE *output, char *data, size_t length)
+{
+    cat_log_async_entry_t *entry;
+    uint64_t position = cat_atomic_uint64_load(&async->tail);
+
+    while (1) {
+        int64_t diff;
+        entry = &async->entries[position & async->mask];
+        diff = (int64_t) cat_atomic_uint64_load(&entry->sequence) - (int64_t) position;
+        if (diff == 0) {
+            if (cat_atomic_uint64_compare_exchange_weak(&async->tail, &position, position + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return cat_false; /* full */
+        } else {
+            position = cat_atomic_uint64_load(&async->tail);
+        }
+    }
+    entry->output = output;
+    entry->data = data;
+    entry->length = length;
+    cat_atomic_uint64_store(&entry->sequence, position + 1);
+    cat_log_async_wakeup(async);
+
+    return cat_true;
+}
+
+static unsigned int cat_log_async_pop(cat_log_async_t *async, cat_log_async_entry_t *entries, unsigned int max_count)
+{
+    uint64_t head = cat_atomic_uint64_load(&async->head);
+    unsigned int count = 0;
+
+    while (count < max_count) {
+        cat_log_async_entry_t *entry = &async->entries[head & async->mask];
+        uint64_t sequence = head + 1;
+        if (cat_atomic_uint64_load(&entry->sequence) != sequence) {
+            break;
+        }
+        entries[count].output = entry->output;
+        entries[count].data = entry->data;
+        entries[count].length = entry->length;
+        /* claim it, it may have been taken by cat_log_async_crash_flush() */
+        if (unlikely(!cat_atomic_uint64_compare_exchange_strong(&entry->sequence, &sequence, head + async->mask + 1))) {
+            break;
+        }
+        count++;
+        head++;
+    }
+
+    return count;
+}
+
+static cat_bool_t cat_log_async_writev(FILE *file, cat_io_vector_t *vector, unsigned int vector_count)
+{
+#ifndef CAT_OS_WIN
+    int fd = fileno(file);
+
+    while (vector_count > 0) {
+        ssize_t n = writev(fd, (struct iovec *) vector, (int) vector_count);
+        if (unlikely(n < 0)) {
+            if (cat_sys_errno == EINTR || (cat_sys_errno == EAGAIN && cat_log_select_writable(fd))) {
+                continue;
+            }
+            return cat_false;
+        }
+        /* partial write */
+        while (vector_count > 0 && (size_t) n >= vector->length) {
+            n -= vector->length;
+            vector++;
+            vector_count--;
+        }
+        if (n > 0) {
+            vector->base = ((char *) vector->base) + n;
+            vector->length -= n;
+        }
+    }
+
+    return cat_true;
+#else
+    cat_bool_t ret = cat_true;
+    for (; vector_count > 0; vector++, vector_count--) {
+        if (unlikely(fwrite(vector->base, 1, vector->length, file) != vector->length)) {
+            ret = cat_false;
+        }
+    }
+    fflush(file);
+    return ret;
+#endif
+}
+
+/* write consecutive entries of the same output at once */
+static void cat_log_async_write(cat_log_async_t *async, cat_log_async_entry_t *entries, unsigned int count)
+{
+    cat_io_vector_t vectors[CAT_LOG_ASYNC_BATCH_SIZE];
+    unsigned int i = 0;
+
+    while (i < count) {
+        FILE *output = entries[i].output;
+        unsigned int n = 0;
+        do {
+            vectors[n].base = entries[i + n].data;
+            vectors[n].length = (cat_io_vector_length_t) entries[i + n].length;
+            n++;
+        } while (i + n < count && entries[i + n].output == output);
+        if (likely(cat_log_async_writev(output, vectors, n))) {
+            (void) cat_atomic_uint64_fetch_add(&async->written, n);
+        } else {
+            (void) cat_atomic_uint64_fetch_add(&async->write_errors, 1);
+        }
+        for (; n > 0; n--, i++) {
+            cat_sys_free(entries[i].data);
+        }
+    }
+}
+
+static void cat_log_async_writer(void *arg)
+{
+    cat_log_async_t *async = (cat_log_async_t *) arg;
+    cat_log_async_entry_t entries[CAT_LOG_ASYNC_BATCH_SIZE];
+
+    while (1) {
+        unsigned int count = cat_log_async_pop(async, entries, CAT_ARRAY_SIZE(entries));
+        uint64_t head;
+        if (count > 0) {
+            cat_log_async_write(async, entries, count);
+            head = cat_atomic_uint64_load(&async->head);
+            cat_atomic_uint64_store(&async->head, head + count);
+            continue;
+        }
+        if (cat_atomic_bool_load(&async->stop)) {
+            break;
+        }
+        uv_mutex_lock(&async->mutex);
+        cat_atomic_bool_store(&async->waiting, cat_true);
+        /* re-check after announcing that we are waiting, so the wakeup can not be missed */
+        head = cat_atomic_uint64_load(&async->head);
+        if (cat_atomic_uint64_load(&async->entries[head & async->mask].sequence) != head + 1 &&
+            !cat_atomic_bool_load(&async->stop)) {
+            (void) uv_cond_timedwait(&async->cond, &async->mutex, async->options.flush_interval * 1000 * 1000);
+        }
+        cat_atomic_bool_store(&async->waiting, cat_false);
+        uv_mutex_unlock(&async->mutex);
+    }
+}
+
+/* write pending messages on crash: each message is claimed from the writer before it is read,
+ * it is never freed, and only write() is used, so that it is async-signal-safe;
+ * messages which have been popped by writer but not written yet may be lost */
+CAT_API void cat_log_async_crash_flush(void)
+{
+    cat_log_async_t *async = cat_log_async_acquire();
+    uint64_t position, tail;
+
+    if (async == NULL) {
+        return;
+    }
+    if (cat_atomic_bool_exchange(&async->crashed, cat_true)) {
+        goto _out;
+    }
+    position = cat_atomic_uint64_load(&async->head);
+    tail = cat_atomic_uint64_load(&async->tail);
+    for (; position < tail; position++) {
+        cat_log_async_entry_t *entry = &async->entries[position & async->mask];
+        uint64_t sequence = position + 1;
+        cat_io_vector_t vector;
+        FILE *output;
+        if (cat_atomic_uint64_load(&entry->sequence) != sequence) {
+            continue; /* popped by writer or not published yet */
+        }
+        output = entry->output;
+        vector.base = entry->data;
+        vector.length = (cat_io_vector_length_t) entry->length;
+        /* same as pop(), writer will stop at this slot if we win */
+        if (!cat_atomic_uint64_compare_exchange_strong(&entry->sequence, &sequence, position + async->mask + 1)) {
+            continue;
+        }
+        (void) cat_log_async_writev(output, &vector, 1);
+    }
+
+    _out:
+    cat_log_async_release();
+}
+
+#ifdef CAT_OS_UNIX_LIKE
+static void cat_log_async_crash_signal_handler(int signum)
+{
+    size_t i;
+
+    cat_log_async_crash_flush();
+    /* chain to the previous handler (or the default action) */
+    for (i = 0; i < CAT_ARRAY_SIZE(cat_log_async_crash_signals); i++) {
+        if (cat_log_async_crash_signals[i] == signum) {
+            (void) sigaction(signum, &cat_log_async_crash_old_actions[i], NULL);
+            break;
+        }
+    }
+    (void) raise(signum);
+}
+
+static void cat_log_async_install_crash_handlers(void)
+{
+    struct sigaction action;
+    size_t i;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = cat_log_async_crash_signal_handler;
+    /* stack may be overflowed, use alternate signal stack if there is */
+    action.sa_flags = SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (i = 0; i < CAT_ARRAY_SIZE(cat_log_async_crash_signals); i++) {
+        (void) sigaction(cat_log_async_crash_signals[i], &action, &cat_log_async_crash_old_actions[i]);
+    }
+}
+
+static void cat_log_async_uninstall_crash_handlers(void)
+{
+    size_t i;
+
+    for (i = 0; i < CAT_ARRAY_SIZE(cat_log_async_crash_signals); i++) {
+        struct sigaction current;
+        /* handler may have been replaced by the host after start, keep it */
+        if (sigaction(cat_log_async_crash_signals[i], NULL, &current) != 0 ||
+            current.sa_handler != cat_log_async_crash_signal_handler) {
+            continue;
+        }
+        (void) sigaction(cat_log_async_crash_signals[i], &cat_log_async_crash_old_actions[i], NULL);
+    }
+}
+#endif
+
+CAT_API cat_bool_t cat_log_async_start(const cat_log_async_options_t *options)
+{
+    cat_log_async_t *async;
+    size_t capacity = 1, i;
+    int error;
+
+    if (unlikely(cat_atomic_ptr_load(&cat_log_async_instance) != NULL)) {
+        cat_update_last_error(CAT_EALREADY, "Async log is already running");
+        return cat_false;
+    }
+    async = (cat_log_async_t *) cat_sys_malloc(sizeof(*async));
+#if CAT_SYS_ALLOC_HANDLE_ERRORS
+    if (unlikely(async == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for async log failed");
+        return cat_false;
+    }
+#endif
+    if (options != NULL) {
+        async->options = *options;
+    } else {
+        cat_log_async_options_init(&async->options);
+    }
+    while (capacity < async->options.capacity) {
+        capacity <<= 1;
+    }
+    async->entries = (cat_log_async_entry_t *) cat_sys_malloc(sizeof(*async->entries) * capacity);
+#if CAT_SYS_ALLOC_HANDLE_ERRORS
+    if (unlikely(async->entries == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for async log entries failed");
+        cat_sys_free(async);
+        return cat_false;
+    }
+#endif
+    for (i = 0; i < capacity; i++) {
+        cat_atomic_uint64_init(&async->entries[i].sequence, i);
+    }
+    async->mask = capacity - 1;
+    cat_atomic_uint64_init(&async->tail, 0);
+    cat_atomic_uint64_init(&async->head, 0);
+    cat_atomic_bool_init(&async->waiting, cat_false);
+    cat_atomic_bool_init(&async->stop, cat_false);
+    cat_atomic_bool_init(&async->crashed, cat_false);
+    cat_atomic_uint64_init(&async->written, 0);
+    cat_atomic_uint64_init(&async->dropped, 0);
+    cat_atomic_uint64_init(&async->blocked, 0);
+    cat_atomic_uint64_init(&async->write_errors, 0);
+    (void) uv_mutex_init(&async->mutex);
+    (void) uv_cond_init(&async->cond);
+    error = uv_thread_create(&async->thread, cat_log_async_writer, async);
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "Async log create writer thread failed");
+        uv_cond_destroy(&async->cond);
+        uv_mutex_destroy(&async->mutex);
+        cat_sys_free(async->entries);
+        cat_sys_free(async);
+        return cat_false;
+    }
+    async->previous_function = cat_log_function;
+    cat_atomic_ptr_store(&cat_log_async_instance, async);
+    cat_log_function = cat_log_async;
+#ifdef CAT_OS_UNIX_LIKE
+    cat_log_async_install_crash_handlers();
+#endif
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_log_async_stop(void)
+{
+    cat_log_async_t *async = (cat_log_async_t *) cat_atomic_ptr_load(&cat_log_async_instance);
+
+    if (unlikely(async == NULL)) {
+        cat_update_last_error(CAT_EMISUSE, "Async log is not running");
+        return cat_false;
+    }
+#ifdef CAT_OS_UNIX_LIKE
+    cat_log_async_uninstall_crash_handlers();
+#endif
+    cat_log_function = async->previous_function;
+    /* stop new producers, then wait for the ones which are still pushing */
+    cat_atomic_ptr_store(&cat_log_async_instance, NULL);
+    while (cat_atomic_uint32_load(&cat_log_async_users) != 0) {
+        uv_sleep(0);
+    }
+    /* writer drains all pending messages before exit */
+    uv_mutex_lock(&async->mutex);
+    cat_atomic_bool_store(&async->stop, cat_true);
+    uv_cond_signal(&async->cond);
+    uv_mutex_unlock(&async->mutex);
+    (void) uv_thread_join(&async->thread);
+    uv_cond_destroy(&async->cond);
+    uv_mutex_destroy(&async->mutex);
+    cat_sys_free(async->entries);
+    cat_sys_free(async);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_log_async_is_running(void)
+{
+    return cat_atomic_ptr_load(&cat_log_async_instance) != NULL;
+}
+
+CAT_API cat_bool_t cat_log_async_flush(cat_timeout_t timeout)
+{
+    cat_log_async_t *async = cat_log_async_acquire();
+    cat_bool_t ret = cat_true;
+    uint64_t target;
+    cat_msec_t start;
+
+    if (unlikely(async == NULL)) {
+        return cat_true;
+    }
+    target = cat_atomic_uint64_load(&async->tail);
+    start = uv_hrtime() / (1000 * 1000);
+    while (cat_atomic_uint64_load(&async->head) < target) {
+        if (timeout >= 0 && uv_hrtime() / (1000 * 1000) - start >= (cat_msec_t) timeout) {
+            cat_update_last_error(CAT_ETIMEDOUT, "Async log flush timed out");
+            ret = cat_false;
+            break;
+        }
+        cat_log_async_wakeup(async);
+        uv_sleep(1);
+    }
+    cat_log_async_release();
+
+    return ret;
+}
+
+CAT_API void cat_log_async_get_stats(cat_log_async_stats_t *stats)
+{
+    cat_log_async_t *async = cat_log_async_acquire();
+
+    memset(stats, 0, sizeof(*stats));
+    if (async == NULL) {
+        return;
+    }
+    stats->written = cat_atomic_uint64_load(&async->written);
+    stats->dropped = cat_atomic_uint64_load(&async->dropped);
+    stats->blocked = cat_atomic_uint64_load(&async->blocked);
+    stats->write_errors = cat_atomic_uint64_load(&async->write_errors);
+    stats->pending = (size_t) (cat_atomic_uint64_load(&async->tail) - cat_atomic_uint64_load(&async->head));
+    cat_log_async_release();
+}
+
+CAT_API void cat_log_va_list_async(CAT_LOG_VA_LIST_PARAMETERS)
+{
+    cat_log_async_t *async;
+    cat_buffer_t buffer;
+    FILE *output;
+    char *data;
+
+    if (unlikely(!cat_log_format(&buffer, &output, type, module_name CAT_SOURCE_POSITION_RELAY_CC, code, format, args))) {
+        goto _error;
+    }
+    if (unlikely(output == NULL)) {
+        return;
+    }
+
+    /* instance can not be freed by stop() until it is released */
+    async = cat_log_async_acquire();
+    if (unlikely(async == NULL || (type & (CAT_LOG_TYPE_ERROR | CAT_LOG_TYPE_CORE_ERROR)))) {
+        cat_timeout_t flush_timeout = 0;
+        if (async != NULL) {
+            flush_timeout = async->options.flush_timeout;
+            cat_log_async_release();
+        }
+        /* keep the order, and make sure that it is outputted before abort */
+        (void) cat_log_async_flush(flush_timeout);
+        if (!cat_log_fwrite(output, buffer.value, buffer.length)) {
+            goto _error;
+        }
+        cat_buffer_close(&buffer);
+        goto _out;
+    }
+
+    data = (char *) cat_sys_malloc(buffer.length);
+#if CAT_SYS_ALLOC_HANDLE_ERRORS
+    if (unlikely(data == NULL)) {
+        (void) cat_atomic_uint64_fetch_add(&async->dropped, 1);
+        cat_log_async_release();
+        cat_buffer_close(&buffer);
+        goto _out;
+    }
+#endif
+    memcpy(data, buffer.value, buffer.length);
+    while (unlikely(!cat_log_async_push(async, output, data, buffer.length))) {
+        if (async->options.overflow_policy == CAT_LOG_ASYNC_OVERFLOW_DROP) {
+            (void) cat_atomic_uint64_fetch_add(&async->dropped, 1);
+            cat_sys_free(data);
+            break;
+        }
+        (void) cat_atomic_uint64_fetch_add(&async->blocked, 1);
+        cat_log_async_wakeup(async);
+        uv_sleep(1);
+    }
+    cat_log_async_release();
+    cat_buffer_close(&buffer);
+
+    if (0) {
+        _error:
+        cat_buffer_close(&buffer);
+        if (type & CAT_LOG_TYPES_ABNORMAL) {
+            cat_set_last_error(code, NULL);
+        }
+    }
+
+    _out:
+    if (type & (CAT_LOG_TYPE_ERROR | CAT_LOG_TYPE_CORE_ERROR)) {
+        cat_abort();
+    }
+}
+
+CAT_API void cat_log_async(CAT_LOG_PARAMETERS)
+{
+    va_list args;
+    va_start(args, format);
+
+    cat_log_va_list_async(type, module_name CAT_SOURCE_POSITION_RELAY_CC, code, format, args);
+
+    va_end(args);
+}
+
+/* module types */
+
+CAT_API CAT_ALIGNED(CAT_CACHE_LINE_SIZE) uint8_t cat_log_module_disabled_types[CAT_LOG_MODULE_MAX];
+
+static const char *cat_log_module_names[CAT_LOG_MODULE_MAX];
+static unsigned int cat_log_module_count;
+/* registration is rare, so a spin lock is enough (and it works before module init) */
+static cat_atomic_bool_t cat_log_module_lock;
+
+static void cat_log_module_lock_acquire(void)
+{
+    while (cat_atomic_bool_exchange(&cat_log_module_lock, cat_true)) {
+        uv_sleep(0);
+    }
+}
+
+static void cat_log_module_lock_release(void)
+{
+    cat_atomic_bool_store(&cat_log_module_lock, cat_false);
+}
+
+static cat_log_module_id_t cat_log_module_find(const char *module_name)
+{
+    unsigned int id;
+
+    for (id = 1; id <= cat_log_module_count; id++) {
+        if (cat_strcasecmp(cat_log_module_names[id], module_name) == 0) {
+            return (cat_log_module_id_t) id;
+        }
+    }
+
+    return 0;
+}
+
+CAT_API cat_log_module_id_t cat_log_module_register(const char *module_name)
+{
+    cat_log_module_id_t id;
+
+    cat_log_module_lock_acquire();
+    id = cat_log_module_find(module_name);
+    if (id == 0) {
+        char *name = NULL;
+        if (cat_log_module_count < CAT_LOG_MODULE_MAX - 2) {
+            name = cat_sys_strdup(module_name);
+        }
+        if (likely(name != NULL)) {
+            id = (cat_log_module_id_t) ++cat_log_module_count;
+            cat_log_module_names[id] = name;
+        } else {
+            id = CAT_LOG_MODULE_MAX - 1;
+        }
+    }
+    cat_log_module_lock_release();
+
+    return id;
+}
+
+CAT_API cat_bool_t cat_log_set_module_types(const char *module_name, cat_log_types_t types)
+{
+    cat_log_module_id_t id = cat_log_module_register(module_name);
+
+    if (unlikely(id == CAT_LOG_MODULE_MAX - 1)) {
+        cat_update_last_error(CAT_ENOSPC, "Log module %s can not be registered", module_name);
+        return cat_false;
+    }
+    cat_log_module_disabled_types[id] = (uint8_t) (CAT_LOG_TYPES_ALL & ~types);
+
+    return cat_true;
+}
+
+CAT_API cat_log_types_t cat_log_get_module_types(const char *module_name)
+{
+    cat_log_module_id_t id;
+
+    cat_log_module_lock_acquire();
+    id = cat_log_module_find(module_name);
+    cat_log_module_lock_release();
+
+    return (cat_log_types_t) (CAT_LOG_TYPES_ALL & ~cat_log_module_disabled_types[id]);
+}
+
 CAT_API const char *cat_log_str_quote(const char *str, size_t n, char **tmp_str)
 {
     cat_str_quote_style_flag_t style = CAT_STR_QUOTE_STYLE_FLAG_NONE;
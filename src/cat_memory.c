@@ -107,6 +107,146 @@ CAT_API char *cat_strndup(const char *str, size_t length)
     return ptr;
 }
 
+/* slab */
+
+struct cat_slab_object_s {
+    cat_slab_object_t *next;
+};
+
+struct cat_slab_page_s {
+    cat_slab_page_t *next;
+};
+
+#define CAT_SLAB_PAGE_HEADER_SIZE CAT_MEMORY_ALIGNED_SIZE_EX(sizeof(cat_slab_page_t), 16)
+
+static cat_always_inline size_t cat_slab_get_index(size_t size)
+{
+    return (size - 1) / CAT_SLAB_CLASS_ALIGNMENT;
+}
+
+/* globals are zeroed before runtime init, and runtime may be re-initialized
+ * (e.g. to reload options) while objects are still alive, so do not reset anything here */
+CAT_API void cat_slab_runtime_init(void)
+{
+    size_t index;
+
+    for (index = 0; index < CAT_SLAB_CLASS_COUNT; index++) {
+        CAT_SLAB_G(classes)[index].stats.size = (index + 1) * CAT_SLAB_CLASS_ALIGNMENT;
+    }
+}
+
+CAT_API void cat_slab_runtime_close(void)
+{
+    cat_slab_page_t *page = CAT_SLAB_G(pages);
+
+    while (page != NULL) {
+        cat_slab_page_t *next = page->next;
+        cat_free(page);
+        page = next;
+    }
+    memset(&CAT_G(slab_globals), 0, sizeof(CAT_G(slab_globals)));
+    cat_slab_runtime_init();
+}
+
+#ifndef CAT_SLAB_USE_SYS_MALLOC
+static cat_slab_object_t *cat_slab_grow(cat_slab_class_t *klass, size_t size)
+{
+    cat_slab_page_t *page;
+    cat_slab_object_t *object = NULL;
+    char *p, *pe;
+
+    page = (cat_slab_page_t *) cat_malloc(CAT_SLAB_PAGE_SIZE);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(page == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for slab page failed");
+        return NULL;
+    }
+#endif
+    page->next = CAT_SLAB_G(pages);
+    CAT_SLAB_G(pages) = page;
+    /* link objects in address order */
+    p = ((char *) page) + CAT_SLAB_PAGE_HEADER_SIZE;
+    pe = ((char *) page) + CAT_SLAB_PAGE_SIZE - size;
+    for (; pe >= p; pe -= size) {
+        cat_slab_object_t *prev = (cat_slab_object_t *) pe;
+        prev->next = object;
+        object = prev;
+        klass->stats.cached++;
+    }
+    klass->stats.pages++;
+
+    return object;
+}
+#endif
+
+CAT_API void *cat_slab_alloc(size_t size)
+{
+    cat_slab_class_t *klass;
+    cat_slab_object_t *object;
+
+    if (unlikely(size == 0 || size > CAT_SLAB_MAX_SIZE)) {
+        return cat_malloc(size);
+    }
+    klass = &CAT_SLAB_G(classes)[cat_slab_get_index(size)];
+#ifndef CAT_SLAB_USE_SYS_MALLOC
+    object = klass->free_list;
+    if (unlikely(object == NULL)) {
+        object = cat_slab_grow(klass, CAT_MEMORY_ALIGNED_SIZE_EX(size, CAT_SLAB_CLASS_ALIGNMENT));
+# if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(object == NULL)) {
+            return NULL;
+        }
+# endif
+    }
+    klass->free_list = object->next;
+    klass->stats.cached--;
+#else
+    object = (cat_slab_object_t *) cat_malloc(size);
+# if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(object == NULL)) {
+        return NULL;
+    }
+# endif
+#endif
+    klass->stats.allocs++;
+    if (++klass->stats.in_use > klass->stats.peak) {
+        klass->stats.peak = klass->stats.in_use;
+    }
+
+    return object;
+}
+
+CAT_API void cat_slab_free(void *ptr, size_t size)
+{
+    cat_slab_class_t *klass;
+
+    if (unlikely(size == 0 || size > CAT_SLAB_MAX_SIZE)) {
+        cat_free(ptr);
+        return;
+    }
+    klass = &CAT_SLAB_G(classes)[cat_slab_get_index(size)];
+    CAT_ASSERT(klass->stats.in_use > 0 && "Slab object double free or size mismatch");
+#ifndef CAT_SLAB_USE_SYS_MALLOC
+    ((cat_slab_object_t *) ptr)->next = klass->free_list;
+    klass->free_list = (cat_slab_object_t *) ptr;
+    klass->stats.cached++;
+#else
+    cat_free(ptr);
+#endif
+    klass->stats.frees++;
+    klass->stats.in_use--;
+}
+
+CAT_API const cat_slab_stats_t *cat_slab_get_stats(size_t index)
+{
+    if (unlikely(index >= CAT_SLAB_CLASS_COUNT)) {
+        cat_update_last_error(CAT_EINVAL, "Slab class index out of range");
+        return NULL;
+    }
+
+    return &CAT_SLAB_G(classes)[index].stats;
+}
+
 CAT_API void *cat_malloc_function(size_t size)
 {
     return cat_malloc(size);
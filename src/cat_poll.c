@@ -191,7 +191,7 @@ static void cat_poll_one_close_callback(uv_handle_t *handle)
 {
     cat_poll_one_t *poll = cat_container_of(handle, cat_poll_one_t, u.handle);
     /** @see poll_free_callback() comments.  */
-    cat_free(poll);
+    cat_slab_free(poll, sizeof(*poll));
 }
 
 static void cat_poll_one_done_callback(cat_event_io_defer_task_t *task, cat_data_t *data)
@@ -254,7 +254,7 @@ static cat_ret_t cat_poll_one_impl(cat_os_socket_t fd, cat_pollfd_events_t event
 
     *revents = POLLNONE;
 
-    poll = (cat_poll_one_t *) cat_malloc(sizeof(*poll));
+    poll = (cat_poll_one_t *) cat_slab_alloc(sizeof(*poll));
 #if CAT_ALLOC_HANDLE_ERRORS
     if (unlikely(poll == NULL)) {
         cat_update_last_error_of_syscall("Malloc for poll failed");
@@ -266,7 +266,7 @@ static cat_ret_t cat_poll_one_impl(cat_os_socket_t fd, cat_pollfd_events_t event
         _fd = dup(fd);
         if (unlikely(_fd == CAT_OS_INVALID_SOCKET)) {
             cat_update_last_error_of_syscall("Dup for poll_one() failed");
-            cat_free(poll);
+            cat_slab_free(poll, sizeof(*poll));
             return CAT_RET_ERROR;
         }
         /* uv_poll_init_socket() and uv_poll_start() must return success if fd exists */
@@ -275,7 +275,7 @@ static cat_ret_t cat_poll_one_impl(cat_os_socket_t fd, cat_pollfd_events_t event
     error = uv_poll_init_socket(&CAT_EVENT_G(loop), &poll->u.poll, _fd);
     if (unlikely(error != 0)) {
         cat_update_last_error_with_reason(error, "Poll init failed");
-        cat_free(poll);
+        cat_slab_free(poll, sizeof(*poll));
         *revents = cat_poll_translate_error_to_sys_events(events, cat_poll_filter_init_error(error));
         return CAT_RET_ERROR;
     }
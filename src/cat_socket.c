@@ -23,6 +23,9 @@
 #include "cat_event.h"
 #include "cat_time.h"
 #include "cat_poll.h"
+#define CAT_TRACE_USE_PROBES
+#include "cat_trace.h"
+#include "cat_sync.h"
 
 #include "cat_fs.h" /* for sendfile */
 
@@ -485,6 +488,21 @@ CAT_API cat_bool_t cat_socket_runtime_init(void)
     CAT_SOCKET_G(last_id) = 0;
     CAT_SOCKET_G(options.timeout) = cat_socket_default_global_timeout_options;
     CAT_SOCKET_G(options.tcp_keepalive_delay) = 60;
+    CAT_SOCKET_G(options.tcp_fastopen_queue_length) = 256;
+    CAT_SOCKET_G(options.tcp_defer_accept_timeout) = 5;
+    CAT_SOCKET_G(stats_enabled) = cat_false;
+    memset(&CAT_SOCKET_G(stats), 0, sizeof(CAT_SOCKET_G(stats)));
+    CAT_SOCKET_G(proxy_buffer_pool.head) = NULL;
+    CAT_SOCKET_G(proxy_buffer_pool.count) = 0;
+
+    return cat_true;
+}
+
+static void cat_socket_proxy_buffer_pool_clear(void);
+
+CAT_API cat_bool_t cat_socket_runtime_shutdown(void)
+{
+    cat_socket_proxy_buffer_pool_clear();
 
     return cat_true;
 }
@@ -642,6 +660,26 @@ static CAT_COLD void cat_socket_internal_unrecoverable_io_error(cat_socket_inter
 static cat_always_inline void cat_socket_internal_ssl_recoverability_check(cat_socket_internal_t *socket_i);
 #endif
 
+/* stats */
+
+#define CAT_SOCKET_INTERNAL_STATS_ADD(_socket_i, _field, _value) do { \
+    if (unlikely((_socket_i)->stats != NULL)) { \
+        (_socket_i)->stats->_field += (_value); \
+        CAT_SOCKET_G(stats)._field += (_value); \
+    } \
+} while (0)
+
+#define CAT_SOCKET_INTERNAL_STATS_TIME_START(_socket_i) \
+    (unlikely((_socket_i)->stats != NULL) ? cat_time_nsec() : 0)
+
+#define CAT_SOCKET_INTERNAL_STATS_TIME_ADD(_socket_i, _field, _start) do { \
+    if ((_start) != 0) { \
+        CAT_SOCKET_INTERNAL_STATS_ADD(_socket_i, _field, cat_time_nsec() - (_start)); \
+    } \
+} while (0)
+
+static cat_bool_t cat_socket_internal_enable_stats(cat_socket_internal_t *socket_i);
+
 static int cat_socket__internal_compare(cat_socket_internal_t* socket_i_1, cat_socket_internal_t* socket_i_2)
 {
     cat_socket_fd_t fd_1 = cat_socket_internal_get_fd_fast(socket_i_1);
@@ -951,10 +989,17 @@ static cat_always_inline cat_socket_t *cat_socket_create_impl(cat_socket_t *sock
     socket_i->option_flags = CAT_SOCKET_OPTION_FLAG_NONE;
     socket_i->options.timeout = cat_socket_default_timeout_options;
     socket_i->options.tcp_keepalive_delay = 0;
+    socket_i->options.tcp_fastopen_queue_length = 0;
+    socket_i->options.tcp_defer_accept_timeout = 0;
 #ifdef CAT_SSL
     socket_i->ssl = NULL;
     socket_i->ssl_peer_name = NULL;
 #endif
+    socket_i->stats = NULL;
+    if (CAT_SOCKET_G(stats_enabled)) {
+        /* stats are best-effort */
+        (void) cat_socket_internal_enable_stats(socket_i);
+    }
 
     if (af != AF_UNSPEC) {
         cat_socket_internal_on_open(socket_i, af);
@@ -1617,11 +1662,25 @@ static void cat_socket_accept_connection_callback(uv_stream_t *stream, int statu
             (int) sock_address_length, sock_address, cat_socket_get_sock_port(socket)); \
     });
 
+static cat_bool_t cat_socket_internal_set_tcp_fastopen(cat_socket_internal_t *socket_i, unsigned int queue_length);
+static cat_bool_t cat_socket_internal_set_tcp_defer_accept(cat_socket_internal_t *socket_i, unsigned int timeout);
+
 static cat_always_inline cat_bool_t cat_socket_listen_impl(cat_socket_t *socket, int backlog)
 {
     CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
     int error;
 
+    /* server-side TCP options must be set before listen() to take effect */
+    if (socket_i->option_flags & CAT_SOCKET_OPTION_FLAG_TCP_FAST_OPEN) {
+        if (unlikely(!cat_socket_internal_set_tcp_fastopen(socket_i, socket_i->options.tcp_fastopen_queue_length))) {
+            return cat_false;
+        }
+    }
+    if (socket_i->option_flags & CAT_SOCKET_OPTION_FLAG_TCP_DEFERRED_ACCEPT) {
+        if (unlikely(!cat_socket_internal_set_tcp_defer_accept(socket_i, socket_i->options.tcp_defer_accept_timeout))) {
+            return cat_false;
+        }
+    }
     error = uv_listen(&socket_i->u.stream, backlog, cat_socket_accept_connection_callback);
     if (unlikely(error != 0)) {
         cat_update_last_error_with_reason(error, "Socket listen(%d) failed", backlog);
@@ -1649,6 +1708,55 @@ CAT_API cat_bool_t cat_socket_listen(cat_socket_t *socket, int backlog)
     return ret;
 }
 
+static cat_always_inline cat_bool_t cat_socket_internal_accept_type_check(const cat_socket_internal_t *server_i, const cat_socket_internal_t *connection_i)
+{
+    cat_socket_type_t server_type = cat_socket_type_simplify(server_i->type);
+    cat_socket_type_t connection_type = connection_i->type;
+
+    if (unlikely((server_type & connection_type) != server_type)) {
+        cat_update_last_error(CAT_EINVAL, "Socket accept connection type mismatch, expect %s but got %s",
+            cat_socket_type_get_name(server_type), cat_socket_type_get_name(connection_type));
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+static cat_always_inline void cat_socket_internal_on_accepted(
+    const cat_socket_internal_t *server_i, cat_socket_internal_t *connection_i,
+    const cat_socket_inheritance_info_t *handle_info
+) {
+    /* init client properties */
+    connection_i->flags |= (CAT_SOCKET_INTERNAL_FLAG_ESTABLISHED | CAT_SOCKET_INTERNAL_FLAG_SERVER_CONNECTION);
+    /* TODO: socket_extends() ? */
+    memcpy(&connection_i->options, handle_info == NULL ? &server_i->options : &handle_info->options, sizeof(connection_i->options));
+    cat_socket_internal_on_open(connection_i, cat_socket_type_to_af(handle_info == NULL ? server_i->type : handle_info->type));
+}
+
+static cat_bool_t cat_socket_internal_accept_wait(cat_socket_internal_t *server_i, cat_timeout_t timeout)
+{
+    cat_bool_t ret;
+
+    uv_ref(&server_i->u.handle);
+    server_i->context.accept.data.status = CAT_ECANCELED;
+    server_i->context.accept.coroutine = CAT_COROUTINE_G(current);
+    server_i->io_flags = CAT_SOCKET_IO_FLAG_ACCEPT;
+    ret = cat_time_wait(timeout);
+    server_i->io_flags = CAT_SOCKET_IO_FLAG_NONE;
+    server_i->context.accept.coroutine = NULL;
+    uv_unref(&server_i->u.handle);
+    if (unlikely(!ret)) {
+        cat_update_last_error_with_previous("Socket accept wait failed");
+        return cat_false;
+    }
+    if (unlikely(server_i->context.accept.data.status == CAT_ECANCELED)) {
+        cat_update_last_error(CAT_ECANCELED, "Socket accept has been canceled");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
 static cat_bool_t cat_socket_internal_accept(
     cat_socket_internal_t *server_i, cat_socket_internal_t *connection_i,
     cat_socket_inheritance_info_t *handle_info, cat_timeout_t timeout
@@ -1656,44 +1764,22 @@ static cat_bool_t cat_socket_internal_accept(
     int error;
 
     if (handle_info == NULL) {
-        cat_socket_type_t server_type = cat_socket_type_simplify(server_i->type);
-        cat_socket_type_t connection_type = connection_i->type;
-        if (unlikely((server_type & connection_type) != server_type)) {
-            cat_update_last_error(CAT_EINVAL, "Socket accept connection type mismatch, expect %s but got %s",
-                cat_socket_type_get_name(server_type), cat_socket_type_get_name(connection_type));
+        if (unlikely(!cat_socket_internal_accept_type_check(server_i, connection_i))) {
             return cat_false;
         }
     }
 
     while (1) {
-        cat_bool_t ret;
         error = uv_accept(&server_i->u.stream, &connection_i->u.stream);
         if (error == 0) {
-            /* init client properties */
-            connection_i->flags |= (CAT_SOCKET_INTERNAL_FLAG_ESTABLISHED | CAT_SOCKET_INTERNAL_FLAG_SERVER_CONNECTION);
-            /* TODO: socket_extends() ? */
-            memcpy(&connection_i->options, handle_info == NULL ? &server_i->options : &handle_info->options, sizeof(connection_i->options));
-            cat_socket_internal_on_open(connection_i, cat_socket_type_to_af(handle_info == NULL ? server_i->type : handle_info->type));
+            cat_socket_internal_on_accepted(server_i, connection_i, handle_info);
             return cat_true;
         }
         if (unlikely(error != CAT_EAGAIN)) {
             cat_update_last_error_with_reason(error, "Socket accept failed");
             break;
         }
-        uv_ref(&server_i->u.handle);
-        server_i->context.accept.data.status = CAT_ECANCELED;
-        server_i->context.accept.coroutine = CAT_COROUTINE_G(current);
-        server_i->io_flags = CAT_SOCKET_IO_FLAG_ACCEPT;
-        ret = cat_time_wait(timeout);
-        server_i->io_flags = CAT_SOCKET_IO_FLAG_NONE;
-        server_i->context.accept.coroutine = NULL;
-        uv_unref(&server_i->u.handle);
-        if (unlikely(!ret)) {
-            cat_update_last_error_with_previous("Socket accept wait failed");
-            break;
-        }
-        if (unlikely(server_i->context.accept.data.status == CAT_ECANCELED)) {
-            cat_update_last_error(CAT_ECANCELED, "Socket accept has been canceled");
+        if (unlikely(!cat_socket_internal_accept_wait(server_i, timeout))) {
             break;
         }
     }
@@ -1758,6 +1844,151 @@ CAT_API cat_bool_t cat_socket_accept_ex(cat_socket_t *server, cat_socket_t *conn
     return ret;
 }
 
+#ifdef CAT_OS_UNIX_LIKE
+/* it returns fd or a negative error code */
+static int cat_socket_internal_accept_fd(cat_socket_internal_t *server_i)
+{
+    uv_stream_t *stream = &server_i->u.stream;
+    int fd = stream->accepted_fd;
+
+    if (fd != -1) {
+        /* take over the connection which has been accepted by libuv (see uv_accept()) */
+        stream->accepted_fd = -1;
+        uv__io_start(stream->loop, &stream->io_watcher, POLLIN);
+        return fd;
+    }
+
+    return uv__accept(uv__stream_fd(stream));
+}
+#endif
+
+static ssize_t cat_socket_accept_batch_impl(
+    cat_socket_t *server, cat_socket_t *connections, size_t count,
+    cat_socket_accept_filter_t filter, cat_data_t *data, cat_timeout_t timeout
+) {
+    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(server, server_i, CAT_SOCKET_IO_FLAG_ACCEPT, return -1);
+    CAT_SOCKET_INTERNAL_SERVER_ONLY(server_i, return -1);
+    size_t i, n = 0;
+    int error;
+
+    if (unlikely(server_i->type & CAT_SOCKET_TYPE_FLAG_IPC)) {
+        cat_update_last_error(CAT_EINVAL, "Socket accept batch does not support IPC");
+        return -1;
+    }
+    if (unlikely(count == 0)) {
+        cat_update_last_error(CAT_EINVAL, "Socket accept batch count can not be 0");
+        return -1;
+    }
+    for (i = 0; i < count; i++) {
+        cat_socket_t *connection = &connections[i];
+        CAT_SOCKET_INTERNAL_GETTER_SILENT(connection, connection_i, {
+            cat_update_last_error(CAT_EINVAL, "Socket accept can not act on an unavailable socket");
+            return -1;
+        });
+        if (unlikely(cat_socket_is_open(connection))) {
+            cat_update_last_error(CAT_EMISUSE, "Socket accept can only act on a lazy socket");
+            return -1;
+        }
+        if (unlikely(!cat_socket_internal_accept_type_check(server_i, connection_i))) {
+            return -1;
+        }
+    }
+
+    while (1) {
+        while (n < count) {
+            cat_socket_internal_t *connection_i = connections[n].internal;
+#ifdef CAT_OS_UNIX_LIKE
+            int fd = cat_socket_internal_accept_fd(server_i);
+            if (unlikely(fd < 0)) {
+                error = fd;
+                if (error == CAT_EAGAIN) {
+                    break;
+                }
+                if (error == CAT_ECONNABORTED) {
+                    continue;
+                }
+                goto _error;
+            }
+            if (filter != NULL && !filter(fd, data)) {
+                uv__close(fd);
+                continue;
+            }
+            error = uv__stream_open(&connection_i->u.stream, fd, UV_HANDLE_READABLE | UV_HANDLE_WRITABLE);
+            if (unlikely(error != 0)) {
+                uv__close(fd);
+                goto _error;
+            }
+            connection_i->u.stream.flags |= UV_HANDLE_BOUND;
+            cat_socket_internal_on_accepted(server_i, connection_i, NULL);
+#else
+            error = uv_accept(&server_i->u.stream, &connection_i->u.stream);
+            if (error == CAT_EAGAIN) {
+                break;
+            }
+            if (unlikely(error != 0)) {
+                goto _error;
+            }
+            cat_socket_internal_on_accepted(server_i, connection_i, NULL);
+            if (filter != NULL && !filter(cat_socket_internal_get_fd_fast(connection_i), data)) {
+                /* connection has been bound, we can only re-create it */
+                cat_socket_type_t type = cat_socket_type_simplify(connection_i->type);
+                (void) cat_socket_close(&connections[n]);
+                if (unlikely(cat_socket_create(&connections[n], type) == NULL)) {
+                    cat_update_last_error_with_previous("Socket accept batch re-create rejected connection failed");
+                    goto _out;
+                }
+                continue;
+            }
+#endif
+            n++;
+        }
+        if (n > 0) {
+            break;
+        }
+        if (unlikely(!cat_socket_internal_accept_wait(server_i, timeout))) {
+            return -1;
+        }
+    }
+
+    return n;
+
+    _error:
+    cat_update_last_error_with_reason(error, "Socket accept failed");
+#ifndef CAT_OS_UNIX_LIKE
+    _out:
+#endif
+    /* connections which have been accepted are still available */
+    return n > 0 ? (ssize_t) n : -1;
+}
+
+CAT_API ssize_t cat_socket_accept_batch(cat_socket_t *server, cat_socket_t *connections, size_t count)
+{
+    return cat_socket_accept_batch_ex(server, connections, count, NULL, NULL, cat_socket_get_accept_timeout_fast(server));
+}
+
+CAT_API ssize_t cat_socket_accept_batch_ex(
+    cat_socket_t *server, cat_socket_t *connections, size_t count,
+    cat_socket_accept_filter_t filter, cat_data_t *data, cat_timeout_t timeout
+) {
+    CAT_LOG_DEBUG(SOCKET, "accept_batch(" CAT_SOCKET_ID_FMT ", %zu, " CAT_TIMEOUT_FMT ") = "  CAT_LOG_UNFINISHED_STR,
+        server->id, count, timeout);
+
+    ssize_t n = cat_socket_accept_batch_impl(server, connections, count, filter, data, timeout);
+
+    CAT_LOG_DEBUG(SOCKET, "accept_batch(" CAT_SOCKET_ID_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
+        server->id, count, timeout, CAT_LOG_SSIZE_RET_C(n));
+#ifdef CAT_ENABLE_DEBUG_LOG
+    do {
+        ssize_t i;
+        for (i = 0; i < n; i++) {
+            CAT_LOG_DEBUG_SOCKET_ESTABLISHED(&connections[i], accepted, cat_true);
+        }
+    } while (0);
+#endif
+
+    return n;
+}
+
 static cat_always_inline void cat_socket_internal_on_connect_done(cat_socket_internal_t *socket_i, cat_sa_family_t af)
 {
     /* connect done successfully, we can do something here before transfer data */
@@ -1824,6 +2055,26 @@ static cat_bool_t cat_socket_internal_connect(
         request = NULL;
     }
     if ((type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP) {
+#ifdef TCP_FASTOPEN_CONNECT
+        if (socket_i->option_flags & CAT_SOCKET_OPTION_FLAG_TCP_FAST_OPEN) {
+            /* let the kernel defer the SYN until the first write, so that its data can be carried in the SYN,
+             * the fd is created in advance here for it (it is best-effort, connect() reports errors if any) */
+            cat_socket_fd_t fd = cat_socket_internal_get_fd_fast(socket_i);
+            if (fd == CAT_SOCKET_INVALID_FD) {
+                fd = uv__socket(address->sa_family, SOCK_STREAM, 0);
+                if (unlikely(fd < 0)) {
+                    fd = CAT_SOCKET_INVALID_FD;
+                } else if (unlikely(uv_tcp_open(&socket_i->u.tcp, fd) != 0)) {
+                    uv__close(fd);
+                    fd = CAT_SOCKET_INVALID_FD;
+                }
+            }
+            if (fd != CAT_SOCKET_INVALID_FD) {
+                int on = 1;
+                (void) setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, (const char *) &on, sizeof(on));
+            }
+        }
+#endif
         error = uv_tcp_connect(
             request, &socket_i->u.tcp, address,
             !is_try ? cat_socket_internal_connect_callback : cat_socket_internal_try_connect_callback
@@ -1850,6 +2101,7 @@ static cat_bool_t cat_socket_internal_connect(
     }
     if (request != NULL) {
         if (!is_try) {
+            cat_nsec_t start = CAT_SOCKET_INTERNAL_STATS_TIME_START(socket_i);
             cat_bool_t ret;
             socket_i->context.connect.data.status = CAT_ECANCELED;
             socket_i->context.connect.coroutine = CAT_COROUTINE_G(current);
@@ -1857,6 +2109,8 @@ static cat_bool_t cat_socket_internal_connect(
             ret = cat_time_wait(timeout);
             socket_i->io_flags = CAT_SOCKET_IO_FLAG_NONE;
             socket_i->context.connect.coroutine = NULL;
+            CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, connects, 1);
+            CAT_SOCKET_INTERNAL_STATS_TIME_ADD(socket_i, connect_time, start);
             if (unlikely(!ret)) {
                 cat_update_last_error_with_previous("Socket connect wait failed");
                 /* interrupt can not recover */
@@ -2125,6 +2379,7 @@ static cat_bool_t cat_socket_enable_crypto_impl(cat_socket_t *socket, const cat_
     cat_socket_crypto_options_t ioptions;
     cat_bool_t use_tmp_context;
     cat_bool_t ret = cat_false;
+    cat_nsec_t start;
 
     /* check options */
     if (options == NULL) {
@@ -2220,6 +2475,7 @@ static cat_bool_t cat_socket_enable_crypto_impl(cat_socket_t *socket, const cat_
     ssl->allow_self_signed = ioptions.allow_self_signed;
 
     buffer = &ssl->read_buffer;
+    start = CAT_SOCKET_INTERNAL_STATS_TIME_START(socket_i);
 
     while (1) {
         ssize_t n;
@@ -2277,6 +2533,9 @@ static cat_bool_t cat_socket_enable_crypto_impl(cat_socket_t *socket, const cat_
         }
     }
 
+    CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, handshakes, 1);
+    CAT_SOCKET_INTERNAL_STATS_TIME_ADD(socket_i, handshake_time, start);
+
     if (unlikely(!ret)) {
         /* Notice: io error can not recover */
         goto _unrecoverable_error;
@@ -2758,10 +3017,12 @@ static ssize_t cat_socket_internal_read_raw(
                     goto _error;
                 }
                 if (once) {
+                    CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, read_inline, 1);
                     return error;
                 }
                 nread += error;
                 if (nread == size) {
+                    CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, read_inline, 1);
                     return (ssize_t) nread;
                 }
                 if (error == 0) {
@@ -2790,7 +3051,14 @@ static ssize_t cat_socket_internal_read_raw(
     /* async read */
     {
         cat_socket_read_context_t context;
+        cat_nsec_t start;
         cat_bool_t ret;
+#ifdef CAT_OS_UNIX_LIKE
+        if (likely(cat_socket_internal_support_inline_read(socket_i))) {
+            CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, read_eagain, 1);
+        }
+#endif
+        start = CAT_SOCKET_INTERNAL_STATS_TIME_START(socket_i);
         /* construct context */
         context.once = once;
         context.buffer = buffer;
@@ -2817,6 +3085,7 @@ static ssize_t cat_socket_internal_read_raw(
         socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_READ;
         socket_i->context.io.read.coroutine = NULL;
         socket_i->context.io.read.data.ptr = NULL;
+        CAT_SOCKET_INTERNAL_STATS_TIME_ADD(socket_i, read_wait_time, start);
         if (unlikely(error != 0)) {
             goto _error;
         }
@@ -3077,6 +3346,14 @@ static CAT_BUFFER_STR_FREE char *cat_socket_write_vector_str(const cat_socket_wr
     return cat_buffer_export_str(&buffer);
 }
 
+static cat_always_inline size_t cat_socket_internal_write_request_size(const cat_socket_internal_t *socket_i)
+{
+    if ((socket_i->type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP) {
+        return cat_offsize_of(cat_socket_write_request_t, u.udp);
+    }
+    return cat_offsize_of(cat_socket_write_request_t, u.stream);
+}
+
 /* IOCP/io_uring may not support wait writable */
 static cat_always_inline void cat_socket_internal_write_callback(cat_socket_internal_t *socket_i, cat_socket_write_request_t *request, int status)
 {
@@ -3090,7 +3367,7 @@ static cat_always_inline void cat_socket_internal_write_callback(cat_socket_inte
     }
 
     if (request != socket_i->cache.write_request) {
-        cat_free(request);
+        cat_slab_free(request, cat_socket_internal_write_request_size(socket_i));
     }
 }
 
@@ -3223,12 +3500,8 @@ static cat_bool_t cat_socket_internal_write_raw(
     }
     if (unlikely(request == NULL)) {
         /* why we do not try write: on high-traffic scenarios, is_try_write will instead lead to performance */
-        if (!is_udp) {
-            context_size = cat_offsize_of(cat_socket_write_request_t, u.stream);
-        } else {
-            context_size = cat_offsize_of(cat_socket_write_request_t, u.udp);
-        }
-        request = (cat_socket_write_request_t *) cat_malloc(context_size);
+        context_size = cat_socket_internal_write_request_size(socket_i);
+        request = (cat_socket_write_request_t *) cat_slab_alloc(context_size);
 #if CAT_ALLOC_HANDLE_ERRORS
         if (unlikely(request == NULL)) {
             cat_update_last_error_of_syscall("Malloc for write request failed");
@@ -3254,11 +3527,16 @@ static cat_bool_t cat_socket_internal_write_raw(
         );
     }
     if (likely(error == 0)) {
+        cat_nsec_t start = CAT_SOCKET_INTERNAL_STATS_TIME_START(socket_i);
+        if (!is_dgram && socket_i->u.stream.write_queue_size != 0) {
+            CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, write_eagain, 1);
+        }
         request->error = CAT_ECANCELED;
         request->u.coroutine = CAT_COROUTINE_G(current);
         socket_i->io_flags |= CAT_SOCKET_IO_FLAG_WRITE;
         cat_queue_push_back(&socket_i->context.io.write.coroutines, &CAT_COROUTINE_G(current)->waiter.node);
         ret = cat_time_wait(timeout);
+        CAT_SOCKET_INTERNAL_STATS_TIME_ADD(socket_i, write_wait_time, start);
         cat_queue_remove(&CAT_COROUTINE_G(current)->waiter.node);
         request->u.coroutine = NULL;
         error = request->error;
@@ -3571,32 +3849,84 @@ static cat_always_inline ssize_t cat_socket_internal_try_write(
             } \
         } while (0)
 
+/* writes are queued, so they are allowed during other writes, but not during splice */
+#define CAT_SOCKET_WRITE_CHECK(_socket, _socket_i, _failure) \
+        CAT_SOCKET_IO_CHECK(_socket, _socket_i, CAT_SOCKET_IO_FLAG_NONE, _failure); \
+        do { \
+            if (unlikely(_socket_i->io_flags == CAT_SOCKET_IO_FLAG_PROXY)) { \
+                cat_update_last_error( \
+                    CAT_ELOCKED, "Socket is %s now, unable to %s", \
+                    cat_socket_io_state_naming(_socket_i->io_flags), \
+                    cat_socket_io_state_name(CAT_SOCKET_IO_FLAG_WRITE) \
+                ); \
+                _failure; \
+            } \
+        } while (0)
+
 #define CAT_SOCKET_TRY_IO_CHECK(_socket, _socket_i, _io_flag, _failure) \
         CAT_SOCKET_INTERNAL_GETTER_WITH_IO_SILENT(_socket, _socket_i, _io_flag, _failure); \
         CAT_SOCKET_INTERNAL_IO_ESTABLISHED_CHECK_FOR_STREAM_SILENT(_socket_i, _failure) \
 
 static cat_always_inline ssize_t cat_socket_read_impl(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_timeout_t timeout, cat_bool_t once)
 {
+    ssize_t nread;
+
     CAT_SOCKET_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_READ, return -1);
-    return cat_socket_internal_read(socket_i, buffer, size, address, address_length, timeout, once);
+    CAT_TRACE(SOCKET_READ_START, socket->id, size);
+    nread = cat_socket_internal_read(socket_i, buffer, size, address, address_length, timeout, once);
+    CAT_TRACE(SOCKET_READ_END, socket->id, nread);
+    if (nread > 0) {
+        CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, read_ops, 1);
+        CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, read_bytes, nread);
+    }
+
+    return nread;
 }
 
 static cat_always_inline ssize_t cat_socket_try_recv_impl(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length)
 {
+    ssize_t nread;
+
     CAT_SOCKET_TRY_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_READ, return error);
-    return cat_socket_internal_try_recv(socket_i, buffer, size, address, address_length);
+    nread = cat_socket_internal_try_recv(socket_i, buffer, size, address, address_length);
+    if (nread > 0) {
+        CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, read_ops, 1);
+        CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, read_bytes, nread);
+    }
+
+    return nread;
 }
 
 static cat_always_inline cat_bool_t cat_socket_write_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout)
 {
-    CAT_SOCKET_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_NONE, return cat_false);
-    return cat_socket_internal_write(socket_i, vector, vector_count, address, address_length, timeout);
+    size_t length;
+    cat_bool_t ret;
+
+    CAT_SOCKET_WRITE_CHECK(socket, socket_i, return cat_false);
+    length = cat_socket_write_vector_length(vector, vector_count);
+    CAT_TRACE(SOCKET_WRITE_START, socket->id, length);
+    ret = cat_socket_internal_write(socket_i, vector, vector_count, address, address_length, timeout);
+    CAT_TRACE(SOCKET_WRITE_END, socket->id, ret ? (ssize_t) length : -1);
+    if (ret) {
+        CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, write_ops, 1);
+        CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, write_bytes, length);
+    }
+
+    return ret;
 }
 
 static cat_always_inline ssize_t cat_socket_try_write_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length)
 {
+    ssize_t nwrite;
+
     CAT_SOCKET_TRY_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_WRITE, return error == CAT_ELOCKED ? CAT_EAGAIN : error);
-    return cat_socket_internal_try_write(socket_i, vector, vector_count, address, address_length);
+    nwrite = cat_socket_internal_try_write(socket_i, vector, vector_count, address, address_length);
+    if (nwrite > 0) {
+        CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, write_ops, 1);
+        CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, write_bytes, nwrite);
+    }
+
+    return nwrite;
 }
 
 #define CAT_SOCKET_READ_ADDRESS_CONTEXT(_address, _name, _name_length, _port) \
@@ -3693,7 +4023,7 @@ static cat_always_inline cat_ret_t cat_socket_internal_solve_write_to_address(
 
 static cat_bool_t cat_socket_write_to_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port, cat_timeout_t timeout)
 {
-    CAT_SOCKET_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_NONE, return cat_false);
+    CAT_SOCKET_WRITE_CHECK(socket, socket_i, return cat_false);
     CAT_SOCKET_INTERNAL_SOLVE_WRITE_TO_ADDRESS(socket_i, name, name_length, port, address, address_length, return cat_false);
 
     return cat_socket_internal_write(socket_i, vector, vector_count, address, address_length, timeout);
@@ -3865,6 +4195,90 @@ CAT_API ssize_t cat_socket_try_write_to(cat_socket_t *socket, const cat_socket_w
     return n;
 }
 
+typedef struct cat_socket_write_async_request_s {
+    cat_socket_write_async_callback_t callback;
+    void *data;
+    size_t length;
+    uv_write_t request;
+} cat_socket_write_async_request_t;
+
+static void cat_socket_write_async_callback(uv_write_t *request, int status)
+{
+    cat_socket_write_async_request_t *context = cat_container_of(request, cat_socket_write_async_request_t, request);
+
+    if (status == 0) {
+        cat_socket_internal_t *socket_i = cat_container_of(request->handle, cat_socket_internal_t, u.stream);
+        CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, write_ops, 1);
+        CAT_SOCKET_INTERNAL_STATS_ADD(socket_i, write_bytes, context->length);
+    }
+    context->callback(context->data, status);
+    cat_slab_free(context, sizeof(*context));
+}
+
+static cat_always_inline cat_bool_t cat_socket_write_async_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, cat_socket_write_async_callback_t callback, void *data)
+{
+    CAT_SOCKET_WRITE_CHECK(socket, socket_i, return cat_false);
+    cat_socket_write_async_request_t *request;
+    int error;
+
+    if (unlikely(socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM)) {
+        cat_update_last_error(CAT_ENOTSUP, "Socket write_async only supports stream sockets");
+        return cat_false;
+    }
+#ifdef CAT_SSL
+    if (unlikely(socket_i->ssl != NULL)) {
+        cat_update_last_error(CAT_ENOTSUP, "Socket write_async does not support SSL");
+        return cat_false;
+    }
+#endif
+    request = (cat_socket_write_async_request_t *) cat_slab_alloc(sizeof(*request));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(request == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for write request failed");
+        return cat_false;
+    }
+#endif
+    request->callback = callback;
+    request->data = data;
+    request->length = cat_socket_write_vector_length(vector, vector_count);
+    /* the span only covers queueing, the write is completed by the event loop */
+    CAT_TRACE(SOCKET_WRITE_START, socket->id, request->length);
+    error = uv_write(&request->request, &socket_i->u.stream, (const uv_buf_t *) vector, vector_count, cat_socket_write_async_callback);
+    CAT_TRACE(SOCKET_WRITE_END, socket->id, error == 0 ? (ssize_t) request->length : -1);
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason((cat_errno_t) error, "Socket write_async failed");
+        cat_slab_free(request, sizeof(*request));
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_socket_write_async(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, cat_socket_write_async_callback_t callback, void *data)
+{
+    cat_bool_t ret = cat_socket_write_async_impl(socket, vector, vector_count, callback, data);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *vector_quoted = cat_socket_write_vector_str(vector, vector_count);
+        CAT_LOG_DEBUG_D(SOCKET, "write_async(" CAT_SOCKET_ID_FMT ", %s) = " CAT_LOG_BOOL_RET_FMT,
+            socket->id, vector_quoted, CAT_LOG_BOOL_RET_C(ret));
+        cat_buffer_str_free(vector_quoted);
+    });
+
+    return ret;
+}
+
+CAT_API size_t cat_socket_get_write_queue_size(const cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return 0);
+
+    if (socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM) {
+        return 0;
+    }
+
+    return uv_stream_get_write_queue_size(&socket_i->u.stream);
+}
+
 CAT_API ssize_t cat_socket_recv(cat_socket_t *socket, char *buffer, size_t size)
 {
     return cat_socket_recv_ex(socket, buffer, size, cat_socket_get_read_timeout_fast(socket));
@@ -4637,7 +5051,7 @@ static void cat_socket_close_callback(uv_handle_t *handle)
 #endif
 
     if (socket_i->cache.write_request != NULL) {
-        cat_free(socket_i->cache.write_request);
+        cat_slab_free(socket_i->cache.write_request, cat_socket_internal_write_request_size(socket_i));
     }
     if (socket_i->cache.ipcc_handle_info != NULL) {
         cat_free(socket_i->cache.ipcc_handle_info);
@@ -4648,6 +5062,9 @@ static void cat_socket_close_callback(uv_handle_t *handle)
     if (socket_i->cache.peername != NULL) {
         cat_free(socket_i->cache.peername);
     }
+    if (socket_i->stats != NULL) {
+        cat_free(socket_i->stats);
+    }
 
     cat_free(socket_i);
 }
@@ -4827,6 +5244,15 @@ CAT_API cat_bool_t cat_socket_close(cat_socket_t *socket)
     return ret;
 }
 
+CAT_API void cat_socket_abort(cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return);
+
+    CAT_LOG_DEBUG(SOCKET, "abort(" CAT_SOCKET_ID_FMT ")", socket->id);
+
+    cat_socket_internal_unrecoverable_io_error(socket_i);
+}
+
 static CAT_COLD void cat_socket_internal_unrecoverable_io_error(cat_socket_internal_t *socket_i)
 {
 #ifdef CAT_SSL
@@ -4847,38 +5273,511 @@ static cat_always_inline void cat_socket_internal_ssl_recoverability_check(cat_s
 }
 #endif
 
-/* getter / status / options */
+/* proxy */
 
-CAT_API cat_bool_t cat_socket_is_available(const cat_socket_t *socket)
-{
-    return socket->internal != NULL;
-}
+#ifdef CAT_OS_LINUX
+# define CAT_SOCKET_PROXY_SPLICE 1
+#endif
 
-CAT_API cat_bool_t cat_socket_is_open(const cat_socket_t *socket)
+#define CAT_SOCKET_PROXY_BUFFER_SIZE      (64 * 1024)
+#define CAT_SOCKET_PROXY_BUFFER_POOL_SIZE 16
+
+typedef union cat_socket_proxy_buffer_u {
+    union cat_socket_proxy_buffer_u *next;
+    char data[CAT_SOCKET_PROXY_BUFFER_SIZE];
+} cat_socket_proxy_buffer_t;
+
+static char *cat_socket_proxy_buffer_alloc(void)
 {
-    return cat_socket_get_fd_fast(socket) != CAT_SOCKET_INVALID_FD;
+    cat_socket_proxy_buffer_t *buffer = CAT_SOCKET_G(proxy_buffer_pool.head);
+
+    if (buffer != NULL) {
+        CAT_SOCKET_G(proxy_buffer_pool.head) = buffer->next;
+        CAT_SOCKET_G(proxy_buffer_pool.count)--;
+        return buffer->data;
+    }
+    buffer = (cat_socket_proxy_buffer_t *) cat_malloc(sizeof(*buffer));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(buffer == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for socket proxy buffer failed");
+        return NULL;
+    }
+#endif
+
+    return buffer->data;
 }
 
-CAT_API cat_bool_t cat_socket_is_established(const cat_socket_t *socket)
+static void cat_socket_proxy_buffer_free(char *data)
 {
-    cat_socket_internal_t *socket_i = socket->internal;
-    return socket_i != NULL && cat_socket_internal_is_established(socket_i);
+    cat_socket_proxy_buffer_t *buffer = (cat_socket_proxy_buffer_t *) data;
+
+    if (CAT_SOCKET_G(proxy_buffer_pool.count) >= CAT_SOCKET_PROXY_BUFFER_POOL_SIZE) {
+        cat_free(buffer);
+        return;
+    }
+    buffer->next = CAT_SOCKET_G(proxy_buffer_pool.head);
+    CAT_SOCKET_G(proxy_buffer_pool.head) = buffer;
+    CAT_SOCKET_G(proxy_buffer_pool.count)++;
 }
 
-#ifdef CAT_SSL
-CAT_API cat_bool_t cat_socket_has_crypto(const cat_socket_t *socket)
+static void cat_socket_proxy_buffer_pool_clear(void)
 {
-    cat_socket_internal_t *socket_i = socket->internal;
-    return socket_i != NULL && socket_i->ssl != NULL;
+    cat_socket_proxy_buffer_t *buffer;
+
+    while ((buffer = CAT_SOCKET_G(proxy_buffer_pool.head)) != NULL) {
+        CAT_SOCKET_G(proxy_buffer_pool.head) = buffer->next;
+        cat_free(buffer);
+    }
+    CAT_SOCKET_G(proxy_buffer_pool.count) = 0;
 }
 
-CAT_API cat_bool_t cat_socket_is_encrypted(const cat_socket_t *socket)
+static void cat_socket_proxy_shutdown_write(cat_socket_t *socket)
 {
-    cat_socket_internal_t *socket_i = socket->internal;
-    return socket_i != NULL && cat_socket_internal_is_established(socket_i) &&
-           socket_i->ssl != NULL && cat_ssl_is_established(socket_i->ssl);
-}
-#endif
+    cat_socket_fd_t fd = cat_socket_get_fd_fast(socket);
+
+    if (fd != CAT_SOCKET_INVALID_FD) {
+        /* ENOTCONN or ENOTSOCK are both acceptable here */
+#ifndef CAT_OS_WIN
+        (void) shutdown(fd, SHUT_WR);
+#else
+        (void) shutdown(fd, SD_SEND);
+#endif
+    }
+}
+
+#ifdef CAT_SOCKET_PROXY_SPLICE
+typedef struct cat_socket_proxy_pipe_s {
+    cat_socket_fd_t input;
+    cat_socket_fd_t output;
+    cat_os_fd_t fds[2];
+    size_t pending;
+    uint64_t *bytes;
+    cat_bool_t eof;
+    cat_bool_t shutdown;
+} cat_socket_proxy_pipe_t;
+
+/* it returns CAT_RET_OK if there was any progress, or CAT_RET_NONE if it would block */
+static cat_ret_t cat_socket_proxy_pipe_transfer(cat_socket_proxy_pipe_t *pipe)
+{
+    cat_ret_t ret = CAT_RET_NONE;
+    ssize_t n;
+
+    if (!pipe->eof) {
+        do {
+            n = splice(pipe->input, NULL, pipe->fds[1], NULL,
+                CAT_SOCKET_PROXY_BUFFER_SIZE, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        } while (unlikely(n < 0 && errno == EINTR));
+        if (n > 0) {
+            pipe->pending += n;
+            ret = CAT_RET_OK;
+        } else if (n == 0) {
+            pipe->eof = cat_true;
+            ret = CAT_RET_OK;
+        } else if (unlikely(errno != EAGAIN && errno != EWOULDBLOCK)) {
+            cat_update_last_error_of_syscall("Socket proxy splice from socket failed");
+            return CAT_RET_ERROR;
+        }
+    }
+    while (pipe->pending > 0) {
+        do {
+            n = splice(pipe->fds[0], NULL, pipe->output, NULL,
+                pipe->pending, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        } while (unlikely(n < 0 && errno == EINTR));
+        if (n < 0) {
+            if (unlikely(errno != EAGAIN && errno != EWOULDBLOCK)) {
+                cat_update_last_error_of_syscall("Socket proxy splice to socket failed");
+                return CAT_RET_ERROR;
+            }
+            break;
+        }
+        if (unlikely(n == 0)) {
+            break;
+        }
+        pipe->pending -= n;
+        *pipe->bytes += n;
+        ret = CAT_RET_OK;
+    }
+    if (pipe->eof && pipe->pending == 0 && !pipe->shutdown) {
+#ifndef CAT_OS_WIN
+        (void) shutdown(pipe->output, SHUT_WR);
+#endif
+        pipe->shutdown = cat_true;
+    }
+
+    return ret;
+}
+
+static cat_always_inline void cat_socket_proxy_splice_lock(cat_socket_internal_t *socket_i)
+{
+    /* other IO operations will be rejected, and it can be canceled by close() */
+    socket_i->io_flags = CAT_SOCKET_IO_FLAG_PROXY;
+    socket_i->context.io.read.coroutine = CAT_COROUTINE_G(current);
+}
+
+static cat_always_inline void cat_socket_proxy_splice_unlock(cat_socket_internal_t *socket_i)
+{
+    socket_i->io_flags = CAT_SOCKET_IO_FLAG_NONE;
+    socket_i->context.io.read.coroutine = NULL;
+}
+
+static cat_bool_t cat_socket_proxy_splice(cat_socket_internal_t *a_i, cat_socket_internal_t *b_i, cat_socket_proxy_options_t *options)
+{
+    cat_socket_fd_t fd_a = cat_socket_internal_get_fd_fast(a_i);
+    cat_socket_fd_t fd_b = cat_socket_internal_get_fd_fast(b_i);
+    cat_socket_proxy_pipe_t pipes[2] = {
+        { fd_a, fd_b, { CAT_OS_INVALID_FD, CAT_OS_INVALID_FD }, 0, &options->a_to_b_bytes, cat_false, cat_false },
+        { fd_b, fd_a, { CAT_OS_INVALID_FD, CAT_OS_INVALID_FD }, 0, &options->b_to_a_bytes, cat_false, cat_false },
+    };
+    cat_bool_t ret = cat_false;
+    size_t i;
+
+    for (i = 0; i < CAT_ARRAY_SIZE(pipes); i++) {
+        if (unlikely(!cat_pipe(pipes[i].fds, CAT_PIPE_FLAG_NONBLOCK, CAT_PIPE_FLAG_NONBLOCK))) {
+            cat_update_last_error_with_previous("Socket proxy create pipe failed");
+            goto _out;
+        }
+    }
+    cat_socket_proxy_splice_lock(a_i);
+    cat_socket_proxy_splice_lock(b_i);
+
+    while (!pipes[0].shutdown || !pipes[1].shutdown) {
+        cat_pollfd_t fds[2];
+        cat_nfds_t nfds = 0;
+        cat_pollfd_events_t events_a = 0, events_b = 0;
+        cat_bool_t progress = cat_false;
+        int n;
+
+        for (i = 0; i < CAT_ARRAY_SIZE(pipes); i++) {
+            cat_ret_t transfer_ret = cat_socket_proxy_pipe_transfer(&pipes[i]);
+            if (unlikely(transfer_ret == CAT_RET_ERROR)) {
+                goto _out;
+            }
+            if (transfer_ret == CAT_RET_OK) {
+                progress = cat_true;
+            }
+        }
+        if (progress) {
+            continue;
+        }
+        /* we only wait for readable when pipe is empty,
+         * otherwise pipe may be full and we would be woken up again and again */
+        if (pipes[0].pending > 0) {
+            events_b |= POLLOUT;
+        } else if (!pipes[0].eof) {
+            events_a |= POLLIN;
+        }
+        if (pipes[1].pending > 0) {
+            events_a |= POLLOUT;
+        } else if (!pipes[1].eof) {
+            events_b |= POLLIN;
+        }
+        if (events_a != 0) {
+            fds[nfds].fd = fd_a;
+            fds[nfds].events = events_a;
+            fds[nfds].revents = 0;
+            nfds++;
+        }
+        if (events_b != 0) {
+            fds[nfds].fd = fd_b;
+            fds[nfds].events = events_b;
+            fds[nfds].revents = 0;
+            nfds++;
+        }
+        CAT_ASSERT(nfds > 0);
+        n = cat_poll(fds, nfds, options->idle_timeout);
+        if (unlikely(n <= 0)) {
+            if (n == 0) {
+                cat_update_last_error(CAT_ETIMEDOUT, "Socket proxy idle timedout");
+            } else {
+                cat_update_last_error_with_previous("Socket proxy poll failed");
+            }
+            goto _out;
+        }
+    }
+    ret = cat_true;
+
+    _out:
+    cat_socket_proxy_splice_unlock(a_i);
+    cat_socket_proxy_splice_unlock(b_i);
+    for (i = 0; i < CAT_ARRAY_SIZE(pipes); i++) {
+        if (pipes[i].fds[0] != CAT_OS_INVALID_FD) {
+            (void) uv__close(pipes[i].fds[0]);
+        }
+        if (pipes[i].fds[1] != CAT_OS_INVALID_FD) {
+            (void) uv__close(pipes[i].fds[1]);
+        }
+    }
+
+    return ret;
+}
+#endif /* CAT_SOCKET_PROXY_SPLICE */
+
+typedef struct cat_socket_proxy_context_s cat_socket_proxy_context_t;
+
+typedef struct cat_socket_proxy_channel_s {
+    cat_socket_proxy_context_t *context;
+    cat_socket_t *input;
+    cat_socket_t *output;
+    uint64_t *bytes;
+    /* it is not NULL only when channel is waiting for IO */
+    cat_coroutine_t *coroutine;
+} cat_socket_proxy_channel_t;
+
+struct cat_socket_proxy_context_s {
+    cat_socket_proxy_channel_t channels[2];
+    cat_timeout_t idle_timeout;
+    cat_msec_t last_active_time;
+    cat_bool_t stopping;
+    cat_errno_t error;
+    char *error_message;
+    cat_sync_wait_group_t wg;
+};
+
+static void cat_socket_proxy_context_stop(cat_socket_proxy_context_t *context)
+{
+    size_t i;
+
+    context->stopping = cat_true;
+    for (i = 0; i < CAT_ARRAY_SIZE(context->channels); i++) {
+        cat_coroutine_t *coroutine = context->channels[i].coroutine;
+        if (coroutine != NULL && coroutine != CAT_COROUTINE_G(current)) {
+            cat_coroutine_schedule(coroutine, SOCKET, "Proxy cancel");
+        }
+    }
+}
+
+static void cat_socket_proxy_context_fail(cat_socket_proxy_context_t *context)
+{
+    if (context->error == 0) {
+        context->error = cat_get_last_error_code();
+        context->error_message = cat_strdup(cat_get_last_error_message());
+    }
+    cat_socket_proxy_context_stop(context);
+}
+
+static cat_timeout_t cat_socket_proxy_context_get_idle_timeout(const cat_socket_proxy_context_t *context)
+{
+    cat_msec_t elapsed;
+
+    if (context->idle_timeout < 0) {
+        return CAT_TIMEOUT_FOREVER;
+    }
+    elapsed = cat_time_msec_cached() - context->last_active_time;
+    if (elapsed >= (cat_msec_t) context->idle_timeout) {
+        return 0;
+    }
+
+    return context->idle_timeout - (cat_timeout_t) elapsed;
+}
+
+static void cat_socket_proxy_channel_run(cat_socket_proxy_channel_t *channel)
+{
+    cat_socket_proxy_context_t *context = channel->context;
+    char *buffer;
+
+    buffer = cat_socket_proxy_buffer_alloc();
+    if (unlikely(buffer == NULL)) {
+        cat_socket_proxy_context_fail(context);
+        return;
+    }
+
+    while (!context->stopping) {
+        cat_timeout_t timeout = cat_socket_proxy_context_get_idle_timeout(context);
+        ssize_t n;
+        cat_bool_t ret;
+
+        if (unlikely(timeout == 0)) {
+            cat_update_last_error(CAT_ETIMEDOUT, "Socket proxy idle timedout");
+            cat_socket_proxy_context_fail(context);
+            break;
+        }
+        channel->coroutine = CAT_COROUTINE_G(current);
+        n = cat_socket_recv_ex(channel->input, buffer, CAT_SOCKET_PROXY_BUFFER_SIZE, timeout);
+        channel->coroutine = NULL;
+        if (unlikely(n < 0)) {
+            if (context->stopping) {
+                break;
+            }
+            if (cat_get_last_error_code() == CAT_ETIMEDOUT) {
+                /* the other direction may be still active */
+                continue;
+            }
+            cat_socket_proxy_context_fail(context);
+            break;
+        }
+        if (n == 0) {
+#ifdef CAT_SSL
+            if (cat_socket_has_crypto(channel->output)) {
+                /* TLS connection can not be half-closed */
+                cat_socket_proxy_context_stop(context);
+            } else
+#endif
+            {
+                cat_socket_proxy_shutdown_write(channel->output);
+            }
+            break;
+        }
+        context->last_active_time = cat_time_msec_cached();
+        channel->coroutine = CAT_COROUTINE_G(current);
+        ret = cat_socket_send_ex(channel->output, buffer, n, context->idle_timeout);
+        channel->coroutine = NULL;
+        if (unlikely(!ret)) {
+            if (!context->stopping) {
+                cat_socket_proxy_context_fail(context);
+            }
+            break;
+        }
+        *channel->bytes += n;
+        context->last_active_time = cat_time_msec_cached();
+    }
+
+    cat_socket_proxy_buffer_free(buffer);
+}
+
+static cat_data_t *cat_socket_proxy_channel_function(cat_data_t *data)
+{
+    cat_socket_proxy_channel_t *channel = (cat_socket_proxy_channel_t *) data;
+    cat_sync_wait_group_t *wg = &channel->context->wg;
+
+    cat_socket_proxy_channel_run(channel);
+    /* context may be released after it */
+    (void) cat_sync_wait_group_done(wg);
+
+    return NULL;
+}
+
+static cat_bool_t cat_socket_proxy_copy(cat_socket_t *a, cat_socket_t *b, cat_socket_proxy_options_t *options)
+{
+    cat_socket_proxy_context_t context;
+
+    context.channels[0].context = &context;
+    context.channels[0].input = a;
+    context.channels[0].output = b;
+    context.channels[0].bytes = &options->a_to_b_bytes;
+    context.channels[0].coroutine = NULL;
+    context.channels[1].context = &context;
+    context.channels[1].input = b;
+    context.channels[1].output = a;
+    context.channels[1].bytes = &options->b_to_a_bytes;
+    context.channels[1].coroutine = NULL;
+    context.idle_timeout = options->idle_timeout;
+    context.last_active_time = cat_time_msec_cached();
+    context.stopping = cat_false;
+    context.error = 0;
+    context.error_message = NULL;
+    (void) cat_sync_wait_group_create(&context.wg);
+
+    /* a => b runs in a new coroutine, b => a runs in the current one */
+    (void) cat_sync_wait_group_add(&context.wg, 1);
+    if (unlikely(cat_coroutine_run(NULL, cat_socket_proxy_channel_function, &context.channels[0]) == NULL)) {
+        /* release the slot of the coroutine which was never started */
+        (void) cat_sync_wait_group_done(&context.wg);
+        cat_update_last_error_with_previous("Socket proxy create coroutine failed");
+        return cat_false;
+    }
+    cat_socket_proxy_channel_run(&context.channels[1]);
+    while (!cat_sync_wait_group_wait(&context.wg, CAT_TIMEOUT_FOREVER)) {
+        /* we were interrupted, cancel the other direction and wait again */
+        cat_socket_proxy_context_fail(&context);
+    }
+
+    if (unlikely(context.error != 0)) {
+        cat_set_last_error(context.error, context.error_message);
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+CAT_API void cat_socket_proxy_options_init(cat_socket_proxy_options_t *options)
+{
+    options->idle_timeout = CAT_TIMEOUT_FOREVER;
+    options->a_to_b_bytes = 0;
+    options->b_to_a_bytes = 0;
+}
+
+static cat_bool_t cat_socket_proxy_impl(cat_socket_t *a, cat_socket_t *b, cat_socket_proxy_options_t *options)
+{
+    /* proxy includes both read and write operations */
+    CAT_SOCKET_IO_CHECK(a, a_i, CAT_SOCKET_IO_FLAG_RDWR, return cat_false);
+    CAT_SOCKET_IO_CHECK(b, b_i, CAT_SOCKET_IO_FLAG_RDWR, return cat_false);
+
+    if (unlikely(!(a_i->type & CAT_SOCKET_TYPE_FLAG_STREAM) || !(b_i->type & CAT_SOCKET_TYPE_FLAG_STREAM))) {
+        cat_update_last_error(CAT_EINVAL, "Socket proxy only supports stream sockets");
+        return cat_false;
+    }
+    if (unlikely(a_i == b_i)) {
+        cat_update_last_error(CAT_EINVAL, "Socket proxy can not forward data to itself");
+        return cat_false;
+    }
+
+#ifdef CAT_SOCKET_PROXY_SPLICE
+    if (
+# ifdef CAT_SSL
+        a_i->ssl == NULL && b_i->ssl == NULL &&
+# endif
+        !((a_i->type & CAT_SOCKET_TYPE_TTY) == CAT_SOCKET_TYPE_TTY) &&
+        !((b_i->type & CAT_SOCKET_TYPE_TTY) == CAT_SOCKET_TYPE_TTY)
+    ) {
+        return cat_socket_proxy_splice(a_i, b_i, options);
+    }
+#endif
+
+    return cat_socket_proxy_copy(a, b, options);
+}
+
+CAT_API cat_bool_t cat_socket_proxy(cat_socket_t *a, cat_socket_t *b, cat_socket_proxy_options_t *options)
+{
+    cat_socket_proxy_options_t options_storage;
+
+    if (options == NULL) {
+        cat_socket_proxy_options_init(&options_storage);
+        options = &options_storage;
+    }
+
+    CAT_LOG_DEBUG(SOCKET, "proxy(" CAT_SOCKET_ID_FMT ", " CAT_SOCKET_ID_FMT ", " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+        a->id, b->id, options->idle_timeout);
+
+    cat_bool_t ret = cat_socket_proxy_impl(a, b, options);
+
+    CAT_LOG_DEBUG(SOCKET, "proxy(" CAT_SOCKET_ID_FMT ", " CAT_SOCKET_ID_FMT ", " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT " { a_to_b: %" PRIu64 ", b_to_a: %" PRIu64 " }",
+        a->id, b->id, options->idle_timeout, CAT_LOG_BOOL_RET_C(ret), options->a_to_b_bytes, options->b_to_a_bytes);
+
+    return ret;
+}
+
+/* getter / status / options */
+
+CAT_API cat_bool_t cat_socket_is_available(const cat_socket_t *socket)
+{
+    return socket->internal != NULL;
+}
+
+CAT_API cat_bool_t cat_socket_is_open(const cat_socket_t *socket)
+{
+    return cat_socket_get_fd_fast(socket) != CAT_SOCKET_INVALID_FD;
+}
+
+CAT_API cat_bool_t cat_socket_is_established(const cat_socket_t *socket)
+{
+    cat_socket_internal_t *socket_i = socket->internal;
+    return socket_i != NULL && cat_socket_internal_is_established(socket_i);
+}
+
+#ifdef CAT_SSL
+CAT_API cat_bool_t cat_socket_has_crypto(const cat_socket_t *socket)
+{
+    cat_socket_internal_t *socket_i = socket->internal;
+    return socket_i != NULL && socket_i->ssl != NULL;
+}
+
+CAT_API cat_bool_t cat_socket_is_encrypted(const cat_socket_t *socket)
+{
+    cat_socket_internal_t *socket_i = socket->internal;
+    return socket_i != NULL && cat_socket_internal_is_established(socket_i) &&
+           socket_i->ssl != NULL && cat_ssl_is_established(socket_i->ssl);
+}
+#endif
 
 // TODO: internal version APIs
 CAT_API cat_bool_t cat_socket_is_server(const cat_socket_t *socket)
@@ -5050,6 +5949,8 @@ CAT_API const char *cat_socket_io_state_name(cat_socket_io_flags_t io_state)
             return "read or write";
         case CAT_SOCKET_IO_FLAG_BIND:
             return "bind";
+        case CAT_SOCKET_IO_FLAG_PROXY:
+            return "proxy";
         case CAT_SOCKET_IO_FLAG_NONE:
             return "idle";
     }
@@ -5071,6 +5972,8 @@ CAT_API const char *cat_socket_io_state_naming(cat_socket_io_flags_t io_state)
             return "reading and writing";
         case CAT_SOCKET_IO_FLAG_BIND:
             return "binding";
+        case CAT_SOCKET_IO_FLAG_PROXY:
+            return "proxying";
         case CAT_SOCKET_IO_FLAG_NONE:
             return "idle";
     }
@@ -5178,6 +6081,30 @@ CAT_API int cat_socket_set_send_buffer_size(cat_socket_t *socket, int size)
     return cat_socket_buffer_size(socket, cat_true, cat_socket_align_buffer_size(size));
 }
 
+CAT_API cat_bool_t cat_socket_set_busy_poll(cat_socket_t *socket, unsigned int usec)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    CAT_SOCKET_INTERNAL_FD_GETTER(socket_i, fd, return cat_false);
+#ifdef SO_BUSY_POLL
+    int value = (int) usec;
+    if (unlikely(setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, (const char *) &value, sizeof(value)) != 0)) {
+        cat_update_last_error_of_syscall("Socket set busy poll to %uus failed", usec);
+        return cat_false;
+    }
+#ifdef SO_PREFER_BUSY_POLL
+    value = usec > 0;
+    /* it is only a hint, old kernels may not support it */
+    (void) setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, (const char *) &value, sizeof(value));
+#endif
+    return cat_true;
+#else
+    (void) fd;
+    (void) usec;
+    cat_update_last_error(CAT_ENOTSUP, "Socket busy poll is not supported on this platform");
+    return cat_false;
+#endif
+}
+
 /* we always set the flag for extending (whether it works or not) */
 #define CAT_SOCKET_INTERNAL_SET_FLAG(_socket_i, _flag, _enable) do { \
     if (_enable) { \
@@ -5258,6 +6185,136 @@ CAT_API cat_bool_t cat_socket_set_tcp_keepalive(cat_socket_t *socket, cat_bool_t
     return cat_true;
 }
 
+static cat_bool_t cat_socket_internal_set_tcp_fastopen(cat_socket_internal_t *socket_i, unsigned int queue_length)
+{
+    cat_socket_fd_t fd = cat_socket_internal_get_fd_fast(socket_i);
+
+    if (fd == CAT_SOCKET_INVALID_FD) {
+        /* it will be set on listen() */
+        return cat_true;
+    }
+#ifdef TCP_FASTOPEN
+    int qlen = (int) queue_length;
+    if (unlikely(setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, (const char *) &qlen, sizeof(qlen)) != 0)) {
+        cat_update_last_error_of_syscall("Socket set TCP Fast Open queue length to %u failed", queue_length);
+        return cat_false;
+    }
+    return cat_true;
+#else
+    (void) queue_length;
+    cat_update_last_error(CAT_ENOTSUP, "Socket TCP Fast Open is not supported on this platform");
+    return cat_false;
+#endif
+}
+
+CAT_API cat_bool_t cat_socket_get_tcp_fastopen(const cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return cat_false);
+
+    return socket_i->option_flags & CAT_SOCKET_OPTION_FLAG_TCP_FAST_OPEN;
+}
+
+CAT_API unsigned int cat_socket_get_tcp_fastopen_queue_length(const cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return 0);
+
+    return socket_i->options.tcp_fastopen_queue_length;
+}
+
+CAT_API cat_bool_t cat_socket_set_tcp_fastopen(cat_socket_t *socket, cat_bool_t enable, unsigned int queue_length)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    CAT_SOCKET_INTERNAL_TCP_ONLY(socket_i, return cat_false);
+
+    if (enable) {
+#ifdef TCP_FASTOPEN
+        if (queue_length == 0) {
+            queue_length = CAT_SOCKET_G(options.tcp_fastopen_queue_length);
+        }
+#else
+        cat_update_last_error(CAT_ENOTSUP, "Socket TCP Fast Open is not supported on this platform");
+        return cat_false;
+#endif
+    } else {
+        queue_length = 0;
+    }
+    /* unlike other options, it is applied on listen(), so it is only stored if it works,
+     * otherwise listen() would fail later; client side is applied on connect() */
+    if ((socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_SERVER) &&
+        unlikely(!cat_socket_internal_set_tcp_fastopen(socket_i, queue_length))) {
+        return cat_false;
+    }
+    CAT_SOCKET_INTERNAL_SET_FLAG(socket_i, TCP_FAST_OPEN, enable);
+    socket_i->options.tcp_fastopen_queue_length = queue_length;
+
+    return cat_true;
+}
+
+static cat_bool_t cat_socket_internal_set_tcp_defer_accept(cat_socket_internal_t *socket_i, unsigned int timeout)
+{
+    cat_socket_fd_t fd = cat_socket_internal_get_fd_fast(socket_i);
+
+    if (fd == CAT_SOCKET_INVALID_FD) {
+        /* it will be set on listen() */
+        return cat_true;
+    }
+#ifdef TCP_DEFER_ACCEPT
+    int seconds = (int) timeout;
+    if (unlikely(setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, (const char *) &seconds, sizeof(seconds)) != 0)) {
+        cat_update_last_error_of_syscall("Socket set TCP_DEFER_ACCEPT to %u failed", timeout);
+        return cat_false;
+    }
+    return cat_true;
+#else
+    (void) timeout;
+    cat_update_last_error(CAT_ENOTSUP, "Socket TCP_DEFER_ACCEPT is not supported on this platform");
+    return cat_false;
+#endif
+}
+
+CAT_API cat_bool_t cat_socket_get_tcp_defer_accept(const cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return cat_false);
+
+    return socket_i->option_flags & CAT_SOCKET_OPTION_FLAG_TCP_DEFERRED_ACCEPT;
+}
+
+CAT_API unsigned int cat_socket_get_tcp_defer_accept_timeout(const cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return 0);
+
+    return socket_i->options.tcp_defer_accept_timeout;
+}
+
+CAT_API cat_bool_t cat_socket_set_tcp_defer_accept(cat_socket_t *socket, cat_bool_t enable, unsigned int timeout)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    CAT_SOCKET_INTERNAL_TCP_ONLY(socket_i, return cat_false);
+
+    if (enable) {
+#ifdef TCP_DEFER_ACCEPT
+        if (timeout == 0) {
+            timeout = CAT_SOCKET_G(options.tcp_defer_accept_timeout);
+        }
+#else
+        cat_update_last_error(CAT_ENOTSUP, "Socket TCP_DEFER_ACCEPT is not supported on this platform");
+        return cat_false;
+#endif
+    } else {
+        timeout = 0;
+    }
+    /* it only makes sense on listening socket, otherwise it is applied on listen(),
+     * so it is only stored if it works (same as TCP Fast Open) */
+    if ((socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_SERVER) &&
+        unlikely(!cat_socket_internal_set_tcp_defer_accept(socket_i, timeout))) {
+        return cat_false;
+    }
+    CAT_SOCKET_INTERNAL_SET_FLAG(socket_i, TCP_DEFERRED_ACCEPT, enable);
+    socket_i->options.tcp_defer_accept_timeout = timeout;
+
+    return cat_true;
+}
+
 CAT_API cat_bool_t cat_socket_get_udp_broadcast(const cat_socket_t *socket)
 {
     CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return cat_false);
@@ -5304,6 +6361,106 @@ CAT_API int cat_socket_get_local_free_port(void)
     return port;
 }
 
+/* stats */
+
+static cat_bool_t cat_socket_internal_enable_stats(cat_socket_internal_t *socket_i)
+{
+    if (socket_i->stats != NULL) {
+        return cat_true;
+    }
+    socket_i->stats = (cat_socket_stats_t *) cat_malloc(sizeof(*socket_i->stats));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(socket_i->stats == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for socket stats failed");
+        return cat_false;
+    }
+#endif
+    memset(socket_i->stats, 0, sizeof(*socket_i->stats));
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_socket_set_global_stats(cat_bool_t enable)
+{
+    cat_bool_t previous = CAT_SOCKET_G(stats_enabled);
+
+    CAT_SOCKET_G(stats_enabled) = enable;
+
+    return previous;
+}
+
+CAT_API const cat_socket_stats_t *cat_socket_get_global_stats(void)
+{
+    return &CAT_SOCKET_G(stats);
+}
+
+CAT_API void cat_socket_reset_global_stats(void)
+{
+    memset(&CAT_SOCKET_G(stats), 0, sizeof(CAT_SOCKET_G(stats)));
+}
+
+CAT_API cat_bool_t cat_socket_enable_stats(cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+
+    return cat_socket_internal_enable_stats(socket_i);
+}
+
+CAT_API const cat_socket_stats_t *cat_socket_get_stats(const cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return NULL);
+
+    return socket_i->stats;
+}
+
+static cat_bool_t cat_socket_internal_get_tcp_info(const cat_socket_internal_t *socket_i, cat_socket_tcp_info_t *info)
+{
+#if defined(CAT_OS_LINUX) && defined(TCP_INFO)
+    cat_socket_fd_t fd = cat_socket_internal_get_fd_fast(socket_i);
+    struct tcp_info tcp_info;
+    socklen_t length = sizeof(tcp_info);
+
+    if (unlikely(fd == CAT_SOCKET_INVALID_FD)) {
+        cat_update_last_error(CAT_EBADF, "Socket is not open");
+        return cat_false;
+    }
+    if (unlikely(getsockopt(fd, IPPROTO_TCP, TCP_INFO, &tcp_info, &length) != 0)) {
+        cat_update_last_error_of_syscall("Socket get TCP_INFO failed");
+        return cat_false;
+    }
+    info->rtt = tcp_info.tcpi_rtt;
+    info->rtt_var = tcp_info.tcpi_rttvar;
+    info->retransmits = tcp_info.tcpi_total_retrans;
+    info->lost = tcp_info.tcpi_lost;
+    info->cwnd = tcp_info.tcpi_snd_cwnd;
+    info->mss = tcp_info.tcpi_snd_mss;
+    return cat_true;
+#else
+    (void) socket_i;
+    (void) info;
+    cat_update_last_error(CAT_ENOTSUP, "Socket TCP_INFO is not supported on this platform");
+    return cat_false;
+#endif
+}
+
+CAT_API cat_bool_t cat_socket_get_tcp_info(const cat_socket_t *socket, cat_socket_tcp_info_t *info)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    CAT_SOCKET_INTERNAL_TCP_ONLY(socket_i, return cat_false);
+
+    return cat_socket_internal_get_tcp_info(socket_i, info);
+}
+
+static void cat_socket_dump_stats(const char *name, const cat_socket_stats_t *stats)
+{
+    CAT_LOG_INFO(SOCKET, "     %s: read: %" PRIu64 " ops / %" PRIu64 " bytes (inline: %" PRIu64 ", eagain: %" PRIu64 ", wait: %" PRIu64 "ns), "
+                    "write: %" PRIu64 " ops / %" PRIu64 " bytes (eagain: %" PRIu64 ", wait: %" PRIu64 "ns), "
+                    "connect: %" PRIu64 " (%" PRIu64 "ns), handshake: %" PRIu64 " (%" PRIu64 "ns)", name,
+                    stats->read_ops, stats->read_bytes, stats->read_inline, stats->read_eagain, (uint64_t) stats->read_wait_time,
+                    stats->write_ops, stats->write_bytes, stats->write_eagain, (uint64_t) stats->write_wait_time,
+                    stats->connects, (uint64_t) stats->connect_time, stats->handshakes, (uint64_t) stats->handshake_time);
+}
+
 static void cat_socket_dump_callback(uv_handle_t* handle, void* arg)
 {
     (void) arg;
@@ -5341,16 +6498,35 @@ static void cat_socket_dump_callback(uv_handle_t* handle, void* arg)
         role = cat_socket_get_role_name(socket);
         (void) cat_socket_get_sock_address(socket, sock_addr, &sock_addr_size);
         sock_port = cat_socket_get_sock_port(socket);
-        (void) cat_socket_get_sock_address(socket, peer_addr, &peer_addr_size);
+        (void) cat_socket_get_peer_address(socket, peer_addr, &peer_addr_size);
         peer_port = cat_socket_get_peer_port(socket);
         CAT_LOG_INFO(SOCKET, "%-4s id:%-6d fd: %-6d io: %-12s role: %-7s addr: %s:%d, peer: %s:%d",
                         type_name, (int) socket->id, (int) fd, io_state_naming, role, sock_addr, sock_port, peer_addr, peer_port);
+        if (socket_i->stats != NULL) {
+            cat_socket_dump_stats("stats", socket_i->stats);
+        }
+        /* TCP_INFO is meaningless for listening or unconnected sockets,
+         * and we do not want to overwrite the last error by dumping */
+        if ((socket_i->type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP &&
+            (socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_ESTABLISHED)) {
+            cat_socket_tcp_info_t info;
+            if (cat_socket_internal_get_tcp_info(socket_i, &info)) {
+                CAT_LOG_INFO(SOCKET, "     tcp: rtt: %uus, rttvar: %uus, retrans: %u, lost: %u, cwnd: %u, mss: %u",
+                                info.rtt, info.rtt_var, info.retransmits, info.lost, info.cwnd, info.mss);
+            }
+        }
     } CAT_QUEUE_FOREACH_DATA_END();
 }
 
 CAT_API void cat_socket_dump_all(void)
 {
+    static const cat_socket_stats_t empty_stats;
+
     uv_walk(&CAT_EVENT_G(loop), cat_socket_dump_callback, NULL);
+    /* sockets may have enabled stats by themselves */
+    if (memcmp(&CAT_SOCKET_G(stats), &empty_stats, sizeof(empty_stats)) != 0) {
+        cat_socket_dump_stats("global stats", &CAT_SOCKET_G(stats));
+    }
 }
 
 static void cat_socket_close_by_handle_callback(uv_handle_t* handle, void* arg)
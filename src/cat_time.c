@@ -19,6 +19,8 @@
 #include "cat_time.h"
 #include "cat_coroutine.h"
 #include "cat_event.h"
+#define CAT_TRACE_USE_PROBES
+#include "cat_trace.h"
 
 #ifndef CAT_OS_WIN
 #include "../deps/libuv/src/unix/internal.h"
@@ -116,13 +118,14 @@ static void cat_timer_callback(uv_timer_t* handle)
     cat_coroutine_t *coroutine = timer->coroutine;
 
     timer->coroutine = NULL;
+    CAT_TRACE(TIMER_FIRE, (uintptr_t) timer, 0);
     cat_coroutine_schedule(coroutine, TIME, "Timer");
 }
 
 static void cat_timer_close_callback(uv_handle_t *handle)
 {
     cat_timer_t *timer = cat_container_of(handle, cat_timer_t, handle);
-    cat_free(timer);
+    cat_slab_free(timer, sizeof(*timer));
 }
 
 static cat_timer_t *cat_timer_wait(cat_msec_t msec)
@@ -130,7 +133,7 @@ static cat_timer_t *cat_timer_wait(cat_msec_t msec)
     cat_timer_t *timer;
     cat_bool_t ret;
 
-    timer = (cat_timer_t *) cat_malloc(sizeof(*timer));;
+    timer = (cat_timer_t *) cat_slab_alloc(sizeof(*timer));
 #if CAT_ALLOC_HANDLE_ERRORS
     if (unlikely(timer == NULL)) {
         cat_update_last_error_of_syscall("Malloc for timer failed");
@@ -140,11 +143,15 @@ static cat_timer_t *cat_timer_wait(cat_msec_t msec)
 
     (void) uv_timer_init(&CAT_EVENT_G(loop), &timer->timer);
     (void) uv_timer_start(&timer->timer, cat_timer_callback, msec, 0);
+    CAT_TRACE(TIMER_ARM, (uintptr_t) timer, msec);
 
     timer->coroutine = CAT_COROUTINE_G(current);
 
     ret = cat_coroutine_yield(NULL, NULL);
 
+    if (timer->coroutine != NULL) {
+        CAT_TRACE(TIMER_CANCEL, (uintptr_t) timer, 0);
+    }
     uv_close(&timer->handle, cat_timer_close_callback);
 
     if (unlikely(!ret)) {
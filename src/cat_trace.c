@@ -0,0 +1,203 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#define CAT_TRACE_USE_PROBES
+#include "cat_trace.h"
+#include "cat_coroutine.h"
+#include "cat_time.h"
+
+CAT_API CAT_GLOBALS_DECLARE(cat_trace);
+
+#ifdef CAT_HAVE_SDT
+/* semaphores of probes, they are incremented by tracers (see CAT_TRACE_PROBE()) */
+#define CAT_TRACE_PROBE_SEMAPHORE_GEN(name, phase, title, object, value) \
+    CAT_API volatile unsigned short CAT_TRACE_PROBE_SEMAPHORE(name) __attribute__((section(".probes"))) = 0;
+CAT_TRACE_EVENT_MAP(CAT_TRACE_PROBE_SEMAPHORE_GEN)
+#undef CAT_TRACE_PROBE_SEMAPHORE_GEN
+#endif
+
+typedef struct cat_trace_event_info_s {
+    const char *name;
+    const char *phase;
+    const char *title;
+    const char *object;
+    const char *value;
+} cat_trace_event_info_t;
+
+static const cat_trace_event_info_t cat_trace_event_infos[] = {
+#define CAT_TRACE_EVENT_INFO_GEN(name, phase, title, object, value) { #name, phase, title, object, value },
+    CAT_TRACE_EVENT_MAP(CAT_TRACE_EVENT_INFO_GEN)
+#undef CAT_TRACE_EVENT_INFO_GEN
+};
+
+CAT_API cat_bool_t cat_trace_module_init(void)
+{
+    CAT_GLOBALS_REGISTER(cat_trace);
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_trace_module_shutdown(void)
+{
+    CAT_GLOBALS_UNREGISTER(cat_trace);
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_trace_runtime_init(void)
+{
+    /* do not touch the records, runtime may be re-initialized */
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_trace_runtime_shutdown(void)
+{
+    CAT_TRACE_G(enabled) = cat_false;
+    if (CAT_TRACE_G(records) != NULL) {
+        cat_free(CAT_TRACE_G(records));
+        CAT_TRACE_G(records) = NULL;
+    }
+    CAT_TRACE_G(mask) = 0;
+    CAT_TRACE_G(count) = 0;
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_trace_start(size_t capacity)
+{
+    cat_trace_record_t *records;
+    size_t size = 1;
+
+    if (unlikely(CAT_TRACE_G(enabled))) {
+        cat_update_last_error(CAT_EALREADY, "Trace is already started");
+        return cat_false;
+    }
+    if (capacity == 0) {
+        capacity = CAT_TRACE_DEFAULT_CAPACITY;
+    }
+    while (size < capacity) {
+        size <<= 1;
+    }
+    capacity = size;
+    if (capacity != CAT_TRACE_G(mask) + 1 || CAT_TRACE_G(records) == NULL) {
+        records = (cat_trace_record_t *) cat_malloc(sizeof(*records) * capacity);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(records == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for trace records failed");
+            return cat_false;
+        }
+#endif
+        if (CAT_TRACE_G(records) != NULL) {
+            cat_free(CAT_TRACE_G(records));
+        }
+        CAT_TRACE_G(records) = records;
+        CAT_TRACE_G(mask) = capacity - 1;
+    }
+    CAT_TRACE_G(count) = 0;
+    CAT_TRACE_G(enabled) = cat_true;
+
+    return cat_true;
+}
+
+CAT_API void cat_trace_stop(void)
+{
+    CAT_TRACE_G(enabled) = cat_false;
+}
+
+CAT_API cat_bool_t cat_trace_is_enabled(void)
+{
+    return CAT_TRACE_G(enabled);
+}
+
+CAT_API const char *cat_trace_event_name(cat_trace_event_t event)
+{
+    if (unlikely((size_t) event >= CAT_ARRAY_SIZE(cat_trace_event_infos))) {
+        return "UNKNOWN";
+    }
+    return cat_trace_event_infos[event].name;
+}
+
+CAT_API void cat_trace_record(cat_trace_event_t event, uint64_t object, int64_t value)
+{
+    cat_trace_record_t *record = &CAT_TRACE_G(records)[CAT_TRACE_G(count)++ & CAT_TRACE_G(mask)];
+
+    record->timestamp = cat_time_nsec();
+    record->coroutine_id = cat_coroutine_get_current_id();
+    record->object = object;
+    record->value = value;
+    record->event = event;
+    record->reserved = 0;
+}
+
+CAT_API size_t cat_trace_get_record_count(void)
+{
+    if (CAT_TRACE_G(records) == NULL) {
+        return 0;
+    }
+    return (size_t) CAT_MIN(CAT_TRACE_G(count), (uint64_t) CAT_TRACE_G(mask) + 1);
+}
+
+CAT_API const cat_trace_record_t *cat_trace_get_record(size_t index)
+{
+    size_t count = cat_trace_get_record_count();
+
+    if (unlikely(index >= count)) {
+        return NULL;
+    }
+    return &CAT_TRACE_G(records)[(CAT_TRACE_G(count) - count + index) & CAT_TRACE_G(mask)];
+}
+
+CAT_API uint64_t cat_trace_get_lost_count(void)
+{
+    return CAT_TRACE_G(count) - cat_trace_get_record_count();
+}
+
+CAT_API cat_bool_t cat_trace_export_chrome(FILE *file)
+{
+    size_t count = cat_trace_get_record_count(), index;
+    uint64_t start = count > 0 ? cat_trace_get_record(0)->timestamp : 0;
+    int error = 0;
+
+    error |= fprintf(file, "{\"traceEvents\":[\n") < 0;
+    for (index = 0; index < count && error == 0; index++) {
+        const cat_trace_record_t *record = cat_trace_get_record(index);
+        const cat_trace_event_info_t *info = &cat_trace_event_infos[record->event];
+        error |= fprintf(file,
+            "%s{\"name\":\"%s\",\"cat\":\"libcat\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":%d,\"tid\":%" PRIu64,
+            index == 0 ? "" : ",\n", info->title, info->phase,
+            (double) (record->timestamp - start) / 1000, (int) uv_os_getpid(), record->coroutine_id) < 0;
+        if (info->phase[0] == 'i') {
+            error |= fprintf(file, ",\"s\":\"t\"") < 0;
+        } else if (info->phase[0] == 'b' || info->phase[0] == 'e') {
+            error |= fprintf(file, ",\"id\":\"0x%" PRIx64 "\"", record->object) < 0;
+        }
+        error |= fprintf(file, ",\"args\":{\"event\":\"%s\"", info->name) < 0;
+        if (info->object != NULL) {
+            error |= fprintf(file, ",\"%s\":%" PRIu64, info->object, record->object) < 0;
+        }
+        if (info->value != NULL) {
+            error |= fprintf(file, ",\"%s\":%" PRId64, info->value, record->value) < 0;
+        }
+        error |= fprintf(file, "}}") < 0;
+    }
+    error |= fprintf(file, "\n]}\n") < 0;
+    if (unlikely(error != 0 || fflush(file) != 0)) {
+        cat_update_last_error_of_syscall("Trace export failed");
+        return cat_false;
+    }
+
+    return cat_true;
+}
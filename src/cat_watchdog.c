@@ -18,6 +18,12 @@
 
 #include "cat_watchdog.h"
 
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+#include <signal.h>
+#include <pthread.h>
+#include <execinfo.h>
+#endif
+
 CAT_API CAT_GLOBALS_DECLARE(cat_watchdog);
 
 static cat_timeout_t cat_watchdog_align_quantum(cat_timeout_t quantum)
@@ -70,9 +76,44 @@ static void cat_improve_timer_resolution(void)
 }
 #endif
 
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+/* signal handler (frame 0) and signal trampoline (frame 1) */
+#define CAT_WATCH_DOG_SAMPLE_SKIP_FRAMES 2
+
+static void cat_watchdog_sample(cat_watchdog_t *watchdog, cat_watchdog_sample_reason_t reason)
+{
+    cat_atomic_uint8_store(&watchdog->sampler->reason, reason);
+    (void) pthread_kill(watchdog->runtime_thread, CAT_WATCH_DOG_SAMPLE_SIGNAL);
+}
+#endif
+
+static void cat_watchdog_request_preempt(cat_watchdog_t *watchdog)
+{
+    cat_coroutine_preempt_flags_t actions = cat_atomic_uint8_load(&watchdog->preempt_actions);
+    cat_coroutine_preempt_flags_t flags = actions & CAT_COROUTINE_PREEMPT_YIELD;
+    cat_timeout_t blocking_time = watchdog->quantum * watchdog->alert_count;
+
+    if (watchdog->threshold != CAT_WATCH_DOG_THRESHOLD_DISABLED && blocking_time >= watchdog->threshold) {
+        flags |= actions & (CAT_COROUTINE_PREEMPT_LOG | CAT_COROUTINE_PREEMPT_CANCEL);
+    }
+    if (flags == CAT_COROUTINE_PREEMPT_NONE) {
+        return;
+    }
+    /* bind the request to the current switch, so that it will not hit the others */
+    cat_atomic_uint64_store(&watchdog->globals->preempt_switches, watchdog->last_switches);
+    cat_atomic_int64_store(&watchdog->globals->preempt_blocking_time, blocking_time);
+    cat_atomic_uint8_store(&watchdog->globals->preempt, flags);
+}
+
 static void cat_watchdog_loop(void* arg)
 {
     cat_watchdog_t *watchdog = (cat_watchdog_t *) arg;
+    /* cond may be woken up before timeout (by start_sampling() or spuriously),
+     * so the real elapsed time is measured */
+    cat_timeout_t elapsed = 0;
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+    cat_timeout_t sample_elapsed = 0;
+#endif
 
 #ifdef CAT_OS_WIN
     cat_improve_timer_resolution();
@@ -80,14 +121,46 @@ static void cat_watchdog_loop(void* arg)
 
     uv_sem_post(watchdog->sem);
 
+    watchdog->last_switches = watchdog->globals->switches;
     while (1) {
-        watchdog->last_switches = watchdog->globals->switches;
+        cat_timeout_t wait = watchdog->quantum - elapsed, interval = 0, waited;
+        uint64_t start;
         uv_mutex_lock(&watchdog->mutex);
-        uv_cond_timedwait(&watchdog->cond, &watchdog->mutex, watchdog->quantum);
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+        if (watchdog->sampler != NULL && watchdog->sampler->interval > 0) {
+            interval = watchdog->sampler->interval;
+            wait = CAT_MIN(wait, CAT_MAX(interval - sample_elapsed, 0));
+        }
+#endif
+        start = uv_hrtime();
+        uv_cond_timedwait(&watchdog->cond, &watchdog->mutex, wait);
         uv_mutex_unlock(&watchdog->mutex);
         if (cat_atomic_bool_load(&watchdog->stop)) {
             return;
         }
+        waited = (cat_timeout_t) (uv_hrtime() - start);
+        elapsed += waited;
+        if (elapsed < watchdog->quantum) {
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+            sample_elapsed += waited;
+            if (interval > 0 && sample_elapsed >= interval) {
+                sample_elapsed = 0;
+                /* periodic sampling, the idle scheduler is not interesting */
+                if (watchdog->globals->current != watchdog->globals->scheduler) {
+                    uv_mutex_lock(&watchdog->mutex);
+                    if (watchdog->sampler != NULL) {
+                        cat_watchdog_sample(watchdog, CAT_WATCH_DOG_SAMPLE_REASON_PERIODIC);
+                    }
+                    uv_mutex_unlock(&watchdog->mutex);
+                }
+            }
+#endif
+            continue;
+        }
+        elapsed = 0;
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+        sample_elapsed = 0;
+#endif
         /* Notice: globals info maybe changed during check,
          * but it is usually acceptable to us.
          * In other words, there is a certain probability of false alert. */
@@ -97,9 +170,18 @@ static void cat_watchdog_loop(void* arg)
         ) {
             watchdog->alert_count++;
             watchdog->alerter(watchdog);
+            cat_watchdog_request_preempt(watchdog);
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+            uv_mutex_lock(&watchdog->mutex);
+            if (watchdog->sampler != NULL) {
+                cat_watchdog_sample(watchdog, CAT_WATCH_DOG_SAMPLE_REASON_ALERT);
+            }
+            uv_mutex_unlock(&watchdog->mutex);
+#endif
         } else {
             watchdog->alert_count = 0;
         }
+        watchdog->last_switches = watchdog->globals->switches;
     }
 }
 
@@ -188,6 +270,9 @@ CAT_API cat_bool_t cat_watchdog_run(cat_watchdog_t *watchdog, cat_timeout_t quan
     watchdog->pid = uv_os_getpid();
     watchdog->globals = CAT_GLOBALS_BULK(cat_coroutine);
     watchdog->last_switches = 0;
+    watchdog->runtime_thread = uv_thread_self();
+    watchdog->sampler = NULL;
+    cat_atomic_uint8_init(&watchdog->preempt_actions, CAT_COROUTINE_PREEMPT_NONE);
 
     error = uv_sem_init(&sem, 0);
     if (error != 0) {
@@ -247,6 +332,10 @@ CAT_API cat_bool_t cat_watchdog_stop(void)
         return cat_false;
     }
 
+    if (watchdog->sampler != NULL) {
+        (void) cat_watchdog_stop_sampling();
+    }
+
     cat_atomic_bool_store(&watchdog->stop, cat_true);
     uv_mutex_lock(&watchdog->mutex);
     uv_cond_signal(&watchdog->cond);
@@ -262,6 +351,8 @@ CAT_API cat_bool_t cat_watchdog_stop(void)
     uv_mutex_destroy(&watchdog->mutex);
     uv_cond_destroy(&watchdog->cond);
     CAT_ASSERT(watchdog->sem == NULL);
+    /* drop the pending preemption request */
+    cat_atomic_uint8_store(&watchdog->globals->preempt, CAT_COROUTINE_PREEMPT_NONE);
 
     if (watchdog->allocated) {
         cat_free(watchdog);
@@ -272,6 +363,339 @@ CAT_API cat_bool_t cat_watchdog_stop(void)
     return cat_true;
 }
 
+/* sampling */
+
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+static struct sigaction cat_watchdog_sample_old_action;
+
+/* it only touches the ring which is owned by the current thread, so it is async-signal-safe
+ * (except for the first call of backtrace(), which may load libgcc, see cat_watchdog_start_sampling()) */
+static void cat_watchdog_sample_signal_handler(int signum)
+{
+    cat_watchdog_t *watchdog = CAT_WATCH_DOG_G(watchdog);
+    cat_watchdog_sampler_t *sampler;
+    cat_watchdog_sample_t *sample;
+    uint64_t head;
+    int saved_errno = errno;
+    (void) signum;
+
+    if (unlikely(watchdog == NULL || watchdog->sampler == NULL)) {
+        return;
+    }
+    sampler = watchdog->sampler;
+    head = cat_atomic_uint64_load(&sampler->head);
+    sample = &sampler->samples[head & (sampler->capacity - 1)];
+    sample->coroutine_id = watchdog->globals->current->id;
+    sample->reason = cat_atomic_uint8_load(&sampler->reason);
+    sample->depth = (uint8_t) backtrace(sample->frames, CAT_WATCH_DOG_SAMPLE_MAX_DEPTH);
+    cat_atomic_uint64_store(&sampler->head, head + 1);
+    errno = saved_errno;
+}
+
+static cat_always_inline void cat_watchdog_block_sample_signal(sigset_t *old_set)
+{
+    sigset_t set;
+
+    sigemptyset(&set);
+    sigaddset(&set, CAT_WATCH_DOG_SAMPLE_SIGNAL);
+    (void) pthread_sigmask(SIG_BLOCK, &set, old_set);
+}
+
+static cat_always_inline void cat_watchdog_unblock_sample_signal(const sigset_t *old_set)
+{
+    (void) pthread_sigmask(SIG_SETMASK, old_set, NULL);
+}
+
+/* consume the signal which has been sent but not been delivered yet (signal must be blocked) */
+static void cat_watchdog_drain_sample_signal(void)
+{
+    sigset_t set, pending;
+    int signum;
+
+    sigemptyset(&set);
+    sigaddset(&set, CAT_WATCH_DOG_SAMPLE_SIGNAL);
+    while (sigpending(&pending) == 0 && sigismember(&pending, CAT_WATCH_DOG_SAMPLE_SIGNAL) == 1) {
+        if (sigwait(&set, &signum) != 0) {
+            break;
+        }
+    }
+}
+#endif
+
+CAT_API cat_bool_t cat_watchdog_start_sampling(cat_timeout_t interval, size_t capacity)
+{
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+    cat_watchdog_t *watchdog = CAT_WATCH_DOG_G(watchdog);
+    cat_watchdog_sampler_t *sampler;
+    struct sigaction action;
+    void *dummy[1];
+
+    if (unlikely(watchdog == NULL)) {
+        cat_update_last_error(CAT_EMISUSE, "Watchdog is not running");
+        return cat_false;
+    }
+    if (unlikely(watchdog->sampler != NULL)) {
+        cat_update_last_error(CAT_EMISUSE, "Watchdog is already sampling");
+        return cat_false;
+    }
+    if (capacity == 0) {
+        capacity = CAT_WATCH_DOG_DEFAULT_SAMPLE_CAPACITY;
+    }
+    /* ring index is masked, so capacity must be power of 2 */
+    while ((capacity & (capacity - 1)) != 0) {
+        capacity = (capacity | (capacity - 1)) + 1;
+    }
+    sampler = (cat_watchdog_sampler_t *) cat_malloc(sizeof(*sampler) + sizeof(*sampler->samples) * capacity);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(sampler == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for watchdog sampler failed");
+        return cat_false;
+    }
+#endif
+    sampler->interval = interval > 0 ? interval : 0;
+    sampler->capacity = capacity;
+    cat_atomic_uint64_init(&sampler->head, 0);
+    cat_atomic_uint8_init(&sampler->reason, CAT_WATCH_DOG_SAMPLE_REASON_ALERT);
+    sampler->samples = (cat_watchdog_sample_t *) (sampler + 1);
+
+    /* backtrace() may allocate memory on its first call, do it out of signal handler */
+    (void) backtrace(dummy, 1);
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = cat_watchdog_sample_signal_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (unlikely(sigaction(CAT_WATCH_DOG_SAMPLE_SIGNAL, &action, &cat_watchdog_sample_old_action) != 0)) {
+        cat_update_last_error_of_syscall("Watchdog install sample signal handler failed");
+        cat_free(sampler);
+        return cat_false;
+    }
+
+    uv_mutex_lock(&watchdog->mutex);
+    watchdog->sampler = sampler;
+    /* apply the new interval at once */
+    uv_cond_signal(&watchdog->cond);
+    uv_mutex_unlock(&watchdog->mutex);
+
+    return cat_true;
+#else
+    cat_update_last_error(CAT_ENOTSUP, "Watchdog sampling is not supported on this platform");
+    return cat_false;
+#endif
+}
+
+CAT_API cat_bool_t cat_watchdog_stop_sampling(void)
+{
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+    cat_watchdog_t *watchdog = CAT_WATCH_DOG_G(watchdog);
+    cat_watchdog_sampler_t *sampler;
+    sigset_t old_set;
+
+    if (unlikely(watchdog == NULL || watchdog->sampler == NULL)) {
+        cat_update_last_error(CAT_EMISUSE, "Watchdog is not sampling");
+        return cat_false;
+    }
+    uv_mutex_lock(&watchdog->mutex);
+    sampler = watchdog->sampler;
+    watchdog->sampler = NULL;
+    uv_mutex_unlock(&watchdog->mutex);
+    /* watchdog thread will not send signals any more since sampler is NULL,
+     * but the last one may be still pending, and it would be delivered to the
+     * old disposition (usually SIG_DFL, which terminates the process) after the
+     * signal was unblocked, so we must consume it before restoring the old action */
+    cat_watchdog_block_sample_signal(&old_set);
+    cat_watchdog_drain_sample_signal();
+    (void) sigaction(CAT_WATCH_DOG_SAMPLE_SIGNAL, &cat_watchdog_sample_old_action, NULL);
+    cat_watchdog_unblock_sample_signal(&old_set);
+    cat_free(sampler);
+
+    return cat_true;
+#else
+    cat_update_last_error(CAT_ENOTSUP, "Watchdog sampling is not supported on this platform");
+    return cat_false;
+#endif
+}
+
+CAT_API cat_bool_t cat_watchdog_is_sampling(void)
+{
+    cat_watchdog_t *watchdog = CAT_WATCH_DOG_G(watchdog);
+
+    return watchdog != NULL && watchdog->sampler != NULL;
+}
+
+CAT_API size_t cat_watchdog_get_sample_count(void)
+{
+    cat_watchdog_t *watchdog = CAT_WATCH_DOG_G(watchdog);
+    uint64_t head;
+
+    if (watchdog == NULL || watchdog->sampler == NULL) {
+        return 0;
+    }
+    head = cat_atomic_uint64_load(&watchdog->sampler->head);
+
+    return (size_t) CAT_MIN(head, (uint64_t) watchdog->sampler->capacity);
+}
+
+CAT_API size_t cat_watchdog_get_sample_count_by_reason(cat_watchdog_sample_reason_t reason)
+{
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+    cat_watchdog_t *watchdog = CAT_WATCH_DOG_G(watchdog);
+    sigset_t old_set;
+    size_t count, n = 0, i;
+
+    if (watchdog == NULL || watchdog->sampler == NULL) {
+        return 0;
+    }
+    /* ring must not be changed by signal handler during counting */
+    cat_watchdog_block_sample_signal(&old_set);
+    count = cat_watchdog_get_sample_count();
+    for (i = 0; i < count; i++) {
+        if (watchdog->sampler->samples[i].reason == reason) {
+            n++;
+        }
+    }
+    cat_watchdog_unblock_sample_signal(&old_set);
+
+    return n;
+#else
+    (void) reason;
+    return 0;
+#endif
+}
+
+CAT_API void cat_watchdog_clear_samples(void)
+{
+    cat_watchdog_t *watchdog = CAT_WATCH_DOG_G(watchdog);
+
+    if (watchdog != NULL && watchdog->sampler != NULL) {
+        cat_atomic_uint64_store(&watchdog->sampler->head, 0);
+    }
+}
+
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+static int cat_watchdog_sample_compare(const void *a, const void *b)
+{
+    const cat_watchdog_sample_t *sa = (const cat_watchdog_sample_t *) a, *sb = (const cat_watchdog_sample_t *) b;
+
+    if (sa->coroutine_id != sb->coroutine_id) {
+        return sa->coroutine_id < sb->coroutine_id ? -1 : 1;
+    }
+    if (sa->depth != sb->depth) {
+        return sa->depth < sb->depth ? -1 : 1;
+    }
+
+    return memcmp(sa->frames, sb->frames, sizeof(sa->frames[0]) * sa->depth);
+}
+
+/* "binary(symbol+0x1a) [0x...]" (glibc) => "symbol", or the address if it is unknown */
+static cat_bool_t cat_watchdog_append_frame(cat_buffer_t *buffer, const char *symbol, void *address)
+{
+    const char *start = symbol != NULL ? strchr(symbol, '(') : NULL;
+    const char *end;
+
+    if (start != NULL) {
+        start++;
+        end = start + strcspn(start, "+)");
+        if (end > start) {
+            return cat_buffer_append(buffer, start, end - start);
+        }
+    }
+
+    return cat_buffer_append_printf(buffer, "%p", address);
+}
+#endif
+
+CAT_API cat_bool_t cat_watchdog_export_samples(cat_buffer_t *buffer, cat_bool_t by_coroutine)
+{
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+    cat_watchdog_t *watchdog = CAT_WATCH_DOG_G(watchdog);
+    cat_watchdog_sample_t *samples;
+    sigset_t old_set;
+    size_t count, i, j;
+    cat_bool_t ret = cat_false;
+
+    if (unlikely(watchdog == NULL || watchdog->sampler == NULL)) {
+        cat_update_last_error(CAT_EMISUSE, "Watchdog is not sampling");
+        return cat_false;
+    }
+    /* take a snapshot, ring must not be changed by signal handler during copy */
+    cat_watchdog_block_sample_signal(&old_set);
+    count = cat_watchdog_get_sample_count();
+    samples = (cat_watchdog_sample_t *) cat_malloc(sizeof(*samples) * CAT_MAX(count, 1));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(samples == NULL)) {
+        cat_watchdog_unblock_sample_signal(&old_set);
+        cat_update_last_error_of_syscall("Malloc for watchdog samples failed");
+        return cat_false;
+    }
+#endif
+    memcpy(samples, watchdog->sampler->samples, sizeof(*samples) * count);
+    cat_watchdog_unblock_sample_signal(&old_set);
+
+    if (!by_coroutine) {
+        for (i = 0; i < count; i++) {
+            samples[i].coroutine_id = 0;
+        }
+    }
+    /* same stacks are adjacent after sorting */
+    qsort(samples, count, sizeof(*samples), cat_watchdog_sample_compare);
+    for (i = 0; i < count; i = j) {
+        cat_watchdog_sample_t *sample = &samples[i];
+        int depth = sample->depth, k;
+        char **symbols;
+        for (j = i + 1; j < count && cat_watchdog_sample_compare(sample, &samples[j]) == 0; j++);
+        if (depth <= CAT_WATCH_DOG_SAMPLE_SKIP_FRAMES) {
+            continue;
+        }
+        if (by_coroutine && unlikely(!cat_buffer_append_printf(buffer, "coroutine#" CAT_COROUTINE_ID_FMT ";", sample->coroutine_id))) {
+            goto _out;
+        }
+        symbols = backtrace_symbols(sample->frames, depth);
+        /* root first */
+        for (k = depth - 1; k >= CAT_WATCH_DOG_SAMPLE_SKIP_FRAMES; k--) {
+            if (unlikely(!cat_watchdog_append_frame(buffer, symbols != NULL ? symbols[k] : NULL, sample->frames[k]) ||
+                         !cat_buffer_append_char(buffer, k > CAT_WATCH_DOG_SAMPLE_SKIP_FRAMES ? ';' : ' '))) {
+                free(symbols);
+                goto _out;
+            }
+        }
+        free(symbols);
+        if (unlikely(!cat_buffer_append_printf(buffer, "%zu\n", j - i))) {
+            goto _out;
+        }
+    }
+    ret = cat_true;
+
+    _out:
+    cat_free(samples);
+    return ret;
+#else
+    cat_update_last_error(CAT_ENOTSUP, "Watchdog sampling is not supported on this platform");
+    return cat_false;
+#endif
+}
+
+CAT_API cat_bool_t cat_watchdog_set_preempt_actions(cat_coroutine_preempt_flags_t actions)
+{
+    cat_watchdog_t *watchdog = CAT_WATCH_DOG_G(watchdog);
+
+    if (unlikely(watchdog == NULL)) {
+        cat_update_last_error(CAT_EMISUSE, "Watchdog is not running");
+        return cat_false;
+    }
+    cat_atomic_uint8_store(&watchdog->preempt_actions, actions);
+
+    return cat_true;
+}
+
+CAT_API cat_coroutine_preempt_flags_t cat_watchdog_get_preempt_actions(void)
+{
+    cat_watchdog_t *watchdog = CAT_WATCH_DOG_G(watchdog);
+
+    return watchdog != NULL ?
+            cat_atomic_uint8_load(&watchdog->preempt_actions) :
+            CAT_COROUTINE_PREEMPT_NONE;
+}
+
 CAT_API cat_bool_t cat_watchdog_is_running(void)
 {
     return CAT_WATCH_DOG_G(watchdog) != NULL;
@@ -18,6 +18,23 @@
 
 #include "cat_websocket.h"
 
+#ifdef CAT_L64
+# if defined(__x86_64__) || defined(_M_X64)
+#  include <emmintrin.h>
+#  define CAT_WEBSOCKET_MASK_USE_SSE2 1
+#  if defined(__GNUC__) /* (and clang) */
+#   include <immintrin.h>
+#   define CAT_WEBSOCKET_MASK_USE_AVX2 1
+#  endif
+# elif defined(__aarch64__) || defined(_M_ARM64)
+#  include <arm_neon.h>
+#  define CAT_WEBSOCKET_MASK_USE_NEON 1
+# endif
+# if defined(CAT_WEBSOCKET_MASK_USE_SSE2) || defined(CAT_WEBSOCKET_MASK_USE_NEON)
+#  define CAT_WEBSOCKET_MASK_USE_KERNEL 1
+# endif
+#endif
+
 CAT_API const char* cat_websocket_opcode_get_name(cat_websocket_opcode_t opcode)
 {
     switch(opcode) {
@@ -159,6 +176,106 @@ CAT_API void cat_websocket_header_set_payload_info(cat_websocket_header_t *heade
     cat_websocket_header_set_masking_key(header, masking_key);
 }
 
+#ifdef CAT_WEBSOCKET_MASK_USE_KERNEL
+/* vectorized kernels,
+ * they process the largest multiple of their block size of the data and return it,
+ * the caller must make sure that the index is aligned to the masking key (index % 4 == 0),
+ * from and to can be the same (but must not be partially overlapped). */
+
+typedef size_t (*cat_websocket_mask_kernel_t)(const char *from, char *to, size_t length, uint32_t masking_key_u32);
+
+#define CAT_WEBSOCKET_MASK_KERNEL_MIN_LENGTH 64
+
+#ifdef CAT_WEBSOCKET_MASK_USE_SSE2
+static size_t cat_websocket_mask_kernel_sse2(const char *from, char *to, size_t length, uint32_t masking_key_u32)
+{
+    const __m128i masking_key_m128 = _mm_set1_epi32((int) masking_key_u32);
+    size_t n = length & ~((size_t) 16 - 1), i;
+
+    for (i = 0; i < n; i += 16) {
+        __m128i data = _mm_loadu_si128((const __m128i *) (from + i));
+        _mm_storeu_si128((__m128i *) (to + i), _mm_xor_si128(data, masking_key_m128));
+    }
+
+    return n;
+}
+#endif
+
+#ifdef CAT_WEBSOCKET_MASK_USE_AVX2
+__attribute__((target("avx2")))
+static size_t cat_websocket_mask_kernel_avx2(const char *from, char *to, size_t length, uint32_t masking_key_u32)
+{
+    const __m256i masking_key_m256 = _mm256_set1_epi32((int) masking_key_u32);
+    size_t n = length & ~((size_t) 32 - 1), i;
+
+    for (i = 0; i < n; i += 32) {
+        __m256i data = _mm256_loadu_si256((const __m256i *) (from + i));
+        _mm256_storeu_si256((__m256i *) (to + i), _mm256_xor_si256(data, masking_key_m256));
+    }
+
+    return n;
+}
+#endif
+
+#ifdef CAT_WEBSOCKET_MASK_USE_NEON
+static size_t cat_websocket_mask_kernel_neon(const char *from, char *to, size_t length, uint32_t masking_key_u32)
+{
+    const uint8x16_t masking_key_u8x16 = vreinterpretq_u8_u32(vdupq_n_u32(masking_key_u32));
+    size_t n = length & ~((size_t) 16 - 1), i;
+
+    for (i = 0; i < n; i += 16) {
+        uint8x16_t data = vld1q_u8((const uint8_t *) (from + i));
+        vst1q_u8((uint8_t *) (to + i), veorq_u8(data, masking_key_u8x16));
+    }
+
+    return n;
+}
+#endif
+
+static size_t cat_websocket_mask_kernel_resolve(const char *from, char *to, size_t length, uint32_t masking_key_u32);
+
+static cat_websocket_mask_kernel_t cat_websocket_mask_kernel = cat_websocket_mask_kernel_resolve;
+static const char *cat_websocket_mask_kernel_name = NULL;
+
+/* it is idempotent, so it does not matter if threads race on it */
+static void cat_websocket_mask_kernel_select(void)
+{
+#if defined(CAT_WEBSOCKET_MASK_USE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        cat_websocket_mask_kernel_name = "avx2";
+        cat_websocket_mask_kernel = cat_websocket_mask_kernel_avx2;
+        return;
+    }
+#endif
+#if defined(CAT_WEBSOCKET_MASK_USE_SSE2)
+    cat_websocket_mask_kernel_name = "sse2";
+    cat_websocket_mask_kernel = cat_websocket_mask_kernel_sse2;
+#elif defined(CAT_WEBSOCKET_MASK_USE_NEON)
+    cat_websocket_mask_kernel_name = "neon";
+    cat_websocket_mask_kernel = cat_websocket_mask_kernel_neon;
+#endif
+}
+
+static size_t cat_websocket_mask_kernel_resolve(const char *from, char *to, size_t length, uint32_t masking_key_u32)
+{
+    cat_websocket_mask_kernel_select();
+    return cat_websocket_mask_kernel(from, to, length, masking_key_u32);
+}
+#endif
+
+CAT_API const char *cat_websocket_mask_get_kernel_name(void)
+{
+#ifdef CAT_WEBSOCKET_MASK_USE_KERNEL
+    if (cat_websocket_mask_kernel_name == NULL) {
+        cat_websocket_mask_kernel_select();
+    }
+    return cat_websocket_mask_kernel_name;
+#else
+    return "none";
+#endif
+}
+
 /* The difference between mask1 and mask2 is that
  * mask1 only needs to do calculate for the p++,
  * but mask2 should not only calculate for the from++, but also for the to++,
@@ -175,6 +292,13 @@ static void cat_websocket_mask1(char *data, uint64_t length, const char *masking
         for (; p < pe && ((index & (sizeof(uint64_t) - 1)) != 0); p++, index++) {
             *p ^= masking_key[index & (CAT_WEBSOCKET_MASKING_KEY_LENGTH - 1)];
         }
+#ifdef CAT_WEBSOCKET_MASK_USE_KERNEL
+        if (pe - p >= CAT_WEBSOCKET_MASK_KERNEL_MIN_LENGTH) {
+            size_t n = cat_websocket_mask_kernel(p, p, pe - p, *((uint32_t *) masking_key));
+            p += n;
+            index += n;
+        }
+#endif
         uint64_t masking_key_u64 = ((uint64_t) (*((uint32_t *) masking_key)) << 32) | *((uint32_t *) masking_key);
         uint64_t unmasked_length_of_u64 = pe - p;
         unmasked_length_of_u64 = unmasked_length_of_u64 - (unmasked_length_of_u64 & (sizeof(uint64_t) - 1));
@@ -198,6 +322,14 @@ static void cat_websocket_mask2(const char *from, char *to, uint64_t length, con
         for (; to < to_end && ((index & (sizeof(uint64_t) - 1)) != 0); from++, to++, index++) {
             *to = *from ^ masking_key[index & (CAT_WEBSOCKET_MASKING_KEY_LENGTH - 1)];
         }
+#ifdef CAT_WEBSOCKET_MASK_USE_KERNEL
+        if (to_end - to >= CAT_WEBSOCKET_MASK_KERNEL_MIN_LENGTH) {
+            size_t n = cat_websocket_mask_kernel(from, to, to_end - to, *((uint32_t *) masking_key));
+            from += n;
+            to += n;
+            index += n;
+        }
+#endif
         uint64_t masking_key_u64 = ((uint64_t) (*((uint32_t *) masking_key)) << 32) | *((uint32_t *) masking_key);
         uint64_t unmasked_length_of_u64 = to_end - to;
         unmasked_length_of_u64 = unmasked_length_of_u64 - (unmasked_length_of_u64 & (sizeof(uint64_t) - 1));
@@ -244,3 +376,351 @@ CAT_API void cat_websocket_unmask_ex(char *data, uint64_t length, const char *ma
 {
     cat_websocket_mask_ex(data, data, length, masking_key, index);
 }
+
+/* parser */
+
+enum cat_websocket_parser_state_e {
+    CAT_WEBSOCKET_PARSER_STATE_HEADER,
+    CAT_WEBSOCKET_PARSER_STATE_PAYLOAD,
+    CAT_WEBSOCKET_PARSER_STATE_FRAME_END,
+    CAT_WEBSOCKET_PARSER_STATE_DEAD,
+};
+
+CAT_API void cat_websocket_parser_init(cat_websocket_parser_t *parser)
+{
+    parser->flags = CAT_WEBSOCKET_PARSER_FLAG_NONE;
+    parser->max_message_length = 0;
+    cat_websocket_parser_reset(parser);
+}
+
+CAT_API void cat_websocket_parser_reset(cat_websocket_parser_t *parser)
+{
+    parser->event = CAT_WEBSOCKET_PARSER_EVENT_NONE;
+    cat_websocket_header_init(&parser->header);
+    parser->payload_length = 0;
+    parser->payload_offset = 0;
+    parser->message_opcode = CAT_WEBSOCKET_OPCODE_CONTINUATION;
+    parser->message_length = 0;
+    parser->data = NULL;
+    parser->data_length = 0;
+    parser->parsed_length = 0;
+    parser->error_status = 0;
+    parser->state = CAT_WEBSOCKET_PARSER_STATE_HEADER;
+    parser->header_length = 0;
+    parser->in_message = cat_false;
+}
+
+CAT_API cat_bool_t cat_websocket_opcode_is_control(cat_websocket_opcode_t opcode)
+{
+    return (opcode & 0x8) != 0;
+}
+
+static cat_bool_t cat_websocket_parser_error(cat_websocket_parser_t *parser, cat_websocket_status_code_t status, const char *message)
+{
+    parser->state = CAT_WEBSOCKET_PARSER_STATE_DEAD;
+    parser->error_status = status;
+    cat_update_last_error(status == CAT_WEBSOCKET_STATUS_MESSAGE_TOO_BIG ? CAT_EMSGSIZE : CAT_EPROTO,
+        "WebSocket-Parser execute failed: %s", message);
+    return cat_false;
+}
+
+static cat_bool_t cat_websocket_parser_on_header_complete(cat_websocket_parser_t *parser)
+{
+    const cat_websocket_header_t *header = &parser->header;
+    cat_websocket_opcode_t opcode = header->opcode;
+
+    if (unlikely(header->rsv2 || header->rsv3 || (header->rsv1 && !(parser->flags & CAT_WEBSOCKET_PARSER_FLAG_ALLOW_RSV1)))) {
+        return cat_websocket_parser_error(parser, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, "reserved bits must be 0");
+    }
+    if (unlikely(!header->mask && (parser->flags & CAT_WEBSOCKET_PARSER_FLAG_REQUIRE_MASK))) {
+        return cat_websocket_parser_error(parser, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, "frame must be masked");
+    }
+    parser->payload_length = cat_websocket_header_get_payload_length(header);
+    if (unlikely(parser->payload_length >> 63)) {
+        return cat_websocket_parser_error(parser, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, "payload length overflow");
+    }
+    parser->payload_offset = 0;
+    switch (opcode) {
+        case CAT_WEBSOCKET_OPCODE_CLOSE:
+        case CAT_WEBSOCKET_OPCODE_PING:
+        case CAT_WEBSOCKET_OPCODE_PONG:
+            if (unlikely(!header->fin)) {
+                return cat_websocket_parser_error(parser, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, "control frame must not be fragmented");
+            }
+            if (unlikely(parser->payload_length > CAT_WEBSOCKET_CONTROL_FRAME_MAX_PAYLOAD_LENGTH)) {
+                return cat_websocket_parser_error(parser, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, "control frame payload is too long");
+            }
+            /* RSV1 (per-message compressed) is only allowed on the first frame of data messages (RFC 7692 section 6) */
+            if (unlikely(header->rsv1)) {
+                return cat_websocket_parser_error(parser, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, "control frame must not be compressed");
+            }
+            return cat_true;
+        case CAT_WEBSOCKET_OPCODE_TEXT:
+        case CAT_WEBSOCKET_OPCODE_BINARY:
+            if (unlikely(parser->in_message)) {
+                return cat_websocket_parser_error(parser, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, "expect continuation frame");
+            }
+            parser->in_message = cat_true;
+            parser->message_opcode = opcode;
+            parser->message_length = 0;
+            break;
+        case CAT_WEBSOCKET_OPCODE_CONTINUATION:
+            if (unlikely(!parser->in_message)) {
+                return cat_websocket_parser_error(parser, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, "unexpected continuation frame");
+            }
+            if (unlikely(header->rsv1)) {
+                return cat_websocket_parser_error(parser, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, "reserved bit 1 must be 0 on continuation frame");
+            }
+            break;
+        default:
+            return cat_websocket_parser_error(parser, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, "unknown opcode");
+    }
+    parser->message_length += parser->payload_length;
+    if (unlikely(parser->max_message_length != 0 && parser->message_length > parser->max_message_length)) {
+        return cat_websocket_parser_error(parser, CAT_WEBSOCKET_STATUS_MESSAGE_TOO_BIG, "message is too big");
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_websocket_parser_execute(cat_websocket_parser_t *parser, char *data, size_t length)
+{
+    size_t parsed_length = 0;
+
+    parser->event = CAT_WEBSOCKET_PARSER_EVENT_NONE;
+    parser->data = NULL;
+    parser->data_length = 0;
+
+    switch (parser->state) {
+        case CAT_WEBSOCKET_PARSER_STATE_HEADER: {
+            char *header = (char *) &parser->header;
+            size_t header_size;
+            size_t n;
+            if (parser->header_length < CAT_WEBSOCKET_HEADER_MIN_SIZE) {
+                n = CAT_MIN(length, (size_t) (CAT_WEBSOCKET_HEADER_MIN_SIZE - parser->header_length));
+                memcpy(header + parser->header_length, data, n);
+                parser->header_length += (uint8_t) n;
+                parsed_length += n;
+                if (parser->header_length < CAT_WEBSOCKET_HEADER_MIN_SIZE) {
+                    break;
+                }
+            }
+            header_size = (size_t) cat_websocket_header_get_size(&parser->header);
+            n = CAT_MIN(length - parsed_length, header_size - parser->header_length);
+            memcpy(header + parser->header_length, data + parsed_length, n);
+            parser->header_length += (uint8_t) n;
+            parsed_length += n;
+            if (parser->header_length < header_size) {
+                break;
+            }
+            if (unlikely(!cat_websocket_parser_on_header_complete(parser))) {
+                parser->parsed_length = parsed_length;
+                return cat_false;
+            }
+            parser->state = parser->payload_length > 0 ?
+                CAT_WEBSOCKET_PARSER_STATE_PAYLOAD :
+                CAT_WEBSOCKET_PARSER_STATE_FRAME_END;
+            parser->event = CAT_WEBSOCKET_PARSER_EVENT_FRAME_HEADER;
+            break;
+        }
+        case CAT_WEBSOCKET_PARSER_STATE_PAYLOAD: {
+            uint64_t rest = parser->payload_length - parser->payload_offset;
+            size_t n = rest < length ? (size_t) rest : length;
+            if (n == 0) {
+                break;
+            }
+            if (parser->header.mask) {
+                cat_websocket_unmask_ex(data, n, cat_websocket_header_get_masking_key(&parser->header), parser->payload_offset);
+            }
+            parser->data = data;
+            parser->data_length = n;
+            parser->payload_offset += n;
+            parsed_length = n;
+            if (parser->payload_offset == parser->payload_length) {
+                parser->state = CAT_WEBSOCKET_PARSER_STATE_FRAME_END;
+            }
+            parser->event = CAT_WEBSOCKET_PARSER_EVENT_PAYLOAD;
+            break;
+        }
+        case CAT_WEBSOCKET_PARSER_STATE_FRAME_END: {
+            if (!parser->header.fin) {
+                parser->event = CAT_WEBSOCKET_PARSER_EVENT_FRAME_COMPLETE;
+            } else {
+                if (!cat_websocket_opcode_is_control(parser->header.opcode)) {
+                    parser->in_message = cat_false;
+                }
+                parser->event = CAT_WEBSOCKET_PARSER_EVENT_MESSAGE_COMPLETE;
+            }
+            parser->state = CAT_WEBSOCKET_PARSER_STATE_HEADER;
+            parser->header_length = 0;
+            break;
+        }
+        case CAT_WEBSOCKET_PARSER_STATE_DEAD:
+        default:
+            cat_update_last_error(CAT_EPROTO, "WebSocket-Parser is unavailable due to previous error");
+            parser->parsed_length = 0;
+            return cat_false;
+    }
+    parser->parsed_length = parsed_length;
+
+    CAT_LOG_DEBUG_V3(WEBSOCKET, "websocket_parser_execute(length=%-4zu) parsed %-4zu return %s",
+        length, parsed_length, cat_websocket_parser_get_event_name(parser));
+
+    return cat_true;
+}
+
+CAT_API const char *cat_websocket_parser_event_get_name(cat_websocket_parser_event_t event)
+{
+    switch (event) {
+#define CAT_WEBSOCKET_PARSER_EVENT_NAME_GEN(name, unused1) case CAT_WEBSOCKET_PARSER_EVENT_##name: return #name;
+        CAT_WEBSOCKET_PARSER_EVENT_MAP(CAT_WEBSOCKET_PARSER_EVENT_NAME_GEN);
+#undef CAT_WEBSOCKET_PARSER_EVENT_NAME_GEN
+    }
+    return "UNKNOWN";
+}
+
+CAT_API const char *cat_websocket_parser_get_event_name(const cat_websocket_parser_t *parser)
+{
+    return cat_websocket_parser_event_get_name(parser->event);
+}
+
+CAT_API cat_websocket_opcode_t cat_websocket_parser_get_opcode(const cat_websocket_parser_t *parser)
+{
+    if (parser->header.opcode == CAT_WEBSOCKET_OPCODE_CONTINUATION) {
+        return parser->message_opcode;
+    }
+    return parser->header.opcode;
+}
+
+/* serializer */
+
+CAT_API unsigned int cat_websocket_frame_serialize(
+    cat_websocket_header_t *header, cat_io_vector_t vector[2],
+    cat_websocket_opcode_t opcode, cat_bool_t fin,
+    char *payload, uint64_t payload_length, const char *masking_key
+)
+{
+    cat_websocket_header_init(header);
+    header->fin = fin;
+    header->opcode = opcode;
+    cat_websocket_header_set_payload_info(header, payload_length, masking_key);
+    if (masking_key != NULL) {
+        cat_websocket_mask_ex(payload, payload, payload_length, masking_key, 0);
+    }
+    vector[0].base = (char *) header;
+    vector[0].length = (cat_io_vector_length_t) cat_websocket_header_get_size(header);
+    if (payload_length == 0) {
+        return 1;
+    }
+    vector[1].base = payload;
+    vector[1].length = (cat_io_vector_length_t) payload_length;
+
+    return 2;
+}
+
+/* broadcast */
+
+CAT_API cat_websocket_broadcast_frame_t *cat_websocket_broadcast_frame_create(cat_websocket_opcode_t opcode, const char *payload, size_t payload_length)
+{
+    cat_websocket_broadcast_frame_t *frame;
+
+    frame = (cat_websocket_broadcast_frame_t *) cat_malloc(cat_offsize_of(cat_websocket_broadcast_frame_t, payload) + payload_length);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(frame == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for WebSocket broadcast frame failed");
+        return NULL;
+    }
+#endif
+    CAT_REF_INIT(frame);
+    if (payload_length != 0) {
+        memcpy(frame->payload, payload, payload_length);
+    }
+    frame->vector_count = cat_websocket_frame_serialize(
+        &frame->header, (cat_io_vector_t *) frame->vector,
+        opcode, cat_true, frame->payload, payload_length, NULL
+    );
+
+    return frame;
+}
+
+CAT_API void cat_websocket_broadcast_frame_release(cat_websocket_broadcast_frame_t *frame)
+{
+    if (CAT_REF_DEL(frame) == 0) {
+        cat_free(frame);
+    }
+}
+
+CAT_API void cat_websocket_broadcast_options_init(cat_websocket_broadcast_options_t *options)
+{
+    options->policy = CAT_WEBSOCKET_BROADCAST_POLICY_DROP;
+    options->max_queue_size = 0;
+    options->timeout = CAT_TIMEOUT_INVALID;
+}
+
+static void cat_websocket_broadcast_callback(void *data, cat_errno_t status)
+{
+    (void) status;
+    cat_websocket_broadcast_frame_release((cat_websocket_broadcast_frame_t *) data);
+}
+
+CAT_API size_t cat_websocket_broadcast(
+    cat_websocket_broadcast_frame_t *frame,
+    cat_socket_t * const *sockets, size_t count,
+    const cat_websocket_broadcast_options_t *options,
+    cat_websocket_broadcast_result_t *result
+)
+{
+    cat_websocket_broadcast_options_t default_options;
+    cat_websocket_broadcast_result_t default_result;
+    size_t frame_length, n;
+    cat_bool_t ret;
+
+    if (options == NULL) {
+        cat_websocket_broadcast_options_init(&default_options);
+        options = &default_options;
+    }
+    if (result == NULL) {
+        result = &default_result;
+    }
+    memset(result, 0, sizeof(*result));
+    frame_length = cat_socket_write_vector_length(frame->vector, frame->vector_count);
+
+    for (n = 0; n < count; n++) {
+        cat_socket_t *socket = sockets[n];
+        if (options->max_queue_size != 0 &&
+            cat_socket_get_write_queue_size(socket) + frame_length > options->max_queue_size) {
+            /* slow consumer */
+            if (options->policy == CAT_WEBSOCKET_BROADCAST_POLICY_DROP) {
+                result->dropped++;
+                continue;
+            } else if (options->policy == CAT_WEBSOCKET_BROADCAST_POLICY_DISCONNECT) {
+                cat_socket_abort(socket);
+                result->disconnected++;
+                continue;
+            }
+            /* the write queue is ordered, so it returns after all data queued before has been written */
+            if (options->timeout == CAT_TIMEOUT_INVALID) {
+                ret = cat_socket_write(socket, frame->vector, frame->vector_count);
+            } else {
+                ret = cat_socket_write_ex(socket, frame->vector, frame->vector_count, options->timeout);
+            }
+            if (unlikely(!ret)) {
+                CAT_LOG_DEBUG_V3(WEBSOCKET, "Broadcast to socket#" CAT_SOCKET_ID_FMT " failed, reason: %s", socket->id, cat_get_last_error_message());
+                result->failed++;
+                continue;
+            }
+            result->written++;
+            continue;
+        }
+        CAT_REF_ADD(frame);
+        if (unlikely(!cat_socket_write_async(socket, frame->vector, frame->vector_count, cat_websocket_broadcast_callback, frame))) {
+            CAT_LOG_DEBUG_V3(WEBSOCKET, "Broadcast to socket#" CAT_SOCKET_ID_FMT " failed, reason: %s", socket->id, cat_get_last_error_message());
+            CAT_REF_DEL(frame);
+            result->failed++;
+            continue;
+        }
+        result->queued++;
+    }
+
+    return result->queued + result->written;
+}
@@ -0,0 +1,616 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "cat_websocket_deflate.h"
+
+#ifdef CAT_WEBSOCKET_DEFLATE
+
+#define CAT_WEBSOCKET_DEFLATE_TRAILER        "\x00\x00\xff\xff"
+#define CAT_WEBSOCKET_DEFLATE_TRAILER_LENGTH 4
+#define CAT_WEBSOCKET_DEFLATE_CHUNK_SIZE     4096
+
+/* handshake */
+
+CAT_API void cat_websocket_deflate_parameters_init(cat_websocket_deflate_parameters_t *parameters)
+{
+    parameters->server_max_window_bits = 0;
+    parameters->client_max_window_bits = 0;
+    parameters->server_no_context_takeover = cat_false;
+    parameters->client_no_context_takeover = cat_false;
+}
+
+static cat_always_inline cat_bool_t cat_websocket_deflate_is_space(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+static void cat_websocket_deflate_trim(const char **s, const char **e)
+{
+    while (*s < *e && cat_websocket_deflate_is_space(**s)) {
+        (*s)++;
+    }
+    while (*e > *s && cat_websocket_deflate_is_space(*(*e - 1))) {
+        (*e)--;
+    }
+}
+
+static cat_bool_t cat_websocket_deflate_token_equals(const char *s, const char *e, const char *token)
+{
+    size_t length = strlen(token);
+    return (size_t) (e - s) == length && cat_strncasecmp(s, token, length) == 0;
+}
+
+static uint8_t cat_websocket_deflate_parse_window_bits(const char *s, const char *e)
+{
+    /* value may be quoted */
+    if (e - s >= 2 && *s == '"' && *(e - 1) == '"') {
+        s++;
+        e--;
+    }
+    if (e - s == 1 && *s >= '8' && *s <= '9') {
+        return (uint8_t) (*s - '0');
+    }
+    if (e - s == 2 && *s == '1' && *(s + 1) >= '0' && *(s + 1) <= '5') {
+        return (uint8_t) (10 + (*(s + 1) - '0'));
+    }
+    return 0;
+}
+
+/* parse parameters of one extension (without its name), returns false if any of them is invalid */
+static cat_bool_t cat_websocket_deflate_parameters_parse_one(cat_websocket_deflate_parameters_t *parameters, const char *s, const char *e)
+{
+    cat_websocket_deflate_parameters_init(parameters);
+    while (s < e) {
+        const char *ps = s, *pe, *vs = NULL, *ve = NULL, *eq;
+        cat_bool_t duplicated;
+        pe = (const char *) memchr(s, ';', e - s);
+        if (pe == NULL) {
+            pe = e;
+        }
+        s = pe + (pe < e);
+        eq = (const char *) memchr(ps, '=', pe - ps);
+        if (eq != NULL) {
+            vs = eq + 1;
+            ve = pe;
+            pe = eq;
+            cat_websocket_deflate_trim(&vs, &ve);
+        }
+        cat_websocket_deflate_trim(&ps, &pe);
+        if (ps == pe) {
+            continue;
+        }
+        if (cat_websocket_deflate_token_equals(ps, pe, "server_no_context_takeover")) {
+            duplicated = parameters->server_no_context_takeover;
+            parameters->server_no_context_takeover = cat_true;
+        } else if (cat_websocket_deflate_token_equals(ps, pe, "client_no_context_takeover")) {
+            duplicated = parameters->client_no_context_takeover;
+            parameters->client_no_context_takeover = cat_true;
+        } else if (cat_websocket_deflate_token_equals(ps, pe, "server_max_window_bits")) {
+            duplicated = parameters->server_max_window_bits != 0;
+            if (vs == NULL || (parameters->server_max_window_bits = cat_websocket_deflate_parse_window_bits(vs, ve)) == 0) {
+                return cat_false;
+            }
+            continue;
+        } else if (cat_websocket_deflate_token_equals(ps, pe, "client_max_window_bits")) {
+            duplicated = parameters->client_max_window_bits != 0;
+            if (vs == NULL) {
+                parameters->client_max_window_bits = CAT_WEBSOCKET_DEFLATE_WINDOW_BITS_ANY;
+            } else if ((parameters->client_max_window_bits = cat_websocket_deflate_parse_window_bits(vs, ve)) == 0) {
+                return cat_false;
+            }
+            if (duplicated) {
+                return cat_false;
+            }
+            continue;
+        } else {
+            /* unknown parameter */
+            return cat_false;
+        }
+        if (duplicated || vs != NULL) {
+            return cat_false;
+        }
+    }
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_websocket_deflate_parameters_parse(cat_websocket_deflate_parameters_t *parameters, const char *value, size_t length)
+{
+    const char *s = value, *e = value + length;
+
+    while (s < e) {
+        const char *es = s, *ee, *ns, *ne;
+        ee = (const char *) memchr(s, ',', e - s);
+        if (ee == NULL) {
+            ee = e;
+        }
+        s = ee + (ee < e);
+        ns = es;
+        ne = (const char *) memchr(es, ';', ee - es);
+        if (ne == NULL) {
+            ne = ee;
+        }
+        cat_websocket_deflate_trim(&ns, &ne);
+        if (!cat_websocket_deflate_token_equals(ns, ne, CAT_WEBSOCKET_DEFLATE_EXTENSION_NAME)) {
+            continue;
+        }
+        if (cat_websocket_deflate_parameters_parse_one(parameters, ne + (ne < ee), ee)) {
+            return cat_true;
+        }
+        /* decline the invalid offer and try the next one */
+    }
+
+    return cat_false;
+}
+
+CAT_API size_t cat_websocket_deflate_parameters_format(const cat_websocket_deflate_parameters_t *parameters, char *buffer, size_t size)
+{
+    char client_max_window_bits[sizeof("; client_max_window_bits=255")];
+    char server_max_window_bits[sizeof("; server_max_window_bits=255")];
+    int length;
+
+    if (parameters->client_max_window_bits == CAT_WEBSOCKET_DEFLATE_WINDOW_BITS_ANY) {
+        snprintf(client_max_window_bits, sizeof(client_max_window_bits), "; client_max_window_bits");
+    } else if (parameters->client_max_window_bits != 0) {
+        snprintf(client_max_window_bits, sizeof(client_max_window_bits), "; client_max_window_bits=%u", parameters->client_max_window_bits);
+    } else {
+        client_max_window_bits[0] = '\0';
+    }
+    if (parameters->server_max_window_bits != 0) {
+        snprintf(server_max_window_bits, sizeof(server_max_window_bits), "; server_max_window_bits=%u", parameters->server_max_window_bits);
+    } else {
+        server_max_window_bits[0] = '\0';
+    }
+    length = snprintf(buffer, size, CAT_WEBSOCKET_DEFLATE_EXTENSION_NAME "%s%s%s%s",
+        parameters->server_no_context_takeover ? "; server_no_context_takeover" : "",
+        parameters->client_no_context_takeover ? "; client_no_context_takeover" : "",
+        server_max_window_bits, client_max_window_bits);
+    if (unlikely(length < 0 || (size_t) length >= size)) {
+        return 0;
+    }
+
+    return (size_t) length;
+}
+
+CAT_API cat_bool_t cat_websocket_deflate_parameters_negotiate(
+    const cat_websocket_deflate_parameters_t *offer,
+    const cat_websocket_deflate_parameters_t *limits,
+    cat_websocket_deflate_parameters_t *response
+)
+{
+    uint8_t window_bits;
+
+    cat_websocket_deflate_parameters_init(response);
+    response->server_no_context_takeover = offer->server_no_context_takeover || limits->server_no_context_takeover;
+    response->client_no_context_takeover = offer->client_no_context_takeover || limits->client_no_context_takeover;
+    /* what we will use */
+    window_bits = limits->server_max_window_bits != 0 ? limits->server_max_window_bits : CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS;
+    if (offer->server_max_window_bits != 0 && offer->server_max_window_bits < window_bits) {
+        window_bits = offer->server_max_window_bits;
+    }
+    if (window_bits < CAT_WEBSOCKET_DEFLATE_MIN_WINDOW_BITS) {
+        return cat_false;
+    }
+    if (window_bits != CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS || offer->server_max_window_bits != 0) {
+        response->server_max_window_bits = window_bits;
+    }
+    /* what client will use, we can only limit it if client supports it */
+    if (offer->client_max_window_bits != 0) {
+        window_bits = offer->client_max_window_bits != CAT_WEBSOCKET_DEFLATE_WINDOW_BITS_ANY ?
+            offer->client_max_window_bits : CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS;
+        if (limits->client_max_window_bits != 0 &&
+            limits->client_max_window_bits != CAT_WEBSOCKET_DEFLATE_WINDOW_BITS_ANY &&
+            limits->client_max_window_bits < window_bits) {
+            window_bits = limits->client_max_window_bits;
+        }
+        if (window_bits != CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS || offer->client_max_window_bits != CAT_WEBSOCKET_DEFLATE_WINDOW_BITS_ANY) {
+            response->client_max_window_bits = window_bits;
+        }
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_websocket_deflate_parameters_accept(
+    const cat_websocket_deflate_parameters_t *offer,
+    const cat_websocket_deflate_parameters_t *response
+)
+{
+    /* server must not respond with a value we did not offer or a bigger window than we asked for */
+    if (offer->server_max_window_bits != 0 &&
+        (response->server_max_window_bits == 0 || response->server_max_window_bits > offer->server_max_window_bits)) {
+        return cat_false;
+    }
+    if (response->client_max_window_bits != 0) {
+        if (offer->client_max_window_bits == 0 ||
+            response->client_max_window_bits == CAT_WEBSOCKET_DEFLATE_WINDOW_BITS_ANY ||
+            (offer->client_max_window_bits != CAT_WEBSOCKET_DEFLATE_WINDOW_BITS_ANY &&
+             response->client_max_window_bits > offer->client_max_window_bits)) {
+            return cat_false;
+        }
+        /* we are the deflater of this direction */
+        if (response->client_max_window_bits < CAT_WEBSOCKET_DEFLATE_MIN_WINDOW_BITS) {
+            return cat_false;
+        }
+    }
+
+    return cat_true;
+}
+
+/* stream */
+
+struct cat_websocket_deflate_stream_s {
+    cat_queue_node_t node;
+    z_stream z;
+    cat_bool_t is_deflater;
+    int window_bits;
+    int level;
+    int mem_level;
+    size_t memory_usage;
+};
+
+static voidpf cat_websocket_deflate_zalloc(voidpf opaque, uInt items, uInt size)
+{
+    cat_websocket_deflate_stream_t *stream = (cat_websocket_deflate_stream_t *) opaque;
+    size_t length = (size_t) items * size;
+    size_t *ptr = (size_t *) cat_malloc(sizeof(size_t) + length);
+
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(ptr == NULL)) {
+        return Z_NULL;
+    }
+#endif
+    *ptr = length;
+    stream->memory_usage += length;
+
+    return ptr + 1;
+}
+
+static void cat_websocket_deflate_zfree(voidpf opaque, voidpf address)
+{
+    cat_websocket_deflate_stream_t *stream = (cat_websocket_deflate_stream_t *) opaque;
+    size_t *ptr = ((size_t *) address) - 1;
+
+    stream->memory_usage -= *ptr;
+    cat_free(ptr);
+}
+
+static cat_websocket_deflate_stream_t *cat_websocket_deflate_stream_create(cat_bool_t is_deflater, int window_bits, int level, int mem_level)
+{
+    cat_websocket_deflate_stream_t *stream;
+    int error;
+
+    stream = (cat_websocket_deflate_stream_t *) cat_malloc(sizeof(*stream));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(stream == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for WebSocket deflate stream failed");
+        return NULL;
+    }
+#endif
+    memset(&stream->z, 0, sizeof(stream->z));
+    stream->z.zalloc = cat_websocket_deflate_zalloc;
+    stream->z.zfree = cat_websocket_deflate_zfree;
+    stream->z.opaque = stream;
+    stream->is_deflater = is_deflater;
+    stream->window_bits = window_bits;
+    stream->level = level;
+    stream->mem_level = mem_level;
+    stream->memory_usage = 0;
+    /* negative window bits for raw deflate data */
+    if (is_deflater) {
+        error = deflateInit2(&stream->z, level, Z_DEFLATED, -window_bits, mem_level, Z_DEFAULT_STRATEGY);
+    } else {
+        error = inflateInit2(&stream->z, -window_bits);
+    }
+    if (unlikely(error != Z_OK)) {
+        cat_update_last_error(CAT_EINVAL, "WebSocket %s init failed: %s", is_deflater ? "deflate" : "inflate", zError(error));
+        cat_free(stream);
+        return NULL;
+    }
+
+    return stream;
+}
+
+static void cat_websocket_deflate_stream_free(cat_websocket_deflate_stream_t *stream)
+{
+    if (stream->is_deflater) {
+        (void) deflateEnd(&stream->z);
+    } else {
+        (void) inflateEnd(&stream->z);
+    }
+    cat_free(stream);
+}
+
+/* zlib deflate() is shadowed by the context argument in the functions below */
+static cat_always_inline int cat_websocket_deflate_stream_deflate(cat_websocket_deflate_stream_t *stream, int flush)
+{
+    return deflate(&stream->z, flush);
+}
+
+static void cat_websocket_deflate_stream_reset(cat_websocket_deflate_stream_t *stream)
+{
+    if (stream->is_deflater) {
+        (void) deflateReset(&stream->z);
+    } else {
+        (void) inflateReset(&stream->z);
+    }
+}
+
+/* pool */
+
+CAT_API cat_websocket_deflate_pool_t *cat_websocket_deflate_pool_create(cat_websocket_deflate_pool_t *pool, size_t max_count)
+{
+    if (pool == NULL) {
+        pool = (cat_websocket_deflate_pool_t *) cat_malloc(sizeof(*pool));
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(pool == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for WebSocket deflate pool failed");
+            return NULL;
+        }
+#endif
+    }
+    cat_queue_init(&pool->streams);
+    pool->count = 0;
+    pool->max_count = max_count;
+
+    return pool;
+}
+
+CAT_API void cat_websocket_deflate_pool_close(cat_websocket_deflate_pool_t *pool)
+{
+    cat_websocket_deflate_stream_t *stream;
+
+    while ((stream = cat_queue_front_data(&pool->streams, cat_websocket_deflate_stream_t, node))) {
+        cat_queue_remove(&stream->node);
+        cat_websocket_deflate_stream_free(stream);
+    }
+    pool->count = 0;
+}
+
+/* context */
+
+CAT_API void cat_websocket_deflate_options_init(cat_websocket_deflate_options_t *options)
+{
+    options->level = Z_DEFAULT_COMPRESSION;
+    options->mem_level = 8;
+    options->max_message_length = 0;
+    options->pool = NULL;
+}
+
+static uint8_t cat_websocket_deflate_window_bits(uint8_t window_bits)
+{
+    if (window_bits == 0 || window_bits == CAT_WEBSOCKET_DEFLATE_WINDOW_BITS_ANY) {
+        return CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS;
+    }
+    return CAT_MAX(window_bits, CAT_WEBSOCKET_DEFLATE_MIN_WINDOW_BITS);
+}
+
+CAT_API cat_websocket_deflate_t *cat_websocket_deflate_create(
+    cat_websocket_deflate_t *deflate,
+    const cat_websocket_deflate_parameters_t *parameters, cat_bool_t is_server,
+    const cat_websocket_deflate_options_t *options
+)
+{
+    if (deflate == NULL) {
+        deflate = (cat_websocket_deflate_t *) cat_malloc(sizeof(*deflate));
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(deflate == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for WebSocket deflate failed");
+            return NULL;
+        }
+#endif
+    }
+    if (options == NULL) {
+        cat_websocket_deflate_options_init(&deflate->options);
+    } else {
+        deflate->options = *options;
+    }
+    if (is_server) {
+        deflate->deflate_window_bits = cat_websocket_deflate_window_bits(parameters->server_max_window_bits);
+        deflate->inflate_window_bits = cat_websocket_deflate_window_bits(parameters->client_max_window_bits);
+        deflate->deflate_no_context_takeover = parameters->server_no_context_takeover;
+        deflate->inflate_no_context_takeover = parameters->client_no_context_takeover;
+    } else {
+        deflate->deflate_window_bits = cat_websocket_deflate_window_bits(parameters->client_max_window_bits);
+        deflate->inflate_window_bits = cat_websocket_deflate_window_bits(parameters->server_max_window_bits);
+        deflate->deflate_no_context_takeover = parameters->client_no_context_takeover;
+        deflate->inflate_no_context_takeover = parameters->server_no_context_takeover;
+    }
+    deflate->deflater = NULL;
+    deflate->inflater = NULL;
+    deflate->inflated_length = 0;
+
+    return deflate;
+}
+
+CAT_API void cat_websocket_deflate_close(cat_websocket_deflate_t *deflate)
+{
+    if (deflate->deflater != NULL) {
+        cat_websocket_deflate_stream_free(deflate->deflater);
+        deflate->deflater = NULL;
+    }
+    if (deflate->inflater != NULL) {
+        cat_websocket_deflate_stream_free(deflate->inflater);
+        deflate->inflater = NULL;
+    }
+}
+
+static cat_websocket_deflate_stream_t *cat_websocket_deflate_acquire(cat_websocket_deflate_t *deflate, cat_bool_t is_deflater)
+{
+    cat_websocket_deflate_stream_t **stream_ptr = is_deflater ? &deflate->deflater : &deflate->inflater;
+    cat_bool_t no_context_takeover = is_deflater ? deflate->deflate_no_context_takeover : deflate->inflate_no_context_takeover;
+    int window_bits = is_deflater ? deflate->deflate_window_bits : deflate->inflate_window_bits;
+    cat_websocket_deflate_pool_t *pool = deflate->options.pool;
+
+    if (*stream_ptr != NULL) {
+        return *stream_ptr;
+    }
+    if (pool != NULL && no_context_takeover) {
+        CAT_QUEUE_FOREACH_DATA_START(&pool->streams, cat_websocket_deflate_stream_t, node, stream) {
+            if (stream->is_deflater == is_deflater &&
+                stream->window_bits == window_bits &&
+                (!is_deflater || (stream->level == deflate->options.level && stream->mem_level == deflate->options.mem_level))) {
+                cat_queue_remove(&stream->node);
+                pool->count--;
+                *stream_ptr = stream;
+                return stream;
+            }
+        } CAT_QUEUE_FOREACH_DATA_END();
+    }
+    *stream_ptr = cat_websocket_deflate_stream_create(is_deflater, window_bits, deflate->options.level, deflate->options.mem_level);
+
+    return *stream_ptr;
+}
+
+/* called at the end of each message */
+static void cat_websocket_deflate_release(cat_websocket_deflate_t *deflate, cat_bool_t is_deflater)
+{
+    cat_websocket_deflate_stream_t **stream_ptr = is_deflater ? &deflate->deflater : &deflate->inflater;
+    cat_bool_t no_context_takeover = is_deflater ? deflate->deflate_no_context_takeover : deflate->inflate_no_context_takeover;
+    cat_websocket_deflate_pool_t *pool = deflate->options.pool;
+    cat_websocket_deflate_stream_t *stream = *stream_ptr;
+
+    if (!no_context_takeover) {
+        return;
+    }
+    cat_websocket_deflate_stream_reset(stream);
+    if (pool == NULL) {
+        return;
+    }
+    *stream_ptr = NULL;
+    if (pool->count < pool->max_count) {
+        cat_queue_push_back(&pool->streams, &stream->node);
+        pool->count++;
+    } else {
+        cat_websocket_deflate_stream_free(stream);
+    }
+}
+
+CAT_API cat_bool_t cat_websocket_deflate_compress(cat_websocket_deflate_t *deflate, const char *data, size_t length, cat_bool_t fin, cat_buffer_t *buffer)
+{
+    cat_websocket_deflate_stream_t *stream;
+    z_stream *z;
+    int flush = fin ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+    int error;
+
+    stream = cat_websocket_deflate_acquire(deflate, cat_true);
+    if (unlikely(stream == NULL)) {
+        return cat_false;
+    }
+    z = &stream->z;
+    z->next_in = (Bytef *) data;
+    z->avail_in = (uInt) length;
+    do {
+        if (unlikely(!cat_buffer_prepare(buffer, CAT_MAX(length / 2, CAT_WEBSOCKET_DEFLATE_CHUNK_SIZE)))) {
+            return cat_false;
+        }
+        z->next_out = (Bytef *) (buffer->value + buffer->length);
+        z->avail_out = (uInt) (buffer->size - buffer->length);
+        error = cat_websocket_deflate_stream_deflate(stream, flush);
+        if (unlikely(error != Z_OK && error != Z_BUF_ERROR)) {
+            cat_update_last_error(CAT_EINVAL, "WebSocket deflate failed: %s", z->msg != NULL ? z->msg : zError(error));
+            return cat_false;
+        }
+        buffer->length = buffer->size - z->avail_out;
+    } while (z->avail_out == 0 || z->avail_in != 0);
+    if (fin) {
+        /* remove the tail of the empty stored block */
+        CAT_ASSERT(buffer->length >= CAT_WEBSOCKET_DEFLATE_TRAILER_LENGTH);
+        CAT_ASSERT(memcmp(buffer->value + buffer->length - CAT_WEBSOCKET_DEFLATE_TRAILER_LENGTH,
+            CAT_WEBSOCKET_DEFLATE_TRAILER, CAT_WEBSOCKET_DEFLATE_TRAILER_LENGTH) == 0);
+        buffer->length -= CAT_WEBSOCKET_DEFLATE_TRAILER_LENGTH;
+        cat_websocket_deflate_release(deflate, cat_true);
+    }
+
+    return cat_true;
+}
+
+static cat_bool_t cat_websocket_deflate_inflate(cat_websocket_deflate_t *deflate, z_stream *z, const char *data, size_t length, cat_buffer_t *buffer)
+{
+    size_t max_message_length = deflate->options.max_message_length;
+    int error;
+
+    z->next_in = (Bytef *) data;
+    z->avail_in = (uInt) length;
+    while (z->avail_in != 0) {
+        size_t previous_length = buffer->length;
+        if (unlikely(!cat_buffer_prepare(buffer, CAT_MAX(length * 2, CAT_WEBSOCKET_DEFLATE_CHUNK_SIZE)))) {
+            return cat_false;
+        }
+        z->next_out = (Bytef *) (buffer->value + buffer->length);
+        z->avail_out = (uInt) (buffer->size - buffer->length);
+        error = inflate(z, Z_SYNC_FLUSH);
+        if (error == Z_STREAM_END) {
+            /* peer set BFINAL, the rest of the message (trailer) is ignored */
+            (void) inflateReset(z);
+            z->avail_in = 0;
+        } else if (unlikely(error != Z_OK && error != Z_BUF_ERROR)) {
+            cat_update_last_error(CAT_EPROTO, "WebSocket inflate failed: %s", z->msg != NULL ? z->msg : zError(error));
+            return cat_false;
+        }
+        buffer->length = buffer->size - z->avail_out;
+        deflate->inflated_length += buffer->length - previous_length;
+        if (unlikely(max_message_length != 0 && deflate->inflated_length > max_message_length)) {
+            cat_update_last_error(CAT_EMSGSIZE, "WebSocket inflated message is too big");
+            return cat_false;
+        }
+        if (error == Z_BUF_ERROR && z->avail_out != 0) {
+            /* no progress is possible */
+            break;
+        }
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_websocket_deflate_decompress(cat_websocket_deflate_t *deflate, const char *data, size_t length, cat_bool_t fin, cat_buffer_t *buffer)
+{
+    cat_websocket_deflate_stream_t *stream;
+
+    stream = cat_websocket_deflate_acquire(deflate, cat_false);
+    if (unlikely(stream == NULL)) {
+        return cat_false;
+    }
+    if (unlikely(!cat_websocket_deflate_inflate(deflate, &stream->z, data, length, buffer))) {
+        return cat_false;
+    }
+    if (fin) {
+        if (unlikely(!cat_websocket_deflate_inflate(deflate, &stream->z, CAT_STRL(CAT_WEBSOCKET_DEFLATE_TRAILER), buffer))) {
+            return cat_false;
+        }
+        deflate->inflated_length = 0;
+        cat_websocket_deflate_release(deflate, cat_false);
+    }
+
+    return cat_true;
+}
+
+CAT_API size_t cat_websocket_deflate_get_memory_usage(const cat_websocket_deflate_t *deflate)
+{
+    size_t usage = 0;
+
+    if (deflate->deflater != NULL) {
+        usage += deflate->deflater->memory_usage;
+    }
+    if (deflate->inflater != NULL) {
+        usage += deflate->inflater->memory_usage;
+    }
+
+    return usage;
+}
+
+#endif /* CAT_WEBSOCKET_DEFLATE */
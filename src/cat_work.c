@@ -20,6 +20,8 @@
 #include "cat_coroutine.h"
 #include "cat_event.h"
 #include "cat_time.h"
+#define CAT_TRACE_USE_PROBES
+#include "cat_trace.h"
 
 typedef struct cat_work_context_s {
     union {
@@ -43,6 +45,7 @@ static void cat_work_after_done(uv_work_t *request, int status)
 {
     cat_work_context_t *context = (cat_work_context_t *) request;
 
+    CAT_TRACE(WORK_COMPLETE, (uintptr_t) context, status);
     if (likely(context->request.coroutine != NULL)) {
         context->status = status;
         cat_coroutine_schedule(context->request.coroutine, WORK, "Work");
@@ -51,12 +54,12 @@ static void cat_work_after_done(uv_work_t *request, int status)
     if (context->cleanup != NULL) {
         context->cleanup(context->data);
     }
-    cat_free(context);
+    cat_slab_free(context, sizeof(*context));
 }
 
 CAT_API cat_bool_t cat_work(cat_work_kind_t kind, cat_work_function_t function, cat_work_cleanup_callback_t cleanup, cat_data_t *data, cat_timeout_t timeout)
 {
-    cat_work_context_t *context = (cat_work_context_t *) cat_malloc(sizeof(*context));
+    cat_work_context_t *context = (cat_work_context_t *) cat_slab_alloc(sizeof(*context));
     cat_bool_t ret;
 
 #if CAT_ALLOC_HANDLE_ERRORS
@@ -72,6 +75,7 @@ CAT_API cat_bool_t cat_work(cat_work_kind_t kind, cat_work_function_t function,
     context->cleanup = cleanup;
     context->data = data;
     (void) uv_queue_work_ex(&CAT_EVENT_G(loop), &context->request.work, (uv_work_kind) kind, cat_work_callback, cat_work_after_done);
+    CAT_TRACE(WORK_SUBMIT, (uintptr_t) context, 0);
     context->status = CAT_ECANCELED;
     context->request.coroutine = CAT_COROUTINE_G(current);
     ret = cat_time_wait(timeout);
@@ -0,0 +1,203 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "test.h"
+
+extern cat_coroutine_t *echo_tcp_server;
+extern char echo_tcp_server_ip[CAT_SOCKET_IPV6_BUFFER_SIZE];
+extern size_t echo_tcp_server_ip_length;
+extern int echo_tcp_server_port;
+
+extern TEST_REQUIREMENT_DTOR(cat_socket, echo_tcp_server);
+extern TEST_REQUIREMENT(cat_socket, echo_tcp_server);
+
+static std::string chain_to_string(const cat_buf_chain_t *chain)
+{
+    std::string s(chain->length, '\0');
+    EXPECT_EQ(cat_buf_chain_copy(chain, 0, &s[0], s.length()), chain->length);
+    return s;
+}
+
+TEST(cat_buf_chain, append)
+{
+    cat_buf_chain_t chain;
+    cat_buf_chain_init(&chain);
+    DEFER(cat_buf_chain_close(&chain));
+
+    std::string data = get_random_bytes(CAT_BUF_BLOCK_CAPACITY * 2 + 1);
+    size_t offset = 0;
+    for (size_t n = 1; offset < data.length(); n *= 3) {
+        n = CAT_MIN(n, data.length() - offset);
+        ASSERT_TRUE(cat_buf_chain_append(&chain, data.c_str() + offset, n));
+        offset += n;
+    }
+    /* appending never splits slices on the same block */
+    ASSERT_EQ(chain.count, 3);
+    ASSERT_EQ(chain.length, data.length());
+    ASSERT_EQ(chain_to_string(&chain), data);
+
+    char buffer[16];
+    ASSERT_EQ(cat_buf_chain_copy(&chain, CAT_BUF_BLOCK_CAPACITY - 8, buffer, sizeof(buffer)), sizeof(buffer));
+    ASSERT_EQ(std::string(buffer, sizeof(buffer)), data.substr(CAT_BUF_BLOCK_CAPACITY - 8, sizeof(buffer)));
+    ASSERT_EQ(cat_buf_chain_copy(&chain, data.length() - 1, buffer, sizeof(buffer)), 1);
+
+    cat_buf_chain_consume(&chain, CAT_BUF_BLOCK_CAPACITY + 1);
+    ASSERT_EQ(chain.count, 2);
+    ASSERT_EQ(chain_to_string(&chain), data.substr(CAT_BUF_BLOCK_CAPACITY + 1));
+    cat_buf_chain_consume(&chain, SIZE_MAX);
+    ASSERT_EQ(chain.count, 0);
+    ASSERT_EQ(chain.length, 0);
+}
+
+TEST(cat_buf_chain, append_ref)
+{
+    cat_buf_chain_t src, dst;
+    cat_buf_chain_init(&src);
+    DEFER(cat_buf_chain_close(&src));
+    cat_buf_chain_init(&dst);
+    DEFER(cat_buf_chain_close(&dst));
+
+    ASSERT_TRUE(cat_buf_chain_append(&src, CAT_STRL("Hello")));
+    ASSERT_TRUE(cat_buf_chain_append_ref(&dst, &src, 0, SIZE_MAX));
+    cat_buf_slice_t *slice = cat_queue_front_data(&src.slices, cat_buf_slice_t, node);
+    ASSERT_EQ(CAT_REF_GET(slice->block), 2);
+
+    /* both of them can keep appending to the shared block without overwriting each other */
+    ASSERT_TRUE(cat_buf_chain_append(&src, CAT_STRL(" World")));
+    ASSERT_TRUE(cat_buf_chain_append(&dst, CAT_STRL(", libcat")));
+    ASSERT_EQ(chain_to_string(&src), "Hello World");
+    ASSERT_EQ(chain_to_string(&dst), "Hello, libcat");
+    ASSERT_EQ(src.count, 1);
+    ASSERT_EQ(dst.count, 2);
+
+    /* self reference */
+    ASSERT_TRUE(cat_buf_chain_append_ref(&src, &src, 6, 5));
+    ASSERT_EQ(chain_to_string(&src), "Hello WorldWorld");
+    ASSERT_TRUE(cat_buf_chain_append_ref(&dst, &src, 100, 1) == false);
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EINVAL);
+
+    cat_buf_chain_clear(&src);
+    ASSERT_EQ(CAT_REF_GET(slice->block), 1);
+    ASSERT_EQ(chain_to_string(&dst), "Hello, libcat");
+}
+
+TEST(cat_buf_chain, prepare_commit)
+{
+    cat_buf_chain_t chain;
+    cat_buf_chain_init(&chain);
+    DEFER(cat_buf_chain_close(&chain));
+
+    size_t available;
+    char *p = cat_buf_chain_prepare(&chain, &available);
+    ASSERT_NE(p, nullptr);
+    ASSERT_EQ(available, CAT_BUF_BLOCK_CAPACITY);
+    cat_buf_chain_commit(&chain, 0);
+    ASSERT_EQ(chain.count, 0);
+
+    p = cat_buf_chain_prepare(&chain, &available);
+    memcpy(p, CAT_STRL("foo"));
+    cat_buf_chain_commit(&chain, 3);
+    p = cat_buf_chain_prepare(&chain, &available);
+    ASSERT_EQ(available, CAT_BUF_BLOCK_CAPACITY - 3);
+    memcpy(p, CAT_STRL("bar"));
+    ASSERT_TRUE(cat_buf_chain_commit(&chain, 3));
+    ASSERT_EQ(chain.count, 1);
+    ASSERT_EQ(chain_to_string(&chain), "foobar");
+
+    ASSERT_FALSE(cat_buf_chain_commit(&chain, 0));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EMISUSE);
+    p = cat_buf_chain_prepare(&chain, &available);
+    ASSERT_FALSE(cat_buf_chain_commit(&chain, available + 1));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EINVAL);
+    ASSERT_TRUE(cat_buf_chain_commit(&chain, 0));
+    ASSERT_EQ(chain_to_string(&chain), "foobar");
+}
+
+TEST(cat_buf_chain, prepare_reserves_space)
+{
+    cat_buf_chain_t chain, other;
+    cat_buf_chain_init(&chain);
+    DEFER(cat_buf_chain_close(&chain));
+    cat_buf_chain_init(&other);
+    DEFER(cat_buf_chain_close(&other));
+
+    /* other chain shares the tail block of chain */
+    ASSERT_TRUE(cat_buf_chain_append(&chain, CAT_STRL("foo")));
+    ASSERT_TRUE(cat_buf_chain_append_ref(&other, &chain, 0, SIZE_MAX));
+
+    size_t available;
+    char *p = cat_buf_chain_prepare(&chain, &available);
+    ASSERT_EQ(available, CAT_BUF_BLOCK_CAPACITY - 3);
+    /* prepare again returns the same space */
+    size_t available2;
+    ASSERT_EQ(cat_buf_chain_prepare(&chain, &available2), p);
+    ASSERT_EQ(available2, available);
+    /* e.g. chain is waiting for data, other one can not append to the reserved space */
+    ASSERT_TRUE(cat_buf_chain_append(&other, CAT_STRL("baz")));
+    ASSERT_EQ(other.count, 2);
+    memcpy(p, CAT_STRL("bar"));
+    ASSERT_TRUE(cat_buf_chain_commit(&chain, 3));
+    ASSERT_EQ(chain_to_string(&chain), "foobar");
+    ASSERT_EQ(chain_to_string(&other), "foobaz");
+
+    /* unused space has been given back */
+    ASSERT_TRUE(cat_buf_chain_append(&chain, CAT_STRL("!")));
+    ASSERT_EQ(chain.count, 1);
+    ASSERT_EQ(chain_to_string(&chain), "foobar!");
+
+    /* reserved slice survives consume(), and clear() gives back the space */
+    p = cat_buf_chain_prepare(&chain, &available);
+    cat_buf_chain_consume(&chain, SIZE_MAX);
+    ASSERT_EQ(chain.length, 0);
+    ASSERT_EQ(cat_buf_chain_prepare(&chain, &available2), p);
+    ASSERT_TRUE(cat_buf_chain_commit(&chain, 0));
+    ASSERT_EQ(chain.count, 0);
+}
+
+TEST(cat_buf_chain, write)
+{
+    TEST_REQUIRE(echo_tcp_server != nullptr, cat_socket, echo_tcp_server);
+    cat_socket_t socket;
+    ASSERT_NE(cat_socket_create(&socket, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&socket));
+    ASSERT_TRUE(cat_socket_connect_to(&socket, echo_tcp_server_ip, echo_tcp_server_ip_length, echo_tcp_server_port));
+
+    cat_buf_chain_t chain, broadcast;
+    cat_buf_chain_init(&chain);
+    DEFER(cat_buf_chain_close(&chain));
+    cat_buf_chain_init(&broadcast);
+    DEFER(cat_buf_chain_close(&broadcast));
+
+    /* many small slices to exceed the vector batch */
+    std::string expected;
+    for (int n = 0; n < 100; n++) {
+        ASSERT_TRUE(cat_buf_chain_append(&chain, CAT_STRL("0123456789")));
+        ASSERT_TRUE(cat_buf_chain_append_ref(&broadcast, &chain, n * 10, 10));
+        expected += "0123456789";
+    }
+    ASSERT_EQ(broadcast.count, 100);
+
+    cat_socket_write_vector_t vectors[8];
+    ASSERT_EQ(cat_buf_chain_get_vectors(&broadcast, vectors, CAT_ARRAY_SIZE(vectors)), CAT_ARRAY_SIZE(vectors));
+    ASSERT_EQ(vectors[1].length, 10);
+
+    ASSERT_TRUE(cat_buf_chain_write(&broadcast, &socket));
+    std::string received(expected.length(), '\0');
+    ASSERT_EQ(cat_socket_read(&socket, &received[0], received.length()), (ssize_t) received.length());
+    ASSERT_EQ(received, expected);
+}
@@ -122,6 +122,64 @@ TEST(cat_buffer, module_init)
     ASSERT_TRUE(cat_buffer_module_init());
 }
 
+#ifndef CAT_BUFFER_USE_SYS_MALLOC
+TEST(cat_buffer, pool)
+{
+    /* 8K class */
+    const size_t index = 13 - CAT_BUFFER_POOL_MIN_SHIFT;
+    const cat_buffer_pool_stats_t *stats = cat_buffer_pool_get_stats(index);
+    ASSERT_NE(stats, nullptr);
+    ASSERT_EQ(stats->size, CAT_BUFFER_COMMON_SIZE);
+    ASSERT_EQ(cat_buffer_pool_get_stats(CAT_BUFFER_POOL_CLASS_COUNT), nullptr);
+
+    cat_buffer_pool_trim();
+    ASSERT_EQ(stats->cached, 0);
+    uint64_t allocs = stats->allocs;
+    size_t in_use = stats->in_use;
+
+    char *value = cat_buffer_pool_alloc(CAT_BUFFER_COMMON_SIZE - 1);
+    ASSERT_NE(value, nullptr);
+    ASSERT_EQ(stats->allocs, allocs + 1);
+    ASSERT_EQ(stats->in_use, in_use + 1);
+    cat_buffer_pool_free(value);
+    ASSERT_EQ(stats->cached, 1);
+    ASSERT_EQ(stats->in_use, in_use);
+    /* reused */
+    char *value2 = cat_buffer_pool_alloc(CAT_BUFFER_COMMON_SIZE);
+    ASSERT_EQ(value2, value);
+    ASSERT_EQ(stats->cached, 0);
+
+    /* realloc in the same class keeps the value */
+    memset(value2, 'x', CAT_BUFFER_COMMON_SIZE);
+    value = cat_buffer_pool_realloc(value2, CAT_BUFFER_COMMON_SIZE / 2 + 1);
+    ASSERT_EQ(value, value2);
+    /* grow to a larger class and then to a large value which is not pooled */
+    value = cat_buffer_pool_realloc(value, CAT_BUFFER_COMMON_SIZE * 2);
+    ASSERT_NE(value, value2);
+    ASSERT_EQ(stats->cached, 1);
+    value = cat_buffer_pool_realloc(value, CAT_BUFFER_POOL_MAX_SIZE * 2);
+    value = cat_buffer_pool_realloc(value, CAT_BUFFER_POOL_MAX_SIZE * 4);
+    ASSERT_EQ(std::string(value, CAT_BUFFER_COMMON_SIZE), std::string(CAT_BUFFER_COMMON_SIZE, 'x'));
+    /* and shrink back */
+    value = cat_buffer_pool_realloc(value, 100);
+    ASSERT_EQ(std::string(value, 100), std::string(100, 'x'));
+    cat_buffer_pool_free(value);
+
+    /* cached values are limited */
+    std::vector<char *> values;
+    for (size_t n = 0; n < stats->max_cached + 1; n++) {
+        values.push_back(cat_buffer_pool_alloc(CAT_BUFFER_COMMON_SIZE));
+    }
+    for (char *v : values) {
+        cat_buffer_pool_free(v);
+    }
+    ASSERT_EQ(stats->cached, stats->max_cached);
+    ASSERT_GE(stats->peak, stats->max_cached + 1);
+    cat_buffer_pool_trim();
+    ASSERT_EQ(stats->cached, 0);
+}
+#endif
+
 TEST(cat_buffer, register_allocator_not_fill)
 {
     cat_buffer_allocator_t allocator = { };
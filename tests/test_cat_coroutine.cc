@@ -606,3 +606,49 @@ TEST(cat_coroutine, get_role_name)
     ASSERT_STREQ(cat_coroutine_get_current_role_name(), "main");
     CAT_COROUTINE_G(current) = current_coroutine;
 }
+
+TEST(cat_coroutine, arena)
+{
+    co([] {
+        cat_coroutine_arena_t *arena = &cat_coroutine_get_current()->arena;
+        ASSERT_EQ(arena->chunk, nullptr);
+
+        char *p1 = (char *) cat_coroutine_arena_alloc(1);
+        char *p2 = (char *) cat_coroutine_arena_alloc(3);
+        ASSERT_NE(p1, nullptr);
+        ASSERT_EQ(p2, p1 + CAT_MEMORY_DEFAULT_ALIGNED_SIZE);
+        ASSERT_EQ(((uintptr_t) p2) % CAT_MEMORY_DEFAULT_ALIGNED_SIZE, 0);
+        cat_coroutine_arena_chunk_t *chunk = arena->chunk;
+
+        /* large allocation does not waste the current chunk */
+        char *large = (char *) cat_coroutine_arena_alloc(CAT_COROUTINE_ARENA_CHUNK_SIZE);
+        ASSERT_NE(large, nullptr);
+        memset(large, 'x', CAT_COROUTINE_ARENA_CHUNK_SIZE);
+        ASSERT_EQ(arena->chunk, chunk);
+        ASSERT_EQ(cat_coroutine_arena_alloc(1), p2 + CAT_MEMORY_DEFAULT_ALIGNED_SIZE);
+
+        /* it grows */
+        for (size_t n = 0; n < 4 * CAT_COROUTINE_ARENA_CHUNK_SIZE / 64; n++) {
+            char *p = (char *) cat_coroutine_arena_alloc(64);
+            ASSERT_NE(p, nullptr);
+            memset(p, 'y', 64);
+        }
+        ASSERT_NE(arena->chunk, chunk);
+
+        ASSERT_STREQ(cat_coroutine_arena_sprintf("%s#%d", "coroutine", 1), "coroutine#1");
+        ASSERT_STREQ(cat_coroutine_arena_strndup(CAT_STRL("foobar")), "foobar");
+
+        cat_coroutine_arena_reset();
+        ASSERT_EQ(arena->chunk, nullptr);
+        ASSERT_GT(CAT_COROUTINE_G(arena_pool_count), 0);
+    });
+
+    /* chunks are reused from pool and released on exit */
+    uint32_t pool_count = CAT_COROUTINE_G(arena_pool_count);
+    ASSERT_GT(pool_count, 0);
+    co([pool_count] {
+        ASSERT_NE(cat_coroutine_arena_alloc(1), nullptr);
+        ASSERT_EQ(CAT_COROUTINE_G(arena_pool_count), pool_count - 1);
+    });
+    ASSERT_EQ(CAT_COROUTINE_G(arena_pool_count), pool_count);
+}
@@ -264,6 +264,96 @@ TEST(cat_event, real_fork)
 }
 #endif
 
+TEST(cat_event, busy_poll)
+{
+    cat_socket_t server, client;
+    cat_event_busy_poll_stats_t stats1, stats2;
+    int port;
+
+    ASSERT_EQ(cat_event_get_busy_poll(), 0);
+    ASSERT_NE(cat_socket_create(&server, CAT_SOCKET_TYPE_UDP), nullptr);
+    DEFER(cat_socket_close(&server));
+    ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+    ASSERT_GT(port = cat_socket_get_sock_port(&server), 0);
+    ASSERT_NE(cat_socket_create(&client, CAT_SOCKET_TYPE_UDP), nullptr);
+    DEFER(cat_socket_close(&client));
+    ASSERT_TRUE(cat_socket_connect_to(&client, CAT_STRL(TEST_LISTEN_IPV4), port));
+    if (!cat_socket_set_busy_poll(&server, 50)) {
+        ASSERT_TRUE(cat_get_last_error_code() == CAT_EPERM || cat_get_last_error_code() == CAT_ENOTSUP);
+    }
+
+    cat_event_get_busy_poll_stats(&stats1);
+    cat_event_set_busy_poll(100 * 1000 * 1000);
+    DEFER(cat_event_set_busy_poll(0));
+    ASSERT_EQ(cat_event_get_busy_poll(), 100 * 1000 * 1000);
+    co([&] {
+        char buffer[CAT_STRLEN("ping")];
+        cat_sockaddr_info_t address;
+        for (int n = 0; n < 10; n++) {
+            address.length = sizeof(address.address);
+            ASSERT_EQ(cat_socket_recvfrom(&server, CAT_STRS(buffer), &address.address.common, &address.length), CAT_STRLEN("ping"));
+            ASSERT_TRUE(cat_socket_sendto(&server, CAT_STRS(buffer), &address.address.common, address.length));
+        }
+    });
+    for (int n = 0; n < 10; n++) {
+        char buffer[CAT_STRLEN("ping")];
+        ASSERT_TRUE(cat_socket_send(&client, CAT_STRL("ping")));
+        ASSERT_EQ(cat_socket_recv(&client, CAT_STRS(buffer)), CAT_STRLEN("ping"));
+    }
+    cat_event_get_busy_poll_stats(&stats2);
+    ASSERT_GT(stats2.spins, stats1.spins);
+    ASSERT_GT(stats2.hits, stats1.hits);
+
+    /* run out of budget and go to sleep */
+    cat_event_set_busy_poll(1 * 1000 * 1000);
+    ASSERT_TRUE(cat_time_delay(20));
+    cat_event_get_busy_poll_stats(&stats2);
+    ASSERT_GT(stats2.sleeps, stats1.sleeps);
+
+    cat_event_set_busy_poll(0);
+    ASSERT_EQ(cat_event_get_busy_poll(), 0);
+    cat_event_get_busy_poll_stats(&stats1);
+    ASSERT_TRUE(cat_time_delay(1));
+    cat_event_get_busy_poll_stats(&stats2);
+    ASSERT_EQ(stats2.spins, stats1.spins);
+}
+
+TEST(cat_event, metrics)
+{
+    cat_event_metrics_t metrics1, metrics2;
+    uint64_t rounds = 0;
+
+    ASSERT_FALSE(cat_event_get_metrics_enabled());
+    cat_event_get_metrics(&metrics1);
+    ASSERT_EQ(metrics1.elapsed_time, 0);
+    ASSERT_EQ(metrics1.rounds, cat_event_get_round());
+
+    cat_event_set_metrics_enabled(cat_true);
+    DEFER(cat_event_set_metrics_enabled(cat_false));
+    ASSERT_TRUE(cat_event_get_metrics_enabled());
+    co([] {
+        ASSERT_TRUE(cat_time_delay(10));
+    });
+    ASSERT_TRUE(cat_time_delay(1));
+    cat_event_get_metrics(&metrics1);
+    ASSERT_GE(metrics1.active_handles_by_type[UV_TIMER], 1);
+    ASSERT_GE(metrics1.active_handles, metrics1.active_handles_by_type[UV_TIMER]);
+    ASSERT_GE(metrics1.coroutines, 2);
+    ASSERT_TRUE(cat_time_delay(20));
+    cat_event_get_metrics(&metrics2);
+    ASSERT_GT(metrics2.rounds, metrics1.rounds);
+    ASSERT_GT(metrics2.switches, metrics1.switches);
+    ASSERT_GT(metrics2.elapsed_time, metrics1.elapsed_time);
+    ASSERT_GT(metrics2.poll_time, metrics1.poll_time);
+    ASSERT_GE(metrics2.run_time, metrics1.run_time);
+    ASSERT_LE(metrics2.poll_time + metrics2.run_time, metrics2.elapsed_time);
+    for (size_t i = 0; i < CAT_EVENT_METRICS_LAG_BUCKET_COUNT; i++) {
+        rounds += metrics2.lag_histogram[i];
+    }
+    ASSERT_GT(rounds, 0);
+    ASSERT_GT(metrics2.max_lag, 0);
+}
+
 TEST(cat_event, busy)
 {
     co([] {
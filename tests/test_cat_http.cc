@@ -87,6 +87,146 @@ TEST(cat_http_parser, status_get_reason)
     ASSERT_STREQ("UNKNOWN", cat_http_status_get_reason(~0));
 }
 
+TEST(cat_http_parser, status_get_line)
+{
+    const char *line;
+    size_t length;
+
+#define CAT_HTTP_STATUS_LINE_ASSERTIONS_GEN(name, code, reason) \
+    ASSERT_NE(line = cat_http_status_get_line(CAT_HTTP_STATUS_##name, &length), nullptr); \
+    ASSERT_EQ(std::string(line, length), std::string("HTTP/1.1 ") + std::to_string(code) + " " + reason + "\r\n");
+    CAT_HTTP_STATUS_MAP(CAT_HTTP_STATUS_LINE_ASSERTIONS_GEN)
+#undef CAT_HTTP_STATUS_LINE_ASSERTIONS_GEN
+    ASSERT_EQ(cat_http_status_get_line(999, &length), nullptr);
+    ASSERT_EQ(length, 0);
+}
+
+TEST(cat_http, get_date_header)
+{
+    std::string date = cat_http_get_date_header();
+    bool matched = false;
+    time_t now = time(nullptr);
+
+    ASSERT_EQ(date.size(), CAT_HTTP_DATE_HEADER_LENGTH);
+    /* it is cached per second, so it may fall behind */
+    for (time_t t = now + 1; t >= now - 2; t--) {
+        char expected[64];
+        struct tm *tm;
+        ASSERT_NE(tm = gmtime(&t), nullptr);
+        ASSERT_GT(strftime(expected, sizeof(expected), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", tm), 0);
+        if (date == expected) {
+            matched = true;
+            break;
+        }
+    }
+    ASSERT_TRUE(matched) << date;
+    ASSERT_EQ(std::string(cat_http_get_date_header()).size(), CAT_HTTP_DATE_HEADER_LENGTH);
+}
+
+static std::string test_http_response_writer_join(const cat_http_response_writer_t *writer)
+{
+    const cat_socket_write_vector_t *vectors;
+    unsigned int count;
+    std::string s;
+
+    vectors = cat_http_response_writer_get_vectors(writer, &count);
+    for (unsigned int i = 0; i < count; i++) {
+        s.append(vectors[i].base, vectors[i].length);
+    }
+
+    return s;
+}
+
+TEST(cat_http_response_writer, build)
+{
+    cat_http_response_writer_t writer;
+    std::string response;
+
+    cat_http_response_writer_init(&writer, CAT_HTTP_STATUS_OK);
+    ASSERT_TRUE(cat_http_response_writer_add_header(&writer, CAT_STRL("Content-Type"), CAT_STRL("text/plain")));
+    ASSERT_TRUE(cat_http_response_writer_add_header_line(&writer, CAT_STRL("Server: libcat\r\n")));
+    ASSERT_TRUE(cat_http_response_writer_add_content_length(&writer, 13));
+    ASSERT_TRUE(cat_http_response_writer_add_date(&writer));
+    ASSERT_TRUE(cat_http_response_writer_end(&writer, CAT_STRL("Hello, World!")));
+    ASSERT_FALSE(cat_http_response_writer_add_header_line(&writer, CAT_STRL("X-Late: 1\r\n")));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EMISUSE);
+
+    response = test_http_response_writer_join(&writer);
+    ASSERT_EQ(response.size(), cat_http_response_writer_get_length(&writer));
+    ASSERT_EQ(response,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain\r\n"
+        "Server: libcat\r\n"
+        "Content-Length: 13\r\n" +
+        std::string(cat_http_get_date_header()) +
+        "\r\n"
+        "Hello, World!"
+    );
+
+    /* it can be parsed back */
+    cat_http_parser_t parser;
+    ASSERT_EQ(cat_http_parser_create(&parser), &parser);
+    cat_http_parser_set_type(&parser, CAT_HTTP_PARSER_TYPE_RESPONSE);
+    cat_http_parser_set_events(&parser, CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE);
+    ASSERT_TRUE(cat_http_parser_execute(&parser, response.data(), response.size()));
+    ASSERT_TRUE(cat_http_parser_is_completed(&parser));
+    ASSERT_EQ(cat_http_parser_get_status_code(&parser), CAT_HTTP_STATUS_OK);
+    ASSERT_EQ(cat_http_parser_get_content_length(&parser), 13);
+}
+
+TEST(cat_http_response_writer, special)
+{
+    cat_http_response_writer_t writer;
+
+    /* unknown status, no body */
+    cat_http_response_writer_init(&writer, 599);
+    ASSERT_TRUE(cat_http_response_writer_add_content_length(&writer, 0));
+    ASSERT_TRUE(cat_http_response_writer_end(&writer, nullptr, 0));
+    ASSERT_EQ(test_http_response_writer_join(&writer), "HTTP/1.1 599 \r\nContent-Length: 0\r\n\r\n");
+
+    /* max content length */
+    cat_http_response_writer_init(&writer, CAT_HTTP_STATUS_NO_CONTENT);
+    ASSERT_TRUE(cat_http_response_writer_add_content_length(&writer, UINT64_MAX));
+    ASSERT_EQ(test_http_response_writer_join(&writer), "HTTP/1.1 204 No Content\r\nContent-Length: 18446744073709551615\r\n");
+
+    /* vectors are exhausted */
+    cat_http_response_writer_init(&writer, CAT_HTTP_STATUS_OK);
+    while (cat_http_response_writer_add_header_line(&writer, CAT_STRL("X-Foo: bar\r\n")));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_ENOBUFS);
+    ASSERT_FALSE(cat_http_response_writer_end(&writer, nullptr, 0));
+}
+
+TEST(cat_http_response_writer, write)
+{
+    cat_socket_t server, client, connection;
+    cat_http_response_writer_t writer;
+    std::string expected;
+    char buffer[256];
+    int port;
+
+    ASSERT_EQ(cat_socket_create(&server, CAT_SOCKET_TYPE_TCP), &server);
+    DEFER(cat_socket_close(&server));
+    ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+    ASSERT_TRUE(cat_socket_listen(&server, TEST_SERVER_BACKLOG));
+    ASSERT_GT(port = cat_socket_get_sock_port(&server), 0);
+    ASSERT_EQ(cat_socket_create(&client, CAT_SOCKET_TYPE_TCP), &client);
+    DEFER(cat_socket_close(&client));
+    ASSERT_EQ(cat_socket_create(&connection, CAT_SOCKET_TYPE_TCP), &connection);
+    DEFER(cat_socket_close(&connection));
+    ASSERT_TRUE(cat_socket_connect_to(&client, CAT_STRL(TEST_LISTEN_IPV4), port));
+    ASSERT_TRUE(cat_socket_accept(&server, &connection));
+
+    cat_http_response_writer_init(&writer, CAT_HTTP_STATUS_NOT_FOUND);
+    ASSERT_TRUE(cat_http_response_writer_add_content_length(&writer, 9));
+    ASSERT_FALSE(cat_http_response_writer_write(&writer, &connection));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EMISUSE);
+    ASSERT_TRUE(cat_http_response_writer_end(&writer, CAT_STRL("Not Found")));
+    expected = test_http_response_writer_join(&writer);
+    ASSERT_TRUE(cat_http_response_writer_write(&writer, &connection));
+    ASSERT_EQ(cat_socket_read(&client, buffer, expected.size()), (ssize_t) expected.size());
+    ASSERT_EQ(std::string(buffer, expected.size()), expected);
+}
+
 TEST(cat_http_parser, create_null)
 {
     cat_http_parser_t *parser;
@@ -496,6 +636,152 @@ TEST(cat_http_parser, all)
     }
 }
 
+TEST(cat_http_header, lookup)
+{
+    for (int id = CAT_HTTP_HEADER_UNKNOWN + 1; id < CAT_HTTP_HEADER_ID_MAX; id++) {
+        const char *name = cat_http_header_get_name((cat_http_header_id_t) id);
+        std::string lower(name);
+        for (char &c : lower) {
+            c = (char) tolower(c);
+        }
+        /* perfect hash table must be up-to-date */
+        ASSERT_EQ(cat_http_header_lookup(name, strlen(name)), id);
+        ASSERT_EQ(cat_http_header_lookup(lower.c_str(), lower.size()), id);
+    }
+    ASSERT_EQ(cat_http_header_lookup(CAT_STRL("X-Foo")), CAT_HTTP_HEADER_UNKNOWN);
+    ASSERT_EQ(cat_http_header_lookup(CAT_STRL("Hosts")), CAT_HTTP_HEADER_UNKNOWN);
+    ASSERT_EQ(cat_http_header_lookup(CAT_STRL("Htst")), CAT_HTTP_HEADER_UNKNOWN);
+    ASSERT_EQ(cat_http_header_lookup("", 0), CAT_HTTP_HEADER_UNKNOWN);
+    ASSERT_STREQ(cat_http_header_get_name(CAT_HTTP_HEADER_CONTENT_LENGTH), "Content-Length");
+    ASSERT_STREQ(cat_http_header_get_name(CAT_HTTP_HEADER_ID_MAX), "UNKNOWN");
+}
+
+TEST(cat_http_parser, header_index)
+{
+    static const cat_const_string_t request = cat_const_string(
+        "POST /upload HTTP/1.1\r\n"
+        "Host: www.foo.com\r\n"
+        "X-Empty:\r\n"
+        "content-length: 7\r\n"
+        "X-Custom-Header: custom value\r\n"
+        "Host: www.bar.com\r\n"
+        "\r\n"
+        "foo=bar"
+    );
+    cat_http_parser_t parser;
+    cat_http_header_index_t index;
+    const cat_http_header_slice_t *slice;
+
+    for (size_t chunk_size : { (size_t) 1, (size_t) 5, request.length }) {
+        /* read buffer, it may be reallocated on each read,
+         * it starts with the tail of a previous message which will be compacted out */
+        std::string buffer = "PREV";
+        size_t offset = 0, parsed = buffer.size();
+
+        ASSERT_EQ(cat_http_parser_create(&parser), &parser);
+        cat_http_parser_set_events(&parser, CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE);
+        cat_http_header_index_init(&index, nullptr);
+        cat_http_parser_set_header_index(&parser, &index);
+        ASSERT_EQ(cat_http_parser_get_header_index(&parser), &index);
+        while (parser.event != CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE) {
+            size_t n = CAT_MIN(chunk_size, request.length - offset);
+            ASSERT_GT(n, 0);
+            buffer.append(request.data + offset, n);
+            offset += n;
+            cat_http_header_index_rebase(&index, buffer.data(), 0);
+            while (parsed < buffer.size()) {
+                ASSERT_TRUE(cat_http_parser_execute(&parser, buffer.data() + parsed, buffer.size() - parsed));
+                parsed += cat_http_parser_get_parsed_length(&parser);
+                if (parser.event == CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE) {
+                    break;
+                }
+            }
+        }
+        buffer.erase(0, CAT_STRLEN("PREV"));
+        cat_http_header_index_rebase(&index, buffer.data(), CAT_STRLEN("PREV"));
+        ASSERT_EQ(index.count, 5);
+        ASSERT_NE(slice = cat_http_header_index_find(&index, CAT_HTTP_HEADER_HOST), nullptr);
+        ASSERT_EQ(slice->id, CAT_HTTP_HEADER_HOST);
+        ASSERT_EQ(std::string(cat_http_header_index_get_value(&index, slice), slice->value_length), "www.foo.com");
+        ASSERT_NE(slice = cat_http_header_index_get(&index, CAT_STRL("Content-Length")), nullptr);
+        ASSERT_EQ(std::string(cat_http_header_index_get_name(&index, slice), slice->name_length), "content-length");
+        ASSERT_EQ(std::string(cat_http_header_index_get_value(&index, slice), slice->value_length), "7");
+        ASSERT_NE(slice = cat_http_header_index_get(&index, CAT_STRL("x-custom-header")), nullptr);
+        ASSERT_EQ(slice->id, CAT_HTTP_HEADER_UNKNOWN);
+        ASSERT_EQ(std::string(cat_http_header_index_get_value(&index, slice), slice->value_length), "custom value");
+        ASSERT_NE(slice = cat_http_header_index_get(&index, CAT_STRL("X-Empty")), nullptr);
+        ASSERT_EQ(slice->value_length, 0);
+        ASSERT_EQ(cat_http_header_index_find(&index, CAT_HTTP_HEADER_COOKIE), nullptr);
+        ASSERT_EQ(cat_http_header_index_get(&index, CAT_STRL("X-Missing")), nullptr);
+    }
+}
+
+TEST(cat_http_parser, header_index_too_many_headers)
+{
+    cat_http_parser_t parser;
+    cat_http_header_index_t index;
+    std::string request = "GET / HTTP/1.1\r\n";
+
+    for (int n = 0; n <= CAT_HTTP_HEADER_INDEX_MAX_HEADERS; n++) {
+        request += "X-Header-" + std::to_string(n) + ": value\r\n";
+    }
+    request += "\r\n";
+    ASSERT_EQ(cat_http_parser_create(&parser), &parser);
+    cat_http_header_index_init(&index, request.data());
+    cat_http_parser_set_header_index(&parser, &index);
+    ASSERT_FALSE(cat_http_parser_execute(&parser, request.data(), request.size()));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EHP_HEADER_INDEX);
+    ASSERT_TRUE(cat_http_parser_is_errno(CAT_EHP_HEADER_INDEX));
+    ASSERT_TRUE(cat_http_parser_is_errno(CAT_EHP_OK));
+    ASSERT_FALSE(cat_http_parser_is_errno(CAT_EHP_HEADER_INDEX - 1));
+    ASSERT_FALSE(cat_http_parser_is_errno(CAT_EMSGSIZE));
+}
+
+TEST(cat_http_parser, pipelining)
+{
+    cat_http_parser_t parser;
+    std::string stream = std::string(request_get.data, request_get.length) +
+        std::string(request_post.data, request_post.length) +
+        std::string(request_post.data, request_post.length) +
+        std::string(request_get_with_connection_close.data, request_get_with_connection_close.length);
+
+    for (size_t chunk_size : { (size_t) 1, (size_t) 7, (size_t) 64, stream.size() }) {
+        std::vector<std::string> messages;
+        std::string url, body;
+        size_t offset = 0, end = 0;
+
+        ASSERT_EQ(cat_http_parser_create(&parser), &parser);
+        cat_http_parser_set_type(&parser, CAT_HTTP_PARSER_TYPE_REQUEST);
+        cat_http_parser_set_events(&parser, CAT_HTTP_PARSER_EVENT_URL | CAT_HTTP_PARSER_EVENT_BODY | CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE);
+        while (offset < stream.size()) {
+            /* data is always resumed from the current offset */
+            end = CAT_MIN(end + chunk_size, stream.size());
+            while (offset < end) {
+                ASSERT_TRUE(cat_http_parser_execute(&parser, stream.data() + offset, end - offset));
+                offset += cat_http_parser_get_parsed_length(&parser);
+                if (parser.event == CAT_HTTP_PARSER_EVENT_URL) {
+                    url.append(parser.data, parser.data_length);
+                } else if (parser.event == CAT_HTTP_PARSER_EVENT_BODY) {
+                    body.append(parser.data, parser.data_length);
+                } else if (parser.event == CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE) {
+                    messages.push_back(std::string(cat_http_parser_get_method_name(&parser)) + " " + url + " " + body +
+                        (cat_http_parser_should_keep_alive(&parser) ? "" : " close"));
+                    url.clear();
+                    body.clear();
+                } else {
+                    /* not subscribed, it needs more data */
+                    ASSERT_EQ(offset, end);
+                }
+            }
+        }
+        ASSERT_EQ(messages.size(), 4);
+        ASSERT_EQ(messages[0], "GET /get ");
+        ASSERT_EQ(messages[1], "POST /api/build/v1/foo foo=bar");
+        ASSERT_EQ(messages[2], "POST /api/build/v1/foo foo=bar");
+        ASSERT_EQ(messages[3], "GET /get  close");
+    }
+}
+
 TEST(cat_http_parser, byte_by_byte)
 {
     cat_http_parser_t parser;
@@ -1509,3 +1795,189 @@ TEST(cat_http_parser, multipart_bad_heads)
         }
     }
 }
+
+static cat_bool_t test_http_pipeline_handler(cat_http_pipeline_t *pipeline, void *data)
+{
+    std::string response = std::string(pipeline->url, pipeline->url_length) + "|" +
+        std::string(pipeline->body == NULL ? "" : pipeline->body, pipeline->body_length) + "\n";
+    const cat_http_header_slice_t *host = cat_http_header_index_find(&pipeline->headers, CAT_HTTP_HEADER_HOST);
+    (void) data;
+    EXPECT_NE(host, nullptr);
+    if (host != NULL) {
+        EXPECT_EQ(std::string(cat_http_header_index_get_value(&pipeline->headers, host), host->value_length), "www.foo.com");
+    }
+    return cat_http_pipeline_respond(pipeline, response.data(), response.size()) &&
+        cat_http_pipeline_respond_static(pipeline, CAT_STRL("OK\n"));
+}
+
+TEST(cat_http_pipeline, run)
+{
+    cat_socket_t server, client, connection;
+    cat_http_pipeline_t pipeline;
+    std::string stream = std::string(request_get.data, request_get.length) +
+        std::string(request_post.data, request_post.length) +
+        std::string(request_post.data, request_post.length) +
+        std::string(request_get_with_connection_close.data, request_get_with_connection_close.length);
+    std::string expected = "/get|\nOK\n/api/build/v1/foo|foo=bar\nOK\n/api/build/v1/foo|foo=bar\nOK\n/get|\nOK\n";
+    char buffer[256];
+    int port;
+
+    ASSERT_EQ(cat_socket_create(&server, CAT_SOCKET_TYPE_TCP), &server);
+    DEFER(cat_socket_close(&server));
+    ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+    ASSERT_TRUE(cat_socket_listen(&server, TEST_SERVER_BACKLOG));
+    ASSERT_GT(port = cat_socket_get_sock_port(&server), 0);
+    ASSERT_EQ(cat_socket_create(&client, CAT_SOCKET_TYPE_TCP), &client);
+    DEFER(cat_socket_close(&client));
+    ASSERT_EQ(cat_socket_create(&connection, CAT_SOCKET_TYPE_TCP), &connection);
+    DEFER(cat_socket_close(&connection));
+    ASSERT_TRUE(cat_socket_connect_to(&client, CAT_STRL(TEST_LISTEN_IPV4), port));
+    ASSERT_TRUE(cat_socket_accept(&server, &connection));
+    ASSERT_EQ(cat_http_pipeline_create(&pipeline), &pipeline);
+    DEFER(cat_http_pipeline_close(&pipeline));
+
+    /* all requests arrive at once, they are responded by one write */
+    ASSERT_TRUE(cat_socket_send(&client, stream.data(), stream.size()));
+    ASSERT_TRUE(cat_http_pipeline_run(&pipeline, &connection, test_http_pipeline_handler, nullptr));
+    ASSERT_EQ(pipeline.requests, 4);
+    ASSERT_LE(pipeline.writes, 2);
+    ASSERT_EQ(cat_socket_read(&client, buffer, expected.size()), (ssize_t) expected.size());
+    ASSERT_EQ(std::string(buffer, expected.size()), expected);
+
+    /* byte by byte, unfinished request is kept across reads */
+    wait_group wg;
+    co([&] {
+        wg++;
+        DEFER(wg--);
+        for (size_t i = 0; i < stream.size(); i++) {
+            ASSERT_TRUE(cat_socket_send(&client, &stream[i], 1));
+            cat_time_sleep(0);
+        }
+    });
+    ASSERT_TRUE(cat_http_pipeline_run(&pipeline, &connection, test_http_pipeline_handler, nullptr));
+    ASSERT_EQ(pipeline.requests, 8);
+    ASSERT_EQ(cat_socket_read(&client, buffer, expected.size()), (ssize_t) expected.size());
+    ASSERT_EQ(std::string(buffer, expected.size()), expected);
+}
+
+TEST(cat_http_pipeline, request_too_large)
+{
+    cat_socket_t server, client, connection;
+    cat_http_pipeline_t pipeline;
+    std::string request = "GET /" + std::string(CAT_BUFFER_COMMON_SIZE * 2, 'x') + " HTTP/1.1\r\n\r\n";
+    int port;
+
+    ASSERT_EQ(cat_socket_create(&server, CAT_SOCKET_TYPE_TCP), &server);
+    DEFER(cat_socket_close(&server));
+    ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+    ASSERT_TRUE(cat_socket_listen(&server, TEST_SERVER_BACKLOG));
+    ASSERT_GT(port = cat_socket_get_sock_port(&server), 0);
+    ASSERT_EQ(cat_socket_create(&client, CAT_SOCKET_TYPE_TCP), &client);
+    DEFER(cat_socket_close(&client));
+    ASSERT_EQ(cat_socket_create(&connection, CAT_SOCKET_TYPE_TCP), &connection);
+    DEFER(cat_socket_close(&connection));
+    ASSERT_TRUE(cat_socket_connect_to(&client, CAT_STRL(TEST_LISTEN_IPV4), port));
+    ASSERT_TRUE(cat_socket_accept(&server, &connection));
+    ASSERT_EQ(cat_http_pipeline_create(&pipeline), &pipeline);
+    DEFER(cat_http_pipeline_close(&pipeline));
+    pipeline.max_request_length = CAT_BUFFER_COMMON_SIZE;
+
+    ASSERT_TRUE(cat_socket_send(&client, request.data(), request.size()));
+    ASSERT_FALSE(cat_http_pipeline_run(&pipeline, &connection, test_http_pipeline_handler, nullptr));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EMSGSIZE);
+    ASSERT_EQ(pipeline.requests, 0);
+}
+
+TEST(cat_http_chunked_writer, chunk_header_render)
+{
+    char buffer[CAT_HTTP_CHUNK_HEADER_MAX_LENGTH];
+
+    ASSERT_EQ(std::string(buffer, cat_http_chunk_header_render(buffer, 0)), "0\r\n");
+    ASSERT_EQ(std::string(buffer, cat_http_chunk_header_render(buffer, 10)), "a\r\n");
+    ASSERT_EQ(std::string(buffer, cat_http_chunk_header_render(buffer, 0x1f40)), "1f40\r\n");
+    ASSERT_EQ(std::string(buffer, cat_http_chunk_header_render(buffer, UINT64_MAX)), "ffffffffffffffff\r\n");
+}
+
+TEST(cat_http_chunked_writer, stream)
+{
+    cat_socket_t server, client, connection;
+    cat_http_response_writer_t response_writer;
+    cat_http_chunked_writer_t writer;
+    cat_http_parser_t parser;
+    std::string large(CAT_HTTP_CHUNKED_WRITER_DEFAULT_COALESCE_SIZE * 2, 'x');
+    std::string expected_body, received, body;
+    size_t chunks = 0, offset = 0;
+    char buffer[8192];
+    int port;
+
+    ASSERT_EQ(cat_socket_create(&server, CAT_SOCKET_TYPE_TCP), &server);
+    DEFER(cat_socket_close(&server));
+    ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+    ASSERT_TRUE(cat_socket_listen(&server, TEST_SERVER_BACKLOG));
+    ASSERT_GT(port = cat_socket_get_sock_port(&server), 0);
+    ASSERT_EQ(cat_socket_create(&client, CAT_SOCKET_TYPE_TCP), &client);
+    DEFER(cat_socket_close(&client));
+    ASSERT_EQ(cat_socket_create(&connection, CAT_SOCKET_TYPE_TCP), &connection);
+    ASSERT_TRUE(cat_socket_connect_to(&client, CAT_STRL(TEST_LISTEN_IPV4), port));
+    ASSERT_TRUE(cat_socket_accept(&server, &connection));
+
+    cat_http_response_writer_init(&response_writer, CAT_HTTP_STATUS_OK);
+    ASSERT_TRUE(cat_http_response_writer_add_chunked(&response_writer));
+    ASSERT_TRUE(cat_http_response_writer_end(&response_writer, nullptr, 0));
+    ASSERT_TRUE(cat_http_response_writer_write(&response_writer, &connection));
+
+    ASSERT_EQ(cat_http_chunked_writer_create(&writer, &connection), &writer);
+    DEFER(cat_http_chunked_writer_close(&writer));
+    /* small writes are coalesced into one chunk */
+    for (int i = 0; i < 10; i++) {
+        std::string piece = "piece" + std::to_string(i) + ";";
+        ASSERT_TRUE(cat_http_chunked_writer_write(&writer, piece.data(), piece.size()));
+        expected_body += piece;
+    }
+    ASSERT_TRUE(cat_http_chunked_writer_write(&writer, nullptr, 0));
+    ASSERT_EQ(writer.chunks, 0);
+    ASSERT_TRUE(cat_http_chunked_writer_flush(&writer));
+    ASSERT_EQ(writer.chunks, 1);
+    ASSERT_TRUE(cat_http_chunked_writer_flush(&writer));
+    ASSERT_EQ(writer.chunks, 1);
+    /* large write is sent with pending data as one chunk */
+    ASSERT_TRUE(cat_http_chunked_writer_write(&writer, CAT_STRL("head;")));
+    ASSERT_TRUE(cat_http_chunked_writer_write(&writer, large.data(), large.size()));
+    expected_body += "head;" + large;
+    ASSERT_EQ(writer.chunks, 2);
+    ASSERT_TRUE(cat_http_chunked_writer_write(&writer, CAT_STRL("tail")));
+    expected_body += "tail";
+    ASSERT_TRUE(cat_http_chunked_writer_end(&writer, CAT_STRL("X-Checksum: 42\r\n")));
+    ASSERT_EQ(writer.chunks, 3);
+    ASSERT_EQ(writer.bytes, expected_body.size());
+    ASSERT_FALSE(cat_http_chunked_writer_write(&writer, CAT_STRL("late")));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EMISUSE);
+    cat_socket_close(&connection);
+
+    while (true) {
+        ssize_t n = cat_socket_recv(&client, buffer, sizeof(buffer));
+        ASSERT_GE(n, 0);
+        if (n == 0) {
+            break;
+        }
+        received.append(buffer, n);
+    }
+    ASSERT_EQ(received.substr(received.size() - CAT_STRLEN("0\r\nX-Checksum: 42\r\n\r\n")), "0\r\nX-Checksum: 42\r\n\r\n");
+    ASSERT_EQ(cat_http_parser_create(&parser), &parser);
+    cat_http_parser_set_type(&parser, CAT_HTTP_PARSER_TYPE_RESPONSE);
+    cat_http_parser_set_events(&parser, CAT_HTTP_PARSER_EVENT_BODY | CAT_HTTP_PARSER_EVENT_CHUNK_HEADER | CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE);
+    while (!cat_http_parser_is_completed(&parser)) {
+        ASSERT_LT(offset, received.size());
+        ASSERT_TRUE(cat_http_parser_execute(&parser, received.data() + offset, received.size() - offset));
+        offset += cat_http_parser_get_parsed_length(&parser);
+        if (parser.event == CAT_HTTP_PARSER_EVENT_BODY) {
+            body.append(parser.data, parser.data_length);
+        } else if (parser.event == CAT_HTTP_PARSER_EVENT_CHUNK_HEADER) {
+            chunks++;
+        }
+    }
+    ASSERT_TRUE(cat_http_parser_is_chunked(&parser));
+    ASSERT_EQ(body, expected_body);
+    /* including the last chunk */
+    ASSERT_EQ(chunks, 4);
+}
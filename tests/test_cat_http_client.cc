@@ -0,0 +1,431 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "test.h"
+
+#include "cat_http_client.h"
+#include "cat_http_server.h"
+
+static cat_bool_t test_http_client_server_handler(cat_http_server_connection_t *connection, void *data)
+{
+    cat_http_pipeline_t *pipeline = &connection->pipeline;
+    std::string url(pipeline->url, pipeline->url_length);
+
+    if (url == "/echo") {
+        return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, CAT_STRL("text/plain"), pipeline->body, pipeline->body_length);
+    }
+    if (url == "/chunked") {
+        return cat_http_pipeline_respond_static(pipeline, CAT_STRL(
+            "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+            "5\r\nHello\r\n7\r\n World!\r\n0\r\nX-Trailer: foo\r\n\r\n"));
+    }
+    if (url == "/close") {
+        /* body is delimited by EOF */
+        (void) cat_http_pipeline_respond_static(pipeline, CAT_STRL("HTTP/1.1 200 OK\r\nConnection: close\r\n\r\nbye"));
+        return cat_false;
+    }
+    if (url == "/head") {
+        return cat_http_pipeline_respond_static(pipeline, CAT_STRL("HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\n"));
+    }
+    if (url == "/continue") {
+        return cat_http_pipeline_respond_static(pipeline, CAT_STRL(
+            "HTTP/1.1 100 Continue\r\n\r\n"
+            "HTTP/1.1 201 Created\r\nContent-Length: 2\r\n\r\nok"));
+    }
+    if (url == "/headers") {
+        /* render the generated headers as "host|connection" */
+        auto header = [pipeline](const char *name) {
+            const cat_http_header_slice_t *slice = cat_http_header_index_get(&pipeline->headers, name, strlen(name));
+            if (slice == nullptr) {
+                return std::string();
+            }
+            return std::string(cat_http_header_index_get_value(&pipeline->headers, slice), slice->value_length);
+        };
+        std::string body = header("host") + "|" + header("connection");
+        return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, CAT_STRL("text/plain"), body.data(), body.size());
+    }
+    if (url == "/sleep") {
+        cat_time_msleep(20);
+    }
+    if (url == "/drop") {
+        /* request has been processed, but the connection is closed before responding */
+        return cat_false;
+    }
+
+    return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, CAT_STRL("text/plain"), CAT_STRL("Hello World!"));
+}
+
+class test_http_client_server
+{
+public:
+    cat_http_server_t server;
+    int port = 0;
+    wait_group wg;
+
+    test_http_client_server(const cat_http_server_options_t *options = nullptr, const char *ip = TEST_LISTEN_IPV4)
+    {
+        EXPECT_EQ(cat_http_server_create(&server, options, test_http_client_server_handler, nullptr), &server);
+        EXPECT_TRUE(cat_http_server_listen(&server, ip, strlen(ip), 0));
+        EXPECT_GT(port = cat_http_server_get_port(&server), 0);
+        co([this] {
+            wg++;
+            DEFER(wg--);
+            EXPECT_TRUE(cat_http_server_run(&server));
+        });
+    }
+
+    ~test_http_client_server()
+    {
+        EXPECT_TRUE(cat_http_server_shutdown(&server, TEST_IO_TIMEOUT));
+        wg();
+        cat_http_server_close(&server);
+    }
+};
+
+static std::string test_http_client_response_body(const cat_http_client_response_t *response)
+{
+    return std::string(response->body.value, response->body.length);
+}
+
+TEST(cat_http_client, keep_alive)
+{
+    test_http_client_server server;
+    cat_http_client_t client;
+    cat_http_client_request_t request;
+    cat_http_client_response_t response;
+    const char *value;
+    size_t value_length;
+
+    ASSERT_EQ(cat_http_client_create(&client, nullptr), &client);
+    DEFER(cat_http_client_close(&client));
+    cat_http_client_response_init(&response);
+    DEFER(cat_http_client_response_close(&response));
+
+    cat_http_client_request_init(&request);
+    for (int n = 0; n < 3; n++) {
+        ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+        ASSERT_EQ(response.status, CAT_HTTP_STATUS_OK);
+        ASSERT_TRUE(response.keep_alive);
+        ASSERT_EQ(test_http_client_response_body(&response), "Hello World!");
+        ASSERT_NE(value = cat_http_client_response_get_header(&response, CAT_STRL("content-type"), &value_length), nullptr);
+        ASSERT_EQ(std::string(value, value_length), "text/plain");
+    }
+
+    request.method = "POST";
+    request.method_length = CAT_STRLEN("POST");
+    request.path = "/echo";
+    request.path_length = CAT_STRLEN("/echo");
+    request.headers = "Content-Type: text/plain\r\n";
+    request.headers_length = CAT_STRLEN("Content-Type: text/plain\r\n");
+    request.body = "foo";
+    request.body_length = CAT_STRLEN("foo");
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(test_http_client_response_body(&response), "foo");
+
+    ASSERT_EQ(client.connects, 1);
+    ASSERT_EQ(client.reuses, 3);
+    ASSERT_EQ(client.requests, 4);
+}
+
+TEST(cat_http_client, framing)
+{
+    test_http_client_server server;
+    cat_http_client_t client;
+    cat_http_client_request_t request;
+    cat_http_client_response_t response;
+
+    ASSERT_EQ(cat_http_client_create(&client, nullptr), &client);
+    DEFER(cat_http_client_close(&client));
+    cat_http_client_response_init(&response);
+    DEFER(cat_http_client_response_close(&response));
+    cat_http_client_request_init(&request);
+
+    request.path = "/chunked";
+    request.path_length = CAT_STRLEN("/chunked");
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(test_http_client_response_body(&response), "Hello World!");
+    ASSERT_TRUE(response.keep_alive);
+
+    request.method = "HEAD";
+    request.method_length = CAT_STRLEN("HEAD");
+    request.path = "/head";
+    request.path_length = CAT_STRLEN("/head");
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(response.status, CAT_HTTP_STATUS_OK);
+    ASSERT_EQ(response.body.length, 0);
+
+    cat_http_client_request_init(&request);
+    request.path = "/continue";
+    request.path_length = CAT_STRLEN("/continue");
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(response.status, CAT_HTTP_STATUS_CREATED);
+    ASSERT_EQ(test_http_client_response_body(&response), "ok");
+
+    request.path = "/close";
+    request.path_length = CAT_STRLEN("/close");
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(test_http_client_response_body(&response), "bye");
+    ASSERT_FALSE(response.keep_alive);
+    ASSERT_EQ(client.connects, 1);
+
+    /* connection was not pooled */
+    request.path = "/";
+    request.path_length = CAT_STRLEN("/");
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(client.connects, 2);
+}
+
+TEST(cat_http_client, pipeline)
+{
+    test_http_client_server server;
+    cat_http_client_t client;
+    cat_http_client_request_t requests[8];
+    cat_http_client_response_t responses[8];
+    std::string bodies[8];
+
+    ASSERT_EQ(cat_http_client_create(&client, nullptr), &client);
+    DEFER(cat_http_client_close(&client));
+    for (int n = 0; n < 8; n++) {
+        bodies[n] = std::to_string(n);
+        cat_http_client_request_init(&requests[n]);
+        requests[n].method = "POST";
+        requests[n].method_length = CAT_STRLEN("POST");
+        requests[n].path = "/echo";
+        requests[n].path_length = CAT_STRLEN("/echo");
+        requests[n].body = bodies[n].data();
+        requests[n].body_length = bodies[n].size();
+        cat_http_client_response_init(&responses[n]);
+    }
+    DEFER({
+        for (int n = 0; n < 8; n++) {
+            cat_http_client_response_close(&responses[n]);
+        }
+    });
+
+    ASSERT_TRUE(cat_http_client_pipeline(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, requests, responses, 8));
+    for (int n = 0; n < 8; n++) {
+        ASSERT_EQ(test_http_client_response_body(&responses[n]), bodies[n]);
+    }
+    ASSERT_EQ(client.connects, 1);
+    ASSERT_EQ(client.requests, 8);
+}
+
+TEST(cat_http_client, queue)
+{
+    test_http_client_server server;
+    cat_http_client_options_t options;
+    cat_http_client_t client;
+    wait_group wg;
+
+    cat_http_client_options_init(&options);
+    options.max_connections_per_host = 2;
+    ASSERT_EQ(cat_http_client_create(&client, &options), &client);
+    DEFER(cat_http_client_close(&client));
+
+    for (int n = 0; n < 8; n++) {
+        co([&] {
+            wg++;
+            DEFER(wg--);
+            cat_http_client_request_t request;
+            cat_http_client_response_t response;
+            cat_http_client_request_init(&request);
+            request.path = "/sleep";
+            request.path_length = CAT_STRLEN("/sleep");
+            cat_http_client_response_init(&response);
+            DEFER(cat_http_client_response_close(&response));
+            ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+            ASSERT_EQ(response.status, CAT_HTTP_STATUS_OK);
+        });
+    }
+    wg();
+    ASSERT_EQ(client.connects, 2);
+    ASSERT_EQ(client.requests, 8);
+}
+
+TEST(cat_http_client, stale_connection)
+{
+    cat_http_server_options_t server_options;
+    cat_http_server_options_init(&server_options);
+    server_options.idle_timeout = 5;
+    test_http_client_server server(&server_options);
+    cat_http_client_t client;
+    cat_http_client_request_t request;
+    cat_http_client_response_t response;
+
+    ASSERT_EQ(cat_http_client_create(&client, nullptr), &client);
+    DEFER(cat_http_client_close(&client));
+    cat_http_client_response_init(&response);
+    DEFER(cat_http_client_response_close(&response));
+    cat_http_client_request_init(&request);
+
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    /* pooled connection is closed by server */
+    cat_time_msleep(20);
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(client.connects, 2);
+}
+
+TEST(cat_http_client, stale_connection_non_idempotent)
+{
+    test_http_client_server server;
+    cat_http_client_t client;
+    cat_http_client_request_t request;
+    cat_http_client_response_t response;
+
+    ASSERT_EQ(cat_http_client_create(&client, nullptr), &client);
+    DEFER(cat_http_client_close(&client));
+    cat_http_client_response_init(&response);
+    DEFER(cat_http_client_response_close(&response));
+    cat_http_client_request_init(&request);
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+
+    /* POST may have been processed, it must not be replayed */
+    request.method = "POST";
+    request.method_length = CAT_STRLEN("POST");
+    request.path = "/drop";
+    request.path_length = CAT_STRLEN("/drop");
+    request.body = "Hello libcat";
+    request.body_length = CAT_STRLEN("Hello libcat");
+    ASSERT_FALSE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(client.connects, 1);
+    ASSERT_EQ(server.server.requests, 2);
+
+    /* idempotent one is replayed on a new connection */
+    request.method = "GET";
+    request.method_length = CAT_STRLEN("GET");
+    request.path = "/";
+    request.path_length = CAT_STRLEN("/");
+    request.body = nullptr;
+    request.body_length = 0;
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    request.path = "/drop";
+    request.path_length = CAT_STRLEN("/drop");
+    ASSERT_FALSE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(client.connects, 3);
+    ASSERT_EQ(server.server.requests, 5);
+}
+
+TEST(cat_http_client, read_timeout)
+{
+    test_http_client_server server;
+    cat_http_client_options_t options;
+    cat_http_client_t client;
+    cat_http_client_request_t request;
+    cat_http_client_response_t response;
+
+    cat_http_client_options_init(&options);
+    options.read_timeout = 5;
+    ASSERT_EQ(cat_http_client_create(&client, &options), &client);
+    DEFER(cat_http_client_close(&client));
+    cat_http_client_response_init(&response);
+    DEFER(cat_http_client_response_close(&response));
+    cat_http_client_request_init(&request);
+    request.path = "/sleep";
+    request.path_length = CAT_STRLEN("/sleep");
+
+    ASSERT_FALSE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_ETIMEDOUT);
+}
+
+TEST(cat_http_client, generated_headers)
+{
+    test_http_client_server server;
+    cat_http_client_options_t options;
+    cat_http_client_t client;
+    cat_http_client_request_t request;
+    cat_http_client_response_t response;
+
+    cat_http_client_response_init(&response);
+    DEFER(cat_http_client_response_close(&response));
+    cat_http_client_request_init(&request);
+    request.path = "/headers";
+    request.path_length = CAT_STRLEN("/headers");
+
+    ASSERT_EQ(cat_http_client_create(&client, nullptr), &client);
+    DEFER(cat_http_client_close(&client));
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(test_http_client_response_body(&response), std::string(TEST_LISTEN_IPV4 ":") + std::to_string(server.port) + "|keep-alive");
+    ASSERT_TRUE(response.keep_alive);
+
+    /* connection will not be pooled */
+    cat_http_client_t oneshot_client;
+    cat_http_client_options_init(&options);
+    options.max_idle_connections_per_host = 0;
+    ASSERT_EQ(cat_http_client_create(&oneshot_client, &options), &oneshot_client);
+    DEFER(cat_http_client_close(&oneshot_client));
+    ASSERT_TRUE(cat_http_client_execute(&oneshot_client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+    ASSERT_EQ(test_http_client_response_body(&response), std::string(TEST_LISTEN_IPV4 ":") + std::to_string(server.port) + "|close");
+    ASSERT_FALSE(response.keep_alive);
+}
+
+TEST(cat_http_client, ipv6_host)
+{
+    test_http_client_server server(nullptr, TEST_LISTEN_IPV6);
+    cat_http_client_t client;
+    cat_http_client_request_t request;
+    cat_http_client_response_t response;
+
+    ASSERT_EQ(cat_http_client_create(&client, nullptr), &client);
+    DEFER(cat_http_client_close(&client));
+    cat_http_client_response_init(&response);
+    DEFER(cat_http_client_response_close(&response));
+    cat_http_client_request_init(&request);
+    request.path = "/headers";
+    request.path_length = CAT_STRLEN("/headers");
+
+    ASSERT_TRUE(cat_http_client_execute(&client, CAT_STRL(TEST_LISTEN_IPV6), server.port, cat_false, &request, &response));
+    ASSERT_EQ(test_http_client_response_body(&response), std::string("[" TEST_LISTEN_IPV6 "]:") + std::to_string(server.port) + "|keep-alive");
+}
+
+TEST(cat_http_client, close_when_busy)
+{
+    test_http_client_server server;
+    cat_http_client_options_t options;
+    cat_http_client_t *client;
+    wait_group wg;
+
+    cat_http_client_options_init(&options);
+    options.max_connections_per_host = 1;
+    ASSERT_NE(client = cat_http_client_create(nullptr, &options), nullptr);
+
+    /* the busy one completes, the waiting one is canceled */
+    for (int n = 0; n < 2; n++) {
+        co([&, n] {
+            wg++;
+            DEFER(wg--);
+            cat_http_client_request_t request;
+            cat_http_client_response_t response;
+            cat_http_client_request_init(&request);
+            request.path = "/sleep";
+            request.path_length = CAT_STRLEN("/sleep");
+            cat_http_client_response_init(&response);
+            DEFER(cat_http_client_response_close(&response));
+            if (n == 0) {
+                ASSERT_TRUE(cat_http_client_execute(client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+                ASSERT_EQ(test_http_client_response_body(&response), "Hello World!");
+            } else {
+                ASSERT_FALSE(cat_http_client_execute(client, CAT_STRL(TEST_LISTEN_IPV4), server.port, cat_false, &request, &response));
+                ASSERT_EQ(cat_get_last_error_code(), CAT_ECANCELED);
+            }
+        });
+    }
+    cat_http_client_close(client);
+    /* busy connection does not access client any more */
+    cat_free(client);
+    ASSERT_TRUE(wg());
+}
@@ -0,0 +1,366 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "test.h"
+
+#include "cat_http_server.h"
+
+#include <vector>
+
+struct test_http_server_response {
+    cat_http_status_code_t status;
+    std::string body;
+};
+
+/* read count responses (less if connection is closed) */
+static std::vector<test_http_server_response> test_http_server_read_responses(cat_socket_t *client, size_t count)
+{
+    std::vector<test_http_server_response> responses;
+    cat_http_parser_t parser;
+    std::string body;
+    char buffer[8192];
+
+    cat_http_parser_create(&parser);
+    cat_http_parser_set_type(&parser, CAT_HTTP_PARSER_TYPE_RESPONSE);
+    cat_http_parser_set_events(&parser, CAT_HTTP_PARSER_EVENT_BODY | CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE);
+    while (responses.size() < count) {
+        ssize_t n = cat_socket_recv(client, buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+        const char *p = buffer, *pe = buffer + n;
+        /* message may complete after body without any more data */
+        while ((p < pe || parser.event == CAT_HTTP_PARSER_EVENT_BODY) && responses.size() < count) {
+            if (!cat_http_parser_execute(&parser, p, pe - p)) {
+                return responses;
+            }
+            p += parser.parsed_length;
+            if (parser.event == CAT_HTTP_PARSER_EVENT_BODY) {
+                body.append(parser.data, parser.data_length);
+            } else if (parser.event == CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE) {
+                responses.push_back({ cat_http_parser_get_status_code(&parser), body });
+                body.clear();
+            }
+        }
+    }
+
+    return responses;
+}
+
+static cat_bool_t test_http_server_handler(cat_http_server_connection_t *connection, void *data)
+{
+    cat_http_pipeline_t *pipeline = &connection->pipeline;
+    std::string url(pipeline->url, pipeline->url_length);
+
+    if (url == "/hello") {
+        return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, CAT_STRL("text/plain"), CAT_STRL("Hello World!"));
+    }
+    if (url == "/echo") {
+        return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, CAT_STRL("text/plain"), pipeline->body, pipeline->body_length);
+    }
+    if (url == "/sleep") {
+        cat_time_msleep(10);
+        return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, nullptr, 0, CAT_STRL("slept"));
+    }
+    if (url == "/shutdown") {
+        /* it must not wait for the current connection */
+        if (!cat_http_server_shutdown(connection->server, TEST_IO_TIMEOUT)) {
+            return cat_http_server_respond(connection, CAT_HTTP_STATUS_INTERNAL_SERVER_ERROR, nullptr, 0, nullptr, 0);
+        }
+        return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, nullptr, 0, CAT_STRL("bye"));
+    }
+
+    return cat_http_server_respond(connection, CAT_HTTP_STATUS_NOT_FOUND, nullptr, 0, nullptr, 0);
+}
+
+class test_http_server
+{
+public:
+    cat_http_server_t server;
+    int port = 0;
+    wait_group wg;
+
+    test_http_server(const cat_http_server_options_t *options = nullptr)
+    {
+        EXPECT_EQ(cat_http_server_create(&server, options, test_http_server_handler, nullptr), &server);
+        EXPECT_TRUE(cat_http_server_listen(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+        EXPECT_GT(port = cat_http_server_get_port(&server), 0);
+        co([this] {
+            wg++;
+            DEFER(wg--);
+            EXPECT_TRUE(cat_http_server_run(&server));
+        });
+    }
+
+    ~test_http_server()
+    {
+        if (!cat_http_server_is_shutting_down(&server)) {
+            EXPECT_TRUE(cat_http_server_shutdown(&server, TEST_IO_TIMEOUT));
+        }
+        wg();
+        cat_http_server_close(&server);
+    }
+
+    void connect(cat_socket_t *client)
+    {
+        ASSERT_EQ(cat_socket_create(client, CAT_SOCKET_TYPE_TCP), client);
+        ASSERT_TRUE(cat_socket_connect_to(client, CAT_STRL(TEST_LISTEN_IPV4), port));
+    }
+};
+
+TEST(cat_http_server, keep_alive)
+{
+    test_http_server server;
+    cat_socket_t client;
+    std::string request;
+
+    server.connect(&client);
+    DEFER(cat_socket_close(&client));
+
+    request = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_TRUE(cat_socket_send(&client, request.data(), request.size()));
+    auto responses = test_http_server_read_responses(&client, 1);
+    ASSERT_EQ(responses.size(), 1);
+    ASSERT_EQ(responses[0].status, CAT_HTTP_STATUS_OK);
+    ASSERT_EQ(responses[0].body, "Hello World!");
+
+    request = "POST /echo HTTP/1.1\r\nHost: localhost\r\nContent-Length: 3\r\n\r\nfoo";
+    ASSERT_TRUE(cat_socket_send(&client, request.data(), request.size()));
+    responses = test_http_server_read_responses(&client, 1);
+    ASSERT_EQ(responses.size(), 1);
+    ASSERT_EQ(responses[0].body, "foo");
+
+    request = "GET /nothing HTTP/1.1\r\nConnection: close\r\n\r\n";
+    ASSERT_TRUE(cat_socket_send(&client, request.data(), request.size()));
+    responses = test_http_server_read_responses(&client, 2);
+    ASSERT_EQ(responses.size(), 1);
+    ASSERT_EQ(responses[0].status, CAT_HTTP_STATUS_NOT_FOUND);
+
+    ASSERT_EQ(server.server.accepted, 1);
+    ASSERT_EQ(server.server.requests, 3);
+}
+
+TEST(cat_http_server, pipelining)
+{
+    test_http_server server;
+    cat_socket_t client;
+    std::string request;
+
+    server.connect(&client);
+    DEFER(cat_socket_close(&client));
+
+    for (int n = 0; n < 16; n++) {
+        request += "POST /echo HTTP/1.1\r\nContent-Length: " + std::to_string(std::to_string(n).size()) + "\r\n\r\n" + std::to_string(n);
+    }
+    ASSERT_TRUE(cat_socket_send(&client, request.data(), request.size()));
+    auto responses = test_http_server_read_responses(&client, 16);
+    ASSERT_EQ(responses.size(), 16);
+    for (int n = 0; n < 16; n++) {
+        ASSERT_EQ(responses[n].body, std::to_string(n));
+    }
+}
+
+TEST(cat_http_server, limits)
+{
+    cat_http_server_options_t options;
+    cat_http_server_options_init(&options);
+    options.max_request_length = CAT_BUFFER_COMMON_SIZE;
+    options.max_body_length = 4;
+    test_http_server server(&options);
+    cat_socket_t client;
+    std::string request;
+
+    /* body is too large */
+    server.connect(&client);
+    request = "POST /echo HTTP/1.1\r\nContent-Length: 5\r\n\r\n12345";
+    ASSERT_TRUE(cat_socket_send(&client, request.data(), request.size()));
+    auto responses = test_http_server_read_responses(&client, 1);
+    ASSERT_EQ(responses.size(), 1);
+    ASSERT_EQ(responses[0].status, CAT_HTTP_STATUS_REQUEST_ENTITY_TOO_LARGE);
+    cat_socket_close(&client);
+
+    /* headers are too large */
+    server.connect(&client);
+    request = "GET /" + std::string(CAT_BUFFER_COMMON_SIZE * 2, 'x') + " HTTP/1.1\r\n\r\n";
+    ASSERT_TRUE(cat_socket_send(&client, request.data(), request.size()));
+    responses = test_http_server_read_responses(&client, 1);
+    ASSERT_EQ(responses.size(), 1);
+    ASSERT_EQ(responses[0].status, CAT_HTTP_STATUS_REQUEST_ENTITY_TOO_LARGE);
+    cat_socket_close(&client);
+
+    /* malformed */
+    server.connect(&client);
+    request = "GET / HTTP/1.1\r\nContent-Length: x\r\n\r\n";
+    ASSERT_TRUE(cat_socket_send(&client, request.data(), request.size()));
+    responses = test_http_server_read_responses(&client, 1);
+    ASSERT_EQ(responses.size(), 1);
+    ASSERT_EQ(responses[0].status, CAT_HTTP_STATUS_BAD_REQUEST);
+    cat_socket_close(&client);
+}
+
+TEST(cat_http_server, timeout)
+{
+    cat_http_server_options_t options;
+    cat_http_server_options_init(&options);
+    options.read_timeout = 10;
+    options.idle_timeout = 20;
+    test_http_server server(&options);
+    cat_socket_t client;
+    std::string request;
+    char buffer[1];
+
+    /* idle connection is closed silently */
+    server.connect(&client);
+    ASSERT_EQ(cat_socket_recv(&client, buffer, sizeof(buffer)), 0);
+    cat_socket_close(&client);
+
+    /* incomplete request */
+    server.connect(&client);
+    request = "GET / HTTP/1.1\r\n";
+    ASSERT_TRUE(cat_socket_send(&client, request.data(), request.size()));
+    auto responses = test_http_server_read_responses(&client, 1);
+    ASSERT_EQ(responses.size(), 1);
+    ASSERT_EQ(responses[0].status, CAT_HTTP_STATUS_REQUEST_TIME_OUT);
+    cat_socket_close(&client);
+}
+
+static cat_bool_t test_http_server_stream_handler(cat_http_server_connection_t *connection, void *data)
+{
+    cat_http_parser_t *parser = &connection->pipeline.parser;
+    std::string *body = (std::string *) data;
+
+    if (parser->event == CAT_HTTP_PARSER_EVENT_BODY) {
+        body->append(parser->data, parser->data_length);
+    }
+
+    return cat_true;
+}
+
+static cat_bool_t test_http_server_stream_request_handler(cat_http_server_connection_t *connection, void *data)
+{
+    std::string *body = (std::string *) data;
+    std::string length = std::to_string(body->size());
+
+    /* body has been streamed, it is not buffered */
+    EXPECT_EQ(connection->pipeline.body, nullptr);
+    body->clear();
+
+    return cat_http_server_respond(connection, CAT_HTTP_STATUS_OK, nullptr, 0, length.data(), length.size());
+}
+
+TEST(cat_http_server, stream_body)
+{
+    cat_http_server_t server;
+    cat_socket_t client;
+    std::string body;
+    std::string request;
+    wait_group wg;
+    size_t size = CAT_BUFFER_COMMON_SIZE * 64;
+
+    ASSERT_EQ(cat_http_server_create(&server, nullptr, test_http_server_stream_request_handler, &body), &server);
+    DEFER(cat_http_server_close(&server));
+    cat_http_server_set_event_handler(&server, CAT_HTTP_PARSER_EVENT_BODY, test_http_server_stream_handler);
+    ASSERT_TRUE(cat_http_server_listen(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+    co([&] {
+        wg++;
+        DEFER(wg--);
+        ASSERT_TRUE(cat_http_server_run(&server));
+    });
+    DEFER({
+        ASSERT_TRUE(cat_http_server_shutdown(&server, TEST_IO_TIMEOUT));
+        wg();
+    });
+
+    ASSERT_EQ(cat_socket_create(&client, CAT_SOCKET_TYPE_TCP), &client);
+    DEFER(cat_socket_close(&client));
+    ASSERT_TRUE(cat_socket_connect_to(&client, CAT_STRL(TEST_LISTEN_IPV4), cat_http_server_get_port(&server)));
+    request = "POST /upload HTTP/1.1\r\nContent-Length: " + std::to_string(size) + "\r\n\r\n" + std::string(size, 'x');
+    for (int n = 0; n < 2; n++) {
+        ASSERT_TRUE(cat_socket_send(&client, request.data(), request.size()));
+        auto responses = test_http_server_read_responses(&client, 1);
+        ASSERT_EQ(responses.size(), 1);
+        ASSERT_EQ(responses[0].body, std::to_string(size));
+    }
+}
+
+TEST(cat_http_server, graceful_shutdown)
+{
+    test_http_server server;
+    cat_socket_t idle_client, busy_client;
+    std::string request = "GET /sleep HTTP/1.1\r\n\r\n";
+    wait_group wg;
+
+    server.connect(&idle_client);
+    DEFER(cat_socket_close(&idle_client));
+    server.connect(&busy_client);
+    DEFER(cat_socket_close(&busy_client));
+    ASSERT_TRUE(cat_socket_send(&busy_client, request.data(), request.size()));
+    /* wait for the request arriving */
+    while (server.server.requests == 0) {
+        cat_time_msleep(1);
+    }
+    ASSERT_EQ(server.server.connections, 2);
+
+    co([&] {
+        wg++;
+        DEFER(wg--);
+        ASSERT_TRUE(cat_http_server_shutdown(&server.server, TEST_IO_TIMEOUT));
+    });
+    ASSERT_TRUE(cat_http_server_is_shutting_down(&server.server));
+
+    /* in-flight request is finished */
+    auto responses = test_http_server_read_responses(&busy_client, 2);
+    ASSERT_EQ(responses.size(), 1);
+    ASSERT_EQ(responses[0].body, "slept");
+    /* idle connection is closed at once */
+    char buffer[1];
+    ASSERT_EQ(cat_socket_recv(&idle_client, buffer, sizeof(buffer)), 0);
+
+    wg();
+    ASSERT_EQ(server.server.connections, 0);
+    /* no more connections */
+    cat_socket_t client;
+    ASSERT_EQ(cat_socket_create(&client, CAT_SOCKET_TYPE_TCP), &client);
+    DEFER(cat_socket_close(&client));
+    ASSERT_FALSE(cat_socket_connect_to(&client, CAT_STRL(TEST_LISTEN_IPV4), server.port));
+}
+
+TEST(cat_http_server, shutdown_in_handler)
+{
+    test_http_server server;
+    cat_socket_t idle_client, client;
+    std::string request = "GET /shutdown HTTP/1.1\r\n\r\n";
+
+    server.connect(&idle_client);
+    DEFER(cat_socket_close(&idle_client));
+    server.connect(&client);
+    DEFER(cat_socket_close(&client));
+    ASSERT_TRUE(cat_socket_send(&client, request.data(), request.size()));
+
+    /* it returns after the others are closed, then the current one is closed after the response */
+    auto responses = test_http_server_read_responses(&client, 2);
+    ASSERT_EQ(responses.size(), 1);
+    ASSERT_EQ(responses[0].status, CAT_HTTP_STATUS_OK);
+    ASSERT_EQ(responses[0].body, "bye");
+    char buffer[1];
+    ASSERT_EQ(cat_socket_recv(&idle_client, buffer, sizeof(buffer)), 0);
+    ASSERT_TRUE(cat_http_server_is_shutting_down(&server.server));
+    while (server.server.connections != 0) {
+        cat_time_msleep(1);
+    }
+}
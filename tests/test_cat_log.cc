@@ -18,6 +18,9 @@
 
 #include "test.h"
 
+#include <atomic>
+#include <thread>
+
 /* the cat_log_standard function is called by default. */
 
 TEST(cat_log, info)
@@ -44,6 +47,27 @@ TEST(cat_log, warn)
     ASSERT_EQ(output, "[    MAIN    ] Warning: <TEST> warn log\n");
 }
 
+TEST(cat_log, module_types)
+{
+    cat_log_types_t types = cat_log_get_module_types("TEST");
+    cat_log_types_t types_without_warning = (cat_log_types_t) (CAT_LOG_TYPES_ALL & ~((int) CAT_LOG_TYPE_WARNING));
+    DEFER(ASSERT_TRUE(cat_log_set_module_types("TEST", types)));
+
+    ASSERT_EQ(types, CAT_LOG_TYPES_ALL);
+    ASSERT_TRUE(cat_log_set_module_types("test", types_without_warning));
+    ASSERT_EQ(cat_log_get_module_types("TEST"), types_without_warning);
+
+    testing::internal::CaptureStderr();
+    CAT_WARN(TEST, "warn log");
+    CAT_NOTICE(TEST, "notice log");
+    CAT_WARN(TEST2, "warn log");
+    std::string output = testing::internal::GetCapturedStderr();
+    ASSERT_EQ(output,
+        "[    MAIN    ] Notice: <TEST> notice log\n"
+        "[    MAIN    ] Warning: <TEST2> warn log\n"
+    );
+}
+
 TEST(cat_log, error)
 {
     ASSERT_DEATH_IF_SUPPORTED({
@@ -67,3 +91,129 @@ TEST(cat_log, buffer_quote)
     ASSERT_STREQ(str, "\"foo\\r\\n\"");
     cat_free(tmp_str);
 }
+
+TEST(cat_log, async)
+{
+    ASSERT_TRUE(cat_log_async_start(nullptr));
+    ASSERT_TRUE(cat_log_async_is_running());
+    ASSERT_FALSE(cat_log_async_start(nullptr));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EALREADY);
+
+    std::string expected;
+    testing::internal::CaptureStderr();
+    for (int n = 0; n < 1000; n++) {
+        CAT_WARN(TEST, "async log %d", n);
+        expected += "[    MAIN    ] Warning: <TEST> async log " + std::to_string(n) + "\n";
+    }
+    ASSERT_TRUE(cat_log_async_flush(CAT_TIMEOUT_FOREVER));
+    std::string output = testing::internal::GetCapturedStderr();
+    ASSERT_EQ(output, expected);
+    /* last error is still updated on the caller */
+    ASSERT_STREQ(cat_get_last_error_message(), "async log 999");
+
+    cat_log_async_stats_t stats;
+    cat_log_async_get_stats(&stats);
+    ASSERT_EQ(stats.written, 1000);
+    ASSERT_EQ(stats.dropped, 0);
+    ASSERT_EQ(stats.pending, 0);
+
+    ASSERT_TRUE(cat_log_async_stop());
+    ASSERT_FALSE(cat_log_async_is_running());
+    ASSERT_EQ(cat_log_function, cat_log_standard);
+}
+
+TEST(cat_log, async_overflow_block)
+{
+    cat_log_async_options_t options;
+    cat_log_async_options_init(&options);
+    options.capacity = 2;
+    options.overflow_policy = CAT_LOG_ASYNC_OVERFLOW_BLOCK;
+    ASSERT_TRUE(cat_log_async_start(&options));
+
+    testing::internal::CaptureStderr();
+    for (int n = 0; n < 100; n++) {
+        CAT_NOTICE(TEST, "async log");
+    }
+    ASSERT_TRUE(cat_log_async_stop());
+    std::string output = testing::internal::GetCapturedStderr();
+    ASSERT_EQ(output.length(), (sizeof("[    MAIN    ] Notice: <TEST> async log\n") - 1) * 100);
+}
+
+TEST(cat_log, async_error)
+{
+    ASSERT_DEATH_IF_SUPPORTED({
+        cat_log_async_start(nullptr);
+        CAT_WARN(TEST, "warn log");
+        CAT_ERROR(TEST, "error log");
+    }, "\\[    MAIN    \\] Warning: <TEST> warn log\n\\[    MAIN    \\] Error: <TEST> error log\n");
+}
+
+TEST(cat_log, async_crash)
+{
+    auto crash = [](std::function<void()> abort_function) {
+        cat_log_async_options_t options;
+        cat_log_async_options_init(&options);
+        options.capacity = 64 * 1024;
+        cat_log_async_start(&options);
+        for (int n = 0; n < 10000; n++) {
+            CAT_WARN(TEST, "async log %d", n);
+        }
+        abort_function();
+    };
+    ASSERT_DEATH_IF_SUPPORTED(crash([] { cat_abort(); }), "<TEST> async log 9999\n");
+#ifdef CAT_OS_UNIX_LIKE
+    ASSERT_DEATH_IF_SUPPORTED(crash([] { raise(SIGSEGV); }), "<TEST> async log 9999\n");
+#endif
+}
+
+#ifdef CAT_OS_UNIX_LIKE
+static void test_cat_log_async_signal_handler(int signum)
+{
+    (void) signum;
+}
+
+TEST(cat_log, async_signal_handlers)
+{
+    struct sigaction action, old_action, current;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = test_cat_log_async_signal_handler;
+    sigemptyset(&action.sa_mask);
+
+    /* handler which is installed before start is restored by stop */
+    ASSERT_EQ(sigaction(SIGBUS, &action, &old_action), 0);
+    DEFER(sigaction(SIGBUS, &old_action, nullptr));
+    ASSERT_TRUE(cat_log_async_start(nullptr));
+    ASSERT_EQ(sigaction(SIGBUS, nullptr, &current), 0);
+    ASSERT_NE(current.sa_handler, test_cat_log_async_signal_handler);
+    ASSERT_TRUE(cat_log_async_stop());
+    ASSERT_EQ(sigaction(SIGBUS, nullptr, &current), 0);
+    ASSERT_EQ(current.sa_handler, test_cat_log_async_signal_handler);
+
+    /* handler which is installed after start is kept by stop */
+    ASSERT_TRUE(cat_log_async_start(nullptr));
+    ASSERT_EQ(sigaction(SIGFPE, &action, &old_action), 0);
+    DEFER(sigaction(SIGFPE, &old_action, nullptr));
+    ASSERT_TRUE(cat_log_async_stop());
+    ASSERT_EQ(sigaction(SIGFPE, nullptr, &current), 0);
+    ASSERT_EQ(current.sa_handler, test_cat_log_async_signal_handler);
+}
+#endif
+
+TEST(cat_log, async_stop_with_concurrent_users)
+{
+    for (int n = 0; n < 10; n++) {
+        std::atomic<bool> done(false);
+        ASSERT_TRUE(cat_log_async_start(nullptr));
+        std::thread thread([&done] {
+            while (!done) {
+                cat_log_async_stats_t stats;
+                cat_log_async_get_stats(&stats);
+                (void) cat_log_async_flush(0);
+            }
+        });
+        uv_sleep(1);
+        ASSERT_TRUE(cat_log_async_stop());
+        done = true;
+        thread.join();
+    }
+}
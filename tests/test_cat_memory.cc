@@ -156,3 +156,47 @@ TEST(cat_memory, ntoh64)
     num = cat_ntoh64(1125899906842624);
     ASSERT_EQ(1024, num);
 }
+
+TEST(cat_memory, slab)
+{
+    const size_t size = 100;
+    const cat_slab_stats_t *stats = cat_slab_get_stats((size - 1) / CAT_SLAB_CLASS_ALIGNMENT);
+    ASSERT_NE(stats, nullptr);
+    ASSERT_EQ(stats->size, 128);
+    size_t in_use = stats->in_use;
+    uint64_t allocs = stats->allocs, frees = stats->frees;
+
+    void *ptrs[256];
+    for (size_t n = 0; n < CAT_ARRAY_SIZE(ptrs); n++) {
+        ptrs[n] = cat_slab_alloc(size);
+        ASSERT_NE(ptrs[n], nullptr);
+        ASSERT_EQ(((uintptr_t) ptrs[n]) % CAT_MEMORY_DEFAULT_ALIGNED_SIZE, 0);
+        memset(ptrs[n], (int) n, size);
+    }
+    ASSERT_EQ(stats->in_use, in_use + CAT_ARRAY_SIZE(ptrs));
+    ASSERT_GE(stats->peak, stats->in_use);
+    for (size_t n = 0; n < CAT_ARRAY_SIZE(ptrs); n++) {
+        ASSERT_EQ(((unsigned char *) ptrs[n])[size - 1], (unsigned char) n);
+    }
+    for (size_t n = 0; n < CAT_ARRAY_SIZE(ptrs); n++) {
+        cat_slab_free(ptrs[n], size);
+    }
+    ASSERT_EQ(stats->in_use, in_use);
+    ASSERT_EQ(stats->allocs, allocs + CAT_ARRAY_SIZE(ptrs));
+    ASSERT_EQ(stats->frees, frees + CAT_ARRAY_SIZE(ptrs));
+#ifndef CAT_SLAB_USE_SYS_MALLOC
+    ASSERT_GT(stats->pages, 0);
+    /* LIFO reuse */
+    void *ptr = cat_slab_alloc(size - 1);
+    ASSERT_EQ(ptr, ptrs[CAT_ARRAY_SIZE(ptrs) - 1]);
+    cat_slab_free(ptr, size - 1);
+#endif
+
+    /* out of classes */
+    void *large = cat_slab_alloc(CAT_SLAB_MAX_SIZE + 1);
+    ASSERT_NE(large, nullptr);
+    cat_slab_free(large, CAT_SLAB_MAX_SIZE + 1);
+
+    ASSERT_EQ(cat_slab_get_stats(CAT_SLAB_CLASS_COUNT), nullptr);
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EINVAL);
+}
@@ -910,6 +910,95 @@ TEST(cat_socket, is_established)
     ASSERT_FALSE(cat_socket_is_established(&socket));
 }
 
+static cat_bool_t test_accept_filter_odd(cat_socket_fd_t fd, cat_data_t *data)
+{
+    (void) fd;
+    return ((*((int *) data))++ % 2) == 0;
+}
+
+TEST(cat_socket, accept_batch)
+{
+    constexpr size_t n = 8;
+
+    for (int with_filter = 0; with_filter < 2; with_filter++) {
+        cat_socket_t server;
+        cat_socket_t connections[n * 2];
+        cat_socket_t clients[n];
+        wait_group wg;
+        int port, filter_counter = 0;
+        ssize_t accepted;
+
+        ASSERT_NE(cat_socket_create(&server, CAT_SOCKET_TYPE_TCP), nullptr);
+        DEFER(cat_socket_close(&server));
+        ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+        ASSERT_TRUE(cat_socket_listen(&server, TEST_SERVER_BACKLOG));
+        ASSERT_GT(port = cat_socket_get_sock_port(&server), 0);
+
+        for (size_t i = 0; i < n; i++) {
+            cat_socket_t *client = &clients[i];
+            ASSERT_NE(cat_socket_create(client, CAT_SOCKET_TYPE_TCP), nullptr);
+            co([&, client] {
+                wg++;
+                DEFER(wg--);
+                ASSERT_TRUE(cat_socket_connect_to(client, CAT_STRL(TEST_LISTEN_IPV4), port));
+            });
+        }
+        DEFER(for (size_t i = 0; i < n; i++) { cat_socket_close(&clients[i]); });
+        ASSERT_TRUE(wg());
+
+        for (size_t i = 0; i < CAT_ARRAY_SIZE(connections); i++) {
+            ASSERT_NE(cat_socket_create(&connections[i], CAT_SOCKET_TYPE_TCP), nullptr);
+        }
+        DEFER(for (size_t i = 0; i < CAT_ARRAY_SIZE(connections); i++) { cat_socket_close(&connections[i]); });
+        if (!with_filter) {
+            accepted = cat_socket_accept_batch(&server, connections, CAT_ARRAY_SIZE(connections));
+            ASSERT_EQ(accepted, n);
+        } else {
+            accepted = cat_socket_accept_batch_ex(&server, connections, CAT_ARRAY_SIZE(connections), test_accept_filter_odd, &filter_counter, TEST_IO_TIMEOUT);
+            ASSERT_EQ(accepted, n / 2);
+            ASSERT_EQ(filter_counter, n);
+        }
+        for (ssize_t i = 0; i < accepted; i++) {
+            ASSERT_TRUE(cat_socket_is_established(&connections[i]));
+            ASSERT_STREQ(cat_socket_get_role_name(&connections[i]), "server-connection");
+            ASSERT_TRUE(cat_socket_send(&connections[i], CAT_STRL("OK")));
+        }
+        for (size_t i = accepted; i < CAT_ARRAY_SIZE(connections); i++) {
+            ASSERT_FALSE(cat_socket_is_open(&connections[i]));
+        }
+        /* rejected clients get EOF or RST */
+        size_t ok = 0, rejected = 0;
+        for (size_t i = 0; i < n; i++) {
+            char buffer[CAT_STRLEN("OK")];
+            ssize_t nread = cat_socket_read(&clients[i], CAT_STRS(buffer));
+            if (nread <= 0) {
+                rejected++;
+            } else {
+                ASSERT_EQ(nread, CAT_STRLEN("OK"));
+                ok++;
+            }
+        }
+        ASSERT_EQ(ok, (size_t) accepted);
+        ASSERT_EQ(rejected, n - accepted);
+    }
+}
+
+TEST(cat_socket, accept_batch_timeout)
+{
+    cat_socket_t server, connection;
+
+    ASSERT_NE(cat_socket_create(&server, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&server));
+    ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+    ASSERT_TRUE(cat_socket_listen(&server, TEST_SERVER_BACKLOG));
+    ASSERT_NE(cat_socket_create(&connection, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&connection));
+    ASSERT_EQ(cat_socket_accept_batch_ex(&server, &connection, 1, nullptr, nullptr, 1), -1);
+    ASSERT_EQ(cat_get_last_error_code(), CAT_ETIMEDOUT);
+    ASSERT_EQ(cat_socket_accept_batch_ex(&server, &connection, 0, nullptr, nullptr, 1), -1);
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EINVAL);
+}
+
 TEST(cat_socket, is_server)
 {
     cat_socket_t socket;
@@ -1123,6 +1212,63 @@ TEST(cat_socket, set_tcp_keepalive)
     // ASSERT_EQ(cat_socket_get_tcp_keepalive_delay(&socket), 0);
 }
 
+TEST(cat_socket, set_tcp_fastopen_and_defer_accept)
+{
+    cat_socket_t server, client, connection;
+    char buffer[CAT_STRLEN("hello")];
+    int port;
+
+    ASSERT_NE(cat_socket_create(&server, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&server));
+    ASSERT_FALSE(cat_socket_get_tcp_fastopen(&server));
+    ASSERT_EQ(cat_socket_get_tcp_fastopen_queue_length(&server), 0);
+    ASSERT_FALSE(cat_socket_get_tcp_defer_accept(&server));
+    ASSERT_EQ(cat_socket_get_tcp_defer_accept_timeout(&server), 0);
+    ASSERT_TRUE(cat_socket_set_tcp_fastopen(&server, cat_true, 0));
+    ASSERT_TRUE(cat_socket_get_tcp_fastopen(&server));
+    ASSERT_EQ(cat_socket_get_tcp_fastopen_queue_length(&server), CAT_SOCKET_G(options.tcp_fastopen_queue_length));
+    ASSERT_TRUE(cat_socket_set_tcp_defer_accept(&server, cat_true, 3));
+    ASSERT_TRUE(cat_socket_get_tcp_defer_accept(&server));
+    ASSERT_EQ(cat_socket_get_tcp_defer_accept_timeout(&server), 3);
+    ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+    ASSERT_TRUE(cat_socket_listen(&server, TEST_SERVER_BACKLOG));
+    ASSERT_GT(port = cat_socket_get_sock_port(&server), 0);
+#ifdef __linux__
+    do {
+        int value = 0;
+        socklen_t length = sizeof(value);
+        ASSERT_EQ(getsockopt(cat_socket_get_fd(&server), IPPROTO_TCP, TCP_DEFER_ACCEPT, &value, &length), 0);
+        ASSERT_GT(value, 0);
+    } while (0);
+#endif
+    /* change on the fly */
+    ASSERT_TRUE(cat_socket_set_tcp_fastopen(&server, cat_true, 16));
+    ASSERT_EQ(cat_socket_get_tcp_fastopen_queue_length(&server), 16);
+
+    ASSERT_NE(cat_socket_create(&client, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&client));
+    ASSERT_TRUE(cat_socket_set_tcp_fastopen(&client, cat_true, 0));
+    co([&] {
+        ASSERT_TRUE(cat_socket_connect_to(&client, CAT_STRL(TEST_LISTEN_IPV4), port));
+        ASSERT_TRUE(cat_socket_send(&client, CAT_STRL("hello")));
+    });
+    ASSERT_NE(cat_socket_create(&connection, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&connection));
+    ASSERT_TRUE(cat_socket_accept(&server, &connection));
+    ASSERT_EQ(cat_socket_read(&connection, CAT_STRS(buffer)), CAT_STRLEN("hello"));
+    ASSERT_EQ(std::string(buffer, sizeof(buffer)), "hello");
+    ASSERT_TRUE(cat_socket_send(&connection, CAT_STRS(buffer)));
+    ASSERT_EQ(cat_socket_read(&client, CAT_STRS(buffer)), CAT_STRLEN("hello"));
+    ASSERT_EQ(std::string(buffer, sizeof(buffer)), "hello");
+
+    ASSERT_TRUE(cat_socket_set_tcp_defer_accept(&server, cat_false, 0));
+    ASSERT_FALSE(cat_socket_get_tcp_defer_accept(&server));
+    ASSERT_EQ(cat_socket_get_tcp_defer_accept_timeout(&server), 0);
+    ASSERT_TRUE(cat_socket_set_tcp_fastopen(&server, cat_false, 0));
+    ASSERT_FALSE(cat_socket_get_tcp_fastopen(&server));
+    ASSERT_EQ(cat_socket_get_tcp_fastopen_queue_length(&server), 0);
+}
+
 TEST(cat_socket, set_udp_broadcast)
 {
     cat_socket_t socket;
@@ -1882,6 +2028,156 @@ TEST(cat_socket, send_file_to_remote_ssl_server)
 }
 #endif
 
+TEST(cat_socket, proxy)
+{
+    TEST_REQUIRE(echo_tcp_server != nullptr, cat_socket, echo_tcp_server);
+#ifndef CAT_SSL
+    const int mode_count = 1;
+#else
+    const int mode_count = 2;
+#endif
+
+    for (int mode = 0; mode < mode_count; mode++) {
+        cat_socket_t server, client;
+        cat_socket_proxy_options_t options;
+        int port;
+        wait_group wg;
+
+        ASSERT_NE(cat_socket_create(&server, CAT_SOCKET_TYPE_TCP), nullptr);
+        DEFER(cat_socket_close(&server));
+        ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+        ASSERT_TRUE(cat_socket_listen(&server, TEST_SERVER_BACKLOG));
+        ASSERT_GT(port = cat_socket_get_sock_port(&server), 0);
+        cat_socket_proxy_options_init(&options);
+        options.idle_timeout = TEST_IO_TIMEOUT;
+
+        co([&] {
+            wg++;
+            DEFER(wg--);
+            cat_socket_t connection, upstream;
+            ASSERT_NE(cat_socket_create(&connection, CAT_SOCKET_TYPE_TCP), nullptr);
+            DEFER(cat_socket_close(&connection));
+            ASSERT_TRUE(cat_socket_accept(&server, &connection));
+            ASSERT_NE(cat_socket_create(&upstream, CAT_SOCKET_TYPE_TCP), nullptr);
+            DEFER(cat_socket_close(&upstream));
+            ASSERT_TRUE(cat_socket_connect_to(&upstream, echo_tcp_server_ip, echo_tcp_server_ip_length, echo_tcp_server_port));
+#ifdef CAT_SSL
+            if (mode == 1) {
+                /* encrypted upstream makes proxy fall back to copying */
+                ASSERT_TRUE(cat_socket_send(&upstream, CAT_STRL("SSL")));
+                char ssl_greeter[CAT_STRLEN("SSL")];
+                ASSERT_EQ(cat_socket_read(&upstream, CAT_STRS(ssl_greeter)), CAT_STRLEN("SSL"));
+                cat_socket_crypto_options_t ssl_options;
+                cat_socket_crypto_options_init(&ssl_options, cat_true);
+                ssl_options.allow_self_signed = cat_true;
+                ssl_options.peer_name = "localhost";
+                ssl_options.ca_file = TEST_SERVER_SSL_CA_FILE;
+                ssl_options.certificate = TEST_CLIENT_SSL_CERTIFICATE;
+                ssl_options.certificate_key = TEST_CLIENT_SSL_CERTIFICATE_KEY;
+                ASSERT_TRUE(cat_socket_enable_crypto(&upstream, &ssl_options));
+            }
+#endif
+            ASSERT_TRUE(cat_socket_proxy(&connection, &upstream, &options));
+        });
+
+        ASSERT_NE(cat_socket_create(&client, CAT_SOCKET_TYPE_TCP), nullptr);
+        DEFER(cat_socket_close(&client));
+        ASSERT_TRUE(cat_socket_connect_to(&client, CAT_STRL(TEST_LISTEN_IPV4), port));
+        for (int n = 0; n < 8; n++) {
+            std::string random_bytes = get_random_bytes(TEST_BUFFER_SIZE_STD);
+            char read_buffer[TEST_BUFFER_SIZE_STD];
+            ASSERT_TRUE(cat_socket_send(&client, random_bytes.c_str(), random_bytes.length()));
+            ASSERT_EQ(cat_socket_read(&client, CAT_STRS(read_buffer)), sizeof(read_buffer));
+            ASSERT_EQ(std::string(read_buffer, sizeof(read_buffer)), random_bytes);
+        }
+        ASSERT_EQ(shutdown(cat_socket_get_fd(&client), SHUT_WR), 0);
+        ASSERT_TRUE(wg());
+        ASSERT_EQ(options.a_to_b_bytes, TEST_BUFFER_SIZE_STD * 8);
+        ASSERT_EQ(options.b_to_a_bytes, TEST_BUFFER_SIZE_STD * 8);
+    }
+}
+
+TEST(cat_socket, proxy_idle_timeout)
+{
+    TEST_REQUIRE(echo_tcp_server != nullptr, cat_socket, echo_tcp_server);
+    cat_socket_t server, client, connection, upstream;
+    cat_socket_proxy_options_t options;
+    int port;
+
+    ASSERT_NE(cat_socket_create(&server, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&server));
+    ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+    ASSERT_TRUE(cat_socket_listen(&server, TEST_SERVER_BACKLOG));
+    ASSERT_GT(port = cat_socket_get_sock_port(&server), 0);
+    ASSERT_NE(cat_socket_create(&client, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&client));
+    ASSERT_TRUE(cat_socket_connect_to(&client, CAT_STRL(TEST_LISTEN_IPV4), port));
+    ASSERT_NE(cat_socket_create(&connection, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&connection));
+    ASSERT_TRUE(cat_socket_accept(&server, &connection));
+    ASSERT_NE(cat_socket_create(&upstream, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&upstream));
+    ASSERT_TRUE(cat_socket_connect_to(&upstream, echo_tcp_server_ip, echo_tcp_server_ip_length, echo_tcp_server_port));
+
+    cat_socket_proxy_options_init(&options);
+    options.idle_timeout = 10;
+    ASSERT_FALSE(cat_socket_proxy(&connection, &upstream, &options));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_ETIMEDOUT);
+    ASSERT_EQ(options.a_to_b_bytes, 0);
+    ASSERT_EQ(options.b_to_a_bytes, 0);
+}
+
+TEST(cat_socket, proxy_locked)
+{
+    TEST_REQUIRE(echo_tcp_server != nullptr, cat_socket, echo_tcp_server);
+    cat_socket_t server, client, connection, upstream;
+    cat_socket_proxy_options_t options;
+    char buffer[1];
+    int port;
+    wait_group wg;
+
+    ASSERT_NE(cat_socket_create(&server, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&server));
+    ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+    ASSERT_TRUE(cat_socket_listen(&server, TEST_SERVER_BACKLOG));
+    ASSERT_GT(port = cat_socket_get_sock_port(&server), 0);
+    ASSERT_NE(cat_socket_create(&client, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&client));
+    ASSERT_TRUE(cat_socket_connect_to(&client, CAT_STRL(TEST_LISTEN_IPV4), port));
+    ASSERT_NE(cat_socket_create(&connection, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&connection));
+    ASSERT_TRUE(cat_socket_accept(&server, &connection));
+    ASSERT_NE(cat_socket_create(&upstream, CAT_SOCKET_TYPE_TCP), nullptr);
+    DEFER(cat_socket_close(&upstream));
+    ASSERT_TRUE(cat_socket_connect_to(&upstream, echo_tcp_server_ip, echo_tcp_server_ip_length, echo_tcp_server_port));
+
+    cat_socket_proxy_options_init(&options);
+    options.idle_timeout = TEST_IO_TIMEOUT;
+    co([&] {
+        wg++;
+        DEFER(wg--);
+        ASSERT_FALSE(cat_socket_proxy(&connection, &upstream, &options));
+    });
+
+    ASSERT_LT(cat_socket_recv(&connection, CAT_STRS(buffer)), 0);
+    ASSERT_EQ(cat_get_last_error_code(), CAT_ELOCKED);
+    ASSERT_LT(cat_socket_recv(&upstream, CAT_STRS(buffer)), 0);
+    ASSERT_EQ(cat_get_last_error_code(), CAT_ELOCKED);
+#ifdef CAT_OS_LINUX
+    /* splice path does not allow queued writes either */
+    ASSERT_FALSE(cat_socket_send(&connection, CAT_STRL("x")));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_ELOCKED);
+    ASSERT_FALSE(cat_socket_send(&upstream, CAT_STRL("x")));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_ELOCKED);
+#endif
+
+    /* close() cancels the proxy */
+    cat_socket_close(&upstream);
+    ASSERT_TRUE(wg());
+    ASSERT_TRUE(cat_socket_is_available(&connection));
+    ASSERT_TRUE(cat_socket_send(&connection, CAT_STRL("x")));
+}
+
 TEST(cat_socket, cross_close_when_connecting_local)
 {
     TEST_REQUIRE(echo_tcp_server != nullptr, cat_socket, echo_tcp_server);
@@ -2411,6 +2707,62 @@ TEST(cat_socket, pipe)
     ASSERT_STREQ(buffer, random.c_str());
 }
 
+TEST(cat_socket, stats)
+{
+    TEST_REQUIRE(echo_tcp_server != nullptr, cat_socket, echo_tcp_server);
+    cat_bool_t previous = cat_socket_set_global_stats(cat_true);
+    DEFER(cat_socket_set_global_stats(previous));
+    cat_socket_reset_global_stats();
+    cat_socket_t socket, plain_socket;
+    char buffer[TEST_BUFFER_SIZE_STD];
+
+    ASSERT_NE(nullptr, cat_socket_create(&socket, CAT_SOCKET_TYPE_TCP));
+    DEFER(cat_socket_close(&socket));
+    ASSERT_TRUE(cat_socket_connect_to(&socket, echo_tcp_server_ip, echo_tcp_server_ip_length, echo_tcp_server_port));
+    for (int n = 0; n < 3; n++) {
+        ASSERT_TRUE(cat_socket_send(&socket, CAT_STRL("Hello libcat")));
+        ASSERT_EQ(cat_socket_read(&socket, buffer, CAT_STRLEN("Hello libcat")), (ssize_t) CAT_STRLEN("Hello libcat"));
+    }
+
+    const cat_socket_stats_t *stats = cat_socket_get_stats(&socket);
+    ASSERT_NE(stats, nullptr);
+    ASSERT_EQ(stats->connects, 1);
+    ASSERT_EQ(stats->write_ops, 3);
+    ASSERT_EQ(stats->write_bytes, 3 * CAT_STRLEN("Hello libcat"));
+    ASSERT_EQ(stats->read_ops, 3);
+    ASSERT_EQ(stats->read_bytes, 3 * CAT_STRLEN("Hello libcat"));
+    ASSERT_GE(stats->read_inline + stats->read_eagain, 3);
+    const cat_socket_stats_t *global_stats = cat_socket_get_global_stats();
+    ASSERT_GE(global_stats->read_bytes, stats->read_bytes);
+    ASSERT_GE(global_stats->write_bytes, stats->write_bytes);
+
+    cat_socket_tcp_info_t info;
+    if (!cat_socket_get_tcp_info(&socket, &info)) {
+        ASSERT_EQ(cat_get_last_error_code(), CAT_ENOTSUP);
+    } else {
+        ASSERT_GT(info.mss, 0);
+    }
+
+    testing::internal::CaptureStdout();
+    cat_socket_dump_all();
+    std::string output = testing::internal::GetCapturedStdout();
+    ASSERT_NE(output.find("global stats"), std::string::npos);
+
+    /* stats are disabled by default */
+    cat_socket_set_global_stats(cat_false);
+    /* but global stats are still shown as long as something has been counted */
+    testing::internal::CaptureStdout();
+    cat_socket_dump_all();
+    output = testing::internal::GetCapturedStdout();
+    ASSERT_NE(output.find("global stats"), std::string::npos);
+    ASSERT_NE(nullptr, cat_socket_create(&plain_socket, CAT_SOCKET_TYPE_TCP));
+    DEFER(cat_socket_close(&plain_socket));
+    ASSERT_EQ(cat_socket_get_stats(&plain_socket), nullptr);
+    ASSERT_TRUE(cat_socket_enable_stats(&plain_socket));
+    ASSERT_NE(cat_socket_get_stats(&plain_socket), nullptr);
+    ASSERT_EQ(cat_socket_get_stats(&plain_socket)->read_ops, 0);
+}
+
 TEST(cat_socket, dump_all_and_close_all)
 {
     // TODO: now all sockets are unavailable
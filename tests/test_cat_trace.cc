@@ -0,0 +1,143 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "test.h"
+
+extern cat_coroutine_t *echo_tcp_server;
+extern char echo_tcp_server_ip[CAT_SOCKET_IPV6_BUFFER_SIZE];
+extern size_t echo_tcp_server_ip_length;
+extern int echo_tcp_server_port;
+
+extern TEST_REQUIREMENT_DTOR(cat_socket, echo_tcp_server);
+extern TEST_REQUIREMENT(cat_socket, echo_tcp_server);
+
+static size_t trace_count_event(cat_trace_event_t event)
+{
+    size_t count = cat_trace_get_record_count(), index, n = 0;
+
+    for (index = 0; index < count; index++) {
+        if (cat_trace_get_record(index)->event == event) {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+TEST(cat_trace, events)
+{
+    TEST_REQUIRE(echo_tcp_server != nullptr, cat_socket, echo_tcp_server);
+    cat_coroutine_id_t id = 0;
+    char buffer[4];
+
+    ASSERT_TRUE(cat_trace_start(0));
+    DEFER(cat_trace_stop());
+    ASSERT_TRUE(cat_trace_is_enabled());
+    ASSERT_FALSE(cat_trace_start(0));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EALREADY);
+
+    co([&] {
+        id = cat_coroutine_get_current_id();
+    });
+    ASSERT_EQ(cat_time_msleep(1), 0);
+    ASSERT_TRUE(work(CAT_WORK_KIND_FAST_IO, [] { }, TEST_IO_TIMEOUT));
+    do {
+        cat_socket_t socket;
+        ASSERT_NE(cat_socket_create(&socket, CAT_SOCKET_TYPE_TCP), nullptr);
+        DEFER(cat_socket_close(&socket));
+        ASSERT_TRUE(cat_socket_connect_to(&socket, echo_tcp_server_ip, echo_tcp_server_ip_length, echo_tcp_server_port));
+        ASSERT_TRUE(cat_socket_send(&socket, CAT_STRL("ping")));
+        ASSERT_EQ(cat_socket_read(&socket, buffer, sizeof(buffer)), 4);
+    } while (0);
+    cat_trace_stop();
+    ASSERT_FALSE(cat_trace_is_enabled());
+
+    ASSERT_GE(trace_count_event(CAT_TRACE_EVENT_COROUTINE_CREATE), 1);
+    ASSERT_GE(trace_count_event(CAT_TRACE_EVENT_COROUTINE_RESUME), 1);
+    ASSERT_GE(trace_count_event(CAT_TRACE_EVENT_COROUTINE_YIELD), 1);
+    ASSERT_GE(trace_count_event(CAT_TRACE_EVENT_COROUTINE_FINISH), 1);
+    /* timers of the echo server may be still alive */
+    ASSERT_GE(trace_count_event(CAT_TRACE_EVENT_TIMER_ARM),
+              trace_count_event(CAT_TRACE_EVENT_TIMER_FIRE) + trace_count_event(CAT_TRACE_EVENT_TIMER_CANCEL));
+    ASSERT_GE(trace_count_event(CAT_TRACE_EVENT_TIMER_FIRE), 1);
+    ASSERT_EQ(trace_count_event(CAT_TRACE_EVENT_WORK_SUBMIT), 1);
+    ASSERT_EQ(trace_count_event(CAT_TRACE_EVENT_WORK_COMPLETE), 1);
+    ASSERT_EQ(trace_count_event(CAT_TRACE_EVENT_SOCKET_WRITE_START), trace_count_event(CAT_TRACE_EVENT_SOCKET_WRITE_END));
+    ASSERT_GE(trace_count_event(CAT_TRACE_EVENT_SOCKET_READ_END), 1);
+
+    size_t count = cat_trace_get_record_count(), index;
+    bool found = false;
+    for (index = 0; index < count; index++) {
+        const cat_trace_record_t *record = cat_trace_get_record(index);
+        if (record->event == CAT_TRACE_EVENT_COROUTINE_CREATE && record->object == id) {
+            found = true;
+        }
+        if (record->event == CAT_TRACE_EVENT_SOCKET_READ_END) {
+            ASSERT_EQ(record->value, 4);
+        }
+        if (index > 0) {
+            ASSERT_GE(record->timestamp, cat_trace_get_record(index - 1)->timestamp);
+        }
+    }
+    ASSERT_TRUE(found);
+    ASSERT_STREQ(cat_trace_event_name(CAT_TRACE_EVENT_DNS_END), "DNS_END");
+}
+
+TEST(cat_trace, overwrite)
+{
+    ASSERT_TRUE(cat_trace_start(3));
+    DEFER(cat_trace_stop());
+
+    for (int n = 0; n < 10; n++) {
+        CAT_TRACE(WORK_SUBMIT, n, 0);
+    }
+    cat_trace_stop();
+    /* capacity is rounded up to 4, the oldest ones are overwritten */
+    ASSERT_EQ(cat_trace_get_record_count(), 4);
+    ASSERT_EQ(cat_trace_get_lost_count(), 6);
+    ASSERT_EQ(cat_trace_get_record(0)->object, 6);
+    ASSERT_EQ(cat_trace_get_record(3)->object, 9);
+    ASSERT_EQ(cat_trace_get_record(4), nullptr);
+    /* nothing is recorded after stop */
+    CAT_TRACE(WORK_SUBMIT, 10, 0);
+    ASSERT_EQ(cat_trace_get_record(3)->object, 9);
+}
+
+TEST(cat_trace, export_chrome)
+{
+    ASSERT_TRUE(cat_trace_start(0));
+    DEFER(cat_trace_stop());
+    CAT_TRACE(SOCKET_READ_START, 1, 4);
+    CAT_TRACE(SOCKET_READ_END, 1, 4);
+    CAT_TRACE(TIMER_ARM, 0x10, 1);
+    cat_trace_stop();
+
+    FILE *file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    DEFER(fclose(file));
+    ASSERT_TRUE(cat_trace_export_chrome(file));
+    rewind(file);
+    std::string output(4096, '\0');
+    output.resize(fread(&output[0], 1, output.size(), file));
+    ASSERT_EQ(output.find("{\"traceEvents\":[\n"), 0);
+    ASSERT_NE(output.find("\"name\":\"read\",\"cat\":\"libcat\",\"ph\":\"B\",\"ts\":0.000"), std::string::npos);
+    ASSERT_NE(output.find("\"args\":{\"event\":\"SOCKET_READ_END\",\"socket\":1,\"bytes\":4}}"), std::string::npos);
+    ASSERT_NE(output.find("\"ph\":\"b\""), std::string::npos);
+    ASSERT_NE(output.find("\"id\":\"0x10\""), std::string::npos);
+    ASSERT_EQ(output.substr(output.length() - 4), "\n]}\n");
+}
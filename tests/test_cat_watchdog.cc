@@ -142,3 +142,140 @@ TEST(cat_watchdog, not_running)
 {
     ASSERT_EQ(cat_watchdog_get_quantum(), -1);
 }
+
+#ifdef CAT_WATCH_DOG_HAVE_SAMPLING
+static void test_busy_loop(cat_nsec_t ns_total)
+{
+    cat_nsec_t start = cat_time_nsec();
+    volatile uint64_t n = 0;
+    while (cat_time_nsec() - start < ns_total) {
+        n++;
+    }
+}
+
+TEST(cat_watchdog, sampling)
+{
+    ASSERT_FALSE(cat_watchdog_start_sampling(0, 0));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EMISUSE);
+
+    testing::internal::CaptureStderr();
+    ([&] {
+        ASSERT_TRUE(cat_watchdog_run(nullptr, 0, 0, nullptr));
+        DEFER(cat_watchdog_stop());
+        ASSERT_TRUE(cat_watchdog_start_sampling(1000 * 1000, 100 /* will be aligned to 128 */));
+        ASSERT_TRUE(cat_watchdog_is_sampling());
+        ASSERT_FALSE(cat_watchdog_start_sampling(0, 0));
+        ASSERT_EQ(cat_get_last_error_code(), CAT_EMISUSE);
+
+        co([=] {
+            test_busy_loop(cat_watchdog_get_quantum() * 20);
+        });
+        ASSERT_GT(cat_watchdog_get_sample_count(), 0);
+        ASSERT_LE(cat_watchdog_get_sample_count(), 128);
+        ASSERT_GT(cat_watchdog_get_sample_count_by_reason(CAT_WATCH_DOG_SAMPLE_REASON_ALERT), 0);
+        ASSERT_GT(cat_watchdog_get_sample_count_by_reason(CAT_WATCH_DOG_SAMPLE_REASON_PERIODIC), 0);
+        ASSERT_EQ(cat_watchdog_get_sample_count_by_reason(CAT_WATCH_DOG_SAMPLE_REASON_ALERT) +
+                  cat_watchdog_get_sample_count_by_reason(CAT_WATCH_DOG_SAMPLE_REASON_PERIODIC),
+                  cat_watchdog_get_sample_count());
+
+        cat_buffer_t buffer;
+        ASSERT_TRUE(cat_buffer_create(&buffer, 0));
+        DEFER(cat_buffer_close(&buffer));
+        ASSERT_TRUE(cat_watchdog_export_samples(&buffer, cat_false));
+        std::string flat(buffer.value, buffer.length);
+        ASSERT_FALSE(flat.empty());
+        ASSERT_EQ(flat.back(), '\n');
+        ASSERT_EQ(flat.find("coroutine#"), std::string::npos);
+        cat_buffer_clear(&buffer);
+        ASSERT_TRUE(cat_watchdog_export_samples(&buffer, cat_true));
+        std::string grouped(buffer.value, buffer.length);
+        ASSERT_EQ(grouped.rfind("coroutine#", 0), 0);
+
+        cat_watchdog_clear_samples();
+        ASSERT_EQ(cat_watchdog_get_sample_count(), 0);
+        ASSERT_TRUE(cat_watchdog_stop_sampling());
+        ASSERT_FALSE(cat_watchdog_is_sampling());
+        ASSERT_FALSE(cat_watchdog_stop_sampling());
+        ASSERT_EQ(cat_get_last_error_code(), CAT_EMISUSE);
+
+        cat_watchdog_stop();
+        fflush(stderr);
+    })();
+    (void) testing::internal::GetCapturedStderr();
+}
+#endif
+
+/* returns false if it has been canceled */
+static bool test_busy_loop_with_checkpoint(cat_nsec_t ns_total)
+{
+    cat_nsec_t start = cat_time_nsec();
+    while (cat_time_nsec() - start < ns_total) {
+        if (!cat_coroutine_check_preempt()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(cat_watchdog, preempt_not_running)
+{
+    ASSERT_FALSE(cat_watchdog_set_preempt_actions(CAT_COROUTINE_PREEMPT_YIELD));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EMISUSE);
+    ASSERT_EQ(cat_watchdog_get_preempt_actions(), CAT_COROUTINE_PREEMPT_NONE);
+    ASSERT_TRUE(cat_coroutine_check_preempt());
+}
+
+TEST(cat_watchdog, preempt_yield)
+{
+    testing::internal::CaptureStderr();
+    ([&] {
+        ASSERT_TRUE(cat_watchdog_run(nullptr, 0, 0, nullptr));
+        DEFER(cat_watchdog_stop());
+        ASSERT_TRUE(cat_watchdog_set_preempt_actions(CAT_COROUTINE_PREEMPT_YIELD));
+        ASSERT_EQ(cat_watchdog_get_preempt_actions(), CAT_COROUTINE_PREEMPT_YIELD);
+
+        wait_group wg;
+        bool done = false;
+        co([&] {
+            wg++;
+            DEFER(wg--);
+            ASSERT_TRUE(test_busy_loop_with_checkpoint(cat_watchdog_get_quantum() * 20));
+            done = true;
+        });
+        /* runaway coroutine has been preempted */
+        ASSERT_FALSE(done);
+        ASSERT_TRUE(wg());
+        ASSERT_TRUE(done);
+
+        cat_watchdog_stop();
+        fflush(stderr);
+    })();
+    (void) testing::internal::GetCapturedStderr();
+}
+
+TEST(cat_watchdog, preempt_cancel)
+{
+    testing::internal::CaptureStderr();
+    ([&] {
+        ASSERT_TRUE(cat_watchdog_run(nullptr, 0, 0, nullptr));
+        DEFER(cat_watchdog_stop());
+        ASSERT_TRUE(cat_watchdog_set_preempt_actions(CAT_COROUTINE_PREEMPT_LOG | CAT_COROUTINE_PREEMPT_CANCEL));
+
+        wait_group wg;
+        co([&] {
+            wg++;
+            DEFER(wg--);
+            /* it would be blocked for 10s without preemption */
+            ASSERT_FALSE(test_busy_loop_with_checkpoint(10 * 1000 * 1000 * 1000LL));
+            ASSERT_EQ(cat_get_last_error_code(), CAT_ECANCELED);
+            /* error is resumable */
+            ASSERT_TRUE(cat_coroutine_check_preempt());
+        });
+        ASSERT_TRUE(wg());
+
+        cat_watchdog_stop();
+        fflush(stderr);
+    })();
+    std::string output = testing::internal::GetCapturedStderr();
+    ASSERT_NE(output.find("without yielding"), std::string::npos);
+}
@@ -94,3 +94,275 @@ TEST(cat_websocket, mask_and_unmask)
     );
     ASSERT_STREQ(raw, processed);
 }
+
+TEST(cat_websocket, mask_with_kernel)
+{
+    const char *masking_key = "\x12\x34\x56\x78";
+    size_t max_length = 300;
+    std::string raw(max_length + 32, '\0'), expected, processed;
+
+    ASSERT_NE(cat_websocket_mask_get_kernel_name(), nullptr);
+    ASSERT_NE(cat_srand(&raw[0], raw.size()), nullptr);
+    for (size_t length = 0; length <= max_length; length++) {
+        for (uint64_t index = 0; index < 8; index++) {
+            /* unaligned pointer */
+            size_t offset = (length + (size_t) index) % 7;
+            expected = raw.substr(offset, length);
+            for (size_t i = 0; i < length; i++) {
+                expected[i] ^= masking_key[(index + i) % CAT_WEBSOCKET_MASKING_KEY_LENGTH];
+            }
+            processed.assign(length, '\0');
+            cat_websocket_mask_ex(raw.data() + offset, &processed[0], length, masking_key, index);
+            ASSERT_EQ(processed, expected);
+            processed = raw.substr(offset, length);
+            cat_websocket_unmask_ex(&processed[0], length, masking_key, index);
+            ASSERT_EQ(processed, expected);
+        }
+    }
+}
+
+static std::string test_websocket_frame(cat_websocket_opcode_t opcode, bool fin, std::string payload, const char *masking_key)
+{
+    cat_websocket_header_t header;
+    cat_io_vector_t vector[2];
+    std::string frame;
+    unsigned int n = cat_websocket_frame_serialize(&header, vector, opcode, fin, &payload[0], payload.size(), masking_key);
+    for (unsigned int i = 0; i < n; i++) {
+        frame.append(vector[i].base, vector[i].length);
+    }
+    return frame;
+}
+
+TEST(cat_websocket, parser)
+{
+    std::string big(70000, 'x'), stream;
+    cat_websocket_parser_t parser;
+
+    stream += test_websocket_frame(CAT_WEBSOCKET_OPCODE_TEXT, false, "Hello ", "abcd");
+    stream += test_websocket_frame(CAT_WEBSOCKET_OPCODE_PING, true, "ping", "efgh");
+    stream += test_websocket_frame(CAT_WEBSOCKET_OPCODE_CONTINUATION, false, "", "ijkl");
+    stream += test_websocket_frame(CAT_WEBSOCKET_OPCODE_CONTINUATION, true, "libcat", "mnop");
+    stream += test_websocket_frame(CAT_WEBSOCKET_OPCODE_BINARY, true, big, "qrst");
+    stream += test_websocket_frame(CAT_WEBSOCKET_OPCODE_CLOSE, true, "\x03\xe8", "uvwx");
+
+    for (size_t chunk_size : { (size_t) 1, (size_t) 3, (size_t) 1000, stream.size() }) {
+        std::string input = stream, events, message, control;
+        std::vector<std::string> messages;
+        char *p = &input[0], *pe = p + input.size();
+
+        cat_websocket_parser_init(&parser);
+        parser.flags = CAT_WEBSOCKET_PARSER_FLAG_REQUIRE_MASK;
+        while (p < pe) {
+            size_t length = CAT_MIN(chunk_size, (size_t) (pe - p));
+            char *chunk = p;
+            p += length;
+            do {
+                ASSERT_TRUE(cat_websocket_parser_execute(&parser, chunk, length));
+                chunk += parser.parsed_length;
+                length -= parser.parsed_length;
+                switch (parser.event) {
+                    case CAT_WEBSOCKET_PARSER_EVENT_FRAME_HEADER:
+                        events += "H";
+                        break;
+                    case CAT_WEBSOCKET_PARSER_EVENT_PAYLOAD:
+                        if (cat_websocket_opcode_is_control(parser.header.opcode)) {
+                            control.append(parser.data, parser.data_length);
+                        } else {
+                            message.append(parser.data, parser.data_length);
+                        }
+                        break;
+                    case CAT_WEBSOCKET_PARSER_EVENT_FRAME_COMPLETE:
+                        events += "F";
+                        break;
+                    case CAT_WEBSOCKET_PARSER_EVENT_MESSAGE_COMPLETE:
+                        events += "M";
+                        if (cat_websocket_opcode_is_control(parser.header.opcode)) {
+                            messages.push_back(std::string(cat_websocket_opcode_get_name(parser.header.opcode)) + ":" + control);
+                            control.clear();
+                        } else {
+                            messages.push_back(std::string(cat_websocket_opcode_get_name(cat_websocket_parser_get_opcode(&parser))) + ":" + message);
+                            message.clear();
+                        }
+                        break;
+                    default:
+                        ASSERT_EQ(parser.event, CAT_WEBSOCKET_PARSER_EVENT_NONE);
+                }
+            } while (parser.event != CAT_WEBSOCKET_PARSER_EVENT_NONE);
+            ASSERT_EQ(length, 0);
+        }
+        ASSERT_EQ(events, "HFHMHFHMHMHM");
+        ASSERT_EQ(messages.size(), 4);
+        ASSERT_EQ(messages[0], "PING:ping");
+        ASSERT_EQ(messages[1], "TEXT:Hello libcat");
+        ASSERT_EQ(messages[2], "BINARY:" + big);
+        ASSERT_EQ(messages[3], std::string("CLOSE:\x03\xe8"));
+    }
+}
+
+TEST(cat_websocket, parser_error)
+{
+    cat_websocket_parser_t parser;
+    auto parse = [&parser](std::string frame) {
+        cat_websocket_parser_reset(&parser);
+        if (!cat_websocket_parser_execute(&parser, &frame[0], frame.size())) {
+            return false;
+        }
+        return parser.event == CAT_WEBSOCKET_PARSER_EVENT_FRAME_HEADER;
+    };
+
+    cat_websocket_parser_init(&parser);
+    ASSERT_TRUE(parse(test_websocket_frame(CAT_WEBSOCKET_OPCODE_TEXT, true, "foo", nullptr)));
+    parser.flags = CAT_WEBSOCKET_PARSER_FLAG_REQUIRE_MASK;
+    ASSERT_FALSE(parse(test_websocket_frame(CAT_WEBSOCKET_OPCODE_TEXT, true, "foo", nullptr)));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EPROTO);
+    ASSERT_EQ(parser.error_status, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR);
+    /* dead */
+    ASSERT_FALSE(cat_websocket_parser_execute(&parser, nullptr, 0));
+    parser.flags = CAT_WEBSOCKET_PARSER_FLAG_NONE;
+    ASSERT_FALSE(parse(test_websocket_frame(CAT_WEBSOCKET_OPCODE_PING, false, "foo", nullptr)));
+    ASSERT_FALSE(parse(test_websocket_frame(CAT_WEBSOCKET_OPCODE_PING, true, std::string(126, 'x'), nullptr)));
+    ASSERT_FALSE(parse(test_websocket_frame(CAT_WEBSOCKET_OPCODE_CONTINUATION, true, "foo", nullptr)));
+    ASSERT_FALSE(parse(test_websocket_frame(0x3, true, "foo", nullptr)));
+    do {
+        std::string frame = test_websocket_frame(CAT_WEBSOCKET_OPCODE_TEXT, true, "foo", nullptr);
+        frame[0] |= 0x40; /* rsv1 */
+        ASSERT_FALSE(parse(frame));
+        parser.flags = CAT_WEBSOCKET_PARSER_FLAG_ALLOW_RSV1;
+        ASSERT_TRUE(parse(frame));
+        /* only the first frame of data messages can be compressed */
+        for (auto opcode : { CAT_WEBSOCKET_OPCODE_CLOSE, CAT_WEBSOCKET_OPCODE_PING, CAT_WEBSOCKET_OPCODE_PONG }) {
+            std::string control_frame = test_websocket_frame(opcode, true, "", nullptr);
+            control_frame[0] |= 0x40;
+            ASSERT_FALSE(parse(control_frame));
+            ASSERT_EQ(parser.error_status, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR);
+        }
+        std::string frames = test_websocket_frame(CAT_WEBSOCKET_OPCODE_TEXT, false, "foo", nullptr);
+        frames[0] |= 0x40;
+        std::string continuation = test_websocket_frame(CAT_WEBSOCKET_OPCODE_CONTINUATION, true, "bar", nullptr);
+        continuation[0] |= 0x40;
+        frames += continuation;
+        cat_websocket_parser_reset(&parser);
+        char *data = &frames[0];
+        size_t length = frames.size();
+        cat_bool_t ret;
+        while ((ret = cat_websocket_parser_execute(&parser, data, length)) && parser.event != CAT_WEBSOCKET_PARSER_EVENT_NONE) {
+            data += parser.parsed_length;
+            length -= parser.parsed_length;
+        }
+        ASSERT_FALSE(ret);
+        ASSERT_EQ(parser.error_status, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR);
+        parser.flags = CAT_WEBSOCKET_PARSER_FLAG_NONE;
+    } while (0);
+    parser.max_message_length = 4;
+    ASSERT_TRUE(parse(test_websocket_frame(CAT_WEBSOCKET_OPCODE_TEXT, true, "foo", nullptr)));
+    ASSERT_FALSE(parse(test_websocket_frame(CAT_WEBSOCKET_OPCODE_TEXT, true, "foobar", nullptr)));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EMSGSIZE);
+    ASSERT_EQ(parser.error_status, CAT_WEBSOCKET_STATUS_MESSAGE_TOO_BIG);
+}
+
+TEST(cat_websocket, broadcast)
+{
+    cat_socket_t server, clients[3], connections[3];
+    cat_socket_t *sockets[3];
+    cat_websocket_broadcast_options_t options;
+    cat_websocket_broadcast_result_t result;
+    cat_websocket_broadcast_frame_t *frame, *big_frame;
+    std::string expected = test_websocket_frame(CAT_WEBSOCKET_OPCODE_TEXT, true, "hello", nullptr);
+    size_t big_frame_length;
+    char buffer[64];
+    int port;
+
+    ASSERT_EQ(cat_socket_create(&server, CAT_SOCKET_TYPE_TCP), &server);
+    DEFER(cat_socket_close(&server));
+    ASSERT_TRUE(cat_socket_bind_to(&server, CAT_STRL(TEST_LISTEN_IPV4), 0));
+    ASSERT_TRUE(cat_socket_listen(&server, TEST_SERVER_BACKLOG));
+    ASSERT_GT(port = cat_socket_get_sock_port(&server), 0);
+    for (size_t i = 0; i < CAT_ARRAY_SIZE(clients); i++) {
+        ASSERT_EQ(cat_socket_create(&clients[i], CAT_SOCKET_TYPE_TCP), &clients[i]);
+        ASSERT_EQ(cat_socket_create(&connections[i], CAT_SOCKET_TYPE_TCP), &connections[i]);
+        sockets[i] = &connections[i];
+    }
+    DEFER({
+        for (size_t i = 0; i < CAT_ARRAY_SIZE(clients); i++) {
+            cat_socket_close(&clients[i]);
+            cat_socket_close(&connections[i]);
+        }
+    });
+    for (size_t i = 0; i < CAT_ARRAY_SIZE(clients); i++) {
+        ASSERT_TRUE(cat_socket_connect_to(&clients[i], CAT_STRL(TEST_LISTEN_IPV4), port));
+        ASSERT_TRUE(cat_socket_accept(&server, &connections[i]));
+        ASSERT_TRUE(cat_socket_enable_stats(&connections[i]));
+    }
+
+    /* encode once, fan out to all */
+    ASSERT_NE(frame = cat_websocket_broadcast_frame_create(CAT_WEBSOCKET_OPCODE_TEXT, CAT_STRL("hello")), nullptr);
+    DEFER(cat_websocket_broadcast_frame_release(frame));
+    ASSERT_EQ(cat_websocket_broadcast(frame, sockets, CAT_ARRAY_SIZE(sockets), nullptr, &result), 3);
+    ASSERT_EQ(result.queued, 3);
+    for (size_t i = 0; i < CAT_ARRAY_SIZE(clients); i++) {
+        ASSERT_EQ(cat_socket_read(&clients[i], buffer, expected.size()), (ssize_t) expected.size());
+        ASSERT_EQ(std::string(buffer, expected.size()), expected);
+    }
+    /* async writes are accounted as normal writes once the loop completes them */
+    ASSERT_EQ(cat_time_msleep(0), 0);
+    for (size_t i = 0; i < CAT_ARRAY_SIZE(connections); i++) {
+        const cat_socket_stats_t *stats = cat_socket_get_stats(&connections[i]);
+        ASSERT_NE(stats, nullptr);
+        ASSERT_EQ(stats->write_ops, 1);
+        ASSERT_EQ(stats->write_bytes, expected.size());
+    }
+
+    /* make the first and second ones slow consumers (empty frame has only header) */
+    ASSERT_NE(big_frame = cat_websocket_broadcast_frame_create(CAT_WEBSOCKET_OPCODE_BINARY, nullptr, 0), nullptr);
+    ASSERT_EQ(big_frame->vector_count, 1);
+    cat_websocket_broadcast_frame_release(big_frame);
+    do {
+        std::string big(32 * 1024 * 1024, 'x');
+        ASSERT_NE(big_frame = cat_websocket_broadcast_frame_create(CAT_WEBSOCKET_OPCODE_BINARY, big.c_str(), big.size()), nullptr);
+    } while (0);
+    big_frame_length = cat_socket_write_vector_length(big_frame->vector, big_frame->vector_count);
+    ASSERT_EQ(cat_websocket_broadcast(big_frame, sockets, 2, nullptr, nullptr), 2);
+    /* frame is still referenced by the write queues */
+    cat_websocket_broadcast_frame_release(big_frame);
+    ASSERT_GT(cat_socket_get_write_queue_size(&connections[0]), 0);
+    ASSERT_GT(cat_socket_get_write_queue_size(&connections[1]), 0);
+    ASSERT_EQ(cat_socket_get_write_queue_size(&connections[2]), 0);
+
+    cat_websocket_broadcast_options_init(&options);
+    options.max_queue_size = 64 * 1024;
+    ASSERT_EQ(cat_websocket_broadcast(frame, sockets, CAT_ARRAY_SIZE(sockets), &options, &result), 1);
+    ASSERT_EQ(result.queued, 1);
+    ASSERT_EQ(result.dropped, 2);
+
+    /* wait until the second one drains */
+    do {
+        wait_group wg;
+        co([&] {
+            wg++;
+            DEFER(wg--);
+            std::string data(big_frame_length + expected.size(), '\0');
+            ASSERT_EQ(cat_socket_read(&clients[1], &data[0], data.size()), (ssize_t) data.size());
+            ASSERT_EQ(data.substr(big_frame_length), expected);
+        });
+        options.policy = CAT_WEBSOCKET_BROADCAST_POLICY_WAIT;
+        options.timeout = TEST_IO_TIMEOUT;
+        ASSERT_EQ(cat_websocket_broadcast(frame, sockets + 1, 1, &options, &result), 1);
+        ASSERT_EQ(result.written, 1);
+    } while (0);
+
+    /* disconnect the first one */
+    options.policy = CAT_WEBSOCKET_BROADCAST_POLICY_DISCONNECT;
+    ASSERT_EQ(cat_websocket_broadcast(frame, sockets, CAT_ARRAY_SIZE(sockets), &options, &result), 2);
+    ASSERT_EQ(result.queued, 2);
+    ASSERT_EQ(result.disconnected, 1);
+    ASSERT_FALSE(cat_socket_is_available(&connections[0]));
+    ASSERT_EQ(cat_websocket_broadcast(frame, sockets, 1, &options, &result), 0);
+    ASSERT_EQ(result.failed, 1);
+    for (size_t i = 1; i < CAT_ARRAY_SIZE(clients); i++) {
+        /* the third one got 2 frames (the dropped one was not for it) */
+        for (size_t n = 0; n < (i == 1 ? 1 : 2); n++) {
+            ASSERT_EQ(cat_socket_read(&clients[i], buffer, expected.size()), (ssize_t) expected.size());
+            ASSERT_EQ(std::string(buffer, expected.size()), expected);
+        }
+    }
+}
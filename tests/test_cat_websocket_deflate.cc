@@ -0,0 +1,298 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "test.h"
+
+#include "cat_websocket_deflate.h"
+
+static std::string test_websocket_deflate_parameters_format(const cat_websocket_deflate_parameters_t *parameters)
+{
+    char buffer[256];
+    size_t length = cat_websocket_deflate_parameters_format(parameters, buffer, sizeof(buffer));
+    return std::string(buffer, length);
+}
+
+TEST(cat_websocket_deflate, parameters_parse)
+{
+    cat_websocket_deflate_parameters_t parameters;
+
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&parameters, CAT_STRL("permessage-deflate")));
+    ASSERT_EQ(parameters.server_max_window_bits, 0);
+    ASSERT_EQ(parameters.client_max_window_bits, 0);
+    ASSERT_FALSE(parameters.server_no_context_takeover);
+    ASSERT_FALSE(parameters.client_no_context_takeover);
+
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&parameters, CAT_STRL(
+        "x-webkit-deflate-frame, Permessage-Deflate ; server_no_context_takeover; server_max_window_bits=\"10\"; client_max_window_bits"
+    )));
+    ASSERT_EQ(parameters.server_max_window_bits, 10);
+    ASSERT_EQ(parameters.client_max_window_bits, CAT_WEBSOCKET_DEFLATE_WINDOW_BITS_ANY);
+    ASSERT_TRUE(parameters.server_no_context_takeover);
+    ASSERT_FALSE(parameters.client_no_context_takeover);
+
+    /* invalid offers are declined, the next one is used */
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&parameters, CAT_STRL(
+        "permessage-deflate; server_max_window_bits=16, permessage-deflate; unknown, permessage-deflate; client_no_context_takeover; client_max_window_bits=12"
+    )));
+    ASSERT_EQ(parameters.server_max_window_bits, 0);
+    ASSERT_EQ(parameters.client_max_window_bits, 12);
+    ASSERT_TRUE(parameters.client_no_context_takeover);
+
+    ASSERT_FALSE(cat_websocket_deflate_parameters_parse(&parameters, CAT_STRL("")));
+    ASSERT_FALSE(cat_websocket_deflate_parameters_parse(&parameters, CAT_STRL("permessage-deflate-x")));
+    ASSERT_FALSE(cat_websocket_deflate_parameters_parse(&parameters, CAT_STRL("permessage-deflate; server_max_window_bits")));
+    ASSERT_FALSE(cat_websocket_deflate_parameters_parse(&parameters, CAT_STRL("permessage-deflate; server_no_context_takeover=1")));
+    ASSERT_FALSE(cat_websocket_deflate_parameters_parse(&parameters, CAT_STRL("permessage-deflate; client_max_window_bits=7")));
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&parameters, CAT_STRL("permessage-deflate; client_max_window_bits=8")));
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&parameters, CAT_STRL("permessage-deflate; server_max_window_bits=8")));
+    ASSERT_FALSE(cat_websocket_deflate_parameters_parse(&parameters, CAT_STRL("permessage-deflate; client_no_context_takeover; client_no_context_takeover")));
+}
+
+TEST(cat_websocket_deflate, parameters_format_and_negotiate)
+{
+    cat_websocket_deflate_parameters_t offer, limits, response;
+
+    cat_websocket_deflate_parameters_init(&offer);
+    cat_websocket_deflate_parameters_init(&limits);
+    ASSERT_EQ(test_websocket_deflate_parameters_format(&offer), "permessage-deflate");
+    ASSERT_EQ(cat_websocket_deflate_parameters_format(&offer, nullptr, 0), 0);
+
+    /* the default offer of browsers */
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&offer, CAT_STRL("permessage-deflate; client_max_window_bits")));
+    ASSERT_EQ(test_websocket_deflate_parameters_format(&offer), "permessage-deflate; client_max_window_bits");
+    ASSERT_TRUE(cat_websocket_deflate_parameters_negotiate(&offer, &limits, &response));
+    ASSERT_EQ(test_websocket_deflate_parameters_format(&response), "permessage-deflate");
+
+    /* limit memory usage of both sides */
+    limits.server_max_window_bits = 10;
+    limits.client_max_window_bits = 11;
+    limits.server_no_context_takeover = cat_true;
+    ASSERT_TRUE(cat_websocket_deflate_parameters_negotiate(&offer, &limits, &response));
+    ASSERT_EQ(test_websocket_deflate_parameters_format(&response),
+        "permessage-deflate; server_no_context_takeover; server_max_window_bits=10; client_max_window_bits=11");
+
+    /* client_max_window_bits can not be limited if client does not support it */
+    offer.client_max_window_bits = 0;
+    offer.server_max_window_bits = 9;
+    offer.client_no_context_takeover = cat_true;
+    ASSERT_TRUE(cat_websocket_deflate_parameters_negotiate(&offer, &limits, &response));
+    ASSERT_EQ(test_websocket_deflate_parameters_format(&response),
+        "permessage-deflate; server_no_context_takeover; client_no_context_takeover; server_max_window_bits=9");
+
+    /* zlib does not support 8 */
+    offer.server_max_window_bits = 8;
+    ASSERT_FALSE(cat_websocket_deflate_parameters_negotiate(&offer, &limits, &response));
+    /* but we only inflate what client sends */
+    offer.server_max_window_bits = 0;
+    offer.client_max_window_bits = 8;
+    ASSERT_TRUE(cat_websocket_deflate_parameters_negotiate(&offer, &limits, &response));
+    ASSERT_EQ(response.client_max_window_bits, 8);
+    offer.client_max_window_bits = CAT_WEBSOCKET_DEFLATE_WINDOW_BITS_ANY;
+    limits.client_max_window_bits = 8;
+    ASSERT_TRUE(cat_websocket_deflate_parameters_negotiate(&offer, &limits, &response));
+    ASSERT_EQ(response.client_max_window_bits, 8);
+}
+
+TEST(cat_websocket_deflate, parameters_accept)
+{
+    cat_websocket_deflate_parameters_t offer, response;
+
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&offer, CAT_STRL("permessage-deflate; client_max_window_bits")));
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&response, CAT_STRL("permessage-deflate")));
+    ASSERT_TRUE(cat_websocket_deflate_parameters_accept(&offer, &response));
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&response, CAT_STRL("permessage-deflate; server_max_window_bits=8; client_max_window_bits=10")));
+    ASSERT_TRUE(cat_websocket_deflate_parameters_accept(&offer, &response));
+
+    /* we would deflate with window bits of 8 */
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&response, CAT_STRL("permessage-deflate; client_max_window_bits=8")));
+    ASSERT_FALSE(cat_websocket_deflate_parameters_accept(&offer, &response));
+    /* response must have a value */
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&response, CAT_STRL("permessage-deflate; client_max_window_bits")));
+    ASSERT_FALSE(cat_websocket_deflate_parameters_accept(&offer, &response));
+
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&offer, CAT_STRL("permessage-deflate; server_max_window_bits=10")));
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&response, CAT_STRL("permessage-deflate; server_max_window_bits=10")));
+    ASSERT_TRUE(cat_websocket_deflate_parameters_accept(&offer, &response));
+    /* not offered or bigger than offered */
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&response, CAT_STRL("permessage-deflate; server_max_window_bits=11")));
+    ASSERT_FALSE(cat_websocket_deflate_parameters_accept(&offer, &response));
+    ASSERT_TRUE(cat_websocket_deflate_parameters_parse(&response, CAT_STRL("permessage-deflate; client_max_window_bits=10")));
+    ASSERT_FALSE(cat_websocket_deflate_parameters_accept(&offer, &response));
+}
+
+static std::string test_websocket_deflate_message(size_t n)
+{
+    std::string message;
+    for (size_t i = 0; i < n; i++) {
+        message += "{\"id\":" + std::to_string(i) + ",\"name\":\"libcat\",\"tags\":[\"coroutine\",\"websocket\"]},";
+    }
+    return message;
+}
+
+static void test_websocket_deflate_round_trip(cat_bool_t server_no_context_takeover, cat_bool_t client_no_context_takeover, cat_websocket_deflate_pool_t *pool)
+{
+    cat_websocket_deflate_parameters_t parameters;
+    cat_websocket_deflate_options_t options;
+    cat_websocket_deflate_t server, client;
+    std::string message = test_websocket_deflate_message(100);
+    size_t first_compressed_length = 0;
+
+    cat_websocket_deflate_parameters_init(&parameters);
+    parameters.server_no_context_takeover = server_no_context_takeover;
+    parameters.client_no_context_takeover = client_no_context_takeover;
+    parameters.client_max_window_bits = 10;
+    cat_websocket_deflate_options_init(&options);
+    options.pool = pool;
+    ASSERT_EQ(cat_websocket_deflate_create(&server, &parameters, cat_true, &options), &server);
+    DEFER(cat_websocket_deflate_close(&server));
+    ASSERT_EQ(cat_websocket_deflate_create(&client, &parameters, cat_false, &options), &client);
+    DEFER(cat_websocket_deflate_close(&client));
+    ASSERT_EQ(server.deflate_window_bits, 15);
+    ASSERT_EQ(server.inflate_window_bits, 10);
+    ASSERT_EQ(client.deflate_window_bits, 10);
+    ASSERT_EQ(client.inflate_window_bits, 15);
+
+    for (int n = 0; n < 3; n++) {
+        for (cat_websocket_deflate_t *sender : { &server, &client }) {
+            cat_websocket_deflate_t *receiver = sender == &server ? &client : &server;
+            cat_bool_t no_context_takeover = sender == &server ? server_no_context_takeover : client_no_context_takeover;
+            cat_buffer_t compressed, decompressed;
+            ASSERT_TRUE(cat_buffer_create(&compressed, 0));
+            DEFER(cat_buffer_close(&compressed));
+            ASSERT_TRUE(cat_buffer_create(&decompressed, 0));
+            DEFER(cat_buffer_close(&decompressed));
+            /* compress as 3 fragments */
+            size_t fragment_length = message.size() / 3;
+            ASSERT_TRUE(cat_websocket_deflate_compress(sender, message.c_str(), fragment_length, cat_false, &compressed));
+            ASSERT_TRUE(cat_websocket_deflate_compress(sender, message.c_str() + fragment_length, fragment_length, cat_false, &compressed));
+            ASSERT_TRUE(cat_websocket_deflate_compress(sender, message.c_str() + fragment_length * 2, message.size() - fragment_length * 2, cat_true, &compressed));
+            ASSERT_LT(compressed.length, message.size() / 4);
+            if (sender == &server) {
+                if (n == 0) {
+                    first_compressed_length = compressed.length;
+                } else if (no_context_takeover) {
+                    ASSERT_EQ(compressed.length, first_compressed_length);
+                } else {
+                    /* the same message is in the window */
+                    ASSERT_LT(compressed.length, first_compressed_length);
+                }
+            }
+            /* decompress byte by byte */
+            for (size_t i = 0; i < compressed.length; i++) {
+                ASSERT_TRUE(cat_websocket_deflate_decompress(receiver, compressed.value + i, 1, i == compressed.length - 1, &decompressed));
+            }
+            ASSERT_EQ(std::string(decompressed.value, decompressed.length), message);
+        }
+    }
+}
+
+TEST(cat_websocket_deflate, compress_and_decompress)
+{
+    test_websocket_deflate_round_trip(cat_false, cat_false, nullptr);
+    test_websocket_deflate_round_trip(cat_true, cat_false, nullptr);
+    test_websocket_deflate_round_trip(cat_true, cat_true, nullptr);
+}
+
+TEST(cat_websocket_deflate, empty_message)
+{
+    cat_websocket_deflate_parameters_t parameters;
+    cat_websocket_deflate_t deflate;
+    cat_buffer_t buffer;
+
+    cat_websocket_deflate_parameters_init(&parameters);
+    ASSERT_NE(cat_websocket_deflate_create(&deflate, &parameters, cat_true, nullptr), nullptr);
+    DEFER(cat_websocket_deflate_close(&deflate));
+    ASSERT_TRUE(cat_buffer_create(&buffer, 0));
+    DEFER(cat_buffer_close(&buffer));
+    ASSERT_TRUE(cat_websocket_deflate_compress(&deflate, nullptr, 0, cat_true, &buffer));
+    ASSERT_EQ(std::string(buffer.value, buffer.length), std::string("\x00", 1));
+}
+
+TEST(cat_websocket_deflate, pool)
+{
+    cat_websocket_deflate_pool_t pool;
+    cat_websocket_deflate_parameters_t parameters;
+    cat_websocket_deflate_options_t options;
+    cat_websocket_deflate_t deflates[4];
+    std::string message = test_websocket_deflate_message(10);
+
+    ASSERT_EQ(cat_websocket_deflate_pool_create(&pool, 2), &pool);
+    DEFER(cat_websocket_deflate_pool_close(&pool));
+    test_websocket_deflate_round_trip(cat_true, cat_true, &pool);
+    ASSERT_EQ(pool.count, 2);
+
+    cat_websocket_deflate_parameters_init(&parameters);
+    parameters.server_no_context_takeover = cat_true;
+    cat_websocket_deflate_options_init(&options);
+    options.pool = &pool;
+    for (auto &deflate : deflates) {
+        cat_buffer_t buffer;
+        ASSERT_NE(cat_websocket_deflate_create(&deflate, &parameters, cat_true, &options), nullptr);
+        ASSERT_EQ(cat_websocket_deflate_get_memory_usage(&deflate), 0);
+        ASSERT_TRUE(cat_buffer_create(&buffer, 0));
+        DEFER(cat_buffer_close(&buffer));
+        /* idle connections hold no state between messages */
+        ASSERT_TRUE(cat_websocket_deflate_compress(&deflate, message.c_str(), message.size(), cat_false, &buffer));
+        ASSERT_GT(cat_websocket_deflate_get_memory_usage(&deflate), 0);
+    }
+    /* only the pooled deflater was reused, the inflater is still there */
+    ASSERT_EQ(pool.count, 1);
+    for (auto &deflate : deflates) {
+        cat_buffer_t buffer;
+        ASSERT_TRUE(cat_buffer_create(&buffer, 0));
+        DEFER(cat_buffer_close(&buffer));
+        ASSERT_TRUE(cat_websocket_deflate_compress(&deflate, nullptr, 0, cat_true, &buffer));
+        ASSERT_EQ(cat_websocket_deflate_get_memory_usage(&deflate), 0);
+        cat_websocket_deflate_close(&deflate);
+    }
+    ASSERT_EQ(pool.count, 2);
+}
+
+TEST(cat_websocket_deflate, max_message_length)
+{
+    cat_websocket_deflate_parameters_t parameters;
+    cat_websocket_deflate_options_t options;
+    cat_websocket_deflate_t server, client;
+    cat_buffer_t compressed, decompressed;
+    std::string message(1024 * 1024, 'x');
+
+    cat_websocket_deflate_parameters_init(&parameters);
+    cat_websocket_deflate_options_init(&options);
+    ASSERT_NE(cat_websocket_deflate_create(&server, &parameters, cat_true, nullptr), nullptr);
+    DEFER(cat_websocket_deflate_close(&server));
+    options.max_message_length = message.size() - 1;
+    ASSERT_NE(cat_websocket_deflate_create(&client, &parameters, cat_false, &options), nullptr);
+    DEFER(cat_websocket_deflate_close(&client));
+    ASSERT_TRUE(cat_buffer_create(&compressed, 0));
+    DEFER(cat_buffer_close(&compressed));
+    ASSERT_TRUE(cat_buffer_create(&decompressed, 0));
+    DEFER(cat_buffer_close(&decompressed));
+
+    ASSERT_TRUE(cat_websocket_deflate_compress(&server, message.c_str(), message.size(), cat_true, &compressed));
+    ASSERT_LT(compressed.length, 4096);
+    ASSERT_FALSE(cat_websocket_deflate_decompress(&client, compressed.value, compressed.length, cat_true, &decompressed));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EMSGSIZE);
+    /* the output is bounded */
+    ASSERT_LT(decompressed.length, message.size() + 64 * 1024);
+
+    /* broken data */
+    cat_websocket_deflate_close(&client);
+    ASSERT_NE(cat_websocket_deflate_create(&client, &parameters, cat_false, nullptr), nullptr);
+    ASSERT_FALSE(cat_websocket_deflate_decompress(&client, CAT_STRL("\xff\xff\xff\xff"), cat_true, &decompressed));
+    ASSERT_EQ(cat_get_last_error_code(), CAT_EPROTO);
+}